@@ -4,6 +4,22 @@
  * 
  * Provides thread-safe storage for all decoded vehicle parameters with
  * timestamping, freshness tracking, and callback notifications.
+ *
+ * A parameter can also be marked pending: its newest value exists only as
+ * raw data held by a resolver (the J1939 shadow cache) until the task that
+ * feeds the data manager resolves it (data_manager_resolve_pending()).
+ * Getters only read; they never decode or store.
+ *
+ * Change callbacks run on the task that stored the value: the J1939 decode
+ * task for bus and computed values (resolves included), the J1708 task for
+ * J1708 values.
+ *
+ * Bus sources hand over raw integers with a scaling descriptor
+ * (data_manager_update_raw_us(), resolvers). By default they are converted
+ * to engineering units when stored. With DATA_FIXED_POINT the raw integer
+ * and descriptor are stored as they are and converted only when a getter
+ * returns a float: the receive path never touches the FPU, and a repeated
+ * value is recognized by an exact integer compare.
  */
 
 #ifndef DATA_MANAGER_H
@@ -20,13 +36,13 @@ extern "C" {
 /*                        CONFIGURATION                                     */
 /*===========================================================================*/
 
-// Use config.h value if available, otherwise default
-#ifndef DATA_MAX_PARAMETERS
-#define DATA_MAX_PARAMETERS         64      // Maximum tracked parameters
-#endif
 #define DATA_MAX_CALLBACKS          8       // Maximum change callbacks
 #define DATA_FRESHNESS_TIMEOUT_MS   5000    // Default stale threshold
 
+#ifndef DATA_FIXED_POINT
+#define DATA_FIXED_POINT            0       // 1 = keep raw bus values, convert on read
+#endif
+
 /*===========================================================================*/
 /*                        PARAMETER IDENTIFIERS                             */
 /*===========================================================================*/
@@ -107,6 +123,14 @@ typedef enum {
     // Diagnostic parameters (210-229)
     PARAM_ACTIVE_DTC_COUNT = 210,       // Count
     PARAM_MIL_STATUS = 211,             // Boolean
+    PARAM_BUS_LOAD = 212,               // Percent (no stuff bits)
+    PARAM_BUS_LOAD_WORST = 213,         // Percent (worst-case stuffing)
+    PARAM_BUS_FRAME_RATE = 214,         // Frames/s
+    PARAM_BUS_OFF_CYCLE_COUNT = 215,    // (PGN, SA) pairs off their nominal rate
+    PARAM_BUS_MAX_JITTER = 216,         // ms
+    PARAM_BUS_BUSIEST_SA = 217,         // Source address
+    PARAM_BUS_BUSIEST_SA_RATE = 218,    // Frames/s
+    PARAM_BUS_LOST_COUNT = 219,         // (PGN, SA) pairs past their lost deadline
     
     // Computed parameters (230-249)
     PARAM_MPG_CURRENT = 230,            // Miles per gallon
@@ -137,16 +161,35 @@ typedef enum {
     SOURCE_SIMULATED            // Test/simulation data
 } data_source_t;
 
+/**
+ * @brief Conversion of a raw bus value to engineering units
+ *
+ * value = raw * scale + offset. Descriptors are constant (flash-resident)
+ * and outlive every parameter that points at them.
+ */
+typedef struct {
+    float scale;                // Engineering units per bit
+    float offset;               // Engineering offset
+} data_scaling_t;
+
 /**
  * @brief Stored parameter value with metadata
  */
 typedef struct {
     float value;                // Current value
-    float prev_value;           // Previous value (for rate of change)
+    float prev_value;           // Previous value (for rate of change; data_manager_get_prev())
+#if DATA_FIXED_POINT
+    uint32_t raw;               // Current raw value (if scaling is set)
+    uint32_t prev_raw;          // Previous raw value (if prev_scaling is set)
+    const data_scaling_t* prev_scaling;  // Converts prev_raw on read (NULL = prev_value holds it)
+    const data_scaling_t* scaling;  // Converts raw on read (NULL = value holds the value)
+#endif
     uint32_t timestamp_ms;      // When value was last updated
+    uint64_t timestamp_us;      // Same instant in microseconds (source frame receive time)
     uint32_t update_count;      // Number of times updated
     data_source_t source;       // Where this data came from
     bool is_valid;              // True if value is valid
+    bool pending;               // Newer raw data waiting in the resolver
 } data_parameter_t;
 
 /**
@@ -154,13 +197,33 @@ typedef struct {
  */
 typedef void (*data_change_callback_t)(param_id_t param_id, float new_value, float old_value);
 
+/**
+ * @brief Resolver for pending parameters
+ *
+ * Extracts the newest raw value behind a pending parameter; the data
+ * manager applies the scaling (now, or on read with DATA_FIXED_POINT).
+ *
+ * @param param_id Parameter to resolve
+ * @param raw Output: raw value
+ * @param scaling Output: conversion of raw to engineering units
+ * @param timestamp_us Output: receive time of the raw data
+ * @param user Context passed to data_manager_set_resolver()
+ * @return true if a valid value was produced (false keeps the previous one)
+ */
+typedef bool (*data_resolver_t)(param_id_t param_id, uint32_t* raw,
+                                const data_scaling_t** scaling,
+                                uint64_t* timestamp_us, void* user);
+
 /**
  * @brief Data manager context
  */
 typedef struct {
-    data_parameter_t parameters[DATA_MAX_PARAMETERS];
+    data_parameter_t parameters[PARAM_MAX];     // Indexed directly by param_id
     data_change_callback_t callbacks[DATA_MAX_CALLBACKS];
     uint8_t callback_count;
+    data_resolver_t resolver;                   // Decodes pending parameters (NULL = none)
+    data_source_t resolver_source;              // Source tag for resolved values
+    void* resolver_user;
     uint32_t total_updates;
     bool initialized;
 } data_manager_t;
@@ -169,6 +232,13 @@ typedef struct {
 /*                        FUNCTION DECLARATIONS                             */
 /*===========================================================================*/
 
+/**
+ * @brief Convert a raw value to engineering units
+ */
+static inline float data_scaling_apply(const data_scaling_t* scaling, uint32_t raw) {
+    return (float)raw * scaling->scale + scaling->offset;
+}
+
 /**
  * @brief Initialize the data manager
  * @param dm Data manager instance
@@ -186,6 +256,91 @@ void data_manager_init(data_manager_t* dm);
 void data_manager_update(data_manager_t* dm, param_id_t param_id, 
                          float value, data_source_t source, uint32_t timestamp_ms);
 
+/**
+ * @brief Update a parameter value with a microsecond timestamp
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param value New value
+ * @param source Source of this data
+ * @param timestamp_us Timestamp in microseconds (timestamp_ms is derived from it)
+ */
+void data_manager_update_us(data_manager_t* dm, param_id_t param_id,
+                            float value, data_source_t source, uint64_t timestamp_us);
+
+/**
+ * @brief Update a parameter from a raw bus value
+ *
+ * With DATA_FIXED_POINT no floating point is used: the raw value and its
+ * descriptor are stored and converted when read.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param raw Raw value
+ * @param scaling Conversion to engineering units (must stay valid)
+ * @param source Source of this data
+ * @param timestamp_us Timestamp in microseconds
+ */
+void data_manager_update_raw_us(data_manager_t* dm, param_id_t param_id, uint32_t raw,
+                                const data_scaling_t* scaling, data_source_t source,
+                                uint64_t timestamp_us);
+
+/**
+ * @brief Install the resolver for pending parameters
+ * @param dm Data manager instance
+ * @param resolver Decoder for pending parameters, or NULL to remove it
+ * @param source Source tag stored with resolved values
+ * @param user Context passed to the resolver
+ */
+void data_manager_set_resolver(data_manager_t* dm, data_resolver_t resolver,
+                               data_source_t source, void* user);
+
+/**
+ * @brief Mark a parameter as having newer raw data in the resolver
+ *
+ * The value is decoded by the next resolve; a direct update in the meantime
+ * supersedes it.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ */
+void data_manager_mark_pending(data_manager_t* dm, param_id_t param_id);
+
+/**
+ * @brief Decode a pending parameter through the resolver
+ *
+ * Resolving stores the value and runs change callbacks, so call it only
+ * from the task that stores into the data manager (the decode task), never
+ * from readers.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @return true if a new value was stored
+ */
+bool data_manager_resolve(data_manager_t* dm, param_id_t param_id);
+
+/**
+ * @brief Decode every pending parameter through the resolver
+ *
+ * However many frames arrived since the last call, each parameter is
+ * decoded once. Same task rule as data_manager_resolve().
+ *
+ * @param dm Data manager instance
+ * @return Number of parameters that got a new value
+ */
+uint16_t data_manager_resolve_pending(data_manager_t* dm);
+
+/**
+ * @brief Refresh a valid parameter's timestamp without changing its value
+ *
+ * For sources that received the same value again: freshness advances, but
+ * the update count and change callbacks are left alone.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param timestamp_us Timestamp in microseconds
+ */
+void data_manager_touch_us(data_manager_t* dm, param_id_t param_id, uint64_t timestamp_us);
+
 /**
  * @brief Get a parameter value
  * @param dm Data manager instance
@@ -195,6 +350,35 @@ void data_manager_update(data_manager_t* dm, param_id_t param_id,
  */
 bool data_manager_get(data_manager_t* dm, param_id_t param_id, float* value);
 
+/**
+ * @brief Get a parameter's raw value and scaling (DATA_FIXED_POINT builds)
+ *
+ * For exact comparisons without conversion. Parameters stored in
+ * engineering units, and every parameter in a build without
+ * DATA_FIXED_POINT, have no raw value.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param raw Output: raw value
+ * @param scaling Output: conversion to engineering units (may be NULL)
+ * @return true if the parameter is valid and holds a raw value
+ */
+bool data_manager_get_raw(data_manager_t* dm, param_id_t param_id, uint32_t* raw,
+                          const data_scaling_t** scaling);
+
+/**
+ * @brief Get the value a parameter held before its latest update
+ *
+ * In engineering units, for rate of change. With DATA_FIXED_POINT a raw
+ * previous value is converted here, not when it is stored.
+ *
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param value Output: previous value
+ * @return true if the parameter is valid and has been updated at least twice
+ */
+bool data_manager_get_prev(data_manager_t* dm, param_id_t param_id, float* value);
+
 /**
  * @brief Get parameter value with timestamp
  * @param dm Data manager instance
@@ -206,6 +390,17 @@ bool data_manager_get(data_manager_t* dm, param_id_t param_id, float* value);
 bool data_manager_get_with_timestamp(data_manager_t* dm, param_id_t param_id,
                                       float* value, uint32_t* timestamp_ms);
 
+/**
+ * @brief Get parameter value with microsecond timestamp
+ * @param dm Data manager instance
+ * @param param_id Parameter identifier
+ * @param value Output value pointer
+ * @param timestamp_us Output timestamp pointer
+ * @return true if parameter is valid
+ */
+bool data_manager_get_with_timestamp_us(data_manager_t* dm, param_id_t param_id,
+                                         float* value, uint64_t* timestamp_us);
+
 /**
  * @brief Check if a parameter is fresh (recently updated)
  * @param dm Data manager instance
@@ -236,6 +431,10 @@ void data_manager_invalidate(data_manager_t* dm, param_id_t param_id);
 
 /**
  * @brief Register a callback for parameter changes
+ *
+ * Register before the tasks start. The callback runs on the task that
+ * stored the value and must not block it.
+ *
  * @param dm Data manager instance
  * @param callback Function to call when parameters change
  * @return true if callback registered successfully
@@ -19,23 +19,57 @@ extern "C" {
 /*                        PGN DEFINITIONS                                  */
 /*===========================================================================*/
 
+#ifndef PGN_REQUEST
 #define PGN_REQUEST              0xEA00  // 59904 - PGN Request Message
+#endif
+#ifndef PGN_ETC1
 #define PGN_ETC1                 0xF002  // 61442 - Electronic Transmission Controller 1 - Shaft speeds and clutch
+#endif
+#ifndef PGN_EEC2
 #define PGN_EEC2                 0xF003  // 61443 - Electronic Engine Controller 2 - Secondary engine control parameters
+#endif
+#ifndef PGN_EEC1
 #define PGN_EEC1                 0xF004  // 61444 - Electronic Engine Controller 1 - Primary engine control parameters
+#endif
+#ifndef PGN_ETC2
 #define PGN_ETC2                 0xF005  // 61445 - Electronic Transmission Controller 2 - Gear selection
+#endif
+#ifndef PGN_VD
 #define PGN_VD                   0xFEC1  // 65217 - Vehicle Distance - Odometer and trip distance
+#endif
+#ifndef PGN_DM1
 #define PGN_DM1                  0xFECA  // 65226 - DM1 Active Diagnostic Trouble Codes
+#endif
+#ifndef PGN_HOURS
 #define PGN_HOURS                0xFEE5  // 65253 - Engine Hours, Revolutions - Engine total runtime
+#endif
+#ifndef PGN_ET1
 #define PGN_ET1                  0xFEEE  // 65262 - Engine Temperature 1 - Engine temperature readings
+#endif
+#ifndef PGN_EFLP1
 #define PGN_EFLP1                0xFEEF  // 65263 - Engine Fluid Level/Pressure 1 - Oil/coolant/fuel pressures
+#endif
+#ifndef PGN_CCVS
 #define PGN_CCVS                 0xFEF1  // 65265 - Cruise Control/Vehicle Speed - Speed and cruise control status
+#endif
+#ifndef PGN_LFE
 #define PGN_LFE                  0xFEF2  // 65266 - Liquid Fuel Economy - Fuel consumption rates
+#endif
+#ifndef PGN_AMB
 #define PGN_AMB                  0xFEF5  // 65269 - Ambient Conditions - Environmental temperatures/pressures
+#endif
+#ifndef PGN_IC1
 #define PGN_IC1                  0xFEF6  // 65270 - Inlet/Exhaust Conditions 1 - Turbo and intake parameters
+#endif
+#ifndef PGN_VEP1
 #define PGN_VEP1                 0xFEF7  // 65271 - Vehicle Electrical Power 1 - Battery and charging info
+#endif
+#ifndef PGN_TRF1
 #define PGN_TRF1                 0xFEF8  // 65272 - Transmission Fluids 1 - Transmission oil parameters
+#endif
+#ifndef PGN_DD
 #define PGN_DD                   0xFEFC  // 65276 - Dash Display - Fuel level and filter status
+#endif
 
 /*===========================================================================*/
 /*                        MESSAGE CYCLE TIMES (ms)                        */
@@ -56,6 +56,8 @@ extern "C" {
 // Transport Protocol PGNs
 #define PGN_TP_CM                60416     // 0xEC00 - Transport Protocol Connection Management
 #define PGN_TP_DT                60160     // 0xEB00 - Transport Protocol Data Transfer
+#define PGN_ETP_CM               51200     // 0xC800 - Extended Transport Protocol Connection Management
+#define PGN_ETP_DT               50944     // 0xC700 - Extended Transport Protocol Data Transfer
 #define PGN_REQUEST              59904     // 0xEA00 - Request PGN
 
 // Engine PGNs
@@ -0,0 +1,615 @@
+/**
+ * @file can_driver.cpp
+ * @brief ESP32 TWAI/CAN driver wrapper implementation
+ *
+ * The driver logic (state machine, batching, statistics, recovery) is shared;
+ * the hardware access is a small set of hw_* functions with a TWAI backend
+ * for the ESP32 and a loopback backend for native builds. The native backend
+ * reads from a host source (can_host.h) instead of its loopback queue once
+ * can_driver_native_set_source() has opened one.
+ *
+ * Statistics are written by whichever task receives or transmits and read by
+ * any task, using __atomic builtins so no lock is ever taken.
+ *
+ * Filter changes reinstall the controller from the receiving task while
+ * another task may transmit. A transmit owns the controller for the call
+ * (hw_busy) and gives up at once if a reinstall holds it; a reinstall waits
+ * for a transmit in flight to finish.
+ */
+
+#include "can_driver.h"
+#include <string.h>
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#include <driver/twai.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#else
+#include "can_host.h"
+uint32_t millis(void);  // Native stub provided by j1939_parser.cpp
+#endif
+
+/*===========================================================================*/
+/*                        PRIVATE DATA                                      */
+/*===========================================================================*/
+
+/**
+ * @brief Controller status as reported by the backend
+ *
+ * Error/loss counters are cumulative since the backend was installed.
+ */
+typedef struct {
+    can_state_t state;
+    uint32_t tx_error_counter;
+    uint32_t rx_error_counter;
+    uint32_t rx_queue_depth;
+    uint32_t rx_lost;
+    uint32_t tx_failed;
+    uint32_t arbitration_lost;
+    uint32_t bus_errors;
+} can_hw_status_t;
+
+static struct {
+    bool installed;
+    bool resume;                    // Start once a reinstall succeeds (it was running)
+    bool hw_busy;                   // Transmit or reinstall in progress (accessed atomically)
+    can_state_t state;              // Accessed atomically
+    uint8_t tx_pin;
+    uint8_t rx_pin;
+    uint32_t baud_rate;
+    bool dual_filter;               // Two filters over ID28..ID13 (codes/masks [0] and [1])
+    uint32_t accept_code[2];
+    uint32_t accept_mask[2];
+    can_hw_status_t last_status;    // Previous poll, for counter deltas
+    can_stats_t stats;              // Accessed atomically
+} g_can;
+
+static inline void stat_add(uint32_t* counter, uint32_t amount) {
+    if (amount != 0) {
+        __atomic_fetch_add(counter, amount, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void set_state(can_state_t state) {
+    __atomic_store_n(&g_can.state, state, __ATOMIC_RELEASE);
+}
+
+static inline can_state_t get_state(void) {
+    return __atomic_load_n(&g_can.state, __ATOMIC_ACQUIRE);
+}
+
+static inline bool hw_try_lock(void) {
+    return !__atomic_exchange_n(&g_can.hw_busy, true, __ATOMIC_ACQUIRE);
+}
+
+static inline void hw_unlock(void) {
+    __atomic_store_n(&g_can.hw_busy, false, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================*/
+/*                        TWAI BACKEND                                      */
+/*===========================================================================*/
+
+#ifndef NATIVE_BUILD
+
+static bool hw_install(void) {
+    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(
+        (gpio_num_t)g_can.tx_pin,
+        (gpio_num_t)g_can.rx_pin,
+        TWAI_MODE_NORMAL
+    );
+    g_config.rx_queue_len = CAN_DRIVER_RX_QUEUE_LEN;
+    g_config.tx_queue_len = CAN_DRIVER_TX_QUEUE_LEN;
+
+    twai_timing_config_t t_250k = TWAI_TIMING_CONFIG_250KBITS();
+    twai_timing_config_t t_500k = TWAI_TIMING_CONFIG_500KBITS();
+
+    // Single filter, extended layout: ID28..0 in register bits 31..3, 1 = don't care.
+    // Dual filter, extended layout: ID28..13 in bits 31..16 (filter 1) and 15..0 (filter 2)
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    if (g_can.dual_filter) {
+        f_config.single_filter = false;
+        f_config.acceptance_code = ((g_can.accept_code[0] >> 13) << 16) |
+                                   ((g_can.accept_code[1] >> 13) & 0xFFFF);
+        f_config.acceptance_mask = ~(((g_can.accept_mask[0] >> 13) << 16) |
+                                     ((g_can.accept_mask[1] >> 13) & 0xFFFF));
+    } else {
+        f_config.acceptance_code = g_can.accept_code[0] << 3;
+        f_config.acceptance_mask = ~(g_can.accept_mask[0] << 3) | 0x7;
+    }
+
+    const twai_timing_config_t* t_config;
+    if (g_can.baud_rate == CAN_BAUD_250K) {
+        t_config = &t_250k;
+    } else if (g_can.baud_rate == CAN_BAUD_500K) {
+        t_config = &t_500k;
+    } else {
+        return false;
+    }
+
+    return twai_driver_install(&g_config, t_config, &f_config) == ESP_OK;
+}
+
+static void hw_uninstall(void) {
+    twai_driver_uninstall();
+}
+
+static bool hw_start(void) {
+    return twai_start() == ESP_OK;
+}
+
+static bool hw_stop(void) {
+    return twai_stop() == ESP_OK;
+}
+
+static bool hw_receive(can_frame_t* frame, uint32_t timeout_ms) {
+    twai_message_t message;
+
+    if (twai_receive(&message, pdMS_TO_TICKS(timeout_ms)) != ESP_OK) {
+        return false;
+    }
+
+    frame->id = message.identifier;
+    frame->length = (message.data_length_code > 8) ? 8 : message.data_length_code;
+    frame->is_extended = message.extd;
+    frame->is_rtr = message.rtr;
+    frame->timestamp_us = can_driver_time_us();
+    memcpy(frame->data, message.data, 8);
+    return true;
+}
+
+static bool hw_transmit(const can_frame_t* frame, uint32_t timeout_ms) {
+    twai_message_t message;
+
+    memset(&message, 0, sizeof(message));
+    message.identifier = frame->id;
+    message.extd = frame->is_extended;
+    message.rtr = frame->is_rtr;
+    message.data_length_code = (frame->length > 8) ? 8 : frame->length;
+    memcpy(message.data, frame->data, message.data_length_code);
+
+    return twai_transmit(&message, pdMS_TO_TICKS(timeout_ms)) == ESP_OK;
+}
+
+static bool hw_get_status(can_hw_status_t* status) {
+    twai_status_info_t info;
+
+    if (twai_get_status_info(&info) != ESP_OK) return false;
+
+    switch (info.state) {
+        case TWAI_STATE_RUNNING:    status->state = CAN_STATE_RUNNING; break;
+        case TWAI_STATE_BUS_OFF:    status->state = CAN_STATE_BUS_OFF; break;
+        case TWAI_STATE_RECOVERING: status->state = CAN_STATE_RECOVERING; break;
+        default:                    status->state = CAN_STATE_STOPPED; break;
+    }
+    status->tx_error_counter = info.tx_error_counter;
+    status->rx_error_counter = info.rx_error_counter;
+    status->rx_queue_depth = info.msgs_to_rx;
+    status->rx_lost = info.rx_missed_count + info.rx_overrun_count;
+    status->tx_failed = info.tx_failed_count;
+    status->arbitration_lost = info.arb_lost_count;
+    status->bus_errors = info.bus_error_count;
+    return true;
+}
+
+static bool hw_initiate_recovery(void) {
+    return twai_initiate_recovery() == ESP_OK;
+}
+
+uint64_t can_driver_time_us(void) {
+    return (uint64_t)esp_timer_get_time();
+}
+
+static void hw_wait(uint32_t timeout_ms) {
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    vTaskDelay(ticks > 0 ? ticks : 1);
+}
+
+/*===========================================================================*/
+/*                        LOOPBACK / HOST BACKEND (NATIVE)                  */
+/*===========================================================================*/
+
+#else
+
+// Transmitted frames that pass the filter come straight back as received,
+// unless a host source is open, in which case frames go to and from it
+static struct {
+    can_hw_status_t status;
+    can_frame_t queue[CAN_DRIVER_RX_QUEUE_LEN];
+    uint32_t head;
+    uint32_t tail;
+} g_loopback;
+
+static uint8_t g_failing_installs;  // Test hook: installs that fail next
+
+static bool hw_install(void) {
+    if (g_can.baud_rate != CAN_BAUD_250K && g_can.baud_rate != CAN_BAUD_500K) {
+        return false;
+    }
+    if (g_failing_installs > 0) {
+        g_failing_installs--;
+        return false;
+    }
+    memset(&g_loopback, 0, sizeof(g_loopback));
+    g_loopback.status.state = CAN_STATE_STOPPED;
+    return true;
+}
+
+static void hw_uninstall(void) {
+    g_loopback.status.state = CAN_STATE_STOPPED;
+}
+
+static bool hw_start(void) {
+    if (g_loopback.status.state != CAN_STATE_STOPPED) return false;
+    g_loopback.status.state = CAN_STATE_RUNNING;
+    return true;
+}
+
+static bool hw_stop(void) {
+    g_loopback.status.state = CAN_STATE_STOPPED;
+    g_loopback.head = g_loopback.tail = 0;
+    return true;
+}
+
+static inline bool filter_accepts(const can_frame_t* frame) {
+    if (!g_can.dual_filter) {
+        return ((frame->id ^ g_can.accept_code[0]) & g_can.accept_mask[0]) == 0;
+    }
+    // Dual filters only see ID28..ID13 of an extended identifier
+    return ((frame->id ^ g_can.accept_code[0]) & g_can.accept_mask[0] & 0x1FFFE000) == 0 ||
+           ((frame->id ^ g_can.accept_code[1]) & g_can.accept_mask[1] & 0x1FFFE000) == 0;
+}
+
+static bool hw_receive(can_frame_t* frame, uint32_t timeout_ms) {
+    if (g_loopback.status.state != CAN_STATE_RUNNING) return false;
+
+    if (can_host_get_kind() != CAN_HOST_NONE) {
+        while (can_host_read(frame, timeout_ms)) {
+            if (filter_accepts(frame)) return true;
+            timeout_ms = 0;  // Only the first read may wait
+        }
+        return false;
+    }
+
+    // Loopback never blocks
+    if (g_loopback.head == g_loopback.tail) return false;
+
+    *frame = g_loopback.queue[g_loopback.tail % CAN_DRIVER_RX_QUEUE_LEN];
+    frame->timestamp_us = can_driver_time_us();
+    g_loopback.tail++;
+    return true;
+}
+
+static bool hw_transmit(const can_frame_t* frame, uint32_t timeout_ms) {
+    (void)timeout_ms;
+
+    if (g_loopback.status.state != CAN_STATE_RUNNING) return false;
+    if (can_host_get_kind() != CAN_HOST_NONE) return can_host_write(frame);
+    if (!filter_accepts(frame)) {
+        return true;  // Sent, but filtered out on reception
+    }
+
+    if (g_loopback.head - g_loopback.tail >= CAN_DRIVER_RX_QUEUE_LEN) {
+        g_loopback.status.rx_lost++;
+        return true;
+    }
+    g_loopback.queue[g_loopback.head % CAN_DRIVER_RX_QUEUE_LEN] = *frame;
+    g_loopback.head++;
+    return true;
+}
+
+static bool hw_get_status(can_hw_status_t* status) {
+    // Recovery completes at the first poll after it was initiated
+    if (g_loopback.status.state == CAN_STATE_RECOVERING) {
+        g_loopback.status.state = CAN_STATE_STOPPED;
+        g_loopback.status.tx_error_counter = 0;
+        g_loopback.status.rx_error_counter = 0;
+    }
+    // A log source that has been read to the end is a bus that went away
+    if (g_loopback.status.state == CAN_STATE_RUNNING && can_host_at_end()) {
+        g_loopback.status.state = CAN_STATE_STOPPED;
+    }
+    g_loopback.status.rx_queue_depth = g_loopback.head - g_loopback.tail;
+    *status = g_loopback.status;
+    return true;
+}
+
+static bool hw_initiate_recovery(void) {
+    if (g_loopback.status.state != CAN_STATE_BUS_OFF) return false;
+    g_loopback.status.state = CAN_STATE_RECOVERING;
+    return true;
+}
+
+static void hw_wait(uint32_t timeout_ms) {
+    (void)timeout_ms;
+}
+
+uint64_t can_driver_time_us(void) {
+    if (can_host_get_kind() != CAN_HOST_NONE) {
+        return can_host_time_us();
+    }
+    return (uint64_t)millis() * 1000ULL;  // Follows the test millis() stub
+}
+
+bool can_driver_native_set_source(const char* source) {
+    if (source == NULL) {
+        can_host_close();  // Back to the loopback bus
+        return true;
+    }
+    return can_host_open(source);
+}
+
+void can_driver_native_fail_installs(uint8_t count) {
+    g_failing_installs = count;
+}
+
+void can_driver_native_force_bus_off(void) {
+    g_loopback.status.state = CAN_STATE_BUS_OFF;
+    g_loopback.status.tx_error_counter = 255;
+    g_loopback.status.bus_errors += 32;
+    g_loopback.head = g_loopback.tail = 0;  // Controller flushes its queues
+}
+
+#endif // NATIVE_BUILD
+
+/*===========================================================================*/
+/*                        STATUS AND RECOVERY                               */
+/*===========================================================================*/
+
+/**
+ * @brief Growth of a cumulative backend counter since the last poll
+ *
+ * Backend counters restart from zero when the driver is reinstalled.
+ */
+static inline uint32_t counter_delta(uint32_t current, uint32_t previous) {
+    return (current >= previous) ? current - previous : current;
+}
+
+/**
+ * @brief Poll controller status, fold it into the statistics and drive recovery
+ */
+static void poll_status(void) {
+    can_hw_status_t status;
+
+    if (!g_can.installed || !hw_get_status(&status)) return;
+
+    stat_add(&g_can.stats.rx_errors, counter_delta(status.rx_lost, g_can.last_status.rx_lost));
+    stat_add(&g_can.stats.tx_errors, counter_delta(status.tx_failed, g_can.last_status.tx_failed));
+    stat_add(&g_can.stats.arbitration_lost,
+             counter_delta(status.arbitration_lost, g_can.last_status.arbitration_lost));
+    stat_add(&g_can.stats.bus_errors, counter_delta(status.bus_errors, g_can.last_status.bus_errors));
+    g_can.last_status = status;
+
+    uint8_t tec = (status.tx_error_counter > 255) ? 255 : (uint8_t)status.tx_error_counter;
+    uint8_t rec = (status.rx_error_counter > 255) ? 255 : (uint8_t)status.rx_error_counter;
+    __atomic_store_n(&g_can.stats.tx_error_counter, tec, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.rx_error_counter, rec, __ATOMIC_RELAXED);
+
+    if (status.rx_queue_depth > g_can.stats.rx_queue_high_water) {
+        __atomic_store_n(&g_can.stats.rx_queue_high_water, status.rx_queue_depth, __ATOMIC_RELAXED);
+    }
+
+    can_state_t state = get_state();
+
+    if (status.state == CAN_STATE_STOPPED && state == CAN_STATE_RUNNING) {
+        set_state(CAN_STATE_STOPPED);  // Controller went away underneath us
+        return;
+    }
+
+    if (status.state == CAN_STATE_BUS_OFF && state == CAN_STATE_RUNNING) {
+        stat_add(&g_can.stats.bus_off_count, 1);
+        set_state(CAN_STATE_BUS_OFF);
+        state = CAN_STATE_BUS_OFF;
+    }
+
+    if (state == CAN_STATE_BUS_OFF && status.state == CAN_STATE_BUS_OFF) {
+        if (hw_initiate_recovery()) {
+            set_state(CAN_STATE_RECOVERING);
+        }
+    } else if (state == CAN_STATE_RECOVERING && status.state == CAN_STATE_STOPPED) {
+        // Recovery leaves the controller stopped; bring it back on the bus
+        if (hw_start()) {
+            stat_add(&g_can.stats.recovery_count, 1);
+            set_state(CAN_STATE_RUNNING);
+        }
+    }
+}
+
+/*===========================================================================*/
+/*                        INITIALIZATION                                    */
+/*===========================================================================*/
+
+bool can_driver_init(uint8_t tx_pin, uint8_t rx_pin, uint32_t baud_rate) {
+    if (g_can.installed) {
+        can_driver_stop();
+        hw_uninstall();
+    }
+
+    memset(&g_can, 0, sizeof(g_can));
+    g_can.tx_pin = tx_pin;
+    g_can.rx_pin = rx_pin;
+    g_can.baud_rate = baud_rate;
+    g_can.accept_code[0] = 0;
+    g_can.accept_mask[0] = 0;  // Accept all
+    set_state(CAN_STATE_STOPPED);
+
+    g_can.installed = hw_install();
+    return g_can.installed;
+}
+
+bool can_driver_start(void) {
+    if (!g_can.installed || get_state() != CAN_STATE_STOPPED) return false;
+    if (!hw_start()) return false;
+
+    set_state(CAN_STATE_RUNNING);
+    return true;
+}
+
+bool can_driver_stop(void) {
+    if (!g_can.installed) return false;
+    if (get_state() == CAN_STATE_STOPPED) return true;
+
+    hw_stop();
+    set_state(CAN_STATE_STOPPED);
+    return true;
+}
+
+can_state_t can_driver_get_state(void) {
+    return get_state();
+}
+
+/*===========================================================================*/
+/*                        RECEIVE / TRANSMIT                                */
+/*===========================================================================*/
+
+uint32_t can_driver_receive_batch(can_frame_t* frames, uint32_t max_frames, uint32_t timeout_ms) {
+    if (frames == NULL || max_frames == 0) return 0;
+
+    poll_status();
+
+    if (get_state() != CAN_STATE_RUNNING) {
+        if (timeout_ms > 0) hw_wait(timeout_ms);  // Don't spin while off the bus
+        return 0;
+    }
+
+    if (!hw_receive(&frames[0], timeout_ms)) return 0;
+
+    uint32_t count = 1;
+    while (count < max_frames && hw_receive(&frames[count], 0)) {
+        count++;
+    }
+
+    stat_add(&g_can.stats.rx_count, count);
+    return count;
+}
+
+bool can_driver_receive(can_frame_t* frame, uint32_t timeout_ms) {
+    return can_driver_receive_batch(frame, 1, timeout_ms) == 1;
+}
+
+bool can_driver_transmit(const can_frame_t* frame, uint32_t timeout_ms) {
+    if (frame == NULL) return false;
+
+    // A filter reinstall in progress counts as a failed transmit, never a wait
+    bool sent = false;
+    if (hw_try_lock()) {
+        sent = get_state() == CAN_STATE_RUNNING && hw_transmit(frame, timeout_ms);
+        hw_unlock();
+    }
+
+    if (!sent) {
+        stat_add(&g_can.stats.tx_errors, 1);
+        return false;
+    }
+
+    stat_add(&g_can.stats.tx_count, 1);
+    return true;
+}
+
+/*===========================================================================*/
+/*                        STATISTICS                                        */
+/*===========================================================================*/
+
+void can_driver_get_stats(can_stats_t* stats) {
+    if (stats == NULL) return;
+
+    stats->rx_count = __atomic_load_n(&g_can.stats.rx_count, __ATOMIC_RELAXED);
+    stats->tx_count = __atomic_load_n(&g_can.stats.tx_count, __ATOMIC_RELAXED);
+    stats->rx_errors = __atomic_load_n(&g_can.stats.rx_errors, __ATOMIC_RELAXED);
+    stats->tx_errors = __atomic_load_n(&g_can.stats.tx_errors, __ATOMIC_RELAXED);
+    stats->bus_errors = __atomic_load_n(&g_can.stats.bus_errors, __ATOMIC_RELAXED);
+    stats->tx_error_counter = __atomic_load_n(&g_can.stats.tx_error_counter, __ATOMIC_RELAXED);
+    stats->rx_error_counter = __atomic_load_n(&g_can.stats.rx_error_counter, __ATOMIC_RELAXED);
+    stats->arbitration_lost = __atomic_load_n(&g_can.stats.arbitration_lost, __ATOMIC_RELAXED);
+    stats->bus_off_count = __atomic_load_n(&g_can.stats.bus_off_count, __ATOMIC_RELAXED);
+    stats->recovery_count = __atomic_load_n(&g_can.stats.recovery_count, __ATOMIC_RELAXED);
+    stats->rx_queue_high_water = __atomic_load_n(&g_can.stats.rx_queue_high_water, __ATOMIC_RELAXED);
+}
+
+void can_driver_clear_stats(void) {
+    __atomic_store_n(&g_can.stats.rx_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.tx_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.rx_errors, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.tx_errors, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.bus_errors, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.arbitration_lost, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.bus_off_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.recovery_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_can.stats.rx_queue_high_water, 0, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================*/
+/*                        RECOVERY AND FILTERING                            */
+/*===========================================================================*/
+
+bool can_driver_recover(void) {
+    if (get_state() != CAN_STATE_BUS_OFF) return false;
+    if (!hw_initiate_recovery()) return false;
+
+    set_state(CAN_STATE_RECOVERING);
+    return true;
+}
+
+/**
+ * @brief Reinstall the controller with a new filter
+ *
+ * If the controller does not come back with the new filter, the previous one
+ * is installed again. If even that fails, the driver stays uninstalled and
+ * the next filter change installs it (and starts it, if it was running).
+ *
+ * @return true if the new filter is installed and the driver runs as before
+ */
+static bool reinstall_filter(bool dual, const uint32_t code[2], const uint32_t mask[2]) {
+    while (!hw_try_lock()) {
+        hw_wait(1);  // A transmit is using the controller
+    }
+
+    bool resume = g_can.resume || get_state() != CAN_STATE_STOPPED;
+    if (g_can.installed) {
+        can_driver_stop();
+        hw_uninstall();
+    }
+    memset(&g_can.last_status, 0, sizeof(g_can.last_status));
+
+    bool previous_dual = g_can.dual_filter;
+    uint32_t previous_code[2] = { g_can.accept_code[0], g_can.accept_code[1] };
+    uint32_t previous_mask[2] = { g_can.accept_mask[0], g_can.accept_mask[1] };
+    g_can.dual_filter = dual;
+    memcpy(g_can.accept_code, code, sizeof(g_can.accept_code));
+    memcpy(g_can.accept_mask, mask, sizeof(g_can.accept_mask));
+
+    bool applied = hw_install();
+    if (!applied) {
+        g_can.dual_filter = previous_dual;
+        memcpy(g_can.accept_code, previous_code, sizeof(g_can.accept_code));
+        memcpy(g_can.accept_mask, previous_mask, sizeof(g_can.accept_mask));
+    }
+    g_can.installed = applied || hw_install();
+
+    g_can.resume = resume;
+    if (g_can.installed && resume && can_driver_start()) {
+        g_can.resume = false;
+    }
+
+    hw_unlock();
+    return applied && !g_can.resume;
+}
+
+bool can_driver_set_filter(uint32_t accept_code, uint32_t accept_mask) {
+    if (g_can.baud_rate == 0) return false;  // Never initialized
+
+    uint32_t code[2] = { accept_code & 0x1FFFFFFF, 0 };
+    uint32_t mask[2] = { accept_mask & 0x1FFFFFFF, 0 };
+    return reinstall_filter(false, code, mask);
+}
+
+bool can_driver_set_dual_filter(uint32_t code_a, uint32_t mask_a,
+                                uint32_t code_b, uint32_t mask_b) {
+    if (g_can.baud_rate == 0) return false;
+
+    uint32_t code[2] = { code_a & 0x1FFFE000, code_b & 0x1FFFE000 };
+    uint32_t mask[2] = { mask_a & 0x1FFFE000, mask_b & 0x1FFFE000 };
+    return reinstall_filter(true, code, mask);
+}
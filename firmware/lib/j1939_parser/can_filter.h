@@ -0,0 +1,150 @@
+/**
+ * @file can_filter.h
+ * @brief Acceptance filter planner for the TWAI controller
+ *
+ * Turns the set of PGNs the firmware actually consumes into the tightest
+ * acceptance filter the controller offers, so frames nobody reads are
+ * dropped in hardware instead of interrupting the CPU:
+ *
+ *  - single: one code/mask over the full 29-bit identifier
+ *  - dual:   two code/masks, each over ID28..ID13 only (priority, DP, PF and
+ *            the top three PS bits) - the TWAI limit for extended frames
+ *
+ * Candidates are ranked by the frames they would let through in an observed
+ * traffic sample (frames per PGN), or by the identifier space they open when
+ * no sample is available. Priority and source address are never filtered;
+ * neither is the destination of PDU1 PGNs.
+ */
+
+#ifndef CAN_FILTER_H
+#define CAN_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "data_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#define CAN_FILTER_MAX_PGNS         64      // Consumed PGNs per set (more = accept all)
+
+// Identifier bits a dual filter can compare for extended frames (ID28..ID13)
+#define CAN_FILTER_DUAL_ID_BITS     0x1FFFE000UL
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Filter layout chosen by the planner
+ */
+typedef enum {
+    CAN_FILTER_ACCEPT_ALL = 0,  // Nothing to gain, or nothing known
+    CAN_FILTER_SINGLE,          // One 29-bit code/mask
+    CAN_FILTER_DUAL             // Two code/masks over ID28..ID13
+} can_filter_mode_t;
+
+/**
+ * @brief Set of consumed PGNs (kept sorted, so equal sets compare equal)
+ */
+typedef struct {
+    uint32_t pgns[CAN_FILTER_MAX_PGNS];
+    uint8_t count;
+    bool accept_all;            // A consumer wants every frame (or the set overflowed)
+} can_filter_set_t;
+
+/**
+ * @brief Observed traffic for one PGN
+ */
+typedef struct {
+    uint32_t pgn;               // Parameter Group Number (destination stripped)
+    uint32_t frames;            // Frames seen in the sample
+} can_filter_traffic_t;
+
+/**
+ * @brief Planned filter and its estimated effect
+ *
+ * Codes and masks are in 29-bit identifier terms, as can_driver_set_filter()
+ * takes them: a frame passes when (id & mask) == (code & mask).
+ */
+typedef struct {
+    can_filter_mode_t mode;
+    uint32_t code[2];           // [1] used in dual mode only
+    uint32_t mask[2];
+    uint32_t sample_frames;     // Frames in the traffic sample
+    uint32_t sample_rejected;   // Of those, frames the filter would drop
+} can_filter_plan_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Empty a PGN set
+ * @param set Set to clear
+ */
+void can_filter_set_clear(can_filter_set_t* set);
+
+/**
+ * @brief Add a consumed PGN
+ * @param set Set
+ * @param pgn Parameter Group Number (PDU1 destination bits are ignored)
+ * @return false if the set is full (it then accepts everything)
+ */
+bool can_filter_set_add(can_filter_set_t* set, uint32_t pgn);
+
+/**
+ * @brief Add every PGN the signal decoder publishes parameters from
+ * @param set Set
+ */
+void can_filter_set_add_decoder(can_filter_set_t* set);
+
+/**
+ * @brief Add the PGNs that carry a parameter
+ * @param set Set
+ * @param param_id Parameter (PGNs are found through the decoder table)
+ * @return Number of PGNs carrying the parameter
+ */
+uint8_t can_filter_set_add_param(can_filter_set_t* set, param_id_t param_id);
+
+/**
+ * @brief Compare two sets
+ * @return true if both hold the same PGNs and accept-all state
+ */
+bool can_filter_set_equal(const can_filter_set_t* a, const can_filter_set_t* b);
+
+/**
+ * @brief Compute the best filter for a consumed PGN set
+ * @param set Consumed PGNs
+ * @param traffic Observed frames per PGN, or NULL
+ * @param traffic_count Entries in traffic
+ * @param plan Output: filter and estimated rejection
+ */
+void can_filter_plan(const can_filter_set_t* set, const can_filter_traffic_t* traffic,
+                     uint16_t traffic_count, can_filter_plan_t* plan);
+
+/**
+ * @brief Check an identifier against a plan (what the hardware would do)
+ * @param plan Planned filter
+ * @param can_id 29-bit identifier
+ * @return true if the frame would be received
+ */
+bool can_filter_accepts(const can_filter_plan_t* plan, uint32_t can_id);
+
+/**
+ * @brief Get filter mode name for display
+ * @param mode Filter mode
+ * @return Mode name string
+ */
+const char* can_filter_get_mode_name(can_filter_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_FILTER_H */
@@ -0,0 +1,109 @@
+/**
+ * @file can_host.h
+ * @brief Linux CAN sources for native builds (SocketCAN or candump log)
+ *
+ * Lets the CAN driver run on a PC: frames come from a SocketCAN interface
+ * (e.g. vcan0 fed by canplayer) or, when no such interface exists, from a
+ * candump -L style log read from a file, FIFO or stdin ("-"). Only compiled
+ * for NATIVE_BUILD; the driver uses it once can_driver_native_set_source()
+ * has been called, and its in-memory loopback bus otherwise.
+ */
+
+#ifndef CAN_HOST_H
+#define CAN_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "can_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Kind of host source currently open
+ */
+typedef enum {
+    CAN_HOST_NONE,
+    CAN_HOST_SOCKETCAN,         // Raw CAN socket bound to an interface
+    CAN_HOST_LOG                // candump -L lines from a file or pipe
+} can_host_kind_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Open a host CAN source
+ *
+ * A source naming an existing network interface opens a SocketCAN socket;
+ * anything else is opened as a candump log path ("-" reads stdin).
+ *
+ * @param source Interface name, log file path, or "-"
+ * @return true if the source was opened
+ */
+bool can_host_open(const char* source);
+
+/**
+ * @brief Close the current source
+ */
+void can_host_close(void);
+
+/**
+ * @brief Kind of source currently open
+ * @return CAN_HOST_NONE if nothing is open
+ */
+can_host_kind_t can_host_get_kind(void);
+
+/**
+ * @brief Read one frame
+ *
+ * SocketCAN frames are stamped with the host clock at read time. Log frames
+ * keep their recorded spacing: the first line maps to the time the log was
+ * opened and later lines follow at their logged offsets, however fast the
+ * file is consumed.
+ *
+ * @param frame Output frame
+ * @param timeout_ms Maximum wait for SocketCAN (0 for non-blocking); log reads
+ *                   from a pipe block until a line or EOF arrives
+ * @return true if a frame was read
+ */
+bool can_host_read(can_frame_t* frame, uint32_t timeout_ms);
+
+/**
+ * @brief Send one frame (SocketCAN only; logs are receive-only)
+ * @param frame Frame to send
+ * @return true if sent
+ */
+bool can_host_write(const can_frame_t* frame);
+
+/**
+ * @brief Check whether a log source has been read to the end
+ * @return true after EOF on a log source
+ */
+bool can_host_at_end(void);
+
+/**
+ * @brief Host monotonic clock in microseconds
+ * @return Current time
+ */
+uint64_t can_host_time_us(void);
+
+/**
+ * @brief Parse one candump -L line ("(sec.usec) iface ID#DATA")
+ * @param line Text line
+ * @param frame Output frame (timestamp not set)
+ * @param log_time_us Output logged time in microseconds
+ * @return true if the line held a data frame
+ */
+bool can_host_parse_log_line(const char* line, can_frame_t* frame, uint64_t* log_time_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_HOST_H */
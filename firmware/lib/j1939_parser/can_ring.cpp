@@ -0,0 +1,90 @@
+/**
+ * @file can_ring.cpp
+ * @brief Lock-free SPSC CAN frame ring implementation
+ *
+ * Uses GCC __atomic builtins (available on Xtensa and host toolchains) so the
+ * ring stays a plain C struct. The producer publishes head with release
+ * semantics after writing the slot; the consumer publishes tail with release
+ * semantics after reading it.
+ */
+
+#include "can_ring.h"
+#include <string.h>
+
+#define RING_MASK (CAN_RING_SIZE - 1)
+
+/*===========================================================================*/
+/*                        INITIALIZATION                                    */
+/*===========================================================================*/
+
+void can_ring_init(can_ring_t* ring) {
+    if (ring == NULL) return;
+
+    memset(ring, 0, sizeof(can_ring_t));
+}
+
+/*===========================================================================*/
+/*                        PRODUCER                                          */
+/*===========================================================================*/
+
+bool can_ring_push(can_ring_t* ring, const can_frame_t* frame) {
+    if (ring == NULL || frame == NULL) return false;
+
+    uint32_t head = ring->head;  // Only the producer writes head
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t used = head - tail;
+
+    if (used >= CAN_RING_SIZE) {
+        __atomic_store_n(&ring->overflow_count, ring->overflow_count + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    ring->frames[head & RING_MASK] = *frame;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    if (used + 1 > ring->high_water) {
+        __atomic_store_n(&ring->high_water, used + 1, __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+/*===========================================================================*/
+/*                        CONSUMER                                          */
+/*===========================================================================*/
+
+uint32_t can_ring_pop_batch(can_ring_t* ring, can_frame_t* frames, uint32_t max_frames) {
+    if (ring == NULL || frames == NULL) return 0;
+
+    uint32_t tail = ring->tail;  // Only the consumer writes tail
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t available = head - tail;
+    uint32_t count = (available < max_frames) ? available : max_frames;
+
+    for (uint32_t i = 0; i < count; i++) {
+        frames[i] = ring->frames[(tail + i) & RING_MASK];
+    }
+
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+    return count;
+}
+
+/*===========================================================================*/
+/*                        STATISTICS                                        */
+/*===========================================================================*/
+
+uint32_t can_ring_count(const can_ring_t* ring) {
+    if (ring == NULL) return 0;
+
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+void can_ring_get_stats(const can_ring_t* ring, can_ring_stats_t* stats) {
+    if (ring == NULL || stats == NULL) return;
+
+    stats->occupancy = can_ring_count(ring);
+    stats->high_water = __atomic_load_n(&ring->high_water, __ATOMIC_RELAXED);
+    stats->overflow_count = __atomic_load_n(&ring->overflow_count, __ATOMIC_RELAXED);
+    stats->capacity = CAN_RING_SIZE;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file can_ring.h
+ * @brief Lock-free single-producer/single-consumer CAN frame ring
+ *
+ * Hands received frames from the CAN receive task (producer) to the decode
+ * task (consumer) without locks. Exactly one task may push and exactly one
+ * task may pop; each index is written by one side only and published with
+ * release/acquire ordering, so the two sides may run on different cores.
+ */
+
+#ifndef CAN_RING_H
+#define CAN_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "can_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef CAN_RING_SIZE
+#define CAN_RING_SIZE               256         // Frames; must be a power of two
+#endif
+
+#if (CAN_RING_SIZE & (CAN_RING_SIZE - 1)) != 0
+#error "CAN_RING_SIZE must be a power of two"
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Ring buffer state
+ *
+ * Indices run freely and are masked on access, so head - tail is always the
+ * occupancy. Producer-owned fields come first, consumer-owned fields last.
+ */
+typedef struct {
+    // Producer side
+    uint32_t head;              // Next slot to write
+    uint32_t overflow_count;    // Frames dropped because the ring was full
+    uint32_t high_water;        // Highest occupancy seen by the producer
+
+    can_frame_t frames[CAN_RING_SIZE];
+
+    // Consumer side
+    uint32_t tail;              // Next slot to read
+} can_ring_t;
+
+/**
+ * @brief Ring statistics snapshot
+ */
+typedef struct {
+    uint32_t occupancy;         // Frames currently queued
+    uint32_t high_water;        // Highest occupancy seen
+    uint32_t overflow_count;    // Frames dropped (ring full)
+    uint32_t capacity;          // CAN_RING_SIZE
+} can_ring_stats_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize an empty ring (call before either task starts)
+ * @param ring Ring to initialize
+ */
+void can_ring_init(can_ring_t* ring);
+
+/**
+ * @brief Enqueue one frame (producer only)
+ * @param ring Ring buffer
+ * @param frame Frame to copy in
+ * @return true if queued, false if the ring was full (frame dropped)
+ */
+bool can_ring_push(can_ring_t* ring, const can_frame_t* frame);
+
+/**
+ * @brief Dequeue up to max_frames frames in FIFO order (consumer only)
+ * @param ring Ring buffer
+ * @param frames Output array
+ * @param max_frames Capacity of frames
+ * @return Number of frames copied out
+ */
+uint32_t can_ring_pop_batch(can_ring_t* ring, can_frame_t* frames, uint32_t max_frames);
+
+/**
+ * @brief Number of frames currently queued (either side)
+ * @param ring Ring buffer
+ * @return Occupancy
+ */
+uint32_t can_ring_count(const can_ring_t* ring);
+
+/**
+ * @brief Get ring statistics (either side; counters may lag by one frame)
+ * @param ring Ring buffer
+ * @param stats Output statistics
+ */
+void can_ring_get_stats(const can_ring_t* ring, can_ring_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAN_RING_H */
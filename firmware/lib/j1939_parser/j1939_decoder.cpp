@@ -0,0 +1,455 @@
+/**
+ * @file j1939_decoder.cpp
+ * @brief Table-driven J1939 signal decoder implementation
+ *
+ * Signal layouts follow SAE J1939-71. Each PGN owns a small constant array
+ * of signal descriptors; the PGN descriptor table below is indexed by a dense
+ * two-level PF/PS table so dispatch is O(1) regardless of table size.
+ */
+
+#include "j1939_decoder.h"
+#include "j1939_addr.h"
+#include "j1939_dbc_generated.h"   // Cycle times
+#include <string.h>
+
+/*===========================================================================*/
+/*                        SIGNAL DESCRIPTOR TABLES                          */
+/*===========================================================================*/
+
+// Descriptor row: SPN, start bit, bit length, scale, offset, target parameter
+#define J1939_SIGNAL(spn, start, bits, scale, offset, param) \
+    { spn, start, bits, { scale, offset }, J1939_SIGNAL_RAW_LIMIT(bits), param }
+
+#define SIGNAL_COUNT(arr) ((uint8_t)(sizeof(arr) / sizeof(arr[0])))
+
+// PGN 61442 - ETC1 - Electronic Transmission Controller 1
+static const j1939_signal_t etc1_signals[] = {
+    J1939_SIGNAL(191,  8, 16, 0.125f,   0.0f,    PARAM_OUTPUT_SHAFT_SPEED),
+    J1939_SIGNAL(522, 24,  8, 0.4f,     0.0f,    PARAM_CLUTCH_SLIP),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(161, 40, 16, 0.125f,   0.0f,    PARAM_NONE),
+    J1939_SIGNAL(1482, 56,  8, 1.0f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 61443 - EEC2 - Electronic Engine Controller 2
+static const j1939_signal_t eec2_signals[] = {
+    J1939_SIGNAL(91,   8,  8, 0.4f,     0.0f,    PARAM_THROTTLE_POSITION),
+    J1939_SIGNAL(92,  16,  8, 1.0f,     0.0f,    PARAM_ENGINE_LOAD),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(974, 24,  8, 0.4f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(29,  32,  8, 0.4f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 61444 - EEC1 - Electronic Engine Controller 1
+static const j1939_signal_t eec1_signals[] = {
+    J1939_SIGNAL(513, 16,  8, 1.0f,     -125.0f, PARAM_ENGINE_TORQUE),
+    J1939_SIGNAL(190, 24, 16, 0.125f,   0.0f,    PARAM_ENGINE_SPEED),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(899,  0,  4, 1.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(512,  8,  8, 1.0f,     -125.0f, PARAM_NONE),
+    J1939_SIGNAL(1483, 40,  8, 1.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(1675, 48,  4, 1.0f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 61445 - ETC2 - Electronic Transmission Controller 2
+static const j1939_signal_t etc2_signals[] = {
+    J1939_SIGNAL(524,  0,  8, 1.0f,     -125.0f, PARAM_SELECTED_GEAR),
+    J1939_SIGNAL(526,  8, 16, 0.001f,   0.0f,    PARAM_GEAR_RATIO),
+    J1939_SIGNAL(523, 24,  8, 1.0f,     -125.0f, PARAM_CURRENT_GEAR),
+};
+
+// PGN 65217 - VD - Vehicle Distance
+static const j1939_signal_t vd_signals[] = {
+    J1939_SIGNAL(245, 32, 32, 0.125f,   0.0f,    PARAM_TOTAL_DISTANCE),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(244,  0, 32, 0.125f,   0.0f,    PARAM_NONE),
+};
+
+// PGN 65253 - HOURS - Engine Hours, Revolutions
+static const j1939_signal_t hours_signals[] = {
+    J1939_SIGNAL(247,  0, 32, 0.05f,    0.0f,    PARAM_ENGINE_HOURS),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(249, 32, 32, 1000.0f,  0.0f,    PARAM_NONE),
+};
+
+// PGN 65262 - ET1 - Engine Temperature 1
+static const j1939_signal_t et1_signals[] = {
+    J1939_SIGNAL(110,  0,  8, 1.0f,     -40.0f,  PARAM_COOLANT_TEMP),
+    J1939_SIGNAL(174,  8,  8, 1.0f,     -40.0f,  PARAM_FUEL_TEMP),
+    J1939_SIGNAL(175, 16, 16, 0.03125f, -273.0f, PARAM_OIL_TEMP),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(176, 32, 16, 0.03125f, -273.0f, PARAM_NONE),
+    J1939_SIGNAL(52,  48,  8, 1.0f,     -40.0f,  PARAM_NONE),
+    J1939_SIGNAL(1134, 56,  8, 0.4f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65263 - EFLP1 - Engine Fluid Level/Pressure 1
+static const j1939_signal_t eflp1_signals[] = {
+    J1939_SIGNAL(100, 24,  8, 4.0f,     0.0f,    PARAM_OIL_PRESSURE),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(94,   0,  8, 4.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(98,  16,  8, 0.4f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(109, 32,  8, 2.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(111, 56,  8, 0.4f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65265 - CCVS - Cruise Control/Vehicle Speed
+static const j1939_signal_t ccvs_signals[] = {
+    J1939_SIGNAL(70,   2,  2, 1.0f,     0.0f,    PARAM_PARKING_BRAKE),
+    J1939_SIGNAL(84,   8, 16, 0.00390625f, 0.0f, PARAM_VEHICLE_SPEED),
+    J1939_SIGNAL(595, 24,  2, 1.0f,     0.0f,    PARAM_CRUISE_ACTIVE),
+    J1939_SIGNAL(597, 28,  2, 1.0f,     0.0f,    PARAM_BRAKE_SWITCH),
+    J1939_SIGNAL(86,  40,  8, 1.0f,     0.0f,    PARAM_CRUISE_CONTROL_SPEED),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(69,   0,  2, 1.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(596, 26,  2, 1.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(598, 30,  2, 1.0f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65266 - LFE - Fuel Economy (Liquid)
+static const j1939_signal_t lfe_signals[] = {
+    J1939_SIGNAL(183,  0, 16, 0.05f,    0.0f,    PARAM_FUEL_RATE),
+    J1939_SIGNAL(184, 16, 16, 0.001953125f, 0.0f, PARAM_FUEL_ECONOMY_INST),
+    J1939_SIGNAL(185, 32, 16, 0.001953125f, 0.0f, PARAM_FUEL_ECONOMY_AVG),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(51,  48,  8, 0.4f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65269 - AMB - Ambient Conditions
+static const j1939_signal_t amb_signals[] = {
+    J1939_SIGNAL(108,  0,  8, 0.5f,     0.0f,    PARAM_BAROMETRIC_PRESSURE),
+    J1939_SIGNAL(170,  8, 16, 0.03125f, -273.0f, PARAM_CAB_TEMP),
+    J1939_SIGNAL(171, 24, 16, 0.03125f, -273.0f, PARAM_AMBIENT_TEMP),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(172, 40,  8, 1.0f,     -40.0f,  PARAM_NONE),
+    J1939_SIGNAL(79,  48, 16, 0.03125f, -273.0f, PARAM_NONE),
+};
+
+// PGN 65270 - IC1 - Intake/Exhaust Conditions 1
+static const j1939_signal_t ic1_signals[] = {
+    J1939_SIGNAL(102,  8,  8, 2.0f,     0.0f,    PARAM_BOOST_PRESSURE),
+    J1939_SIGNAL(105, 16,  8, 1.0f,     -40.0f,  PARAM_INTAKE_TEMP),
+    J1939_SIGNAL(173, 40, 16, 0.03125f, -273.0f, PARAM_EXHAUST_TEMP),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(81,   0,  8, 0.5f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(106, 24,  8, 2.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(107, 32,  8, 0.05f,    0.0f,    PARAM_NONE),
+    J1939_SIGNAL(112, 56,  8, 0.5f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65271 - VEP1 - Vehicle Electrical Power 1
+static const j1939_signal_t vep1_signals[] = {
+    J1939_SIGNAL(115,  8,  8, 1.0f,     0.0f,    PARAM_ALTERNATOR_CURRENT),
+    J1939_SIGNAL(167, 32, 16, 0.05f,    0.0f,    PARAM_CHARGING_VOLTAGE),
+    J1939_SIGNAL(168, 48, 16, 0.05f,    0.0f,    PARAM_BATTERY_VOLTAGE),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(114,  0,  8, 1.0f,     -125.0f, PARAM_NONE),
+};
+
+// PGN 65272 - TRF1 - Transmission Fluids 1
+static const j1939_signal_t trf1_signals[] = {
+    J1939_SIGNAL(127, 24,  8, 16.0f,    0.0f,    PARAM_TRANS_OIL_PRESSURE),
+    J1939_SIGNAL(177, 32, 16, 0.03125f, -273.0f, PARAM_TRANS_OIL_TEMP),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(123,  0,  8, 16.0f,    0.0f,    PARAM_NONE),
+    J1939_SIGNAL(124,  8,  8, 0.4f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(126, 16,  8, 2.0f,     0.0f,    PARAM_NONE),
+};
+
+// PGN 65276 - DD - Dash Display
+static const j1939_signal_t dd_signals[] = {
+    J1939_SIGNAL(96,   8,  8, 0.4f,     0.0f,    PARAM_FUEL_LEVEL_1),
+    J1939_SIGNAL(38,  48,  8, 0.4f,     0.0f,    PARAM_FUEL_LEVEL_2),
+    // On demand only (j1939_decode_spn)
+    J1939_SIGNAL(80,   0,  8, 0.4f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(95,  16,  8, 2.0f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(99,  24,  8, 0.5f,     0.0f,    PARAM_NONE),
+    J1939_SIGNAL(169, 32, 16, 0.03125f, -273.0f, PARAM_NONE),
+};
+
+#define SIGNALS(arr) arr, SIGNAL_COUNT(arr)
+#define NO_SIGNALS   NULL, 0
+
+#define FROM_ENGINE         J1939_FUNCTION_ENGINE
+#define FROM_TRANSMISSION   J1939_FUNCTION_TRANSMISSION
+#define FROM_ANY            J1939_FUNCTION_ANY
+
+// Sorted by PGN. Cycle times are the *_CYCLE_MS generated from
+// j1939_heavy_duty.dbc (GenMsgCycleTime), DM1's per J1939-73 (1 s while
+// faults are active). Senders only where the
+// PGN has one owner on every truck; CCVS, VD, AMB, VEP1 and DD come from
+// the engine on some and a cab or body controller on others.
+static const j1939_pgn_desc_t pgn_table[] = {
+    { 59904, "RQST - Request",                                    0,              FROM_ANY,           NO_SIGNALS },
+    { 60160, "TP.DT - Transport Protocol Data Transfer",          0,              FROM_ANY,           NO_SIGNALS },
+    { 60416, "TP.CM - Transport Protocol Connection Management",  0,              FROM_ANY,           NO_SIGNALS },
+    { 60928, "ACL - Address Claimed",                             0,              FROM_ANY,           NO_SIGNALS },
+    { 61442, "ETC1 - Electronic Transmission Controller 1",       ETC1_CYCLE_MS,  FROM_TRANSMISSION,  SIGNALS(etc1_signals) },
+    { 61443, "EEC2 - Electronic Engine Controller 2",             EEC2_CYCLE_MS,  FROM_ENGINE,        SIGNALS(eec2_signals) },
+    { 61444, "EEC1 - Electronic Engine Controller 1",             EEC1_CYCLE_MS,  FROM_ENGINE,        SIGNALS(eec1_signals) },
+    { 61445, "ETC2 - Electronic Transmission Controller 2",       ETC2_CYCLE_MS,  FROM_TRANSMISSION,  SIGNALS(etc2_signals) },
+    { 65217, "VD - Vehicle Distance",                             VD_CYCLE_MS,    FROM_ANY,           SIGNALS(vd_signals) },
+    { 65226, "DM1 - Active Diagnostic Trouble Codes",             1000,           FROM_ANY,           NO_SIGNALS },
+    { 65227, "DM2 - Previously Active DTCs",                      0,              FROM_ANY,           NO_SIGNALS },
+    { 65253, "HOURS - Engine Hours, Revolutions",                 HOURS_CYCLE_MS, FROM_ENGINE,        SIGNALS(hours_signals) },
+    { 65262, "ET1 - Engine Temperature 1",                        ET1_CYCLE_MS,   FROM_ENGINE,        SIGNALS(et1_signals) },
+    { 65263, "EFLP1 - Engine Fluid Level/Pressure 1",             EFLP1_CYCLE_MS, FROM_ENGINE,        SIGNALS(eflp1_signals) },
+    { 65265, "CCVS - Cruise Control/Vehicle Speed",               CCVS_CYCLE_MS,  FROM_ANY,           SIGNALS(ccvs_signals) },
+    { 65266, "LFE - Fuel Economy",                                LFE_CYCLE_MS,   FROM_ENGINE,        SIGNALS(lfe_signals) },
+    { 65269, "AMB - Ambient Conditions",                          AMB_CYCLE_MS,   FROM_ANY,           SIGNALS(amb_signals) },
+    { 65270, "IC1 - Intake/Exhaust Conditions 1",                 IC1_CYCLE_MS,   FROM_ENGINE,        SIGNALS(ic1_signals) },
+    { 65271, "VEP1 - Vehicle Electrical Power 1",                 VEP1_CYCLE_MS,  FROM_ANY,           SIGNALS(vep1_signals) },
+    { 65272, "TRF1 - Transmission Fluids 1",                      TRF1_CYCLE_MS,  FROM_TRANSMISSION,  SIGNALS(trf1_signals) },
+    { 65276, "DD - Dash Display",                                 DD_CYCLE_MS,    FROM_ANY,           SIGNALS(dd_signals) },
+};
+
+#define PGN_TABLE_COUNT (sizeof(pgn_table) / sizeof(pgn_table[0]))
+
+/*===========================================================================*/
+/*                        PGN DISPATCH INDEX                                */
+/*===========================================================================*/
+
+// Level 1: (DP << 8 | PF) -> page. Page 0 is all-empty so misses need no branch.
+static uint8_t pf_pages[512];
+
+// Level 2: PS -> descriptor index + 1 (0 = unknown)
+static uint8_t page_slots[J1939_PGN_INDEX_MAX_PAGES + 1][256];
+
+static bool index_ready = false;
+
+bool j1939_pgn_index_init(void) {
+    uint8_t pages_used = 0;
+    bool complete = true;
+
+    memset(pf_pages, 0, sizeof(pf_pages));
+    memset(page_slots, 0, sizeof(page_slots));
+
+    for (uint16_t i = 0; i < PGN_TABLE_COUNT; i++) {
+        uint32_t pgn = pgn_table[i].pgn;
+        uint16_t key = (uint16_t)((pgn >> 8) & 0x1FF);  // DP + PF
+
+        if (pf_pages[key] == 0) {
+            if (pages_used >= J1939_PGN_INDEX_MAX_PAGES) {
+                complete = false;  // Out of pages - raise J1939_PGN_INDEX_MAX_PAGES
+                continue;
+            }
+            pf_pages[key] = ++pages_used;
+        }
+
+        page_slots[pf_pages[key]][pgn & 0xFF] = (uint8_t)(i + 1);
+    }
+
+    index_ready = true;
+    return complete;
+}
+
+const j1939_pgn_desc_t* j1939_decoder_find_pgn(uint32_t pgn) {
+    if (!index_ready) j1939_pgn_index_init();
+    if (pgn > 0x1FFFF) return NULL;  // EDP set - not indexed
+
+    uint8_t slot = page_slots[pf_pages[pgn >> 8]][pgn & 0xFF];
+    return (slot != 0) ? &pgn_table[slot - 1] : NULL;
+}
+
+const j1939_pgn_desc_t* j1939_decoder_get_pgns(uint16_t* count) {
+    if (count != NULL) {
+        *count = PGN_TABLE_COUNT;
+    }
+    return pgn_table;
+}
+
+/*===========================================================================*/
+/*                        SPN INDEX                                         */
+/*===========================================================================*/
+
+// Sorted by SPN for binary search; test_j1939_decoder checks it against the
+// signal tables above, so keep it in step when adding signals.
+static const j1939_spn_entry_t spn_index[] = {
+    { 29,   61443, &eec2_signals[3] },
+    { 38,   65276, &dd_signals[1] },
+    { 51,   65266, &lfe_signals[3] },
+    { 52,   65262, &et1_signals[4] },
+    { 69,   65265, &ccvs_signals[5] },
+    { 70,   65265, &ccvs_signals[0] },
+    { 79,   65269, &amb_signals[4] },
+    { 80,   65276, &dd_signals[2] },
+    { 81,   65270, &ic1_signals[3] },
+    { 84,   65265, &ccvs_signals[1] },
+    { 86,   65265, &ccvs_signals[4] },
+    { 91,   61443, &eec2_signals[0] },
+    { 92,   61443, &eec2_signals[1] },
+    { 94,   65263, &eflp1_signals[1] },
+    { 95,   65276, &dd_signals[3] },
+    { 96,   65276, &dd_signals[0] },
+    { 98,   65263, &eflp1_signals[2] },
+    { 99,   65276, &dd_signals[4] },
+    { 100,  65263, &eflp1_signals[0] },
+    { 102,  65270, &ic1_signals[0] },
+    { 105,  65270, &ic1_signals[1] },
+    { 106,  65270, &ic1_signals[4] },
+    { 107,  65270, &ic1_signals[5] },
+    { 108,  65269, &amb_signals[0] },
+    { 109,  65263, &eflp1_signals[3] },
+    { 110,  65262, &et1_signals[0] },
+    { 111,  65263, &eflp1_signals[4] },
+    { 112,  65270, &ic1_signals[6] },
+    { 114,  65271, &vep1_signals[3] },
+    { 115,  65271, &vep1_signals[0] },
+    { 123,  65272, &trf1_signals[2] },
+    { 124,  65272, &trf1_signals[3] },
+    { 126,  65272, &trf1_signals[4] },
+    { 127,  65272, &trf1_signals[0] },
+    { 161,  61442, &etc1_signals[2] },
+    { 167,  65271, &vep1_signals[1] },
+    { 168,  65271, &vep1_signals[2] },
+    { 169,  65276, &dd_signals[5] },
+    { 170,  65269, &amb_signals[1] },
+    { 171,  65269, &amb_signals[2] },
+    { 172,  65269, &amb_signals[3] },
+    { 173,  65270, &ic1_signals[2] },
+    { 174,  65262, &et1_signals[1] },
+    { 175,  65262, &et1_signals[2] },
+    { 176,  65262, &et1_signals[3] },
+    { 177,  65272, &trf1_signals[1] },
+    { 183,  65266, &lfe_signals[0] },
+    { 184,  65266, &lfe_signals[1] },
+    { 185,  65266, &lfe_signals[2] },
+    { 190,  61444, &eec1_signals[1] },
+    { 191,  61442, &etc1_signals[0] },
+    { 244,  65217, &vd_signals[1] },
+    { 245,  65217, &vd_signals[0] },
+    { 247,  65253, &hours_signals[0] },
+    { 249,  65253, &hours_signals[1] },
+    { 512,  61444, &eec1_signals[3] },
+    { 513,  61444, &eec1_signals[0] },
+    { 522,  61442, &etc1_signals[1] },
+    { 523,  61445, &etc2_signals[2] },
+    { 524,  61445, &etc2_signals[0] },
+    { 526,  61445, &etc2_signals[1] },
+    { 595,  65265, &ccvs_signals[2] },
+    { 596,  65265, &ccvs_signals[6] },
+    { 597,  65265, &ccvs_signals[3] },
+    { 598,  65265, &ccvs_signals[7] },
+    { 899,  61444, &eec1_signals[2] },
+    { 974,  61443, &eec2_signals[2] },
+    { 1134, 65262, &et1_signals[5] },
+    { 1482, 61442, &etc1_signals[3] },
+    { 1483, 61444, &eec1_signals[4] },
+    { 1675, 61444, &eec1_signals[5] },
+};
+
+#define SPN_INDEX_COUNT (sizeof(spn_index) / sizeof(spn_index[0]))
+
+const j1939_spn_entry_t* j1939_decoder_find_spn(uint16_t spn) {
+    uint16_t low = 0;
+    uint16_t high = SPN_INDEX_COUNT;
+
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (spn_index[mid].spn < spn) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < SPN_INDEX_COUNT && spn_index[low].spn == spn) {
+        return &spn_index[low];
+    }
+    return NULL;
+}
+
+const j1939_spn_entry_t* j1939_decoder_get_spns(uint16_t* count) {
+    if (count != NULL) {
+        *count = SPN_INDEX_COUNT;
+    }
+    return spn_index;
+}
+
+/*===========================================================================*/
+/*                        SIGNAL EXTRACTION                                 */
+/*===========================================================================*/
+
+uint64_t j1939_decoder_load_payload(const uint8_t* data, uint8_t data_length) {
+    uint64_t payload = 0;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // Full frame on a little-endian core (ESP32, x86): a single copy
+    if (data_length >= J1939_MAX_DATA_LENGTH) {
+        memcpy(&payload, data, sizeof(payload));
+        return payload;
+    }
+#endif
+
+    for (uint8_t i = 0; i < J1939_MAX_DATA_LENGTH; i++) {
+        uint8_t byte = (i < data_length) ? data[i] : J1939_NOT_AVAILABLE_8;
+        payload |= (uint64_t)byte << (i * 8);
+    }
+
+    return payload;
+}
+
+uint8_t j1939_decode_signals(const j1939_message_t* msg,
+                             j1939_signal_value_t* values, uint8_t max_values) {
+    if (msg == NULL || values == NULL) return 0;
+
+    const j1939_pgn_desc_t* entry = j1939_decoder_find_pgn(msg->pgn);
+    if (entry == NULL || entry->signal_count == 0) return 0;
+
+    uint64_t payload = j1939_decoder_load_payload(msg->data, msg->data_length);
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < entry->signal_count && count < max_values; i++) {
+        const j1939_signal_t* sig = &entry->signals[i];
+        if (sig->param_id == PARAM_NONE) break;  // On-demand signals follow
+
+        uint32_t raw = j1939_signal_extract_raw(payload, sig);
+
+        if (raw >= sig->raw_limit) continue;  // Error or not available
+
+        values[count].param_id = sig->param_id;
+        values[count].value = j1939_signal_to_physical(raw, sig);
+        count++;
+    }
+
+    return count;
+}
+
+uint8_t j1939_decoder_process(const j1939_message_t* msg, data_manager_t* dm,
+                              data_source_t source) {
+    if (dm == NULL || msg == NULL) return 0;
+
+    const j1939_pgn_desc_t* entry = j1939_decoder_find_pgn(msg->pgn);
+    if (entry == NULL || entry->signal_count == 0) return 0;
+
+    uint64_t payload = j1939_decoder_load_payload(msg->data, msg->data_length);
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < entry->signal_count; i++) {
+        const j1939_signal_t* sig = &entry->signals[i];
+        if (sig->param_id == PARAM_NONE) break;  // On-demand signals follow
+
+        uint32_t raw = j1939_signal_extract_raw(payload, sig);
+        if (raw >= sig->raw_limit) continue;  // Error or not available
+
+        data_manager_update_raw_us(dm, sig->param_id, raw, &sig->scaling, source,
+                                   msg->timestamp_us);
+        count++;
+    }
+
+    return count;
+}
+
+bool j1939_decode_spn(const j1939_message_t* msg, uint16_t spn, float* value) {
+    if (msg == NULL || value == NULL) return false;
+
+    const j1939_spn_entry_t* entry = j1939_decoder_find_spn(spn);
+    if (entry == NULL || entry->pgn != msg->pgn) return false;
+
+    uint64_t payload = j1939_decoder_load_payload(msg->data, msg->data_length);
+    uint32_t raw = j1939_signal_extract_raw(payload, entry->signal);
+    if (raw >= entry->signal->raw_limit) return false;  // Error or not available
+
+    *value = j1939_signal_to_physical(raw, entry->signal);
+    return true;
+}
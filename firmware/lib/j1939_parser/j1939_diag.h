@@ -0,0 +1,232 @@
+/**
+ * @file j1939_diag.h
+ * @brief DM2 / DM4 capture jobs for newly active faults
+ *
+ * When an ECU reports a new fault, a capture job asks it for DM2
+ * (previously active DTCs) and DM4 (freeze frames) through the request
+ * scheduler. Replies, single frame or reassembled TP, are copied into the
+ * job as raw bytes; that copy is all the decode task does. A job that has
+ * both replies, or whose time ran out, is handed to a background task
+ * (j1939_diag_take()), which parses and stores it.
+ *
+ * A DM2 with faults that no capture is waiting for (an answer to the
+ * periodic global DM2 request) is handed over the same way, as a job with
+ * only its DM2.
+ *
+ * Freeze frame snapshots are kept raw (8 bytes of standard parameters) and
+ * decoded on demand through the decoder's SPN index, so they store compactly
+ * and decode exactly like the live signals.
+ */
+
+#ifndef J1939_DIAG_H
+#define J1939_DIAG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+#include "j1939_request.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_DIAG_MAX_JOBS
+#define J1939_DIAG_MAX_JOBS         4       // ECUs captured at the same time
+#endif
+
+#ifndef J1939_DIAG_BUFFER
+#define J1939_DIAG_BUFFER           128     // Bytes kept per DM2 / DM4 reply
+#endif
+
+#ifndef J1939_DIAG_TIMEOUT_MS
+#define J1939_DIAG_TIMEOUT_MS       10000   // A job completes with what it has after this
+#endif
+
+#if J1939_REQUEST_MAX_ENTRIES < 2 * J1939_DIAG_MAX_JOBS
+#error "J1939_REQUEST_MAX_ENTRIES must hold the DM2 and DM4 requests of every capture job"
+#endif
+
+/*===========================================================================*/
+/*                        CONSTANTS                                         */
+/*===========================================================================*/
+
+#ifndef PGN_DM2
+#define PGN_DM2                     65227       // 0xFECB - Previously Active DTCs
+#endif
+
+#ifndef PGN_DM4
+#define PGN_DM4                     65229       // 0xFECD - Freeze Frame Parameters
+#endif
+
+#define J1939_FREEZE_FRAME_SNAPSHOT 8       // Standard parameter bytes after the DTC
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief One DM4 freeze frame
+ *
+ * Snapshot bytes per J1939-73: torque mode (SPN 899), boost (102), engine
+ * speed (190, 2 bytes), percent load (92), coolant temperature (110),
+ * wheel-based vehicle speed (84, 2 bytes). Manufacturer-specific bytes
+ * that follow are not kept.
+ */
+typedef struct {
+    j1939_dtc_t dtc;                                // Fault the frame belongs to
+    uint8_t snapshot_length;                        // Valid snapshot bytes
+    uint8_t snapshot[J1939_FREEZE_FRAME_SNAPSHOT];  // Raw standard parameters
+} j1939_freeze_frame_t;
+
+typedef enum {
+    J1939_DIAG_FREE = 0,        // Slot unused
+    J1939_DIAG_WAITING,         // Owned by the decode task, replies outstanding
+    J1939_DIAG_DONE             // Owned by the background task
+} j1939_diag_state_t;
+
+/**
+ * @brief Capture of one ECU's DM2 and DM4
+ */
+typedef struct {
+    uint8_t state;              // j1939_diag_state_t (handed over atomically)
+    uint8_t source_address;     // ECU captured
+    bool dm2_received;
+    bool dm4_received;
+    bool dm2_requested;         // DM2 request registered with the scheduler
+    bool dm4_requested;         // DM4 request registered with the scheduler
+    uint16_t dm2_length;        // Bytes kept in dm2
+    uint16_t dm4_length;        // Bytes kept in dm4
+    uint64_t started_us;        // Time the new fault was seen
+    uint64_t completed_us;      // Time of the last reply (or the timeout)
+    uint8_t dm2[J1939_DIAG_BUFFER];
+    uint8_t dm4[J1939_DIAG_BUFFER];
+} j1939_diag_job_t;
+
+/**
+ * @brief Capture counters
+ */
+typedef struct {
+    uint32_t started;           // Jobs started
+    uint32_t coalesced;         // New faults of an ECU already being captured
+    uint32_t dropped;           // New faults or unsolicited DM2 with no free job
+    uint32_t unrequested;       // Captures refused: the request table was full
+    uint32_t unsolicited;       // DM2 with faults handed over without a capture
+    uint32_t completed;         // Jobs with both replies
+    uint32_t incomplete;        // Jobs that timed out missing a reply
+    uint32_t truncated;         // Replies longer than J1939_DIAG_BUFFER
+} j1939_diag_stats_t;
+
+/**
+ * @brief Capture jobs
+ */
+typedef struct {
+    j1939_diag_job_t jobs[J1939_DIAG_MAX_JOBS];
+    j1939_request_sched_t* requests;    // Scheduler the DM2 / DM4 requests go through
+    j1939_diag_stats_t stats;
+} j1939_diag_t;
+
+/*===========================================================================*/
+/*                        CAPTURE (DECODE TASK)                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize capture jobs
+ * @param diag Jobs to initialize
+ * @param requests Request scheduler for DM2 / DM4, or NULL (replies are only
+ *                 captured when another device asks)
+ */
+void j1939_diag_init(j1939_diag_t* diag, j1939_request_sched_t* requests);
+
+/**
+ * @brief Start capturing an ECU that reported a new fault
+ * @param diag Jobs
+ * @param source_address ECU
+ * @param now_us Current time
+ * @return true if a job is running for the ECU (new or already running);
+ *         false if no job is free or its DM2 / DM4 requests did not fit the
+ *         scheduler's table
+ */
+bool j1939_diag_capture(j1939_diag_t* diag, uint8_t source_address, uint64_t now_us);
+
+/**
+ * @brief Offer a received parameter group to the running jobs
+ * @param diag Jobs
+ * @param pgn PGN (only DM2 and DM4 are taken)
+ * @param source_address Sender
+ * @param data Payload
+ * @param len Payload length
+ * @param timestamp_us Receive time
+ * @return true if a job took the payload, or an unsolicited DM2 with
+ *         faults was handed over
+ */
+bool j1939_diag_payload(j1939_diag_t* diag, uint32_t pgn, uint8_t source_address,
+                        const uint8_t* data, uint16_t len, uint64_t timestamp_us);
+
+/**
+ * @brief Complete jobs that waited J1939_DIAG_TIMEOUT_MS
+ * @param diag Jobs
+ * @param now_us Current time
+ */
+void j1939_diag_poll(j1939_diag_t* diag, uint64_t now_us);
+
+/*===========================================================================*/
+/*                        RESULTS (BACKGROUND TASK)                         */
+/*===========================================================================*/
+
+/**
+ * @brief Take a completed job, freeing its slot
+ * @param diag Jobs
+ * @param job Output: copy of the job
+ * @return true if a job was taken
+ */
+bool j1939_diag_take(j1939_diag_t* diag, j1939_diag_job_t* job);
+
+/**
+ * @brief Parse a DM4 payload into freeze frames
+ * @param data DM4 payload (records of length byte, DTC, parameters)
+ * @param len Payload length
+ * @param frames Output array
+ * @param max_frames Capacity of frames
+ * @return Number of freeze frames parsed
+ */
+uint8_t j1939_parse_dm4(const uint8_t* data, uint16_t len,
+                        j1939_freeze_frame_t* frames, uint8_t max_frames);
+
+/**
+ * @brief Decode a standard parameter from a freeze frame snapshot
+ *
+ * Scale, offset and validity come from the decoder's signal table for the
+ * SPN; only the position is freeze-frame specific.
+ *
+ * @param snapshot Raw snapshot bytes
+ * @param snapshot_length Valid bytes (missing bytes read as not available)
+ * @param spn One of the SPNs listed by j1939_freeze_frame_get_spns()
+ * @param value Output: physical value
+ * @return true if the SPN is in the snapshot and holds a valid value
+ */
+bool j1939_freeze_frame_decode(const uint8_t* snapshot, uint8_t snapshot_length,
+                               uint16_t spn, float* value);
+
+/**
+ * @brief SPNs of the standard freeze frame parameters, in snapshot order
+ * @param count Output: number of SPNs
+ * @return SPN array
+ */
+const uint16_t* j1939_freeze_frame_get_spns(uint8_t* count);
+
+/**
+ * @brief Get capture counters
+ * @param diag Jobs
+ * @param stats Output: counters
+ */
+void j1939_diag_get_stats(const j1939_diag_t* diag, j1939_diag_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_DIAG_H */
@@ -0,0 +1,166 @@
+/**
+ * @file j1939_dm1.cpp
+ * @brief Per-ECU active fault table implementation
+ */
+
+#include "j1939_dm1.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+/**
+ * @brief FNV-1a over the payload (a repeat check, not a checksum)
+ */
+static uint32_t payload_hash(const uint8_t* data, uint16_t len) {
+    uint32_t hash = 2166136261UL;
+    for (uint16_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool contains_fault(const j1939_dtc_t* dtcs, uint8_t count, const j1939_dtc_t* dtc) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (dtcs[i].spn == dtc->spn && dtcs[i].fmi == dtc->fmi) return true;
+    }
+    return false;
+}
+
+static bool same_lamps(const j1939_lamp_status_t* a, const j1939_lamp_status_t* b) {
+    return a->protect_lamp == b->protect_lamp &&
+           a->amber_warning_lamp == b->amber_warning_lamp &&
+           a->red_stop_lamp == b->red_stop_lamp &&
+           a->malfunction_lamp == b->malfunction_lamp;
+}
+
+static j1939_dm1_ecu_t* find_ecu(j1939_dm1_table_t* table, uint8_t source_address) {
+    for (uint8_t i = 0; i < J1939_DM1_MAX_ECUS; i++) {
+        if (table->ecus[i].used && table->ecus[i].source_address == source_address) {
+            return &table->ecus[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Recompute the table-wide totals after an ECU changed
+ */
+static void update_totals(j1939_dm1_table_t* table) {
+    table->active_count = 0;
+    table->mil = false;
+    for (uint8_t i = 0; i < J1939_DM1_MAX_ECUS; i++) {
+        const j1939_dm1_ecu_t* ecu = &table->ecus[i];
+        if (!ecu->used) continue;
+        table->active_count += ecu->dtc_count;
+        if (ecu->lamps.malfunction_lamp) table->mil = true;
+    }
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_dm1_init(j1939_dm1_table_t* table, j1939_dm1_change_handler_t handler, void* user) {
+    if (table == NULL) return;
+
+    memset(table, 0, sizeof(j1939_dm1_table_t));
+    table->handler = handler;
+    table->user = user;
+}
+
+bool j1939_dm1_process(j1939_dm1_table_t* table, uint8_t source_address,
+                       const uint8_t* data, uint16_t len, uint64_t timestamp_us) {
+    if (table == NULL || data == NULL || len < 2) return false;
+
+    table->stats.messages++;
+
+    bool added = false;
+    j1939_dm1_ecu_t* ecu = find_ecu(table, source_address);
+    if (ecu == NULL) {
+        for (uint8_t i = 0; i < J1939_DM1_MAX_ECUS && ecu == NULL; i++) {
+            if (!table->ecus[i].used) ecu = &table->ecus[i];
+        }
+        if (ecu == NULL) {
+            table->stats.overflow++;
+            return false;
+        }
+        memset(ecu, 0, sizeof(j1939_dm1_ecu_t));
+        ecu->source_address = source_address;
+        ecu->used = true;
+        added = true;
+    }
+    ecu->messages++;
+    ecu->last_us = timestamp_us;
+
+    // The usual case: the same DM1 as a second ago
+    uint32_t hash = payload_hash(data, len);
+    if (!added && hash == ecu->hash && len == ecu->length) {
+        table->stats.repeats++;
+        return false;
+    }
+    ecu->hash = hash;
+    ecu->length = len;
+
+    j1939_lamp_status_t lamps;
+    j1939_dtc_t dtcs[J1939_DM1_MAX_DTCS];
+    uint8_t count = j1939_parse_dm1(data, len, &lamps, dtcs, J1939_DM1_MAX_DTCS);
+    if (count == J1939_DM1_MAX_DTCS && len > 2 + 4 * J1939_DM1_MAX_DTCS) {
+        table->stats.truncated++;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        dtcs[i].source_address = source_address;
+    }
+
+    // Report the difference; occurrence counts alone change nothing
+    bool changed = added || !same_lamps(&lamps, &ecu->lamps);
+    for (uint8_t i = 0; i < ecu->dtc_count; i++) {
+        if (!contains_fault(dtcs, count, &ecu->dtcs[i])) {
+            changed = true;
+            if (table->handler != NULL) table->handler(&ecu->dtcs[i], false, timestamp_us, table->user);
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!contains_fault(ecu->dtcs, ecu->dtc_count, &dtcs[i])) {
+            changed = true;
+            if (table->handler != NULL) table->handler(&dtcs[i], true, timestamp_us, table->user);
+        }
+    }
+
+    memcpy(ecu->dtcs, dtcs, count * sizeof(j1939_dtc_t));
+    ecu->dtc_count = count;
+    ecu->lamps = lamps;
+    if (!changed) return false;
+
+    ecu->changes++;
+    table->stats.changes++;
+    update_totals(table);
+    return true;
+}
+
+bool j1939_dm1_forget(j1939_dm1_table_t* table, uint8_t source_address, uint64_t timestamp_us) {
+    if (table == NULL) return false;
+
+    j1939_dm1_ecu_t* ecu = find_ecu(table, source_address);
+    if (ecu == NULL) return false;
+
+    for (uint8_t i = 0; i < ecu->dtc_count && table->handler != NULL; i++) {
+        table->handler(&ecu->dtcs[i], false, timestamp_us, table->user);
+    }
+    ecu->used = false;
+    update_totals(table);
+    return true;
+}
+
+const j1939_dm1_ecu_t* j1939_dm1_find(const j1939_dm1_table_t* table, uint8_t source_address) {
+    if (table == NULL) return NULL;
+
+    return find_ecu((j1939_dm1_table_t*)table, source_address);
+}
+
+void j1939_dm1_get_stats(const j1939_dm1_table_t* table, j1939_dm1_stats_t* stats) {
+    if (table == NULL || stats == NULL) return;
+
+    *stats = table->stats;
+}
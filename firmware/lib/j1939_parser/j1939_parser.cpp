@@ -5,11 +5,11 @@
  * Implements decoding of J1939 CAN messages including:
  * - PGN extraction from 29-bit CAN IDs
  * - SPN value decoding with scaling/offset
- * - Transport Protocol (BAM) reassembly
  * - DM1/DM2 diagnostic message parsing
  */
 
 #include "j1939_parser.h"
+#include "j1939_decoder.h"
 #include <string.h>
 
 #ifndef NATIVE_BUILD
@@ -30,10 +30,15 @@ void j1939_parser_init(j1939_parser_context_t* ctx) {
     
     memset(ctx, 0, sizeof(j1939_parser_context_t));
     
-    // Initialize all TP sessions to idle
+    // Initialize all TP sessions to idle (j1939_tp.cpp)
     for (int i = 0; i < J1939_MAX_ACTIVE_TP; i++) {
         ctx->tp_sessions[i].state = TP_STATE_IDLE;
+        ctx->tp_sessions[i].wheel_slot = 0xFF;  // Not on the timer wheel
     }
+    ctx->tp_local_address = J1939_NULL_ADDRESS;  // BAM only until an address is set
+
+    // Build the PGN dispatch index before any task starts decoding
+    j1939_pgn_index_init();
 }
 
 /*===========================================================================*/
@@ -91,6 +96,11 @@ uint32_t j1939_build_can_id(uint32_t pgn, uint8_t source_address, uint8_t priori
 
 bool j1939_parse_frame(uint32_t can_id, const uint8_t* data, uint8_t data_len,
                        uint32_t timestamp_ms, j1939_message_t* msg) {
+    return j1939_parse_frame_us(can_id, data, data_len, (uint64_t)timestamp_ms * 1000ULL, msg);
+}
+
+bool j1939_parse_frame_us(uint32_t can_id, const uint8_t* data, uint8_t data_len,
+                          uint64_t timestamp_us, j1939_message_t* msg) {
     if (data == NULL || msg == NULL || data_len == 0 || data_len > 8) {
         return false;
     }
@@ -100,7 +110,8 @@ bool j1939_parse_frame(uint32_t can_id, const uint8_t* data, uint8_t data_len,
     msg->priority = j1939_extract_priority(can_id);
     msg->destination = j1939_extract_destination(can_id);
     msg->data_length = data_len;
-    msg->timestamp_ms = timestamp_ms;
+    msg->timestamp_us = timestamp_us;
+    msg->timestamp_ms = (uint32_t)(timestamp_us / 1000ULL);
     
     memcpy(msg->data, data, data_len);
     
@@ -271,125 +282,6 @@ float j1939_decode_ambient_temp(const uint8_t* data) {
     return ((float)raw * 0.03125f) - 273.0f;
 }
 
-/*===========================================================================*/
-/*                        TRANSPORT PROTOCOL HANDLING                       */
-/*===========================================================================*/
-
-static tp_session_t* find_tp_session(j1939_parser_context_t* ctx, uint8_t source_address) {
-    for (int i = 0; i < J1939_MAX_ACTIVE_TP; i++) {
-        if (ctx->tp_sessions[i].state != TP_STATE_IDLE &&
-            ctx->tp_sessions[i].source_address == source_address) {
-            return &ctx->tp_sessions[i];
-        }
-    }
-    return NULL;
-}
-
-static tp_session_t* allocate_tp_session(j1939_parser_context_t* ctx) {
-    for (int i = 0; i < J1939_MAX_ACTIVE_TP; i++) {
-        if (ctx->tp_sessions[i].state == TP_STATE_IDLE) {
-            return &ctx->tp_sessions[i];
-        }
-    }
-    return NULL;
-}
-
-bool j1939_tp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
-    if (ctx == NULL || msg == NULL) return false;
-    
-    if (msg->pgn == PGN_TP_CM) {
-        // Transport Protocol Connection Management
-        uint8_t control_byte = msg->data[0];
-        
-        if (control_byte == TP_CM_BAM) {
-            // Broadcast Announce Message - start new session
-            tp_session_t* session = find_tp_session(ctx, msg->source_address);
-            
-            if (session == NULL) {
-                session = allocate_tp_session(ctx);
-            }
-            
-            if (session == NULL) {
-                return false;  // No free sessions
-            }
-            
-            session->state = TP_STATE_RECEIVING;
-            session->source_address = msg->source_address;
-            session->total_size = (uint16_t)msg->data[1] | ((uint16_t)msg->data[2] << 8);
-            session->total_packets = msg->data[3];
-            session->target_pgn = (uint32_t)msg->data[5] | 
-                                  ((uint32_t)msg->data[6] << 8) | 
-                                  ((uint32_t)msg->data[7] << 16);
-            session->received_packets = 0;
-            session->last_packet_time_ms = msg->timestamp_ms;
-            memset(session->buffer, 0xFF, sizeof(session->buffer));
-        }
-    }
-    else if (msg->pgn == PGN_TP_DT) {
-        // Transport Protocol Data Transfer
-        tp_session_t* session = find_tp_session(ctx, msg->source_address);
-        
-        if (session == NULL || session->state != TP_STATE_RECEIVING) {
-            return false;
-        }
-        
-        // Check for timeout
-        if ((msg->timestamp_ms - session->last_packet_time_ms) > J1939_TP_TIMEOUT_MS) {
-            session->state = TP_STATE_ERROR;
-            return false;
-        }
-        
-        uint8_t seq_num = msg->data[0];  // 1-based sequence number
-        
-        // Validate sequence
-        if (seq_num != session->received_packets + 1) {
-            session->state = TP_STATE_ERROR;
-            return false;
-        }
-        
-        // Copy 7 data bytes to buffer
-        uint16_t offset = (seq_num - 1) * 7;
-        for (int i = 0; i < 7 && (offset + i) < session->total_size; i++) {
-            session->buffer[offset + i] = msg->data[1 + i];
-        }
-        
-        session->received_packets++;
-        session->last_packet_time_ms = msg->timestamp_ms;
-        
-        // Check if complete
-        if (session->received_packets >= session->total_packets) {
-            session->state = TP_STATE_COMPLETE;
-            ctx->tp_complete_count++;
-            return true;
-        }
-    }
-    
-    return false;
-}
-
-uint16_t j1939_tp_get_data(j1939_parser_context_t* ctx, uint8_t source_address,
-                           uint32_t* pgn, uint8_t* data, uint16_t max_len) {
-    if (ctx == NULL || data == NULL) return 0;
-    
-    tp_session_t* session = find_tp_session(ctx, source_address);
-    
-    if (session == NULL || session->state != TP_STATE_COMPLETE) {
-        return 0;
-    }
-    
-    if (pgn != NULL) {
-        *pgn = session->target_pgn;
-    }
-    
-    uint16_t copy_len = (session->total_size < max_len) ? session->total_size : max_len;
-    memcpy(data, session->buffer, copy_len);
-    
-    // Reset session for reuse
-    session->state = TP_STATE_IDLE;
-    
-    return copy_len;
-}
-
 /*===========================================================================*/
 /*                        DM1 DIAGNOSTIC MESSAGE PARSING                    */
 /*===========================================================================*/
@@ -448,40 +340,9 @@ uint8_t j1939_parse_dm1(const uint8_t* data, uint16_t len,
 /*                        STRING LOOKUP FUNCTIONS                           */
 /*===========================================================================*/
 
-typedef struct {
-    uint32_t pgn;
-    const char* name;
-} pgn_name_t;
-
-static const pgn_name_t pgn_names[] = {
-    { 61444, "EEC1 - Electronic Engine Controller 1" },
-    { 61443, "EEC2 - Electronic Engine Controller 2" },
-    { 61442, "ETC1 - Electronic Transmission Controller 1" },
-    { 61445, "ETC2 - Electronic Transmission Controller 2" },
-    { 65262, "ET1 - Engine Temperature 1" },
-    { 65263, "EFLP1 - Engine Fluid Level/Pressure 1" },
-    { 65265, "CCVS - Cruise Control/Vehicle Speed" },
-    { 65266, "LFE - Fuel Economy" },
-    { 65269, "AMB - Ambient Conditions" },
-    { 65270, "IC1 - Intake/Exhaust Conditions 1" },
-    { 65271, "VEP1 - Vehicle Electrical Power 1" },
-    { 65272, "TRF1 - Transmission Fluids 1" },
-    { 65276, "DD - Dash Display" },
-    { 65253, "HOURS - Engine Hours, Revolutions" },
-    { 65226, "DM1 - Active Diagnostic Trouble Codes" },
-    { 65227, "DM2 - Previously Active DTCs" },
-    { 60416, "TP.CM - Transport Protocol Connection Management" },
-    { 60160, "TP.DT - Transport Protocol Data Transfer" },
-    { 0, NULL }
-};
-
 const char* j1939_get_pgn_name(uint32_t pgn) {
-    for (int i = 0; pgn_names[i].name != NULL; i++) {
-        if (pgn_names[i].pgn == pgn) {
-            return pgn_names[i].name;
-        }
-    }
-    return "Unknown PGN";
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(pgn);
+    return (desc != NULL) ? desc->name : "Unknown PGN";
 }
 
 static const char* fmi_descriptions[] = {
@@ -0,0 +1,291 @@
+/**
+ * @file j1939_request.cpp
+ * @brief Request scheduler implementation
+ */
+
+#include "j1939_request.h"
+#include <string.h>
+
+#define REQUEST_PRIORITY    6
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+static inline uint64_t pgn_bit(uint32_t pgn) {
+    return 1ULL << (pgn & 63);
+}
+
+static inline bool entry_matches(const j1939_request_entry_t* e, uint32_t pgn, uint8_t source_address) {
+    return e->pgn == pgn &&
+           (e->destination == J1939_GLOBAL_ADDRESS || e->destination == source_address);
+}
+
+/**
+ * @brief Current request period, backoff included (one-shots retry on the answer window)
+ */
+static uint64_t entry_period_us(const j1939_request_entry_t* e) {
+    uint64_t base_ms = (e->period_ms > 0) ? e->period_ms : J1939_REQUEST_TIMEOUT_MS;
+    return (base_ms * 1000ULL) << e->backoff;
+}
+
+static void rebuild_pgn_bits(j1939_request_sched_t* sched) {
+    sched->pgn_bits = 0;
+    for (uint8_t i = 0; i < sched->count; i++) {
+        sched->pgn_bits |= pgn_bit(sched->entries[i].pgn);
+    }
+}
+
+/**
+ * @brief Free the entries of finished one-shot requests
+ */
+static void drop_done(j1939_request_sched_t* sched) {
+    bool dropped = false;
+    uint8_t i = 0;
+    while (i < sched->count) {
+        if (sched->entries[i].done) {
+            sched->entries[i] = sched->entries[--sched->count];
+            dropped = true;
+        } else {
+            i++;
+        }
+    }
+    if (dropped) rebuild_pgn_bits(sched);
+}
+
+/**
+ * @brief A pending request was answered
+ */
+static void entry_answered(j1939_request_sched_t* sched, j1939_request_entry_t* e,
+                           uint64_t timestamp_us) {
+    uint32_t rtt_us = (uint32_t)(timestamp_us - e->sent_us);
+
+    e->rtt_last_us = rtt_us;
+    if (e->answered == 0 || rtt_us < e->rtt_min_us) e->rtt_min_us = rtt_us;
+    if (rtt_us > e->rtt_max_us) e->rtt_max_us = rtt_us;
+    if (e->answered == 0) {
+        e->rtt_avg_us = rtt_us;  // First answer seeds the average
+    } else {
+        int64_t delta = (int64_t)rtt_us - e->rtt_avg_us;
+        e->rtt_avg_us = (uint32_t)(e->rtt_avg_us + (delta >> J1939_REQUEST_RTT_SHIFT));
+    }
+
+    if (sched->stats.answered == 0) {
+        sched->stats.rtt_avg_us = rtt_us;
+    } else {
+        int64_t delta = (int64_t)rtt_us - sched->stats.rtt_avg_us;
+        sched->stats.rtt_avg_us = (uint32_t)(sched->stats.rtt_avg_us + (delta >> J1939_REQUEST_RTT_SHIFT));
+    }
+    if (rtt_us > sched->stats.rtt_max_us) sched->stats.rtt_max_us = rtt_us;
+
+    e->answered++;
+    sched->stats.answered++;
+    e->pending = false;
+    e->backoff = 0;
+    if (e->period_ms == 0) {
+        e->done = true;
+    } else {
+        e->due_us = e->sent_us + entry_period_us(e);  // Keep the cadence of the requests
+    }
+}
+
+/**
+ * @brief A pending request went unanswered (timeout or NACK)
+ */
+static void entry_unanswered(j1939_request_entry_t* e, uint8_t backoff) {
+    e->pending = false;
+    if (e->period_ms == 0 && backoff > J1939_REQUEST_MAX_BACKOFF) {
+        e->done = true;  // One-shot: give up
+        return;
+    }
+    e->backoff = (backoff > J1939_REQUEST_MAX_BACKOFF) ? J1939_REQUEST_MAX_BACKOFF : backoff;
+    e->due_us = e->sent_us + entry_period_us(e);
+}
+
+/**
+ * @brief Is a global request for this PGN already waiting for its answers
+ */
+static bool global_pending(const j1939_request_sched_t* sched, uint32_t pgn) {
+    for (uint8_t i = 0; i < sched->count; i++) {
+        const j1939_request_entry_t* e = &sched->entries[i];
+        if (e->pending && e->pgn == pgn && e->destination == J1939_GLOBAL_ADDRESS) return true;
+    }
+    return false;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_request_init(j1939_request_sched_t* sched, uint8_t source_address,
+                        j1939_tp_send_t send, void* user) {
+    if (sched == NULL) return;
+
+    memset(sched, 0, sizeof(j1939_request_sched_t));
+    sched->source_address = source_address;
+    sched->send = send;
+    sched->send_user = user;
+}
+
+bool j1939_request_add(j1939_request_sched_t* sched, uint32_t pgn, uint8_t destination,
+                       uint32_t period_ms, uint64_t now_us) {
+    if (sched == NULL) return false;
+
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (e->pgn != pgn || e->destination != destination) continue;
+
+        // Shared entry: the most demanding consumer sets the period
+        e->consumers++;
+        if (period_ms > 0 && (e->period_ms == 0 || period_ms < e->period_ms)) {
+            e->period_ms = period_ms;
+            e->done = false;
+            if (!e->pending && e->due_us > now_us + period_ms * 1000ULL) {
+                e->due_us = now_us + period_ms * 1000ULL;
+            }
+        }
+        return true;
+    }
+
+    if (sched->count >= J1939_REQUEST_MAX_ENTRIES) return false;
+
+    j1939_request_entry_t* e = &sched->entries[sched->count++];
+    memset(e, 0, sizeof(j1939_request_entry_t));
+    e->pgn = pgn;
+    e->destination = destination;
+    e->consumers = 1;
+    e->period_ms = period_ms;
+    e->due_us = now_us;
+    sched->pgn_bits |= pgn_bit(pgn);
+    return true;
+}
+
+bool j1939_request_remove(j1939_request_sched_t* sched, uint32_t pgn, uint8_t destination) {
+    if (sched == NULL) return false;
+
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (e->pgn != pgn || e->destination != destination) continue;
+
+        if (--e->consumers == 0) {
+            sched->entries[i] = sched->entries[--sched->count];
+            rebuild_pgn_bits(sched);
+        }
+        return true;
+    }
+    return false;
+}
+
+void j1939_request_poll(j1939_request_sched_t* sched, uint64_t now_us) {
+    if (sched == NULL) return;
+
+    // Expire unanswered requests
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (e->pending && now_us - e->sent_us >= J1939_REQUEST_TIMEOUT_MS * 1000ULL) {
+            e->timeouts++;
+            sched->stats.timeouts++;
+            entry_unanswered(e, e->backoff + 1);
+        }
+    }
+    drop_done(sched);
+
+    if (sched->send == NULL || now_us < sched->next_tx_us) return;
+
+    // One request per gap: the most overdue entry goes first
+    j1939_request_entry_t* next = NULL;
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (e->pending || e->done || e->due_us > now_us) continue;
+
+        if (e->destination != J1939_GLOBAL_ADDRESS && global_pending(sched, e->pgn)) {
+            // The global request's answers cover this ECU too
+            e->due_us = now_us + entry_period_us(e);
+            sched->stats.coalesced++;
+            continue;
+        }
+        if (next == NULL || e->due_us < next->due_us) next = e;
+    }
+    if (next == NULL) return;
+
+    uint8_t data[3] = {
+        (uint8_t)next->pgn,
+        (uint8_t)(next->pgn >> 8),
+        (uint8_t)(next->pgn >> 16)
+    };
+    uint32_t can_id = j1939_build_can_id(PGN_REQUEST | next->destination,
+                                         sched->source_address, REQUEST_PRIORITY);
+
+    sched->next_tx_us = now_us + J1939_REQUEST_GAP_MS * 1000ULL;
+    if (!sched->send(can_id, data, sizeof(data), sched->send_user)) {
+        sched->stats.tx_failed++;  // Still due; retried after the gap
+        return;
+    }
+
+    next->pending = true;
+    next->sent_us = now_us;
+    next->sent++;
+    sched->stats.sent++;
+}
+
+void j1939_request_frame(j1939_request_sched_t* sched, uint32_t pgn, uint8_t source_address,
+                         uint64_t timestamp_us) {
+    if (sched == NULL || (sched->pgn_bits & pgn_bit(pgn)) == 0) return;
+
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (!entry_matches(e, pgn, source_address)) continue;
+
+        if (e->pending && timestamp_us >= e->sent_us) {
+            entry_answered(sched, e, timestamp_us);
+            continue;
+        }
+
+        // Sent without being asked: no need to ask for a while
+        e->unsolicited++;
+        if (e->pending || e->done) continue;
+        if (e->period_ms == 0) {
+            e->done = true;
+        } else if (e->due_us < timestamp_us + entry_period_us(e)) {
+            e->due_us = timestamp_us + entry_period_us(e);
+        }
+    }
+    drop_done(sched);
+}
+
+void j1939_request_ack(j1939_request_sched_t* sched, uint8_t source_address,
+                       const uint8_t* data, uint8_t len, uint64_t timestamp_us) {
+    if (sched == NULL || data == NULL || len < 8) return;
+
+    uint32_t pgn = (uint32_t)data[5] | ((uint32_t)data[6] << 8) | ((uint32_t)(data[7] & 0x03) << 16);
+    if ((sched->pgn_bits & pgn_bit(pgn)) == 0) return;
+
+    for (uint8_t i = 0; i < sched->count; i++) {
+        j1939_request_entry_t* e = &sched->entries[i];
+        if (!e->pending || !entry_matches(e, pgn, source_address)) continue;
+
+        if (data[0] == J1939_ACK_POSITIVE) {
+            entry_answered(sched, e, timestamp_us);
+        } else {
+            // Not supported (or not now): ask again only rarely
+            e->nacks++;
+            sched->stats.nacks++;
+            entry_unanswered(e, J1939_REQUEST_MAX_BACKOFF);
+        }
+    }
+    drop_done(sched);
+}
+
+bool j1939_request_get_entry(const j1939_request_sched_t* sched, uint8_t index,
+                             j1939_request_entry_t* entry) {
+    if (sched == NULL || entry == NULL || index >= sched->count) return false;
+
+    *entry = sched->entries[index];
+    return true;
+}
+
+void j1939_request_get_stats(const j1939_request_sched_t* sched, j1939_request_stats_t* stats) {
+    if (sched == NULL || stats == NULL) return;
+
+    *stats = sched->stats;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file j1939_request.h
+ * @brief Request (PGN 59904) scheduler for on-request parameter groups
+ *
+ * Many ECUs only send HOURS, VD, DM2 or component identification when
+ * asked. The scheduler keeps one entry per (PGN, destination) and asks for
+ * each at its period:
+ *
+ *  - consumers wanting the same PGN share one entry (shortest period wins),
+ *    and a pending global request also covers per-ECU entries of its PGN
+ *  - at most one request goes out per J1939_REQUEST_GAP_MS, so a list of
+ *    due entries never becomes a burst on the bus
+ *  - a request not answered within J1939_REQUEST_TIMEOUT_MS doubles the
+ *    entry's period (up to 2^J1939_REQUEST_MAX_BACKOFF); a NACK jumps
+ *    straight to the longest period. An answer resets the period.
+ *  - the PGN arriving without a request (an ECU broadcasting it anyway)
+ *    postpones the next request by a period
+ *  - a one-shot entry leaves the table once answered or given up
+ *
+ * Round-trip time from request to answer is kept per entry and overall.
+ * Times are on the frame timestamp clock; requests leave from
+ * j1939_request_poll(), so RTT resolution is the poll period.
+ */
+
+#ifndef J1939_REQUEST_H
+#define J1939_REQUEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_REQUEST_MAX_ENTRIES
+#define J1939_REQUEST_MAX_ENTRIES   16      // (PGN, destination) pairs: boot registrations + DM2/DM4 per capture job
+#endif
+
+#ifndef J1939_REQUEST_GAP_MS
+#define J1939_REQUEST_GAP_MS        50      // Minimum spacing between two requests
+#endif
+
+#ifndef J1939_REQUEST_TIMEOUT_MS
+#define J1939_REQUEST_TIMEOUT_MS    1250    // Answer window (J1939-21 T3; covers TP answers)
+#endif
+
+#ifndef J1939_REQUEST_MAX_BACKOFF
+#define J1939_REQUEST_MAX_BACKOFF   5       // Period doubles per unanswered request, up to 32x
+#endif
+
+#define J1939_REQUEST_RTT_SHIFT     3       // RTT average weight: 1/8 per answer
+
+/*===========================================================================*/
+/*                        CONSTANTS                                         */
+/*===========================================================================*/
+
+#ifndef PGN_REQUEST
+#define PGN_REQUEST                 59904       // 0xEA00 - Request
+#endif
+
+#ifndef PGN_ACKNOWLEDGMENT
+#define PGN_ACKNOWLEDGMENT          59392       // 0xE800 - Acknowledgment (ACK/NACK)
+#endif
+
+#define J1939_ACK_POSITIVE          0
+#define J1939_ACK_NEGATIVE          1
+#define J1939_ACK_ACCESS_DENIED     2
+#define J1939_ACK_CANNOT_RESPOND    3
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief One scheduled request
+ */
+typedef struct {
+    uint32_t pgn;               // Requested Parameter Group Number
+    uint8_t destination;        // ECU asked, or J1939_GLOBAL_ADDRESS
+    uint8_t consumers;          // Registrations sharing this entry
+    uint8_t backoff;            // Period multiplier exponent (unanswered requests)
+    bool pending;               // Request sent, answer not yet seen
+    bool done;                  // One-shot entry answered or given up (then removed)
+    uint32_t period_ms;         // Request period (0 = once)
+    uint64_t due_us;            // Next request
+    uint64_t sent_us;           // Time of the last request
+    uint32_t sent;              // Requests transmitted
+    uint32_t answered;          // Answers to a pending request
+    uint32_t timeouts;          // Requests left unanswered
+    uint32_t nacks;             // Negative acknowledgments
+    uint32_t unsolicited;       // Frames of the PGN received without a pending request
+    uint32_t rtt_last_us;       // Round trip of the last answer
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint32_t rtt_avg_us;        // Running average (1/2^J1939_REQUEST_RTT_SHIFT weight)
+} j1939_request_entry_t;
+
+/**
+ * @brief Scheduler counters (all entries)
+ */
+typedef struct {
+    uint32_t sent;              // Requests transmitted
+    uint32_t answered;          // Requests answered
+    uint32_t timeouts;          // Requests left unanswered
+    uint32_t nacks;             // Requests negatively acknowledged
+    uint32_t tx_failed;         // Requests the transmit hook refused (retried later)
+    uint32_t coalesced;         // Requests not sent because a pending one covered them
+    uint32_t rtt_avg_us;        // Running average round trip
+    uint32_t rtt_max_us;        // Longest round trip
+} j1939_request_stats_t;
+
+/**
+ * @brief Request scheduler
+ *
+ * Fed and polled by one task (the decode task).
+ */
+typedef struct {
+    j1939_request_entry_t entries[J1939_REQUEST_MAX_ENTRIES];
+    uint8_t count;
+    uint64_t pgn_bits;          // Bit (PGN % 64) set for every scheduled PGN
+    uint64_t next_tx_us;        // Earliest time of the next request
+    uint8_t source_address;     // Our address (requests are sent from it)
+    j1939_tp_send_t send;       // Transmit hook
+    void* send_user;
+    j1939_request_stats_t stats;
+} j1939_request_sched_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize an empty scheduler
+ * @param sched Scheduler to initialize
+ * @param source_address Our address
+ * @param send Transmit hook (must not block), or NULL to schedule without sending
+ * @param user Context passed to send
+ */
+void j1939_request_init(j1939_request_sched_t* sched, uint8_t source_address,
+                        j1939_tp_send_t send, void* user);
+
+/**
+ * @brief Register a consumer of a PGN
+ *
+ * A second consumer of the same (PGN, destination) shares the entry; the
+ * shorter period applies. The first request is due immediately.
+ *
+ * @param sched Scheduler
+ * @param pgn PGN to request
+ * @param destination ECU to ask, or J1939_GLOBAL_ADDRESS
+ * @param period_ms Request period (0 = once, retried until answered)
+ * @param now_us Current time
+ * @return true if registered (false: table full)
+ */
+bool j1939_request_add(j1939_request_sched_t* sched, uint32_t pgn, uint8_t destination,
+                       uint32_t period_ms, uint64_t now_us);
+
+/**
+ * @brief Drop a consumer; the entry goes when its last consumer does
+ * @param sched Scheduler
+ * @param pgn PGN
+ * @param destination Destination it was registered with
+ * @return true if the consumer was registered (false also for a one-shot
+ *         entry already answered or given up)
+ */
+bool j1939_request_remove(j1939_request_sched_t* sched, uint32_t pgn, uint8_t destination);
+
+/**
+ * @brief Expire unanswered requests and send the next due one
+ * @param sched Scheduler
+ * @param now_us Current time on the frame timestamp clock
+ */
+void j1939_request_poll(j1939_request_sched_t* sched, uint64_t now_us);
+
+/**
+ * @brief Account a received parameter group (single frame or TP payload)
+ *
+ * Costs one bit test for PGNs nobody requested.
+ *
+ * @param sched Scheduler
+ * @param pgn Received PGN
+ * @param source_address Sender
+ * @param timestamp_us Receive time
+ */
+void j1939_request_frame(j1939_request_sched_t* sched, uint32_t pgn, uint8_t source_address,
+                         uint64_t timestamp_us);
+
+/**
+ * @brief Account an Acknowledgment (PGN 59392) frame
+ * @param sched Scheduler
+ * @param source_address Acknowledging ECU
+ * @param data Frame data (control byte, ..., acknowledged PGN in bytes 5-7)
+ * @param len Data length
+ * @param timestamp_us Receive time
+ */
+void j1939_request_ack(j1939_request_sched_t* sched, uint8_t source_address,
+                       const uint8_t* data, uint8_t len, uint64_t timestamp_us);
+
+/**
+ * @brief Copy an entry by index
+ * @param sched Scheduler
+ * @param index Entry index (0 .. count - 1)
+ * @param entry Output: entry
+ * @return true if the index is in use
+ */
+bool j1939_request_get_entry(const j1939_request_sched_t* sched, uint8_t index,
+                             j1939_request_entry_t* entry);
+
+/**
+ * @brief Get scheduler counters
+ * @param sched Scheduler
+ * @param stats Output: counters
+ */
+void j1939_request_get_stats(const j1939_request_sched_t* sched, j1939_request_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_REQUEST_H */
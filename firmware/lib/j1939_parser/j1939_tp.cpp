@@ -0,0 +1,608 @@
+/**
+ * @file j1939_tp.cpp
+ * @brief J1939-21 Transport Protocol reassembly (BAM and RTS/CTS)
+ *
+ * Receive side of the transport protocol:
+ * - BAM broadcasts from any source, paced by the sender
+ * - RTS/CTS connections addressed to our address, answered with CTS
+ *   windows, an EOM acknowledge or a connection abort
+ *
+ * Reassembly buffers are contiguous runs of blocks from the context's pool,
+ * sized by the total_size announced in the BAM / RTS. Every open session
+ * sits on a timer wheel under its next deadline, so j1939_tp_poll() finds
+ * stalled transfers without scanning the session table.
+ */
+
+#include "j1939_parser.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        BUFFER POOL                                       */
+/*===========================================================================*/
+
+/**
+ * @brief Take a contiguous run of pool blocks (first fit)
+ * @return true if the run was found; updates the pool statistics either way
+ */
+static bool allocate_tp_blocks(j1939_parser_context_t* ctx, tp_session_t* session,
+                               uint16_t size) {
+    j1939_tp_pool_stats_t* stats = &ctx->tp_pool_stats;
+    uint8_t needed = (uint8_t)((size + J1939_TP_BLOCK_SIZE - 1) / J1939_TP_BLOCK_SIZE);
+    uint16_t run = 0;
+
+    for (uint16_t i = 0; i < J1939_TP_POOL_BLOCKS; i++) {
+        run = ctx->tp_block_used[i] ? 0 : run + 1;
+        if (run == needed) {
+            uint8_t first = (uint8_t)(i + 1 - needed);
+            memset(&ctx->tp_block_used[first], 1, needed);
+            session->first_block = first;
+            session->block_count = needed;
+
+            stats->allocations++;
+            stats->blocks_in_use += needed;
+            if (stats->blocks_in_use > stats->blocks_high_water) {
+                stats->blocks_high_water = stats->blocks_in_use;
+            }
+            return true;
+        }
+    }
+
+    if (J1939_TP_POOL_BLOCKS - stats->blocks_in_use >= needed) {
+        stats->fragmented++;
+    } else {
+        stats->exhausted++;
+    }
+    return false;
+}
+
+static void free_tp_blocks(j1939_parser_context_t* ctx, tp_session_t* session) {
+    if (session->block_count == 0) return;
+
+    memset(&ctx->tp_block_used[session->first_block], 0, session->block_count);
+    ctx->tp_pool_stats.blocks_in_use -= session->block_count;
+    session->block_count = 0;
+}
+
+static inline uint8_t* tp_session_buffer(j1939_parser_context_t* ctx, const tp_session_t* session) {
+    return &ctx->tp_pool[(uint16_t)session->first_block * J1939_TP_BLOCK_SIZE];
+}
+
+/*===========================================================================*/
+/*                        TIMER WHEEL                                       */
+/*===========================================================================*/
+
+#define TP_WHEEL_UNARMED    0xFF
+#define TP_WHEEL_SPAN_MS    ((uint32_t)J1939_TP_WHEEL_SLOTS * J1939_TP_WHEEL_TICK_MS)
+
+static inline uint8_t tp_wheel_slot(uint32_t time_ms) {
+    return (uint8_t)((time_ms / J1939_TP_WHEEL_TICK_MS) & (J1939_TP_WHEEL_SLOTS - 1));
+}
+
+static inline bool time_reached(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+static void disarm_tp_session(j1939_parser_context_t* ctx, tp_session_t* session) {
+    if (session->wheel_slot == TP_WHEEL_UNARMED) return;
+
+    if (session->wheel_prev != 0) {
+        ctx->tp_sessions[session->wheel_prev - 1].wheel_next = session->wheel_next;
+    } else {
+        ctx->tp_wheel[session->wheel_slot] = session->wheel_next;
+    }
+    if (session->wheel_next != 0) {
+        ctx->tp_sessions[session->wheel_next - 1].wheel_prev = session->wheel_prev;
+    }
+    session->wheel_slot = TP_WHEEL_UNARMED;
+}
+
+/**
+ * @brief Set a session's deadline and file it under the matching wheel slot
+ *
+ * A deadline already behind the sweep position goes into the next slot to
+ * be swept, so it still expires on the following poll.
+ */
+static void arm_tp_session(j1939_parser_context_t* ctx, tp_session_t* session,
+                           uint32_t deadline_ms) {
+    disarm_tp_session(ctx, session);
+    session->deadline_ms = deadline_ms;
+
+    bool overdue = (int32_t)(deadline_ms - ctx->tp_wheel_ms) < 0;
+    uint8_t slot = tp_wheel_slot(overdue ? ctx->tp_wheel_ms : deadline_ms);
+    uint8_t index = (uint8_t)(session - ctx->tp_sessions + 1);
+    session->wheel_slot = slot;
+    session->wheel_prev = 0;
+    session->wheel_next = ctx->tp_wheel[slot];
+    if (session->wheel_next != 0) {
+        ctx->tp_sessions[session->wheel_next - 1].wheel_prev = index;
+    }
+    ctx->tp_wheel[slot] = index;
+}
+
+/*===========================================================================*/
+/*                        SESSION TABLE                                     */
+/*===========================================================================*/
+
+/**
+ * @brief Source address index for a session kind
+ */
+static inline uint8_t* tp_index(j1939_parser_context_t* ctx, uint8_t mode) {
+    return (mode == TP_MODE_BAM) ? ctx->tp_session_by_sa : ctx->tp_conn_by_sa;
+}
+
+static tp_session_t* find_tp_session(j1939_parser_context_t* ctx, uint8_t mode,
+                                     uint8_t source_address) {
+    uint8_t slot = tp_index(ctx, mode)[source_address];
+    if (slot == 0) return NULL;
+
+    tp_session_t* session = &ctx->tp_sessions[slot - 1];
+    return (session->state != TP_STATE_IDLE) ? session : NULL;
+}
+
+static tp_session_t* allocate_tp_session(j1939_parser_context_t* ctx, uint8_t mode,
+                                         uint8_t source_address) {
+    for (int i = 0; i < J1939_MAX_ACTIVE_TP; i++) {
+        tp_session_t* session = &ctx->tp_sessions[i];
+        if (session->state == TP_STATE_IDLE) {
+            tp_index(ctx, mode)[source_address] = (uint8_t)(i + 1);
+            session->mode = mode;
+            session->source_address = source_address;
+            session->block_count = 0;
+
+            j1939_tp_pool_stats_t* stats = &ctx->tp_pool_stats;
+            stats->sessions_in_use++;
+            if (stats->sessions_in_use > stats->sessions_high_water) {
+                stats->sessions_high_water = stats->sessions_in_use;
+            }
+            return session;
+        }
+    }
+    ctx->tp_pool_stats.no_session++;
+    return NULL;
+}
+
+static void release_tp_session(j1939_parser_context_t* ctx, tp_session_t* session) {
+    disarm_tp_session(ctx, session);
+    free_tp_blocks(ctx, session);
+    tp_index(ctx, session->mode)[session->source_address] = 0;
+    ctx->tp_pool_stats.sessions_in_use--;
+    session->state = TP_STATE_IDLE;
+}
+
+/**
+ * @brief Open a session with a buffer for total_size bytes
+ *
+ * A session already open for the same sender and kind is replaced.
+ *
+ * @return Session in TP_STATE_RECEIVING, or NULL if no session or buffer is free
+ */
+static tp_session_t* open_tp_session(j1939_parser_context_t* ctx, uint8_t mode,
+                                     const j1939_message_t* msg, uint16_t total_size) {
+    tp_session_t* session = find_tp_session(ctx, mode, msg->source_address);
+
+    if (session == NULL) {
+        session = allocate_tp_session(ctx, mode, msg->source_address);
+    } else {
+        free_tp_blocks(ctx, session);  // New announcement replaces an unfinished one
+    }
+    if (session == NULL) {
+        return NULL;  // No free sessions
+    }
+
+    if (!allocate_tp_blocks(ctx, session, total_size)) {
+        release_tp_session(ctx, session);
+        return NULL;  // Pool exhausted or fragmented
+    }
+
+    session->state = TP_STATE_RECEIVING;
+    session->destination = msg->destination;
+    session->total_size = total_size;
+    session->total_packets = msg->data[3];
+    session->target_pgn = (uint32_t)msg->data[5] |
+                          ((uint32_t)msg->data[6] << 8) |
+                          ((uint32_t)msg->data[7] << 16);
+    session->received_packets = 0;
+    session->last_packet_time_ms = msg->timestamp_ms;
+    arm_tp_session(ctx, session, msg->timestamp_ms + J1939_TP_TIMEOUT_MS);
+
+    // In-order packets overwrite the buffer; only bytes beyond the announced
+    // packet count (seen from some ECUs) need the 0xFF "not available" fill
+    uint16_t covered = (uint16_t)session->total_packets * 7;
+    if (covered < total_size) {
+        memset(tp_session_buffer(ctx, session) + covered, 0xFF, total_size - covered);
+    }
+    return session;
+}
+
+/*===========================================================================*/
+/*                        CONNECTION CONTROL FRAMES                         */
+/*===========================================================================*/
+
+/**
+ * @brief Send a TP.CM frame to a sender
+ */
+static void send_tp_cm(j1939_parser_context_t* ctx, uint8_t destination, const uint8_t* data) {
+    uint32_t can_id = j1939_build_can_id(PGN_TP_CM | destination, ctx->tp_local_address, 7);
+
+    if (ctx->tp_send == NULL || !ctx->tp_send(can_id, data, 8, ctx->tp_send_user)) {
+        ctx->tp_conn_stats.send_failures++;
+    }
+}
+
+static void send_tp_abort(j1939_parser_context_t* ctx, uint8_t destination, uint32_t pgn,
+                          uint8_t reason) {
+    uint8_t data[8] = { TP_CM_ABORT, reason, 0xFF, 0xFF, 0xFF,
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_tp_cm(ctx, destination, data);
+    ctx->tp_conn_stats.aborts_sent++;
+}
+
+static void abort_connection(j1939_parser_context_t* ctx, tp_session_t* session, uint8_t reason) {
+    send_tp_abort(ctx, session->source_address, session->target_pgn, reason);
+    release_tp_session(ctx, session);
+}
+
+/**
+ * @brief Clear the sender for the next window of packets
+ */
+static void send_cts(j1939_parser_context_t* ctx, tp_session_t* session, uint32_t now_ms) {
+    uint8_t next = (uint8_t)(session->received_packets + 1);
+    uint16_t remaining = (uint16_t)(session->total_packets - session->received_packets);
+    uint16_t window = J1939_TP_CTS_WINDOW;
+    if (window > session->max_per_cts) window = session->max_per_cts;
+    if (window > remaining) window = remaining;
+
+    uint32_t pgn = session->target_pgn;
+    uint8_t data[8] = { TP_CM_CTS, (uint8_t)window, next, 0xFF, 0xFF,
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_tp_cm(ctx, session->source_address, data);
+
+    session->window_end = (uint8_t)(session->received_packets + window);
+    arm_tp_session(ctx, session, now_ms + J1939_TP_T2_MS);
+    ctx->tp_conn_stats.cts_sent++;
+}
+
+static void send_eom_ack(j1939_parser_context_t* ctx, const tp_session_t* session) {
+    uint32_t pgn = session->target_pgn;
+    uint8_t data[8] = { TP_CM_EOM, (uint8_t)session->total_size,
+                        (uint8_t)(session->total_size >> 8), session->total_packets, 0xFF,
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_tp_cm(ctx, session->source_address, data);
+}
+
+/**
+ * @brief Reclaim a session whose deadline passed and account for it
+ *
+ * Connections are aborted towards the sender; broadcasts and completed
+ * transfers are dropped silently.
+ */
+static void expire_tp_session(j1939_parser_context_t* ctx, tp_session_t* session,
+                              uint32_t now_ms) {
+    j1939_tp_expiry_stats_t* stats = &ctx->tp_expiry_stats;
+    uint8_t source = session->source_address;
+
+    stats->expired++;
+    stats->last_time_ms = now_ms;
+    stats->last_pgn = session->target_pgn;
+    stats->last_source = source;
+    if (ctx->tp_expired_by_sa[source] < 255) {
+        ctx->tp_expired_by_sa[source]++;
+    }
+
+    if (session->state == TP_STATE_COMPLETE) {
+        stats->unclaimed++;
+        release_tp_session(ctx, session);
+    } else if (session->mode == TP_MODE_CMDT) {
+        stats->conn_expired++;
+        ctx->tp_conn_stats.timeouts++;
+        abort_connection(ctx, session, TP_ABORT_TIMEOUT);
+    } else {
+        stats->bam_expired++;
+        release_tp_session(ctx, session);
+    }
+}
+
+/*===========================================================================*/
+/*                        CONNECTION MANAGEMENT                             */
+/*===========================================================================*/
+
+static void handle_bam(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    uint16_t total_size = (uint16_t)msg->data[1] | ((uint16_t)msg->data[2] << 8);
+    if (total_size < J1939_TP_MIN_LENGTH || total_size > J1939_TP_MAX_LENGTH) {
+        ctx->tp_pool_stats.rejected_size++;
+        return;
+    }
+    open_tp_session(ctx, TP_MODE_BAM, msg, total_size);
+}
+
+static void handle_rts(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    uint16_t total_size = (uint16_t)msg->data[1] | ((uint16_t)msg->data[2] << 8);
+    uint32_t pgn = (uint32_t)msg->data[5] | ((uint32_t)msg->data[6] << 8) |
+                   ((uint32_t)msg->data[7] << 16);
+
+    ctx->tp_conn_stats.rts_received++;
+
+    if (total_size < J1939_TP_MIN_LENGTH || total_size > J1939_TP_MAX_LENGTH) {
+        ctx->tp_pool_stats.rejected_size++;
+        send_tp_abort(ctx, msg->source_address, pgn, TP_ABORT_TOO_LARGE);
+        return;
+    }
+
+    // One connection per sender: a different PGN while one is open is refused
+    tp_session_t* open = find_tp_session(ctx, TP_MODE_CMDT, msg->source_address);
+    if (open != NULL && open->target_pgn != pgn) {
+        send_tp_abort(ctx, msg->source_address, pgn, TP_ABORT_BUSY);
+        return;
+    }
+
+    uint32_t refused_before = ctx->tp_pool_stats.no_session;
+    tp_session_t* session = open_tp_session(ctx, TP_MODE_CMDT, msg, total_size);
+    if (session == NULL) {
+        bool no_session = ctx->tp_pool_stats.no_session != refused_before;
+        send_tp_abort(ctx, msg->source_address, pgn,
+                      no_session ? TP_ABORT_BUSY : TP_ABORT_RESOURCES);
+        return;
+    }
+
+    session->max_per_cts = (msg->data[4] == 0) ? 0xFF : msg->data[4];  // 0xFF = no limit
+    send_cts(ctx, session, msg->timestamp_ms);
+}
+
+static void handle_sender_abort(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    uint32_t pgn = (uint32_t)msg->data[5] | ((uint32_t)msg->data[6] << 8) |
+                   ((uint32_t)msg->data[7] << 16);
+    tp_session_t* session = find_tp_session(ctx, TP_MODE_CMDT, msg->source_address);
+
+    if (session != NULL && session->target_pgn == pgn) {
+        release_tp_session(ctx, session);
+        ctx->tp_conn_stats.aborts_received++;
+    }
+}
+
+/*===========================================================================*/
+/*                        DATA TRANSFER                                     */
+/*===========================================================================*/
+
+static bool handle_bam_dt(j1939_parser_context_t* ctx, tp_session_t* session,
+                          const j1939_message_t* msg) {
+    // Timed out before the wheel got to it: give the blocks back at once
+    if ((msg->timestamp_ms - session->last_packet_time_ms) > J1939_TP_TIMEOUT_MS) {
+        expire_tp_session(ctx, session, msg->timestamp_ms);
+        return false;
+    }
+
+    uint8_t seq_num = msg->data[0];  // 1-based sequence number
+
+    // Validate sequence
+    if (seq_num != session->received_packets + 1) {
+        release_tp_session(ctx, session);
+        return false;
+    }
+    return true;
+}
+
+static bool handle_cmdt_dt(j1939_parser_context_t* ctx, tp_session_t* session,
+                           const j1939_message_t* msg) {
+    if (time_reached(msg->timestamp_ms, session->deadline_ms)) {
+        expire_tp_session(ctx, session, msg->timestamp_ms);
+        return false;
+    }
+
+    uint8_t seq_num = msg->data[0];
+
+    if (seq_num == session->received_packets && seq_num != 0) {
+        abort_connection(ctx, session, TP_ABORT_DUPLICATE_SEQUENCE);
+        return false;
+    }
+    if (seq_num != session->received_packets + 1 || seq_num > session->window_end) {
+        abort_connection(ctx, session, TP_ABORT_BAD_SEQUENCE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Store one TP.DT packet; returns true when the transfer is complete
+ */
+static bool store_tp_packet(j1939_parser_context_t* ctx, tp_session_t* session,
+                            const j1939_message_t* msg) {
+    uint8_t seq_num = msg->data[0];
+
+    // Copy 7 data bytes to buffer
+    uint8_t* buffer = tp_session_buffer(ctx, session);
+    uint16_t offset = (seq_num - 1) * 7;
+    for (int i = 0; i < 7 && (offset + i) < session->total_size; i++) {
+        buffer[offset + i] = msg->data[1 + i];
+    }
+
+    session->received_packets++;
+    session->last_packet_time_ms = msg->timestamp_ms;
+    arm_tp_session(ctx, session, msg->timestamp_ms + J1939_TP_TIMEOUT_MS);  // Also bounds an unclaimed result
+
+    if (session->received_packets >= session->total_packets) {
+        session->state = TP_STATE_COMPLETE;
+        ctx->tp_complete_count++;
+        if (session->mode == TP_MODE_CMDT) {
+            send_eom_ack(ctx, session);
+            ctx->tp_conn_stats.completed++;
+        }
+        return true;
+    }
+
+    if (session->mode == TP_MODE_CMDT && session->received_packets == session->window_end) {
+        send_cts(ctx, session, msg->timestamp_ms);
+    }
+    return false;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_tp_set_local_address(j1939_parser_context_t* ctx, uint8_t address,
+                                j1939_tp_send_t send, void* user) {
+    if (ctx == NULL) return;
+
+    ctx->tp_local_address = address;
+    ctx->tp_send = send;
+    ctx->tp_send_user = user;
+}
+
+bool j1939_tp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    if (ctx == NULL || msg == NULL) return false;
+
+    if (msg->pgn == PGN_ETP_CM || msg->pgn == PGN_ETP_DT) {
+        j1939_etp_handle_frame(ctx, msg);  // Streamed to the ETP sink (j1939_etp.cpp)
+        return false;
+    }
+
+    bool broadcast = (msg->destination == J1939_GLOBAL_ADDRESS);
+    bool to_us = !broadcast && ctx->tp_send != NULL &&
+                 ctx->tp_local_address != J1939_NULL_ADDRESS &&
+                 msg->destination == ctx->tp_local_address;
+
+    if (msg->pgn == PGN_TP_CM) {
+        // Transport Protocol Connection Management
+        uint8_t control_byte = msg->data[0];
+
+        if (control_byte == TP_CM_BAM && broadcast) {
+            handle_bam(ctx, msg);
+        } else if (control_byte == TP_CM_RTS && to_us) {
+            handle_rts(ctx, msg);
+        } else if (control_byte == TP_CM_ABORT && to_us) {
+            handle_sender_abort(ctx, msg);
+        }
+        return false;
+    }
+
+    if (msg->pgn == PGN_TP_DT) {
+        // Transport Protocol Data Transfer
+        if (!broadcast && !to_us) return false;  // Connection between other nodes
+
+        tp_session_t* session = find_tp_session(ctx, broadcast ? TP_MODE_BAM : TP_MODE_CMDT,
+                                                msg->source_address);
+        if (session == NULL || session->state != TP_STATE_RECEIVING) {
+            return false;
+        }
+
+        bool accepted = broadcast ? handle_bam_dt(ctx, session, msg)
+                                  : handle_cmdt_dt(ctx, session, msg);
+        return accepted && store_tp_packet(ctx, session, msg);
+    }
+
+    return false;
+}
+
+void j1939_tp_poll(j1939_parser_context_t* ctx, uint32_t now_ms) {
+    if (ctx == NULL) return;
+
+    j1939_etp_poll(ctx, now_ms);
+
+    // Sweep every tick that has fully elapsed; after a long gap one
+    // revolution visits every slot
+    uint32_t now_tick_ms = now_ms & ~(uint32_t)(J1939_TP_WHEEL_TICK_MS - 1);
+    int32_t behind_ms = (int32_t)(now_tick_ms - ctx->tp_wheel_ms);
+    if (behind_ms <= 0) return;
+    if ((uint32_t)behind_ms > TP_WHEEL_SPAN_MS) {
+        ctx->tp_wheel_ms = now_tick_ms - TP_WHEEL_SPAN_MS;
+    }
+
+    ctx->tp_expiry_stats.sweeps++;
+
+    while (ctx->tp_wheel_ms != now_tick_ms) {
+        uint8_t slot = tp_wheel_slot(ctx->tp_wheel_ms);
+        ctx->tp_wheel_ms += J1939_TP_WHEEL_TICK_MS;
+
+        uint8_t index = ctx->tp_wheel[slot];
+        while (index != 0) {
+            tp_session_t* session = &ctx->tp_sessions[index - 1];
+            index = session->wheel_next;
+
+            // Only a deadline one revolution ahead shares the slot and is kept
+            if (time_reached(now_ms, session->deadline_ms)) {
+                expire_tp_session(ctx, session, now_ms);
+            }
+        }
+    }
+}
+
+bool j1939_tp_deliver(j1939_parser_context_t* ctx, const j1939_message_t* msg,
+                      j1939_tp_consumer_t consumer, void* user) {
+    if (ctx == NULL || msg == NULL || consumer == NULL) return false;
+
+    uint8_t mode = (msg->destination == J1939_GLOBAL_ADDRESS) ? TP_MODE_BAM : TP_MODE_CMDT;
+    tp_session_t* session = find_tp_session(ctx, mode, msg->source_address);
+    if (session == NULL || session->state != TP_STATE_COMPLETE) {
+        return false;
+    }
+
+    j1939_tp_payload_t payload;
+    payload.pgn = session->target_pgn;
+    payload.source_address = session->source_address;
+    payload.destination = session->destination;
+    payload.data = tp_session_buffer(ctx, session);
+    payload.length = session->total_size;
+    payload.timestamp_ms = msg->timestamp_ms;
+    payload.timestamp_us = msg->timestamp_us;
+
+    consumer(&payload, user);
+
+    release_tp_session(ctx, session);
+    return true;
+}
+
+uint16_t j1939_tp_get_data(j1939_parser_context_t* ctx, uint8_t source_address,
+                           uint32_t* pgn, uint8_t* data, uint16_t max_len) {
+    if (ctx == NULL || data == NULL) return 0;
+
+    tp_session_t* session = find_tp_session(ctx, TP_MODE_BAM, source_address);
+    if (session == NULL || session->state != TP_STATE_COMPLETE) {
+        session = find_tp_session(ctx, TP_MODE_CMDT, source_address);
+    }
+    if (session == NULL || session->state != TP_STATE_COMPLETE) {
+        return 0;
+    }
+
+    if (pgn != NULL) {
+        *pgn = session->target_pgn;
+    }
+
+    uint16_t copy_len = (session->total_size < max_len) ? session->total_size : max_len;
+    memcpy(data, tp_session_buffer(ctx, session), copy_len);
+
+    // Reset session for reuse
+    release_tp_session(ctx, session);
+
+    return copy_len;
+}
+
+void j1939_tp_get_pool_stats(const j1939_parser_context_t* ctx, j1939_tp_pool_stats_t* stats) {
+    if (ctx == NULL || stats == NULL) return;
+
+    *stats = ctx->tp_pool_stats;
+
+    uint16_t run = 0;
+    stats->largest_free_run = 0;
+    for (uint16_t i = 0; i < J1939_TP_POOL_BLOCKS; i++) {
+        run = ctx->tp_block_used[i] ? 0 : run + 1;
+        if (run > stats->largest_free_run) stats->largest_free_run = run;
+    }
+}
+
+void j1939_tp_get_conn_stats(const j1939_parser_context_t* ctx, j1939_tp_conn_stats_t* stats) {
+    if (ctx == NULL || stats == NULL) return;
+
+    *stats = ctx->tp_conn_stats;
+}
+
+void j1939_tp_get_expiry_stats(const j1939_parser_context_t* ctx, j1939_tp_expiry_stats_t* stats) {
+    if (ctx == NULL || stats == NULL) return;
+
+    *stats = ctx->tp_expiry_stats;
+}
+
+uint8_t j1939_tp_get_expired_count(const j1939_parser_context_t* ctx, uint8_t source_address) {
+    if (ctx == NULL) return 0;
+
+    return ctx->tp_expired_by_sa[source_address];
+}
@@ -3,7 +3,13 @@
  * @brief ESP32 TWAI/CAN driver wrapper for J1939 communication
  * 
  * Provides a simplified interface to the ESP32's TWAI (CAN) controller
- * for J1939 applications.
+ * for J1939 applications. Reception is batched: the TWAI ISR fills the driver
+ * queue and can_driver_receive_batch() drains it into a caller array in one
+ * call. Statistics are updated with atomic stores only, so any task may read
+ * them without locking, and bus-off is recovered automatically.
+ *
+ * Native builds (NATIVE_BUILD) use an in-memory loopback bus instead of TWAI
+ * so the same API can be exercised by host tests.
  */
 
 #ifndef CAN_DRIVER_H
@@ -23,6 +29,14 @@ extern "C" {
 #define CAN_BAUD_250K           250000      // J1939 standard
 #define CAN_BAUD_500K           500000      // Alternative
 
+#ifndef CAN_DRIVER_RX_QUEUE_LEN
+#define CAN_DRIVER_RX_QUEUE_LEN     50          // Driver receive queue depth
+#endif
+
+#ifndef CAN_DRIVER_TX_QUEUE_LEN
+#define CAN_DRIVER_TX_QUEUE_LEN     10          // Driver transmit queue depth
+#endif
+
 /*===========================================================================*/
 /*                        DATA STRUCTURES                                   */
 /*===========================================================================*/
@@ -36,6 +50,7 @@ typedef struct {
     uint8_t length;         // Data length (0-8)
     bool is_extended;       // True for 29-bit ID
     bool is_rtr;            // Remote transmission request
+    uint64_t timestamp_us;  // Receive timestamp (us since boot, see can_driver_time_us)
 } can_frame_t;
 
 /**
@@ -44,11 +59,15 @@ typedef struct {
 typedef struct {
     uint32_t rx_count;
     uint32_t tx_count;
-    uint32_t rx_errors;
-    uint32_t tx_errors;
+    uint32_t rx_errors;             // Frames lost by the controller (queue full/FIFO overrun)
+    uint32_t tx_errors;             // Failed or rejected transmissions
     uint32_t bus_errors;
-    uint8_t tx_error_counter;
-    uint8_t rx_error_counter;
+    uint8_t tx_error_counter;       // TEC at the last status poll
+    uint8_t rx_error_counter;       // REC at the last status poll
+    uint32_t arbitration_lost;
+    uint32_t bus_off_count;         // Bus-off events detected
+    uint32_t recovery_count;        // Successful automatic recoveries
+    uint32_t rx_queue_high_water;   // Deepest driver RX queue seen
 } can_stats_t;
 
 /**
@@ -100,6 +119,21 @@ can_state_t can_driver_get_state(void);
  */
 bool can_driver_receive(can_frame_t* frame, uint32_t timeout_ms);
 
+/**
+ * @brief Receive a burst of CAN frames
+ * 
+ * Waits up to timeout_ms for the first frame, then drains whatever is
+ * already queued without waiting, up to max_frames. Also polls controller
+ * status, updating error counters and driving bus-off recovery, so calling
+ * this regularly (even when idle) is all the servicing the driver needs.
+ * 
+ * @param frames Output array
+ * @param max_frames Capacity of frames
+ * @param timeout_ms Maximum wait for the first frame (0 for non-blocking)
+ * @return Number of frames received
+ */
+uint32_t can_driver_receive_batch(can_frame_t* frames, uint32_t max_frames, uint32_t timeout_ms);
+
 /**
  * @brief Transmit a CAN frame
  * @param frame Frame to transmit
@@ -108,6 +142,16 @@ bool can_driver_receive(can_frame_t* frame, uint32_t timeout_ms);
  */
 bool can_driver_transmit(const can_frame_t* frame, uint32_t timeout_ms);
 
+/**
+ * @brief Microsecond clock used to stamp received frames
+ * 
+ * 64-bit, monotonic since boot (esp_timer on the ESP32), so it never wraps
+ * in practice and shares its epoch with millis().
+ * 
+ * @return Current time in microseconds
+ */
+uint64_t can_driver_time_us(void);
+
 /**
  * @brief Get CAN statistics
  * @param stats Output statistics structure
@@ -121,18 +165,78 @@ void can_driver_clear_stats(void);
 
 /**
  * @brief Initiate bus-off recovery
+ * 
+ * Normally not needed: can_driver_receive_batch() starts recovery on its own
+ * and restarts the controller once the bus has recovered.
+ * 
  * @return true if recovery initiated
  */
 bool can_driver_recover(void);
 
 /**
  * @brief Set acceptance filter (for J1939, accept all extended frames)
+ * 
+ * Code and mask are given in 29-bit identifier terms: a frame is accepted
+ * when (id & accept_mask) == (accept_code & accept_mask), so a mask of 0
+ * accepts everything. On TWAI the filter can only change while the driver
+ * is uninstalled, so a running driver is briefly stopped and reinstalled;
+ * transmits in the meantime fail (counted in tx_errors). Call from the task
+ * that receives.
+ * 
+ * If the controller cannot be installed with the new filter, the previous
+ * filter is reinstalled. If that fails too, the driver is left uninstalled
+ * and the next call installs it again, restarting it if it was running.
+ * 
  * @param accept_code Filter acceptance code
- * @param accept_mask Filter acceptance mask
- * @return true if filter set successfully
+ * @param accept_mask Filter acceptance mask (1 = bit must match)
+ * @return true if the filter is installed and the driver runs as before;
+ *         false keeps the previous filter (retry later)
  */
 bool can_driver_set_filter(uint32_t accept_code, uint32_t accept_mask);
 
+/**
+ * @brief Set two acceptance filters (TWAI dual filter mode)
+ * 
+ * A frame is accepted when either filter matches. For extended frames the
+ * controller compares only ID28..ID13 in this mode, so lower code/mask bits
+ * are ignored. Reinstalls a running driver like can_driver_set_filter().
+ * 
+ * @param code_a First filter acceptance code (29-bit identifier terms)
+ * @param mask_a First filter acceptance mask (1 = bit must match)
+ * @param code_b Second filter acceptance code
+ * @param mask_b Second filter acceptance mask
+ * @return true if filters set successfully
+ */
+bool can_driver_set_dual_filter(uint32_t code_a, uint32_t mask_a,
+                                uint32_t code_b, uint32_t mask_b);
+
+#ifdef NATIVE_BUILD
+/**
+ * @brief Force the loopback bus into bus-off (native test hook)
+ */
+void can_driver_native_force_bus_off(void);
+
+/**
+ * @brief Make the next installs fail (native test hook)
+ * @param count Installs that fail before they succeed again
+ */
+void can_driver_native_fail_installs(uint8_t count);
+
+/**
+ * @brief Attach the native driver to a host CAN source (see can_host.h)
+ * 
+ * Call before can_driver_init(). The source is a SocketCAN interface such as
+ * "vcan0", or a candump -L log path / "-" for stdin when no such interface
+ * exists. Once a log has been read to the end the driver state becomes
+ * CAN_STATE_STOPPED. While a source is open can_driver_time_us() follows the
+ * host monotonic clock.
+ * 
+ * @param source Source name, or NULL to return to the loopback bus
+ * @return true if the source was opened
+ */
+bool can_driver_native_set_source(const char* source);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,315 @@
+/**
+ * @file can_filter.cpp
+ * @brief Acceptance filter planner implementation
+ *
+ * Each consumed PGN is a key: its identifier bits (EDP, DP, PF, PS) plus a
+ * care mask that excludes PS for PDU1 PGNs. A group of keys is covered by
+ * the bits all of them care about and agree on. Dual plans are found by
+ * seeding a two-way split on every key bit and then moving single keys
+ * between the groups while that lowers the cost.
+ */
+
+#include "can_filter.h"
+#include "j1939_decoder.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        KEYS                                              */
+/*===========================================================================*/
+
+#define KEY_ID_BITS         0x03FFFF00UL    // EDP, DP, PF, PS (priority and SA are free)
+#define KEY_PS_BITS         0x0000FF00UL
+#define KEY_BIT_COUNT       18
+#define PDU2_MIN_PF         240
+
+static inline uint32_t pgn_to_id(uint32_t pgn) {
+    return (pgn & 0x3FFFFUL) << 8;
+}
+
+/**
+ * @brief Identifier bits that select a PGN (a PDU1 PS is the destination)
+ */
+static inline uint32_t pgn_care_bits(uint32_t pgn) {
+    uint8_t pf = (uint8_t)(pgn >> 8);
+    return (pf < PDU2_MIN_PF) ? (KEY_ID_BITS & ~KEY_PS_BITS) : KEY_ID_BITS;
+}
+
+/**
+ * @brief Normalize a PGN: PDU1 PGNs carry no destination
+ */
+static inline uint32_t pgn_normalize(uint32_t pgn) {
+    pgn &= 0x3FFFFUL;
+    return ((uint8_t)(pgn >> 8) < PDU2_MIN_PF) ? (pgn & 0x3FF00UL) : pgn;
+}
+
+/*===========================================================================*/
+/*                        PGN SETS                                          */
+/*===========================================================================*/
+
+void can_filter_set_clear(can_filter_set_t* set) {
+    if (set == NULL) return;
+    memset(set, 0, sizeof(can_filter_set_t));
+}
+
+bool can_filter_set_add(can_filter_set_t* set, uint32_t pgn) {
+    if (set == NULL) return false;
+
+    pgn = pgn_normalize(pgn);
+
+    // Sorted insert, duplicates ignored
+    uint8_t pos = 0;
+    while (pos < set->count && set->pgns[pos] < pgn) pos++;
+    if (pos < set->count && set->pgns[pos] == pgn) return true;
+
+    if (set->count >= CAN_FILTER_MAX_PGNS) {
+        set->accept_all = true;
+        return false;
+    }
+
+    memmove(&set->pgns[pos + 1], &set->pgns[pos], (set->count - pos) * sizeof(uint32_t));
+    set->pgns[pos] = pgn;
+    set->count++;
+    return true;
+}
+
+void can_filter_set_add_decoder(can_filter_set_t* set) {
+    uint16_t count = 0;
+    const j1939_pgn_desc_t* pgns = j1939_decoder_get_pgns(&count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (pgns[i].signal_count > 0 && pgns[i].signals[0].param_id != PARAM_NONE) {
+            can_filter_set_add(set, pgns[i].pgn);
+        }
+    }
+}
+
+uint8_t can_filter_set_add_param(can_filter_set_t* set, param_id_t param_id) {
+    uint16_t count = 0;
+    const j1939_pgn_desc_t* pgns = j1939_decoder_get_pgns(&count);
+    uint8_t found = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        for (uint8_t s = 0; s < pgns[i].signal_count; s++) {
+            if (pgns[i].signals[s].param_id == param_id) {
+                can_filter_set_add(set, pgns[i].pgn);
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+bool can_filter_set_equal(const can_filter_set_t* a, const can_filter_set_t* b) {
+    if (a == NULL || b == NULL) return false;
+    if (a->accept_all != b->accept_all || a->count != b->count) return false;
+    return memcmp(a->pgns, b->pgns, a->count * sizeof(uint32_t)) == 0;
+}
+
+/*===========================================================================*/
+/*                        COST MODEL                                        */
+/*===========================================================================*/
+
+typedef struct {
+    uint32_t code;
+    uint32_t mask;
+} cover_t;
+
+typedef struct {
+    const can_filter_set_t* set;
+    const can_filter_traffic_t* traffic;
+    uint16_t traffic_count;
+} plan_ctx_t;
+
+/**
+ * @brief Tightest code/mask accepting every key in a group
+ * @param universe Identifier bits the filter can compare
+ */
+static cover_t cover_group(const can_filter_set_t* set, uint64_t group, uint32_t universe) {
+    cover_t c = { 0, 0 };
+    bool first = true;
+
+    for (uint8_t i = 0; i < set->count; i++) {
+        if ((group & (1ULL << i)) == 0) continue;
+
+        uint32_t id = pgn_to_id(set->pgns[i]);
+        uint32_t care = pgn_care_bits(set->pgns[i]);
+        if (first) {
+            c.code = id;
+            c.mask = universe & care;
+            first = false;
+        } else {
+            c.mask &= care & ~(id ^ c.code);
+        }
+    }
+    c.code &= c.mask;
+    return c;
+}
+
+static inline bool cover_matches(const cover_t* c, uint32_t pgn) {
+    return ((pgn_to_id(pgn) ^ c->code) & c->mask & pgn_care_bits(pgn)) == 0;
+}
+
+/**
+ * @brief Identifier space a cover opens, in keys
+ */
+static inline uint32_t cover_volume(const cover_t* c) {
+    return 1UL << (KEY_BIT_COUNT - __builtin_popcount(c->mask & KEY_ID_BITS));
+}
+
+/**
+ * @brief Cost of accepting through one or two covers
+ *
+ * Sampled frames let through dominate; the opened identifier space breaks
+ * ties (and is the whole cost without a sample).
+ */
+static uint64_t plan_cost(const plan_ctx_t* ctx, const cover_t* covers, uint8_t cover_count) {
+    uint64_t accepted = 0;
+
+    for (uint16_t t = 0; t < ctx->traffic_count; t++) {
+        for (uint8_t c = 0; c < cover_count; c++) {
+            if (cover_matches(&covers[c], ctx->traffic[t].pgn)) {
+                accepted += ctx->traffic[t].frames;
+                break;
+            }
+        }
+    }
+
+    uint64_t volume = 0;
+    for (uint8_t c = 0; c < cover_count; c++) {
+        volume += cover_volume(&covers[c]);
+    }
+    return (accepted << 20) | volume;
+}
+
+static uint64_t dual_cost(const plan_ctx_t* ctx, uint64_t group, uint64_t all, cover_t* covers) {
+    covers[0] = cover_group(ctx->set, group, CAN_FILTER_DUAL_ID_BITS & KEY_ID_BITS);
+    covers[1] = cover_group(ctx->set, all & ~group, CAN_FILTER_DUAL_ID_BITS & KEY_ID_BITS);
+    return plan_cost(ctx, covers, 2);
+}
+
+/**
+ * @brief Best two-way split of the set for the dual filter
+ */
+static uint64_t plan_dual(const plan_ctx_t* ctx, cover_t* best_covers) {
+    const uint8_t n = ctx->set->count;
+    const uint64_t all = (n >= 64) ? ~0ULL : ((1ULL << n) - 1);
+    uint64_t best_group = 0;
+    uint64_t best_cost = UINT64_MAX;
+    cover_t covers[2];
+
+    // Seeds: split on each identifier bit
+    for (uint8_t bit = 8; bit < 8 + KEY_BIT_COUNT; bit++) {
+        uint64_t group = 0;
+        for (uint8_t i = 0; i < n; i++) {
+            if (pgn_to_id(ctx->set->pgns[i]) & (1UL << bit)) group |= 1ULL << i;
+        }
+        if (group == 0 || group == all) continue;
+
+        uint64_t cost = dual_cost(ctx, group, all, covers);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_group = group;
+        }
+    }
+    if (best_cost == UINT64_MAX) return UINT64_MAX;  // Keys agree on every bit
+
+    // Move single keys across while that helps
+    bool improved = true;
+    for (uint8_t pass = 0; improved && pass < n; pass++) {
+        improved = false;
+        for (uint8_t i = 0; i < n; i++) {
+            uint64_t group = best_group ^ (1ULL << i);
+            if (group == 0 || group == all) continue;
+
+            uint64_t cost = dual_cost(ctx, group, all, covers);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_group = group;
+                improved = true;
+            }
+        }
+    }
+
+    dual_cost(ctx, best_group, all, best_covers);
+    return best_cost;
+}
+
+/*===========================================================================*/
+/*                        PLANNING                                          */
+/*===========================================================================*/
+
+/**
+ * @brief Would a plan receive a PGN, whatever its priority, source or destination
+ */
+static bool plan_accepts_pgn(const can_filter_plan_t* plan, uint32_t pgn) {
+    if (plan->mode == CAN_FILTER_ACCEPT_ALL) return true;
+
+    uint8_t covers = (plan->mode == CAN_FILTER_DUAL) ? 2 : 1;
+    uint32_t universe = (plan->mode == CAN_FILTER_DUAL) ? CAN_FILTER_DUAL_ID_BITS : 0x1FFFFFFFUL;
+    for (uint8_t c = 0; c < covers; c++) {
+        cover_t cover = { plan->code[c], plan->mask[c] & universe };
+        if (cover_matches(&cover, pgn)) return true;
+    }
+    return false;
+}
+
+void can_filter_plan(const can_filter_set_t* set, const can_filter_traffic_t* traffic,
+                     uint16_t traffic_count, can_filter_plan_t* plan) {
+    if (plan == NULL) return;
+    memset(plan, 0, sizeof(can_filter_plan_t));
+    plan->mode = CAN_FILTER_ACCEPT_ALL;
+
+    if (set != NULL && !set->accept_all && set->count > 0) {
+        plan_ctx_t ctx = { set, traffic, (traffic != NULL) ? traffic_count : (uint16_t)0 };
+        const uint64_t all = (set->count >= 64) ? ~0ULL : ((1ULL << set->count) - 1);
+
+        cover_t single = cover_group(set, all, KEY_ID_BITS);
+        uint64_t single_cost = plan_cost(&ctx, &single, 1);
+
+        cover_t dual[2];
+        uint64_t dual_best = plan_dual(&ctx, dual);
+
+        if (dual_best < single_cost) {
+            plan->mode = CAN_FILTER_DUAL;
+            plan->code[0] = dual[0].code;
+            plan->mask[0] = dual[0].mask;
+            plan->code[1] = dual[1].code;
+            plan->mask[1] = dual[1].mask;
+        } else if (single.mask != 0) {
+            plan->mode = CAN_FILTER_SINGLE;
+            plan->code[0] = single.code;
+            plan->mask[0] = single.mask;
+        }
+    }
+
+    // Estimated effect on the sampled traffic
+    for (uint16_t t = 0; traffic != NULL && t < traffic_count; t++) {
+        plan->sample_frames += traffic[t].frames;
+        if (!plan_accepts_pgn(plan, traffic[t].pgn)) {
+            plan->sample_rejected += traffic[t].frames;
+        }
+    }
+}
+
+bool can_filter_accepts(const can_filter_plan_t* plan, uint32_t can_id) {
+    if (plan == NULL) return true;
+
+    switch (plan->mode) {
+        case CAN_FILTER_SINGLE:
+            return ((can_id ^ plan->code[0]) & plan->mask[0]) == 0;
+        case CAN_FILTER_DUAL:
+            return ((can_id ^ plan->code[0]) & plan->mask[0] & CAN_FILTER_DUAL_ID_BITS) == 0 ||
+                   ((can_id ^ plan->code[1]) & plan->mask[1] & CAN_FILTER_DUAL_ID_BITS) == 0;
+        default:
+            return true;
+    }
+}
+
+const char* can_filter_get_mode_name(can_filter_mode_t mode) {
+    switch (mode) {
+        case CAN_FILTER_SINGLE: return "single";
+        case CAN_FILTER_DUAL:   return "dual";
+        default:                return "accept-all";
+    }
+}
@@ -0,0 +1,256 @@
+/**
+ * @file can_host.cpp
+ * @brief Linux CAN sources for native builds (SocketCAN or candump log)
+ */
+
+#ifdef NATIVE_BUILD
+
+#include "can_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+/*===========================================================================*/
+/*                        PRIVATE DATA                                      */
+/*===========================================================================*/
+
+static struct {
+    can_host_kind_t kind;
+    int socket_fd;
+    FILE* log;
+    bool at_end;
+    bool have_log_base;
+    uint64_t log_base_us;       // Logged time of the first frame
+    uint64_t open_time_us;      // Host time the source was opened
+} g_host = { CAN_HOST_NONE, -1, NULL, false, false, 0, 0 };
+
+uint64_t can_host_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static bool wait_readable(int fd, uint32_t timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, (int)timeout_ms) > 0;
+}
+
+/*===========================================================================*/
+/*                        SOCKETCAN                                         */
+/*===========================================================================*/
+
+#ifdef __linux__
+static bool open_socketcan(const char* ifname) {
+    if (if_nametoindex(ifname) == 0) return false;  // No such interface
+
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) return false;
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = (int)if_nametoindex(ifname);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    g_host.socket_fd = fd;
+    g_host.kind = CAN_HOST_SOCKETCAN;
+    return true;
+}
+
+static bool read_socketcan(can_frame_t* frame, uint32_t timeout_ms) {
+    struct can_frame raw;
+
+    if (timeout_ms > 0 && !wait_readable(g_host.socket_fd, timeout_ms)) return false;
+    if (recv(g_host.socket_fd, &raw, sizeof(raw), MSG_DONTWAIT) != (ssize_t)sizeof(raw)) {
+        return false;
+    }
+    if (raw.can_id & CAN_ERR_FLAG) return false;  // Error frames are not data
+
+    frame->is_extended = (raw.can_id & CAN_EFF_FLAG) != 0;
+    frame->is_rtr = (raw.can_id & CAN_RTR_FLAG) != 0;
+    frame->id = raw.can_id & (frame->is_extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    frame->length = (raw.can_dlc > 8) ? 8 : raw.can_dlc;
+    memcpy(frame->data, raw.data, 8);
+    frame->timestamp_us = can_host_time_us();
+    return true;
+}
+
+static bool write_socketcan(const can_frame_t* frame) {
+    struct can_frame raw;
+
+    memset(&raw, 0, sizeof(raw));
+    raw.can_id = frame->id | (frame->is_extended ? CAN_EFF_FLAG : 0) |
+                 (frame->is_rtr ? CAN_RTR_FLAG : 0);
+    raw.can_dlc = (frame->length > 8) ? 8 : frame->length;
+    memcpy(raw.data, frame->data, raw.can_dlc);
+
+    return write(g_host.socket_fd, &raw, sizeof(raw)) == (ssize_t)sizeof(raw);
+}
+#endif // __linux__
+
+/*===========================================================================*/
+/*                        CANDUMP LOG                                       */
+/*===========================================================================*/
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool can_host_parse_log_line(const char* line, can_frame_t* frame, uint64_t* log_time_us) {
+    unsigned long long seconds, micros;
+    char iface[32];
+    int consumed = 0;
+
+    if (sscanf(line, " (%llu.%llu) %31s %n", &seconds, &micros, iface, &consumed) != 3) {
+        return false;
+    }
+
+    const char* p = line + consumed;
+    const char* hash = strchr(p, '#');
+    if (hash == NULL || hash[1] == '#') return false;  // Not a frame, or CAN FD
+
+    size_t id_digits = (size_t)(hash - p);
+    if (id_digits == 0 || id_digits > 8) return false;
+
+    uint32_t id = 0;
+    for (size_t i = 0; i < id_digits; i++) {
+        int d = hex_digit(p[i]);
+        if (d < 0) return false;
+        id = (id << 4) | (uint32_t)d;
+    }
+
+    memset(frame, 0, sizeof(*frame));
+    frame->is_extended = (id_digits > 3);
+    frame->id = id & (frame->is_extended ? 0x1FFFFFFF : 0x7FF);
+
+    p = hash + 1;
+    if (*p == 'R') {
+        frame->is_rtr = true;
+    } else {
+        while (frame->length < 8) {
+            int hi = hex_digit(p[0]);
+            int lo = (hi < 0) ? -1 : hex_digit(p[1]);
+            if (lo < 0) break;
+            frame->data[frame->length++] = (uint8_t)((hi << 4) | lo);
+            p += 2;
+        }
+    }
+
+    *log_time_us = (uint64_t)seconds * 1000000ULL + (uint64_t)micros;
+    return true;
+}
+
+static bool open_log(const char* path) {
+    FILE* f = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (f == NULL) return false;
+
+    g_host.log = f;
+    g_host.kind = CAN_HOST_LOG;
+    return true;
+}
+
+static bool read_log(can_frame_t* frame, uint32_t timeout_ms) {
+    char line[256];
+    uint64_t log_time_us;
+
+    (void)timeout_ms;  // stdio buffers lines, so reads from a pipe simply block
+
+    if (g_host.at_end) return false;
+
+    while (fgets(line, sizeof(line), g_host.log) != NULL) {
+        if (!can_host_parse_log_line(line, frame, &log_time_us)) continue;  // Comments etc.
+
+        if (!g_host.have_log_base) {
+            g_host.log_base_us = log_time_us;
+            g_host.have_log_base = true;
+        }
+        uint64_t offset = (log_time_us >= g_host.log_base_us) ? log_time_us - g_host.log_base_us : 0;
+        frame->timestamp_us = g_host.open_time_us + offset;
+        return true;
+    }
+
+    g_host.at_end = true;
+    return false;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+bool can_host_open(const char* source) {
+    if (source == NULL) return false;
+
+    can_host_close();
+    g_host.open_time_us = can_host_time_us();
+
+#ifdef __linux__
+    if (open_socketcan(source)) return true;
+#endif
+    return open_log(source);
+}
+
+void can_host_close(void) {
+    if (g_host.socket_fd >= 0) {
+        close(g_host.socket_fd);
+    }
+    if (g_host.log != NULL && g_host.log != stdin) {
+        fclose(g_host.log);
+    }
+
+    g_host.kind = CAN_HOST_NONE;
+    g_host.socket_fd = -1;
+    g_host.log = NULL;
+    g_host.at_end = false;
+    g_host.have_log_base = false;
+}
+
+can_host_kind_t can_host_get_kind(void) {
+    return g_host.kind;
+}
+
+bool can_host_read(can_frame_t* frame, uint32_t timeout_ms) {
+    if (frame == NULL) return false;
+
+    switch (g_host.kind) {
+#ifdef __linux__
+        case CAN_HOST_SOCKETCAN: return read_socketcan(frame, timeout_ms);
+#endif
+        case CAN_HOST_LOG:       return read_log(frame, timeout_ms);
+        default:                 return false;
+    }
+}
+
+bool can_host_write(const can_frame_t* frame) {
+    if (frame == NULL) return false;
+
+#ifdef __linux__
+    if (g_host.kind == CAN_HOST_SOCKETCAN) return write_socketcan(frame);
+#endif
+    return false;
+}
+
+bool can_host_at_end(void) {
+    return g_host.kind == CAN_HOST_LOG && g_host.at_end;
+}
+
+#endif // NATIVE_BUILD
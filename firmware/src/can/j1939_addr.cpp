@@ -0,0 +1,231 @@
+/**
+ * @file j1939_addr.cpp
+ * @brief Address claim tracking implementation
+ */
+
+#include "j1939_addr.h"
+#include "j1939_request.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+static inline bool is_claimed(const j1939_addr_table_t* table, uint8_t sa) {
+    return (table->claimed[sa >> 5] & (1UL << (sa & 31))) != 0;
+}
+
+/**
+ * @brief Give an address to a NAME
+ */
+static void map_address(j1939_addr_table_t* table, uint8_t sa, uint64_t name) {
+    table->names[sa] = name;
+    table->claimed[sa >> 5] |= 1UL << (sa & 31);
+    table->stats.claimed++;
+
+    uint8_t instance = j1939_name_get_function_instance(name);
+    if (instance < J1939_ADDR_FUNCTION_INSTANCES) {
+        table->by_function[j1939_name_get_function(name)][instance] = sa;
+    }
+}
+
+/**
+ * @brief Release an address (and its function mapping, if it still points here)
+ */
+static void unmap_address(j1939_addr_table_t* table, uint8_t sa) {
+    uint64_t name = table->names[sa];
+    uint8_t instance = j1939_name_get_function_instance(name);
+    if (instance < J1939_ADDR_FUNCTION_INSTANCES) {
+        uint8_t* slot = &table->by_function[j1939_name_get_function(name)][instance];
+        if (*slot == sa) *slot = J1939_NULL_ADDRESS;
+    }
+
+    table->claimed[sa >> 5] &= ~(1UL << (sa & 31));
+    table->names[sa] = 0;
+    table->stats.claimed--;
+}
+
+/**
+ * @brief Release every address other than keep held by a NAME
+ * @return Number of addresses released
+ */
+static uint8_t release_name(j1939_addr_table_t* table, uint64_t name, uint16_t keep) {
+    uint8_t released = 0;
+    for (uint16_t sa = 0; sa < 256; sa++) {
+        if (sa != keep && is_claimed(table, (uint8_t)sa) && table->names[sa] == name) {
+            unmap_address(table, (uint8_t)sa);
+            released++;
+        }
+    }
+    return released;
+}
+
+/**
+ * @brief Send Address Claimed from our address, or Cannot Claim from the null address
+ */
+static bool send_claim(j1939_addr_claim_t* claim) {
+    if (claim->send == NULL) return false;
+
+    uint8_t data[8];
+    for (uint8_t i = 0; i < 8; i++) {
+        data[i] = (uint8_t)(claim->name >> (8 * i));
+    }
+
+    uint8_t source = claim->lost ? J1939_NULL_ADDRESS : claim->address;
+    uint32_t can_id = j1939_build_can_id(PGN_ADDRESS_CLAIMED | J1939_GLOBAL_ADDRESS, source,
+                                         J1939_ADDR_CLAIM_PRIORITY);
+    if (!claim->send(can_id, data, 8, claim->user)) return false;
+
+    claim->claims_sent++;
+    return true;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_addr_init(j1939_addr_table_t* table) {
+    if (table == NULL) return;
+
+    memset(table, 0, sizeof(j1939_addr_table_t));
+    memset(table->by_function, J1939_NULL_ADDRESS, sizeof(table->by_function));
+}
+
+bool j1939_addr_process_claim(j1939_addr_table_t* table, uint8_t source_address,
+                              const uint8_t* data, uint8_t len) {
+    if (table == NULL || data == NULL || len < 8) return false;
+
+    table->stats.claims++;
+
+    uint64_t name = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        name |= (uint64_t)data[i] << (8 * i);
+    }
+
+    // Cannot Claim: the NAME has no address any more
+    if (source_address == J1939_NULL_ADDRESS) {
+        table->stats.cannot_claim++;
+        return release_name(table, name, 256) > 0;
+    }
+
+    // Periodic re-claims and responses to requests change nothing
+    if (is_claimed(table, source_address) && table->names[source_address] == name) {
+        return false;
+    }
+
+    table->stats.moves += release_name(table, name, source_address);
+    if (is_claimed(table, source_address)) {
+        unmap_address(table, source_address);
+        table->stats.takeovers++;
+    }
+    map_address(table, source_address, name);
+    return true;
+}
+
+bool j1939_addr_get_name(const j1939_addr_table_t* table, uint8_t source_address, uint64_t* name) {
+    if (table == NULL || !is_claimed(table, source_address)) return false;
+
+    if (name != NULL) *name = table->names[source_address];
+    return true;
+}
+
+uint8_t j1939_addr_find(const j1939_addr_table_t* table, uint8_t function, uint8_t function_instance) {
+    if (table == NULL) return J1939_NULL_ADDRESS;
+
+    if (function_instance < J1939_ADDR_FUNCTION_INSTANCES) {
+        return table->by_function[function][function_instance];
+    }
+
+    for (uint16_t sa = 0; sa < 256; sa++) {
+        if (!is_claimed(table, (uint8_t)sa)) continue;
+        uint64_t name = table->names[sa];
+        if (j1939_name_get_function(name) == function &&
+            j1939_name_get_function_instance(name) == function_instance) {
+            return (uint8_t)sa;
+        }
+    }
+    return J1939_NULL_ADDRESS;
+}
+
+bool j1939_addr_accepts(const j1939_addr_table_t* table, uint8_t function, uint8_t source_address) {
+    if (table == NULL || function == J1939_FUNCTION_ANY) return true;
+
+    uint8_t owner = table->by_function[function][0];
+    if (owner != J1939_NULL_ADDRESS) return source_address == owner;
+
+    // Function not claimed (yet): only known other ECUs are excluded
+    return !is_claimed(table, source_address);
+}
+
+void j1939_addr_get_stats(const j1939_addr_table_t* table, j1939_addr_stats_t* stats) {
+    if (table == NULL || stats == NULL) return;
+
+    *stats = table->stats;
+}
+
+/*===========================================================================*/
+/*                        OUR ADDRESS                                       */
+/*===========================================================================*/
+
+void j1939_addr_claim_init(j1939_addr_claim_t* claim, uint64_t name, uint8_t address,
+                           j1939_tp_send_t send, void* user) {
+    if (claim == NULL) return;
+
+    memset(claim, 0, sizeof(j1939_addr_claim_t));
+    claim->name = name;
+    claim->address = address;
+    claim->send = send;
+    claim->user = user;
+}
+
+bool j1939_addr_claim_ready(j1939_addr_claim_t* claim) {
+    if (claim == NULL || claim->lost) return false;
+
+    if (!claim->claimed) {
+        claim->claimed = send_claim(claim);
+    }
+    return claim->claimed;
+}
+
+bool j1939_addr_claim_frame(j1939_addr_claim_t* claim, const j1939_message_t* msg) {
+    if (claim == NULL || msg == NULL) return false;
+
+    if (msg->pgn == PGN_REQUEST) {
+        if (msg->destination != J1939_GLOBAL_ADDRESS && msg->destination != claim->address) {
+            return false;
+        }
+        if (msg->data_length < 3) return false;
+
+        uint32_t requested = (uint32_t)msg->data[0] | ((uint32_t)msg->data[1] << 8) |
+                             ((uint32_t)(msg->data[2] & 0x03) << 16);
+        if (requested != PGN_ADDRESS_CLAIMED) return false;
+
+        if (claim->lost) {
+            send_claim(claim);  // Cannot Claim
+        } else {
+            claim->claimed = send_claim(claim);
+        }
+        return true;
+    }
+
+    if (msg->pgn != PGN_ADDRESS_CLAIMED || msg->source_address != claim->address ||
+        msg->data_length < 8 || claim->lost) {
+        return false;
+    }
+
+    uint64_t name = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        name |= (uint64_t)msg->data[i] << (8 * i);
+    }
+    if (name == claim->name) return true;  // Our own claim
+
+    claim->contentions++;
+    if (claim->name < name) {
+        claim->claimed = send_claim(claim);  // We win: defend the address
+    } else {
+        claim->lost = true;
+        claim->claimed = false;
+        send_claim(claim);  // Cannot Claim, then silence
+    }
+    return true;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file j1939_addr.h
+ * @brief Address claim tracking: NAME per source address, ECU by function
+ *
+ * Source addresses are not fixed: an engine at 0x00 on one model year may
+ * claim 0x01 on the next. Every J1939-81 Address Claimed message (PGN 60928)
+ * records the sender's 64-bit NAME in a 256-entry table indexed by source
+ * address, and the NAME's function / function instance in a reverse map, so
+ * "engine #1" or "transmission #1" resolves to its current address with one
+ * array read.
+ *
+ * The decoder table names the function each PGN is expected from
+ * (j1939_pgn_desc_t.source_function); j1939_addr_accepts() uses that to
+ * drop frames from other nodes before they are stored.
+ *
+ * Our own address is claimed by j1939_addr_claim_t: Address Claimed goes
+ * out before the first frame we transmit, Request (PGN 59904) for
+ * Address Claimed is answered, and a node with a higher-priority NAME
+ * claiming our address silences us (Cannot Claim).
+ */
+
+#ifndef J1939_ADDR_H
+#define J1939_ADDR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_ADDR_FUNCTION_INSTANCES
+#define J1939_ADDR_FUNCTION_INSTANCES   4   // Function instances resolved in O(1) (engine #1..#4)
+#endif
+
+/*===========================================================================*/
+/*                        CONSTANTS                                         */
+/*===========================================================================*/
+
+#ifndef PGN_ADDRESS_CLAIMED
+#define PGN_ADDRESS_CLAIMED         60928       // 0xEE00 - Address Claimed / Cannot Claim
+#endif
+
+#define J1939_ADDR_CLAIM_PRIORITY   6
+
+// NAME function codes (J1939-81, industry group independent range)
+#define J1939_FUNCTION_ENGINE           0
+#define J1939_FUNCTION_TRANSMISSION     3
+#define J1939_FUNCTION_BRAKES           9
+#define J1939_FUNCTION_INSTRUMENT       19
+#define J1939_FUNCTION_OFFBOARD_TOOL    129     // Off-board diagnostic-service tool
+#define J1939_FUNCTION_ANY              0xFF    // No routing (also "not available")
+
+/*===========================================================================*/
+/*                        NAME FIELDS                                       */
+/*===========================================================================*/
+
+/*
+ * NAME layout (little-endian in the claim payload):
+ *   bits  0-20  identity number         bits 40-47  function
+ *   bits 21-31  manufacturer code       bit  48     reserved
+ *   bits 32-34  ECU instance            bits 49-55  vehicle system
+ *   bits 35-39  function instance       bits 56-59  vehicle system instance
+ *   bits 60-62  industry group          bit  63     arbitrary address capable
+ */
+
+static inline uint32_t j1939_name_get_identity(uint64_t name) {
+    return (uint32_t)(name & 0x1FFFFFULL);
+}
+
+static inline uint16_t j1939_name_get_manufacturer(uint64_t name) {
+    return (uint16_t)((name >> 21) & 0x7FF);
+}
+
+static inline uint8_t j1939_name_get_ecu_instance(uint64_t name) {
+    return (uint8_t)((name >> 32) & 0x07);
+}
+
+static inline uint8_t j1939_name_get_function_instance(uint64_t name) {
+    return (uint8_t)((name >> 35) & 0x1F);
+}
+
+static inline uint8_t j1939_name_get_function(uint64_t name) {
+    return (uint8_t)(name >> 40);
+}
+
+static inline uint8_t j1939_name_get_industry_group(uint64_t name) {
+    return (uint8_t)((name >> 60) & 0x07);
+}
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Address claim counters
+ */
+typedef struct {
+    uint32_t claims;            // Address Claimed messages processed
+    uint32_t cannot_claim;      // Claims from the null address (NAME lost its address)
+    uint32_t moves;             // A known NAME claimed a different address
+    uint32_t takeovers;         // An address changed hands to a different NAME
+    uint16_t claimed;           // Addresses currently claimed
+} j1939_addr_stats_t;
+
+/**
+ * @brief NAME table
+ *
+ * Written by the decode task. The function map holds single bytes, so
+ * other tasks may resolve addresses without locking.
+ */
+typedef struct {
+    uint64_t names[256];                // NAME per source address
+    uint32_t claimed[8];                // Bitmap: address holds a claimed NAME
+    uint8_t by_function[256][J1939_ADDR_FUNCTION_INSTANCES];  // Address, or J1939_NULL_ADDRESS
+    j1939_addr_stats_t stats;
+} j1939_addr_table_t;
+
+/**
+ * @brief Our address claim
+ *
+ * Used by the decode task only: the frames it transmits and the claims and
+ * requests it receives.
+ */
+typedef struct {
+    uint64_t name;              // Our NAME
+    uint8_t address;            // Address claimed
+    bool claimed;               // Address Claimed sent
+    bool lost;                  // A higher-priority NAME holds the address
+    j1939_tp_send_t send;       // Frame output for claims
+    void* user;                 // Passed to send
+    uint32_t claims_sent;       // Address Claimed / Cannot Claim frames sent
+    uint32_t contentions;       // Claims of our address by another NAME
+} j1939_addr_claim_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize an empty NAME table
+ * @param table Table to initialize
+ */
+void j1939_addr_init(j1939_addr_table_t* table);
+
+/**
+ * @brief Process an Address Claimed message
+ *
+ * The newest claim for an address wins: in a contention the ECU with the
+ * higher-priority NAME defends by claiming again, and the loser either
+ * claims another address or sends Cannot Claim from the null address
+ * (which removes its NAME from the table).
+ *
+ * @param table NAME table
+ * @param source_address Claimed address (J1939_NULL_ADDRESS = cannot claim)
+ * @param data Claim payload (NAME, little-endian)
+ * @param len Payload length (8)
+ * @return true if the table changed
+ */
+bool j1939_addr_process_claim(j1939_addr_table_t* table, uint8_t source_address,
+                              const uint8_t* data, uint8_t len);
+
+/**
+ * @brief Get the NAME that claimed an address
+ * @param table NAME table
+ * @param source_address Address
+ * @param name Output: 64-bit NAME
+ * @return true if the address is claimed
+ */
+bool j1939_addr_get_name(const j1939_addr_table_t* table, uint8_t source_address, uint64_t* name);
+
+/**
+ * @brief Current address of an ECU by function
+ *
+ * Constant time for instances below J1939_ADDR_FUNCTION_INSTANCES, a table
+ * scan above.
+ *
+ * @param table NAME table
+ * @param function NAME function (J1939_FUNCTION_*)
+ * @param function_instance 0 for the first ("engine #1")
+ * @return Address, or J1939_NULL_ADDRESS if no such ECU has claimed one
+ */
+uint8_t j1939_addr_find(const j1939_addr_table_t* table, uint8_t function, uint8_t function_instance);
+
+/**
+ * @brief Should a frame expected from a function be taken from this address
+ *
+ * Once the function's first instance has claimed an address only that
+ * address is accepted. Until then, any address whose NAME is unknown is
+ * accepted (buses and logs without address claims keep working), and
+ * addresses claimed by other functions are rejected.
+ *
+ * @param table NAME table
+ * @param function Expected sender function (J1939_FUNCTION_ANY accepts all)
+ * @param source_address Sender
+ * @return true if the frame should be processed
+ */
+bool j1939_addr_accepts(const j1939_addr_table_t* table, uint8_t function, uint8_t source_address);
+
+/**
+ * @brief Get address claim counters
+ * @param table NAME table
+ * @param stats Output: counters
+ */
+void j1939_addr_get_stats(const j1939_addr_table_t* table, j1939_addr_stats_t* stats);
+
+/*===========================================================================*/
+/*                        OUR ADDRESS                                       */
+/*===========================================================================*/
+
+/**
+ * @brief Prepare our claim (nothing is sent yet)
+ *
+ * Only addresses a node may use without waiting 250 ms after its claim
+ * (0-127, 248-253) are meant to be used here: the claim goes out just
+ * before the first frame.
+ *
+ * @param claim Claim to initialize
+ * @param name Our NAME
+ * @param address Address to claim
+ * @param send Frame output for Address Claimed / Cannot Claim
+ * @param user Passed to send
+ */
+void j1939_addr_claim_init(j1939_addr_claim_t* claim, uint64_t name, uint8_t address,
+                           j1939_tp_send_t send, void* user);
+
+/**
+ * @brief May we transmit from our address
+ *
+ * Call before every frame we transmit. The first call sends Address
+ * Claimed; if that send fails, the next call tries again.
+ *
+ * @param claim Our claim
+ * @return true once Address Claimed went out and no node has taken the address
+ */
+bool j1939_addr_claim_ready(j1939_addr_claim_t* claim);
+
+/**
+ * @brief Handle a received Request or Address Claimed that concerns our claim
+ *
+ * Request for Address Claimed (global or to our address) is answered with
+ * our claim, or Cannot Claim once the address is lost. Address Claimed for
+ * our address from another NAME is contended: the lower NAME wins, and we
+ * either claim again or send Cannot Claim and stay silent.
+ *
+ * @param claim Our claim
+ * @param msg Received frame (other PGNs are ignored)
+ * @return true if the frame was a request or claim for our address
+ */
+bool j1939_addr_claim_frame(j1939_addr_claim_t* claim, const j1939_message_t* msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_ADDR_H */
@@ -0,0 +1,408 @@
+/**
+ * @file j1939_busmon.cpp
+ * @brief Bus load and per-(PGN, SA) rate monitor implementation
+ *
+ * Keys are never removed, so linear probing stops at the first unused slot
+ * (as in the shadow cache). Per-frame work is limited to counting and
+ * re-arming the key's deadline; rates, loads and the off-cycle check run
+ * once per window. The deadline wheel follows the TP session wheel: keys
+ * are linked into their slot by index, and a sweep keeps any key whose
+ * deadline is a revolution or more ahead.
+ */
+
+#include "j1939_busmon.h"
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include <string.h>
+#include <math.h>
+
+/*===========================================================================*/
+/*                        FRAME LENGTH                                      */
+/*===========================================================================*/
+
+#define STUFFED_BITS_STD    34      // SOF, 11-bit ID, RTR, IDE, r0, DLC, CRC (no data)
+#define STUFFED_BITS_EXT    54      // SOF, 29-bit ID, SRR, IDE, RTR, r1, r0, DLC, CRC (no data)
+#define UNSTUFFED_BITS      13      // CRC delimiter, ACK slot and delimiter, EOF, interframe space
+
+uint16_t j1939_busmon_frame_bits(bool extended, bool rtr, uint8_t length, bool worst_case) {
+    uint8_t data_bytes = rtr ? 0 : ((length > 8) ? 8 : length);
+    uint16_t stuffed = (extended ? STUFFED_BITS_EXT : STUFFED_BITS_STD) + 8 * data_bytes;
+    uint16_t bits = stuffed + UNSTUFFED_BITS;
+
+    // A stuff bit after every five equal bits; the first one needs five, each further one four
+    if (worst_case) bits += (stuffed - 1) / 4;
+    return bits;
+}
+
+/*===========================================================================*/
+/*                        KEY TABLE                                         */
+/*===========================================================================*/
+
+static inline uint16_t key_hash(uint32_t pgn, uint8_t source_address) {
+    uint32_t key = (pgn << 8) | source_address;
+    return (uint16_t)((key * 2654435761UL) >> 16) & (J1939_BUSMON_SLOTS - 1);
+}
+
+/**
+ * @brief Nominal period of a PGN: set at run time, else from the decoder table
+ */
+static uint32_t pgn_cycle_ms(const j1939_busmon_t* mon, uint32_t pgn) {
+    for (uint8_t i = 0; i < mon->cycle_count; i++) {
+        if (mon->cycles[i].pgn == pgn) return mon->cycles[i].cycle_ms;
+    }
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(pgn);
+    return (desc != NULL) ? desc->cycle_ms : 0;
+}
+
+/**
+ * @brief Find the slot of a key, claiming an unused one for a new key
+ * @return Slot index, or -1 if the table is full
+ */
+static int32_t find_or_insert_key(j1939_busmon_t* mon, uint32_t pgn, uint8_t source_address) {
+    uint16_t slot = key_hash(pgn, source_address);
+
+    for (uint16_t probe = 0; probe < J1939_BUSMON_SLOTS; probe++) {
+        j1939_busmon_key_t* k = &mon->keys[slot];
+        if (!k->used) {
+            k->pgn = pgn;
+            k->source_address = source_address;
+            k->cycle_ms = pgn_cycle_ms(mon, pgn);
+            k->used = true;
+            mon->stats.keys++;
+            return slot;
+        }
+        if (k->pgn == pgn && k->source_address == source_address) return slot;
+        slot = (slot + 1) & (J1939_BUSMON_SLOTS - 1);
+    }
+    return -1;
+}
+
+/*===========================================================================*/
+/*                        DEADLINE WHEEL                                    */
+/*===========================================================================*/
+
+#define WHEEL_UNARMED       0xFFFF
+#define WHEEL_SPAN_MS       ((uint32_t)J1939_BUSMON_WHEEL_SLOTS * J1939_BUSMON_WHEEL_TICK_MS)
+
+static inline uint16_t wheel_slot(uint32_t time_ms) {
+    return (uint16_t)((time_ms / J1939_BUSMON_WHEEL_TICK_MS) & (J1939_BUSMON_WHEEL_SLOTS - 1));
+}
+
+static inline uint32_t wheel_tick(uint32_t time_ms) {
+    return time_ms & ~(uint32_t)(J1939_BUSMON_WHEEL_TICK_MS - 1);
+}
+
+static void disarm_key(j1939_busmon_t* mon, j1939_busmon_key_t* k) {
+    if (k->wheel_slot == WHEEL_UNARMED) return;
+
+    if (k->wheel_prev != 0) {
+        mon->keys[k->wheel_prev - 1].wheel_next = k->wheel_next;
+    } else {
+        mon->wheel[k->wheel_slot] = k->wheel_next;
+    }
+    if (k->wheel_next != 0) {
+        mon->keys[k->wheel_next - 1].wheel_prev = k->wheel_prev;
+    }
+    k->wheel_slot = WHEEL_UNARMED;
+}
+
+/**
+ * @brief Set a key's lost deadline and file it under the matching slot
+ *
+ * A deadline already behind the sweep position goes into the next slot to
+ * be swept, so it still expires on the following sweep.
+ */
+static void arm_key(j1939_busmon_t* mon, j1939_busmon_key_t* k, uint32_t deadline_ms) {
+    disarm_key(mon, k);
+    k->deadline_ms = deadline_ms;
+
+    bool overdue = (int32_t)(deadline_ms - mon->wheel_ms) < 0;
+    uint16_t slot = wheel_slot(overdue ? mon->wheel_ms : deadline_ms);
+    uint16_t index = (uint16_t)(k - mon->keys + 1);
+    k->wheel_slot = slot;
+    k->wheel_prev = 0;
+    k->wheel_next = mon->wheel[slot];
+    if (k->wheel_next != 0) {
+        mon->keys[k->wheel_next - 1].wheel_prev = index;
+    }
+    mon->wheel[slot] = index;
+}
+
+static void publish_lost(j1939_busmon_t* mon, uint64_t timestamp_us) {
+    if (mon->dm == NULL) return;
+
+    data_manager_update_us(mon->dm, PARAM_BUS_LOST_COUNT, (float)mon->stats.lost_keys,
+                           SOURCE_COMPUTED, timestamp_us);
+}
+
+/**
+ * @brief Sweep every fully elapsed tick and report the keys found overdue
+ */
+static void sweep_wheel(j1939_busmon_t* mon, uint64_t now_us) {
+    uint32_t now_ms = (uint32_t)(now_us / 1000ULL);
+    uint32_t now_tick_ms = wheel_tick(now_ms);
+    int32_t behind_ms = (int32_t)(now_tick_ms - mon->wheel_ms);
+    if (behind_ms <= 0) return;
+    if ((uint32_t)behind_ms > WHEEL_SPAN_MS) {
+        mon->wheel_ms = now_tick_ms - WHEEL_SPAN_MS;  // After a long gap one revolution visits every slot
+    }
+
+    bool changed = false;
+    while (mon->wheel_ms != now_tick_ms) {
+        uint16_t slot = wheel_slot(mon->wheel_ms);
+        mon->wheel_ms += J1939_BUSMON_WHEEL_TICK_MS;
+
+        uint16_t index = mon->wheel[slot];
+        while (index != 0) {
+            j1939_busmon_key_t* k = &mon->keys[index - 1];
+            index = k->wheel_next;
+
+            if ((int32_t)(now_ms - k->deadline_ms) < 0) continue;  // A revolution or more ahead
+
+            disarm_key(mon, k);
+            k->lost = true;
+            k->lost_count++;
+            mon->stats.lost_events++;
+            mon->stats.lost_keys++;
+            changed = true;
+            if (mon->lost_handler != NULL) {
+                mon->lost_handler(k->pgn, k->source_address, k->last_us, mon->lost_user);
+            }
+        }
+    }
+    if (changed) publish_lost(mon, now_us);
+}
+
+/**
+ * @brief Fold one interval into a key's averages
+ */
+static void update_timing(j1939_busmon_key_t* k, uint32_t interval_us) {
+    if (k->interval_us == 0) {
+        k->interval_us = interval_us;  // First interval seeds the average
+    } else {
+        int64_t delta = (int64_t)interval_us - k->interval_us;
+        k->interval_us = (uint32_t)(k->interval_us + (delta >> J1939_BUSMON_JITTER_SHIFT));
+    }
+
+    uint32_t period_us = (k->cycle_ms > 0) ? k->cycle_ms * 1000UL : k->interval_us;
+    uint32_t deviation = (interval_us > period_us) ? interval_us - period_us : period_us - interval_us;
+    int64_t delta = (int64_t)deviation - k->jitter_us;
+    k->jitter_us = (uint32_t)(k->jitter_us + (delta >> J1939_BUSMON_JITTER_SHIFT));
+    if (deviation > k->max_jitter_us) k->max_jitter_us = deviation;
+}
+
+/**
+ * @brief Account a frame of a tracked key: timing, lateness and its deadline
+ */
+static void key_received(j1939_busmon_t* mon, j1939_busmon_key_t* k, uint64_t now_us) {
+    if (k->frames > 0 && now_us > k->last_us) {
+        uint64_t interval_us = now_us - k->last_us;
+        update_timing(k, (interval_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)interval_us);
+
+        if (k->cycle_ms > 0 && interval_us * 100 > (uint64_t)k->cycle_ms * 1000 * J1939_BUSMON_LATE_PCT) {
+            k->late++;
+            mon->stats.late++;
+        }
+    }
+    k->last_us = now_us;
+    k->frames++;
+    k->window_frames++;
+
+    if (k->cycle_ms == 0) return;  // Event driven or unknown: no deadline
+
+    if (k->lost) {
+        k->lost = false;
+        mon->stats.lost_keys--;
+        publish_lost(mon, now_us);
+    }
+    uint32_t now_ms = (uint32_t)(now_us / 1000ULL);
+    arm_key(mon, k, now_ms + k->cycle_ms * J1939_BUSMON_LOST_CYCLES);
+}
+
+/*===========================================================================*/
+/*                        WINDOWS                                           */
+/*===========================================================================*/
+
+static void publish(j1939_busmon_t* mon, uint64_t timestamp_us) {
+    if (mon->dm == NULL) return;
+
+    const j1939_busmon_stats_t* s = &mon->stats;
+    data_manager_update_us(mon->dm, PARAM_BUS_LOAD, s->load_pct, SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_LOAD_WORST, s->load_worst_pct, SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_FRAME_RATE, s->frame_rate, SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_OFF_CYCLE_COUNT, (float)s->off_cycle,
+                           SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_MAX_JITTER, s->max_jitter_us / 1000.0f,
+                           SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_BUSIEST_SA, (float)s->busiest_sa,
+                           SOURCE_COMPUTED, timestamp_us);
+    data_manager_update_us(mon->dm, PARAM_BUS_BUSIEST_SA_RATE, s->busiest_sa_rate,
+                           SOURCE_COMPUTED, timestamp_us);
+}
+
+/**
+ * @brief Turn the window's counts into rates and loads, then start a new one
+ */
+static void close_window(j1939_busmon_t* mon, uint64_t end_us) {
+    j1939_busmon_stats_t* s = &mon->stats;
+    float seconds = (float)(end_us - mon->window_start_us) / 1e6f;
+    float capacity = (float)mon->bit_rate * seconds;
+
+    s->windows++;
+    s->load_pct = (capacity > 0.0f) ? 100.0f * mon->window_bits / capacity : 0.0f;
+    s->load_worst_pct = (capacity > 0.0f) ? 100.0f * mon->window_bits_worst / capacity : 0.0f;
+    if (s->load_worst_pct > s->peak_load_pct) s->peak_load_pct = s->load_worst_pct;
+    s->frame_rate = mon->window_frames / seconds;
+
+    // Per key: rate, and whether it matched the nominal cycle
+    s->off_cycle = 0;
+    s->max_jitter_us = 0;
+    for (uint16_t i = 0; i < J1939_BUSMON_SLOTS; i++) {
+        j1939_busmon_key_t* k = &mon->keys[i];
+        if (!k->used) continue;
+
+        k->rate_hz = k->window_frames / seconds;
+        k->off_cycle = false;
+
+        // Judge keys seen before this window whose cycle fits in it
+        float expected = (k->cycle_ms > 0) ? seconds * 1000.0f / k->cycle_ms : 0.0f;
+        if (expected >= 1.0f && k->frames > k->window_frames) {
+            float tolerance = expected * J1939_BUSMON_RATE_TOLERANCE_PCT / 100.0f;
+            if (tolerance < 1.0f) tolerance = 1.0f;
+            k->off_cycle = fabsf(k->window_frames - expected) > tolerance;
+        }
+        if (k->off_cycle) s->off_cycle++;
+
+        if (k->cycle_ms > 0 && k->jitter_us > s->max_jitter_us) {
+            s->max_jitter_us = k->jitter_us;
+            s->max_jitter_pgn = k->pgn;
+            s->max_jitter_sa = k->source_address;
+        }
+        k->window_frames = 0;
+    }
+
+    // Chattiest source address
+    uint16_t busiest = 0;
+    for (uint16_t sa = 1; sa < 256; sa++) {
+        if (mon->sa_frames[sa] > mon->sa_frames[busiest]) busiest = sa;
+    }
+    s->busiest_sa = (uint8_t)busiest;
+    s->busiest_sa_rate = mon->sa_frames[busiest] / seconds;
+    memset(mon->sa_frames, 0, sizeof(mon->sa_frames));
+
+    mon->window_start_us = end_us;
+    mon->window_frames = 0;
+    mon->window_bits = 0;
+    mon->window_bits_worst = 0;
+
+    publish(mon, end_us);
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_busmon_init(j1939_busmon_t* mon, data_manager_t* dm, uint32_t bit_rate) {
+    if (mon == NULL) return;
+
+    memset(mon, 0, sizeof(j1939_busmon_t));
+    mon->dm = dm;
+    mon->bit_rate = bit_rate;
+    for (uint16_t i = 0; i < J1939_BUSMON_SLOTS; i++) {
+        mon->keys[i].wheel_slot = WHEEL_UNARMED;
+    }
+}
+
+void j1939_busmon_set_lost_handler(j1939_busmon_t* mon, j1939_busmon_lost_handler_t handler,
+                                   void* user) {
+    if (mon == NULL) return;
+
+    mon->lost_handler = handler;
+    mon->lost_user = user;
+}
+
+void j1939_busmon_frame(j1939_busmon_t* mon, const can_frame_t* frame) {
+    if (mon == NULL || frame == NULL) return;
+
+    uint64_t now_us = frame->timestamp_us;
+    if (mon->window_start_us == 0) {
+        mon->window_start_us = now_us;
+        mon->wheel_ms = wheel_tick((uint32_t)(now_us / 1000ULL));
+    } else {
+        sweep_wheel(mon, now_us);
+        if (now_us >= mon->window_start_us + J1939_BUSMON_WINDOW_MS * 1000ULL) {
+            close_window(mon, now_us);
+        }
+    }
+
+    mon->stats.frames++;
+    mon->window_frames++;
+    mon->window_bits += j1939_busmon_frame_bits(frame->is_extended, frame->is_rtr,
+                                                frame->length, false);
+    mon->window_bits_worst += j1939_busmon_frame_bits(frame->is_extended, frame->is_rtr,
+                                                      frame->length, true);
+
+    if (!frame->is_extended) return;  // Rates are tracked for J1939 traffic only
+
+    uint8_t source_address = (uint8_t)(frame->id & 0xFF);
+    mon->sa_frames[source_address]++;
+
+    int32_t slot = find_or_insert_key(mon, j1939_extract_pgn(frame->id), source_address);
+    if (slot < 0) {
+        mon->stats.untracked++;
+        return;
+    }
+
+    key_received(mon, &mon->keys[slot], now_us);
+}
+
+bool j1939_busmon_set_cycle(j1939_busmon_t* mon, uint32_t pgn, uint32_t cycle_ms) {
+    if (mon == NULL) return false;
+
+    uint8_t i = 0;
+    while (i < mon->cycle_count && mon->cycles[i].pgn != pgn) i++;
+    if (i == mon->cycle_count) {
+        if (mon->cycle_count >= J1939_BUSMON_MAX_CYCLES) return false;
+        mon->cycles[mon->cycle_count++].pgn = pgn;
+    }
+    mon->cycles[i].cycle_ms = cycle_ms;
+
+    // Keys already tracked: move armed deadlines to the new period
+    for (uint16_t slot = 0; slot < J1939_BUSMON_SLOTS; slot++) {
+        j1939_busmon_key_t* k = &mon->keys[slot];
+        if (!k->used || k->pgn != pgn) continue;
+
+        k->cycle_ms = cycle_ms;
+        if (k->wheel_slot == WHEEL_UNARMED) continue;
+        if (cycle_ms == 0) {
+            disarm_key(mon, k);
+        } else {
+            uint32_t last_ms = (uint32_t)(k->last_us / 1000ULL);
+            arm_key(mon, k, last_ms + cycle_ms * J1939_BUSMON_LOST_CYCLES);
+        }
+    }
+    return true;
+}
+
+void j1939_busmon_poll(j1939_busmon_t* mon, uint64_t now_us) {
+    if (mon == NULL || mon->window_start_us == 0) return;
+
+    sweep_wheel(mon, now_us);
+    if (now_us >= mon->window_start_us + J1939_BUSMON_WINDOW_MS * 1000ULL) {
+        close_window(mon, now_us);
+    }
+}
+
+bool j1939_busmon_get_key(const j1939_busmon_t* mon, uint16_t index, j1939_busmon_key_t* key) {
+    if (mon == NULL || key == NULL) return false;
+    if (index >= J1939_BUSMON_SLOTS || !mon->keys[index].used) return false;
+
+    *key = mon->keys[index];
+    return true;
+}
+
+void j1939_busmon_get_stats(const j1939_busmon_t* mon, j1939_busmon_stats_t* stats) {
+    if (mon == NULL || stats == NULL) return;
+
+    *stats = mon->stats;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file j1939_busmon.h
+ * @brief Bus load and per-(PGN, SA) rate monitor
+ *
+ * Runs on every received frame and costs a table lookup and a few integer
+ * operations:
+ *
+ *  - bus load from frame bit lengths, both without stuffing (lower bound)
+ *    and with worst-case stuff bits (upper bound)
+ *  - frames per second per (PGN, source address), and the interval jitter
+ *    against the PGN's nominal cycle time from the decoder table
+ *  - frames per second per source address, to spot chatty ECUs
+ *  - a deadline per cyclic (PGN, SA), re-armed on every reception: when
+ *    J1939_BUSMON_LOST_CYCLES cycle times pass without a frame the key is
+ *    reported lost (EEC1 after 30 ms, ET1 after 3 s)
+ *  - PGNs obtained by Request are not on their broadcast cycle: their
+ *    period is set with j1939_busmon_set_cycle() (the request period)
+ *
+ * Deadlines live on a timer wheel, so re-arming costs O(1) and a sweep only
+ * visits the keys due in the elapsed ticks, however many PGNs are tracked.
+ *
+ * Results are computed once per window (J1939_BUSMON_WINDOW_MS) and
+ * published to the data manager as the PARAM_BUS_* parameters. Only
+ * received frames are seen: once a hardware acceptance filter is installed
+ * the load covers the accepted traffic only.
+ */
+
+#ifndef J1939_BUSMON_H
+#define J1939_BUSMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "can_driver.h"
+#include "../data/data_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_BUSMON_SLOTS
+#define J1939_BUSMON_SLOTS          64      // (PGN, SA) pairs tracked (power of two)
+#endif
+
+#if (J1939_BUSMON_SLOTS & (J1939_BUSMON_SLOTS - 1)) != 0 || J1939_BUSMON_SLOTS > 32768
+#error "J1939_BUSMON_SLOTS must be a power of two no larger than 32768"
+#endif
+
+#ifndef J1939_BUSMON_WINDOW_MS
+#define J1939_BUSMON_WINDOW_MS      1000    // Measurement window
+#endif
+
+#ifndef J1939_BUSMON_RATE_TOLERANCE_PCT
+#define J1939_BUSMON_RATE_TOLERANCE_PCT 25  // Rate deviation before a key counts as off-cycle
+#endif
+
+#define J1939_BUSMON_JITTER_SHIFT   3       // Jitter average weight: 1/8 per interval
+
+#ifndef J1939_BUSMON_LOST_CYCLES
+#define J1939_BUSMON_LOST_CYCLES    3       // Missed cycles before a key is reported lost
+#endif
+
+#ifndef J1939_BUSMON_MAX_CYCLES
+#define J1939_BUSMON_MAX_CYCLES     8       // PGNs whose period is set at run time
+#endif
+
+#ifndef J1939_BUSMON_LATE_PCT
+#define J1939_BUSMON_LATE_PCT       150     // Interval (percent of the cycle) counted as late
+#endif
+
+// Deadlines live on a wheel of J1939_BUSMON_WHEEL_SLOTS slots of
+// J1939_BUSMON_WHEEL_TICK_MS; longer deadlines wait out extra revolutions
+#ifndef J1939_BUSMON_WHEEL_SLOTS
+#define J1939_BUSMON_WHEEL_SLOTS    256
+#endif
+#ifndef J1939_BUSMON_WHEEL_TICK_MS
+#define J1939_BUSMON_WHEEL_TICK_MS  8
+#endif
+#if (J1939_BUSMON_WHEEL_SLOTS & (J1939_BUSMON_WHEEL_SLOTS - 1)) != 0
+#error "J1939_BUSMON_WHEEL_SLOTS must be a power of two"
+#endif
+#if (J1939_BUSMON_WHEEL_TICK_MS & (J1939_BUSMON_WHEEL_TICK_MS - 1)) != 0
+#error "J1939_BUSMON_WHEEL_TICK_MS must be a power of two (slots stay aligned across wrap)"
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Timing of one (PGN, source address)
+ */
+typedef struct {
+    uint32_t pgn;               // Parameter Group Number (destination stripped)
+    uint8_t source_address;     // Transmitting ECU
+    bool used;                  // Slot holds a key
+    bool off_cycle;             // Last window's rate missed the nominal one
+    bool lost;                  // Deadline passed; cleared by the next frame
+    uint32_t cycle_ms;          // Nominal period: decoder table or set cycle (0 = unknown/event)
+    uint64_t last_us;           // Receive time of the newest frame
+    uint32_t frames;            // Frames received for this key
+    uint32_t window_frames;     // Frames in the current window
+    float rate_hz;              // Frames per second over the last window
+    uint32_t interval_us;       // Average interval between frames
+    uint32_t jitter_us;         // Average deviation from the nominal period (or the average interval)
+    uint32_t max_jitter_us;     // Largest single deviation seen
+    uint32_t late;              // Frames arriving after J1939_BUSMON_LATE_PCT of the cycle
+    uint32_t lost_count;        // Times the key was reported lost
+    uint32_t deadline_ms;       // Lost deadline (valid while on the wheel)
+    uint16_t wheel_slot;        // Timer wheel slot (0xFFFF = not armed)
+    uint16_t wheel_next;        // Next / previous key in that slot (index + 1, 0 = none)
+    uint16_t wheel_prev;
+} j1939_busmon_key_t;
+
+/**
+ * @brief Period of a PGN set at run time, overriding the decoder table
+ */
+typedef struct {
+    uint32_t pgn;
+    uint32_t cycle_ms;          // 0 = no deadline
+} j1939_busmon_cycle_t;
+
+/**
+ * @brief Bus monitor results (rates and loads as of the last completed window)
+ */
+typedef struct {
+    uint32_t frames;            // Frames seen
+    uint32_t windows;           // Completed windows
+    float load_pct;             // Bus load without stuff bits
+    float load_worst_pct;       // Bus load with worst-case stuffing
+    float peak_load_pct;        // Highest worst-case load of any window
+    float frame_rate;           // Frames per second
+    uint16_t keys;              // (PGN, SA) pairs tracked
+    uint16_t off_cycle;         // Keys whose rate missed their nominal cycle
+    uint32_t untracked;         // Frames not tracked per key (table full)
+    uint8_t busiest_sa;         // Source address sending the most frames
+    float busiest_sa_rate;      // Its frames per second
+    uint32_t max_jitter_us;     // Worst average jitter of a cyclic key
+    uint32_t max_jitter_pgn;    // ... and its PGN
+    uint8_t max_jitter_sa;      // ... and source address
+    uint32_t late;              // Late frames (all keys)
+    uint32_t lost_events;       // Keys reported lost
+    uint16_t lost_keys;         // Keys currently lost
+} j1939_busmon_stats_t;
+
+/**
+ * @brief Called when a cyclic (PGN, SA) misses its deadline
+ * @param pgn Parameter Group Number
+ * @param source_address Silent ECU
+ * @param last_us Receive time of its last frame
+ * @param user Context passed to j1939_busmon_set_lost_handler()
+ */
+typedef void (*j1939_busmon_lost_handler_t)(uint32_t pgn, uint8_t source_address,
+                                            uint64_t last_us, void* user);
+
+/**
+ * @brief Bus monitor
+ *
+ * Fed and polled by one task (the decode task); other tasks read the
+ * published parameters.
+ */
+typedef struct {
+    j1939_busmon_key_t keys[J1939_BUSMON_SLOTS];
+    uint32_t sa_frames[256];            // Frames per source address in the current window
+    data_manager_t* dm;                 // May be NULL (nothing published)
+    uint32_t bit_rate;                  // Bus bit rate (bits/s)
+    uint64_t window_start_us;           // 0 until the first frame
+    uint32_t window_frames;
+    uint32_t window_bits;               // Bits without stuffing
+    uint32_t window_bits_worst;         // Bits with worst-case stuffing
+    uint16_t wheel[J1939_BUSMON_WHEEL_SLOTS];  // Slot -> first key index + 1 (0 = empty)
+    uint32_t wheel_ms;                  // Start of the next wheel tick to sweep
+    j1939_busmon_cycle_t cycles[J1939_BUSMON_MAX_CYCLES];  // Run-time periods
+    uint8_t cycle_count;
+    j1939_busmon_lost_handler_t lost_handler;
+    void* lost_user;
+    j1939_busmon_stats_t stats;
+} j1939_busmon_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize a bus monitor
+ * @param mon Monitor to initialize
+ * @param dm Data manager to publish PARAM_BUS_* to, or NULL
+ * @param bit_rate Bus bit rate in bits/s (e.g. 250000)
+ */
+void j1939_busmon_init(j1939_busmon_t* mon, data_manager_t* dm, uint32_t bit_rate);
+
+/**
+ * @brief Bits a frame occupies on the bus, including the interframe space
+ *
+ * Worst case adds one stuff bit per four bits of the stuffed region
+ * (start of frame through CRC): 160 bits for an 8-byte extended frame
+ * instead of 131.
+ *
+ * @param extended 29-bit identifier
+ * @param rtr Remote frame (no data field)
+ * @param length Data length (clamped to 8)
+ * @param worst_case Include worst-case stuff bits
+ * @return Frame length in bits
+ */
+uint16_t j1939_busmon_frame_bits(bool extended, bool rtr, uint8_t length, bool worst_case);
+
+/**
+ * @brief Account one received frame
+ *
+ * Closes the window first when the frame's timestamp is past its end.
+ *
+ * @param mon Monitor
+ * @param frame Frame as delivered by the CAN driver (any identifier type)
+ */
+void j1939_busmon_frame(j1939_busmon_t* mon, const can_frame_t* frame);
+
+/**
+ * @brief Install the handler for lost (PGN, SA) events
+ * @param mon Monitor
+ * @param handler Called from j1939_busmon_frame() / j1939_busmon_poll(), or NULL
+ * @param user Context passed to the handler
+ */
+void j1939_busmon_set_lost_handler(j1939_busmon_t* mon, j1939_busmon_lost_handler_t handler,
+                                   void* user);
+
+/**
+ * @brief Set the period a PGN is expected at, for every source address
+ *
+ * Overrides the decoder table's cycle time, for keys already tracked too:
+ * a PGN obtained by Request arrives at the request period, not its
+ * broadcast cycle, and would otherwise be reported lost three cycles after
+ * every answer. An armed deadline moves to the new period.
+ *
+ * @param mon Monitor
+ * @param pgn Parameter Group Number
+ * @param cycle_ms Expected period (0 = no deadline)
+ * @return true if set (false: J1939_BUSMON_MAX_CYCLES PGNs already set)
+ */
+bool j1939_busmon_set_cycle(j1939_busmon_t* mon, uint32_t pgn, uint32_t cycle_ms);
+
+/**
+ * @brief Expire overdue deadlines and close the window if it has ended
+ *
+ * Frames sweep the wheel too; polling covers an idle bus. Loss is noticed
+ * within one J1939_BUSMON_WHEEL_TICK_MS of the deadline plus the poll period.
+ *
+ * @param mon Monitor
+ * @param now_us Current time on the frame timestamp clock
+ */
+void j1939_busmon_poll(j1939_busmon_t* mon, uint64_t now_us);
+
+/**
+ * @brief Copy a key's timing by table index
+ * @param mon Monitor
+ * @param index Table index (0 .. J1939_BUSMON_SLOTS - 1)
+ * @param key Output: key timing
+ * @return true if the slot holds a key
+ */
+bool j1939_busmon_get_key(const j1939_busmon_t* mon, uint16_t index, j1939_busmon_key_t* key);
+
+/**
+ * @brief Get the results of the last completed window
+ * @param mon Monitor
+ * @param stats Output: results
+ */
+void j1939_busmon_get_stats(const j1939_busmon_t* mon, j1939_busmon_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_BUSMON_H */
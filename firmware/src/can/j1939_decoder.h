@@ -0,0 +1,188 @@
+/**
+ * @file j1939_decoder.h
+ * @brief Table-driven J1939 signal decoder
+ *
+ * Decodes every mapped SPN of a J1939 frame in a single pass using a constant
+ * signal descriptor table (start bit, length, scale, offset, NA/error limit,
+ * target parameter). Adding a PGN is a table entry in j1939_decoder.cpp.
+ * A sorted SPN index over the same tables backs j1939_decode_spn().
+ */
+
+#ifndef J1939_DECODER_H
+#define J1939_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+#include "../data/data_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONSTANTS                                         */
+/*===========================================================================*/
+
+#define J1939_DECODER_MAX_SIGNALS_PER_PGN   8       // Upper bound for output arrays
+#define J1939_PGN_INDEX_MAX_PAGES           8       // Distinct DP/PF values indexed
+
+/**
+ * @brief First invalid raw value for a signal of the given bit length
+ *
+ * Per J1939-71 the top of each range is reserved for error/not-available:
+ * 0xFE/0xFF for 8-bit, 0xFE00+ for 16-bit, 2/3 for 2-bit status fields, etc.
+ */
+#define J1939_SIGNAL_RAW_LIMIT(bits) \
+    ((bits) >= 8 ? ((uint32_t)0xFE << ((bits) - 8)) : (((uint32_t)1 << (bits)) - 2))
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Signal descriptor (one SPN within a PGN)
+ *
+ * Bit positions use Intel (little-endian) numbering as in the DBC file:
+ * start_bit = byte_index * 8 + bit_in_byte.
+ */
+typedef struct {
+    uint16_t spn;               // Suspect Parameter Number
+    uint8_t start_bit;          // LSB position in the 64-bit payload
+    uint8_t bit_length;         // Signal width (1-32)
+    data_scaling_t scaling;     // Engineering units: raw * scale + offset
+    uint32_t raw_limit;         // Raw values >= limit are error/NA
+    param_id_t param_id;        // Data manager target
+} j1939_signal_t;
+
+/**
+ * @brief PGN descriptor: signal decoder slice, name, nominal cycle time and sender
+ *
+ * One record per known PGN, shared by the decoder, log output and display.
+ * source_function routes the PGN to one ECU through address claims
+ * (j1939_addr_accepts()), whatever address that ECU has on this truck.
+ */
+typedef struct {
+    uint32_t pgn;               // Parameter Group Number
+    const char* name;           // "ACRONYM - Description"
+    uint16_t cycle_ms;          // Nominal broadcast period (0 = on request/event)
+    uint8_t source_function;    // NAME function of the sender (J1939_FUNCTION_ANY = any node)
+    const j1939_signal_t* signals;  // Signal descriptors (NULL if none decoded)
+    uint8_t signal_count;       // Number of signals for this PGN
+} j1939_pgn_desc_t;
+
+/**
+ * @brief SPN index entry (flash-resident, sorted by SPN)
+ */
+typedef struct {
+    uint16_t spn;               // Suspect Parameter Number
+    uint32_t pgn;               // PGN carrying this SPN
+    const j1939_signal_t* signal;   // Layout within the PGN
+} j1939_spn_entry_t;
+
+/**
+ * @brief Decoded signal value ready for the data manager
+ */
+typedef struct {
+    param_id_t param_id;        // Target parameter
+    float value;                // Physical value
+} j1939_signal_value_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Build the PGN dispatch index
+ *
+ * Two-level dense table: (DP, PF) selects a 256-entry page, PS selects the
+ * descriptor. Called from j1939_parser_init(); lookups build it on first use
+ * otherwise.
+ *
+ * @return true if every descriptor was indexed
+ */
+bool j1939_pgn_index_init(void);
+
+/**
+ * @brief Find the descriptor for a PGN in constant time
+ * @param pgn Parameter Group Number
+ * @return Descriptor, or NULL if the PGN is unknown
+ */
+const j1939_pgn_desc_t* j1939_decoder_find_pgn(uint32_t pgn);
+
+/**
+ * @brief Get the PGN descriptor table (sorted by PGN)
+ * @param count Output: number of descriptors
+ * @return Pointer to the first descriptor
+ */
+const j1939_pgn_desc_t* j1939_decoder_get_pgns(uint16_t* count);
+
+/**
+ * @brief Find the index entry for an SPN (binary search)
+ * @param spn Suspect Parameter Number
+ * @return Entry with carrying PGN and layout, or NULL if unknown
+ */
+const j1939_spn_entry_t* j1939_decoder_find_spn(uint16_t spn);
+
+/**
+ * @brief Get the SPN index (sorted by SPN)
+ * @param count Output: number of entries
+ * @return Pointer to the first entry
+ */
+const j1939_spn_entry_t* j1939_decoder_get_spns(uint16_t* count);
+
+/**
+ * @brief Pack frame data into a little-endian 64-bit payload
+ * @param data Frame data bytes
+ * @param data_length Number of valid bytes (missing bytes read as 0xFF)
+ * @return Payload with byte 0 in bits 0-7
+ */
+uint64_t j1939_decoder_load_payload(const uint8_t* data, uint8_t data_length);
+
+/**
+ * @brief Extract a raw signal value from a packed payload
+ */
+static inline uint32_t j1939_signal_extract_raw(uint64_t payload, const j1939_signal_t* sig) {
+    uint64_t mask = (sig->bit_length >= 32) ? 0xFFFFFFFFULL : ((1ULL << sig->bit_length) - 1);
+    return (uint32_t)((payload >> sig->start_bit) & mask);
+}
+
+/**
+ * @brief Convert a raw signal value to engineering units
+ */
+static inline float j1939_signal_to_physical(uint32_t raw, const j1939_signal_t* sig) {
+    return data_scaling_apply(&sig->scaling, raw);
+}
+
+/**
+ * @brief Decode all mapped signals of a frame
+ * @param msg Parsed J1939 message
+ * @param values Output array of decoded values
+ * @param max_values Capacity of values array
+ * @return Number of valid values written (error/NA signals are skipped)
+ *
+ * Only signals mapped to a parameter are decoded; on-demand SPNs
+ * (param_id PARAM_NONE) are reachable through j1939_decode_spn().
+ */
+uint8_t j1939_decode_signals(const j1939_message_t* msg,
+                             j1939_signal_value_t* values, uint8_t max_values);
+
+/**
+ * @brief Decode a frame and publish every valid signal to the data manager
+ * @param msg Parsed J1939 message
+ * @param dm Data manager to update
+ * @param source Data source tag
+ * @return Number of parameters updated
+ * 
+ * Parameters are stamped with the message's receive time (timestamp_us).
+ * Values go to the data manager raw with the signal's scaling, so this path
+ * is integer-only in DATA_FIXED_POINT builds.
+ */
+uint8_t j1939_decoder_process(const j1939_message_t* msg, data_manager_t* dm,
+                              data_source_t source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_DECODER_H */
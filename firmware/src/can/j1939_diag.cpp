@@ -0,0 +1,290 @@
+/**
+ * @file j1939_diag.cpp
+ * @brief DM2 / DM4 capture implementation
+ */
+
+#include "j1939_diag.h"
+#include "j1939_decoder.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        FREEZE FRAME LAYOUT                               */
+/*===========================================================================*/
+
+// Standard parameters in snapshot order. Each starts on the byte after the
+// previous one; width, scale and offset are the live signal's (decoder SPN index).
+static const uint16_t freeze_frame_spns[] = {
+    899,                        // Engine torque mode (byte 0)
+    102,                        // Boost pressure (byte 1)
+    190,                        // Engine speed (bytes 2-3)
+    92,                         // Percent load at current speed (byte 4)
+    110,                        // Engine coolant temperature (byte 5)
+    84,                         // Wheel-based vehicle speed (bytes 6-7)
+};
+
+#define FREEZE_FRAME_FIELD_COUNT \
+    ((uint8_t)(sizeof(freeze_frame_spns) / sizeof(freeze_frame_spns[0])))
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+static inline uint8_t job_state(const j1939_diag_job_t* job) {
+    return __atomic_load_n(&job->state, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Drop the job's DM2 / DM4 requests still registered with the scheduler
+ */
+static void release_requests(j1939_diag_t* diag, j1939_diag_job_t* job) {
+    if (job->dm2_requested) {
+        j1939_request_remove(diag->requests, PGN_DM2, job->source_address);
+        job->dm2_requested = false;
+    }
+    if (job->dm4_requested) {
+        j1939_request_remove(diag->requests, PGN_DM4, job->source_address);
+        job->dm4_requested = false;
+    }
+}
+
+/**
+ * @brief Hand a job over to the background task
+ */
+static void complete_job(j1939_diag_t* diag, j1939_diag_job_t* job, uint64_t now_us) {
+    release_requests(diag, job);
+    job->completed_us = now_us;
+    if (job->dm2_received && job->dm4_received) {
+        diag->stats.completed++;
+    } else {
+        diag->stats.incomplete++;
+    }
+    __atomic_store_n(&job->state, (uint8_t)J1939_DIAG_DONE, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Hand over a DM2 no capture asked for (the periodic global request)
+ *
+ * A reply without faults (first DTC SPN 0 / FMI 0) takes no slot.
+ */
+static bool take_unsolicited_dm2(j1939_diag_t* diag, uint8_t source_address,
+                                 const uint8_t* data, uint16_t len, uint64_t timestamp_us) {
+    if (len < 6 || (data[2] | data[3] | data[4]) == 0) return false;
+
+    for (uint8_t i = 0; i < J1939_DIAG_MAX_JOBS; i++) {
+        j1939_diag_job_t* job = &diag->jobs[i];
+        if (job_state(job) != J1939_DIAG_FREE) continue;
+
+        if (len > J1939_DIAG_BUFFER) {
+            diag->stats.truncated++;
+            len = J1939_DIAG_BUFFER;
+        }
+
+        memset(job, 0, sizeof(j1939_diag_job_t));
+        job->source_address = source_address;
+        job->started_us = timestamp_us;
+        job->completed_us = timestamp_us;
+        memcpy(job->dm2, data, len);
+        job->dm2_length = len;
+        job->dm2_received = true;
+        diag->stats.unsolicited++;
+        __atomic_store_n(&job->state, (uint8_t)J1939_DIAG_DONE, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    diag->stats.dropped++;
+    return false;
+}
+
+/*===========================================================================*/
+/*                        CAPTURE (DECODE TASK)                             */
+/*===========================================================================*/
+
+void j1939_diag_init(j1939_diag_t* diag, j1939_request_sched_t* requests) {
+    if (diag == NULL) return;
+
+    memset(diag, 0, sizeof(j1939_diag_t));
+    diag->requests = requests;
+}
+
+bool j1939_diag_capture(j1939_diag_t* diag, uint8_t source_address, uint64_t now_us) {
+    if (diag == NULL) return false;
+
+    j1939_diag_job_t* slot = NULL;
+    for (uint8_t i = 0; i < J1939_DIAG_MAX_JOBS; i++) {
+        j1939_diag_job_t* job = &diag->jobs[i];
+        uint8_t state = job_state(job);
+        if (state == J1939_DIAG_WAITING && job->source_address == source_address) {
+            diag->stats.coalesced++;  // The running capture covers this fault too
+            return true;
+        }
+        if (state == J1939_DIAG_FREE && slot == NULL) slot = job;
+    }
+
+    if (slot == NULL) {
+        diag->stats.dropped++;
+        return false;
+    }
+
+    // The slot is free: the background task no longer touches it
+    memset(slot, 0, sizeof(j1939_diag_job_t));
+    slot->source_address = source_address;
+    slot->started_us = now_us;
+    if (diag->requests != NULL) {
+        slot->dm4_requested = j1939_request_add(diag->requests, PGN_DM4, source_address, 0, now_us);
+        slot->dm2_requested = j1939_request_add(diag->requests, PGN_DM2, source_address, 0, now_us);
+        if (!slot->dm4_requested || !slot->dm2_requested) {
+            release_requests(diag, slot);  // A capture nobody is asked for would only time out
+            diag->stats.unrequested++;
+            return false;
+        }
+    }
+    slot->state = J1939_DIAG_WAITING;
+    diag->stats.started++;
+    return true;
+}
+
+bool j1939_diag_payload(j1939_diag_t* diag, uint32_t pgn, uint8_t source_address,
+                        const uint8_t* data, uint16_t len, uint64_t timestamp_us) {
+    if (diag == NULL || data == NULL || (pgn != PGN_DM2 && pgn != PGN_DM4)) return false;
+
+    for (uint8_t i = 0; i < J1939_DIAG_MAX_JOBS; i++) {
+        j1939_diag_job_t* job = &diag->jobs[i];
+        if (job_state(job) != J1939_DIAG_WAITING || job->source_address != source_address) continue;
+
+        if (len > J1939_DIAG_BUFFER) {
+            diag->stats.truncated++;
+            len = J1939_DIAG_BUFFER;
+        }
+
+        // Copy only: parsing and storage happen in the background task
+        if (pgn == PGN_DM2) {
+            memcpy(job->dm2, data, len);
+            job->dm2_length = len;
+            job->dm2_received = true;
+        } else {
+            memcpy(job->dm4, data, len);
+            job->dm4_length = len;
+            job->dm4_received = true;
+        }
+
+        if (job->dm2_received && job->dm4_received) {
+            complete_job(diag, job, timestamp_us);
+        }
+        return true;
+    }
+
+    if (pgn == PGN_DM2) {
+        return take_unsolicited_dm2(diag, source_address, data, len, timestamp_us);
+    }
+    return false;
+}
+
+void j1939_diag_poll(j1939_diag_t* diag, uint64_t now_us) {
+    if (diag == NULL) return;
+
+    for (uint8_t i = 0; i < J1939_DIAG_MAX_JOBS; i++) {
+        j1939_diag_job_t* job = &diag->jobs[i];
+        if (job_state(job) != J1939_DIAG_WAITING) continue;
+
+        if (now_us - job->started_us >= J1939_DIAG_TIMEOUT_MS * 1000ULL) {
+            complete_job(diag, job, now_us);  // Store what arrived
+        }
+    }
+}
+
+/*===========================================================================*/
+/*                        RESULTS (BACKGROUND TASK)                         */
+/*===========================================================================*/
+
+bool j1939_diag_take(j1939_diag_t* diag, j1939_diag_job_t* job) {
+    if (diag == NULL || job == NULL) return false;
+
+    for (uint8_t i = 0; i < J1939_DIAG_MAX_JOBS; i++) {
+        j1939_diag_job_t* done = &diag->jobs[i];
+        if (job_state(done) != J1939_DIAG_DONE) continue;
+
+        memcpy(job, done, sizeof(j1939_diag_job_t));
+        __atomic_store_n(&done->state, (uint8_t)J1939_DIAG_FREE, __ATOMIC_RELEASE);
+        return true;
+    }
+    return false;
+}
+
+uint8_t j1939_parse_dm4(const uint8_t* data, uint16_t len,
+                        j1939_freeze_frame_t* frames, uint8_t max_frames) {
+    if (data == NULL || frames == NULL || max_frames == 0) return 0;
+
+    // Each record: length byte (bytes that follow), 4-byte DTC, parameters
+    uint8_t count = 0;
+    uint16_t offset = 0;
+
+    while (offset < len && count < max_frames) {
+        uint8_t record_length = data[offset];
+        if (record_length < 4 || offset + 1 + record_length > len) break;
+
+        const uint8_t* dtc = &data[offset + 1];
+        uint32_t spn = (uint32_t)dtc[0] |
+                       ((uint32_t)dtc[1] << 8) |
+                       (((uint32_t)(dtc[2] & 0xE0)) << 11);
+        uint8_t fmi = dtc[2] & 0x1F;
+
+        // Skip "no freeze frame" records (SPN=0, FMI=0)
+        if (spn != 0 || fmi != 0) {
+            j1939_freeze_frame_t* frame = &frames[count++];
+            uint8_t snapshot_length = record_length - 4;
+            if (snapshot_length > J1939_FREEZE_FRAME_SNAPSHOT) {
+                snapshot_length = J1939_FREEZE_FRAME_SNAPSHOT;  // Manufacturer bytes dropped
+            }
+
+            memset(frame, 0, sizeof(j1939_freeze_frame_t));
+            frame->dtc.spn = spn;
+            frame->dtc.fmi = fmi;
+            frame->dtc.oc = dtc[3] & 0x7F;
+            frame->snapshot_length = snapshot_length;
+            memcpy(frame->snapshot, &dtc[4], snapshot_length);
+        }
+
+        offset += 1 + record_length;
+    }
+
+    return count;
+}
+
+bool j1939_freeze_frame_decode(const uint8_t* snapshot, uint8_t snapshot_length,
+                               uint16_t spn, float* value) {
+    if (snapshot == NULL || value == NULL) return false;
+
+    uint8_t start_bit = 0;
+    for (uint8_t i = 0; i < FREEZE_FRAME_FIELD_COUNT; i++) {
+        const j1939_spn_entry_t* entry = j1939_decoder_find_spn(freeze_frame_spns[i]);
+        if (entry == NULL) return false;
+        if (freeze_frame_spns[i] != spn) {
+            start_bit += (entry->signal->bit_length + 7) & ~7;  // Byte-aligned
+            continue;
+        }
+
+        j1939_signal_t sig = *entry->signal;
+        sig.start_bit = start_bit;
+
+        uint8_t length = (snapshot_length > J1939_FREEZE_FRAME_SNAPSHOT) ?
+                         J1939_FREEZE_FRAME_SNAPSHOT : snapshot_length;
+        uint64_t payload = j1939_decoder_load_payload(snapshot, length);
+        uint32_t raw = j1939_signal_extract_raw(payload, &sig);
+        if (raw >= sig.raw_limit) return false;  // Error, not available or not captured
+
+        *value = j1939_signal_to_physical(raw, &sig);
+        return true;
+    }
+    return false;
+}
+
+const uint16_t* j1939_freeze_frame_get_spns(uint8_t* count) {
+    if (count != NULL) *count = FREEZE_FRAME_FIELD_COUNT;
+    return freeze_frame_spns;
+}
+
+void j1939_diag_get_stats(const j1939_diag_t* diag, j1939_diag_stats_t* stats) {
+    if (diag == NULL || stats == NULL) return;
+
+    *stats = diag->stats;
+}
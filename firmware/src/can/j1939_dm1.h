@@ -0,0 +1,140 @@
+/**
+ * @file j1939_dm1.h
+ * @brief Per-ECU active fault table fed by DM1 (single frame or TP)
+ *
+ * Most ECUs repeat the same DM1 every second. Each ECU's last payload is
+ * remembered as a hash; an identical repetition costs one hash over the
+ * payload and nothing else. Only a different payload is parsed and compared
+ * with the ECU's fault set, and only faults that appeared or cleared are
+ * reported to the change handler (which persists them).
+ */
+
+#ifndef J1939_DM1_H
+#define J1939_DM1_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_DM1_MAX_ECUS
+#define J1939_DM1_MAX_ECUS          16      // Source addresses tracked
+#endif
+
+#ifndef J1939_DM1_MAX_DTCS
+#define J1939_DM1_MAX_DTCS          16      // Active faults kept per ECU
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Active faults of one ECU, as of its last DM1
+ */
+typedef struct {
+    uint8_t source_address;     // Reporting ECU
+    bool used;                  // Slot holds an ECU
+    uint8_t dtc_count;          // Active faults (up to J1939_DM1_MAX_DTCS)
+    uint16_t length;            // Length of the last DM1 payload
+    uint32_t hash;              // Hash of the last DM1 payload
+    j1939_lamp_status_t lamps;
+    j1939_dtc_t dtcs[J1939_DM1_MAX_DTCS];
+    uint64_t last_us;           // Receive time of the last DM1
+    uint32_t messages;          // DM1s received
+    uint32_t changes;           // DM1s that changed the fault set or lamps
+} j1939_dm1_ecu_t;
+
+/**
+ * @brief DM1 processing counters
+ */
+typedef struct {
+    uint32_t messages;          // DM1s processed
+    uint32_t repeats;           // Identical to the ECU's previous DM1 (hash match)
+    uint32_t changes;           // Fault set or lamps changed
+    uint32_t truncated;         // DM1s with more faults than J1939_DM1_MAX_DTCS
+    uint32_t overflow;          // DM1s dropped because the ECU table was full
+} j1939_dm1_stats_t;
+
+/**
+ * @brief Called for each fault that appears or clears
+ * @param dtc Fault (source_address set)
+ * @param active true if it appeared, false if it cleared
+ * @param timestamp_us Receive time of the DM1 that showed the change
+ * @param user Context passed to j1939_dm1_init()
+ */
+typedef void (*j1939_dm1_change_handler_t)(const j1939_dtc_t* dtc, bool active,
+                                           uint64_t timestamp_us, void* user);
+
+/**
+ * @brief Active fault table
+ */
+typedef struct {
+    j1939_dm1_ecu_t ecus[J1939_DM1_MAX_ECUS];
+    uint16_t active_count;      // Active faults over all ECUs
+    bool mil;                   // Any ECU lights its malfunction lamp
+    j1939_dm1_change_handler_t handler;
+    void* user;
+    j1939_dm1_stats_t stats;
+} j1939_dm1_table_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize an empty fault table
+ * @param table Table to initialize
+ * @param handler Called per appeared/cleared fault, or NULL
+ * @param user Context passed to the handler
+ */
+void j1939_dm1_init(j1939_dm1_table_t* table, j1939_dm1_change_handler_t handler, void* user);
+
+/**
+ * @brief Process a DM1 payload
+ * @param table Fault table
+ * @param source_address Reporting ECU
+ * @param data DM1 payload (8 bytes single frame, or a TP payload)
+ * @param len Payload length
+ * @param timestamp_us Receive time
+ * @return true if the ECU is new or its fault set or lamps changed
+ */
+bool j1939_dm1_process(j1939_dm1_table_t* table, uint8_t source_address,
+                       const uint8_t* data, uint16_t len, uint64_t timestamp_us);
+
+/**
+ * @brief Drop an ECU that stopped sending DM1, clearing its faults
+ * @param table Fault table
+ * @param source_address Silent ECU
+ * @param timestamp_us Time reported to the handler for the cleared faults
+ * @return true if the ECU was tracked
+ */
+bool j1939_dm1_forget(j1939_dm1_table_t* table, uint8_t source_address, uint64_t timestamp_us);
+
+/**
+ * @brief Look up an ECU's active faults
+ * @param table Fault table
+ * @param source_address ECU
+ * @return ECU entry, or NULL if it has not sent DM1
+ */
+const j1939_dm1_ecu_t* j1939_dm1_find(const j1939_dm1_table_t* table, uint8_t source_address);
+
+/**
+ * @brief Get DM1 processing counters
+ * @param table Fault table
+ * @param stats Output: counters
+ */
+void j1939_dm1_get_stats(const j1939_dm1_table_t* table, j1939_dm1_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_DM1_H */
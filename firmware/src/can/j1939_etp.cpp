@@ -0,0 +1,320 @@
+/**
+ * @file j1939_etp.cpp
+ * @brief J1939-21 Extended Transport Protocol receiver (ETP.CM / ETP.DT)
+ *
+ * Receive side of ETP connections addressed to our address, for transfers
+ * larger than the 1785 bytes TP can carry. Nothing is reassembled in RAM:
+ * each CTS window is announced by the sender with a DPO, and every packet
+ * of it is checked for order and written straight to the configured sink
+ * (logger, flash, ...), so a session costs the same whatever the size.
+ *
+ *   RTS -> CTS(n, next) -> DPO(n, offset) -> DT x n -> CTS ... -> EOMA
+ */
+
+#include "j1939_parser.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        CONTROL FRAMES                                    */
+/*===========================================================================*/
+
+static inline bool time_reached(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+static inline uint32_t read_pgn(const uint8_t* data) {
+    return (uint32_t)data[5] | ((uint32_t)data[6] << 8) | ((uint32_t)data[7] << 16);
+}
+
+/**
+ * @brief Send an ETP.CM frame to a sender
+ */
+static void send_etp_cm(j1939_parser_context_t* ctx, uint8_t destination, const uint8_t* data) {
+    uint32_t can_id = j1939_build_can_id(PGN_ETP_CM | destination, ctx->tp_local_address, 7);
+
+    if (ctx->tp_send == NULL || !ctx->tp_send(can_id, data, 8, ctx->tp_send_user)) {
+        ctx->tp_conn_stats.send_failures++;
+    }
+}
+
+static void send_etp_abort(j1939_parser_context_t* ctx, uint8_t destination, uint32_t pgn,
+                           uint8_t reason) {
+    uint8_t data[8] = { TP_CM_ABORT, reason, 0xFF, 0xFF, 0xFF,
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_etp_cm(ctx, destination, data);
+    ctx->etp_stats.aborts_sent++;
+}
+
+/**
+ * @brief End a transfer: tell the sink how it ended and free the session
+ */
+static void close_etp_session(j1939_parser_context_t* ctx, etp_session_t* session,
+                              uint8_t result) {
+    const j1939_etp_sink_t* sink = ctx->etp_sink;
+    if (sink != NULL && sink->end != NULL) {
+        sink->end(&session->xfer, result, sink->user);
+    }
+    session->active = false;
+}
+
+static void abort_etp_session(j1939_parser_context_t* ctx, etp_session_t* session,
+                              uint8_t reason) {
+    send_etp_abort(ctx, session->xfer.source_address, session->xfer.pgn, reason);
+    close_etp_session(ctx, session, reason);
+}
+
+/**
+ * @brief Clear the sender for the next window of packets
+ */
+static void send_etp_cts(j1939_parser_context_t* ctx, etp_session_t* session, uint32_t now_ms) {
+    uint32_t next = session->next_packet;
+    uint32_t remaining = session->total_packets - next + 1;
+    uint32_t window = (remaining < J1939_TP_CTS_WINDOW) ? remaining : J1939_TP_CTS_WINDOW;
+
+    uint32_t pgn = session->xfer.pgn;
+    uint8_t data[8] = { ETP_CM_CTS, (uint8_t)window,
+                        (uint8_t)next, (uint8_t)(next >> 8), (uint8_t)(next >> 16),
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_etp_cm(ctx, session->xfer.source_address, data);
+
+    session->window_end = next + window - 1;
+    session->dpo_pending = true;
+    session->deadline_ms = now_ms + J1939_TP_T2_MS;
+}
+
+static void send_etp_eoma(j1939_parser_context_t* ctx, const etp_session_t* session) {
+    uint32_t size = session->xfer.total_size;
+    uint32_t pgn = session->xfer.pgn;
+    uint8_t data[8] = { ETP_CM_EOMA,
+                        (uint8_t)size, (uint8_t)(size >> 8),
+                        (uint8_t)(size >> 16), (uint8_t)(size >> 24),
+                        (uint8_t)pgn, (uint8_t)(pgn >> 8), (uint8_t)(pgn >> 16) };
+    send_etp_cm(ctx, session->xfer.source_address, data);
+}
+
+/*===========================================================================*/
+/*                        CONNECTION MANAGEMENT                             */
+/*===========================================================================*/
+
+static etp_session_t* find_etp_session(j1939_parser_context_t* ctx, uint8_t source_address) {
+    for (int i = 0; i < J1939_MAX_ACTIVE_ETP; i++) {
+        etp_session_t* session = &ctx->etp_sessions[i];
+        if (session->active && session->xfer.source_address == source_address) {
+            return session;
+        }
+    }
+    return NULL;
+}
+
+static etp_session_t* allocate_etp_session(j1939_parser_context_t* ctx) {
+    for (int i = 0; i < J1939_MAX_ACTIVE_ETP; i++) {
+        if (!ctx->etp_sessions[i].active) {
+            return &ctx->etp_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void handle_etp_rts(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    uint32_t total_size = (uint32_t)msg->data[1] | ((uint32_t)msg->data[2] << 8) |
+                          ((uint32_t)msg->data[3] << 16) | ((uint32_t)msg->data[4] << 24);
+    uint32_t pgn = read_pgn(msg->data);
+
+    ctx->etp_stats.rts_received++;
+
+    if (total_size < J1939_TP_MIN_LENGTH || total_size > J1939_ETP_MAX_LENGTH ||
+        ctx->etp_sink == NULL) {
+        send_etp_abort(ctx, msg->source_address, pgn, TP_ABORT_RESOURCES);
+        return;
+    }
+
+    // One connection per sender: a repeated RTS restarts it, another PGN is refused
+    etp_session_t* session = find_etp_session(ctx, msg->source_address);
+    if (session != NULL) {
+        if (session->xfer.pgn != pgn) {
+            send_etp_abort(ctx, msg->source_address, pgn, TP_ABORT_BUSY);
+            return;
+        }
+        close_etp_session(ctx, session, TP_ABORT_BUSY);
+    } else {
+        session = allocate_etp_session(ctx);
+        if (session == NULL) {
+            send_etp_abort(ctx, msg->source_address, pgn, TP_ABORT_BUSY);
+            return;
+        }
+    }
+
+    memset(session, 0, sizeof(etp_session_t));
+    session->xfer.pgn = pgn;
+    session->xfer.source_address = msg->source_address;
+    session->xfer.total_size = total_size;
+    session->xfer.start_time_ms = msg->timestamp_ms;
+    session->total_packets = (total_size + 6) / 7;
+    session->next_packet = 1;
+
+    const j1939_etp_sink_t* sink = ctx->etp_sink;
+    if (sink->begin != NULL && !sink->begin(&session->xfer, sink->user)) {
+        send_etp_abort(ctx, msg->source_address, pgn, TP_ABORT_RESOURCES);
+        return;  // Never started: no end() call
+    }
+
+    session->active = true;
+    send_etp_cts(ctx, session, msg->timestamp_ms);
+}
+
+static void handle_etp_dpo(j1939_parser_context_t* ctx, etp_session_t* session,
+                           const j1939_message_t* msg) {
+    uint8_t packets = msg->data[1];
+    uint32_t offset = (uint32_t)msg->data[2] | ((uint32_t)msg->data[3] << 8) |
+                      ((uint32_t)msg->data[4] << 16);
+
+    if (read_pgn(msg->data) != session->xfer.pgn) {
+        abort_etp_session(ctx, session, TP_ABORT_UNEXPECTED_DT);
+        return;
+    }
+    if (offset != session->next_packet - 1) {
+        abort_etp_session(ctx, session, TP_ABORT_BAD_DPO_OFFSET);
+        return;
+    }
+    if (packets == 0 || offset + packets > session->window_end) {
+        abort_etp_session(ctx, session, TP_ABORT_DPO_EXCEEDS_CTS);
+        return;
+    }
+
+    session->dpo_pending = false;
+    session->dpo_offset = offset;
+    session->dpo_packets = packets;
+    session->deadline_ms = msg->timestamp_ms + J1939_TP_TIMEOUT_MS;
+}
+
+/*===========================================================================*/
+/*                        DATA TRANSFER                                     */
+/*===========================================================================*/
+
+/**
+ * @brief Check one ETP.DT packet and stream it to the sink
+ * @return true when the transfer is complete
+ */
+static bool handle_etp_dt(j1939_parser_context_t* ctx, etp_session_t* session,
+                          const j1939_message_t* msg) {
+    if (time_reached(msg->timestamp_ms, session->deadline_ms)) {
+        ctx->etp_stats.timeouts++;
+        abort_etp_session(ctx, session, TP_ABORT_TIMEOUT);
+        return false;
+    }
+    if (session->dpo_pending) {
+        abort_etp_session(ctx, session, TP_ABORT_UNEXPECTED_DT);
+        return false;
+    }
+
+    uint8_t seq_num = msg->data[0];  // Relative to the DPO offset
+    uint32_t packet = session->dpo_offset + seq_num;
+
+    if (seq_num != 0 && packet == session->next_packet - 1) {
+        abort_etp_session(ctx, session, TP_ABORT_DUPLICATE_SEQUENCE);
+        return false;
+    }
+    if (seq_num == 0 || seq_num > session->dpo_packets || packet != session->next_packet) {
+        abort_etp_session(ctx, session, TP_ABORT_BAD_SEQUENCE);
+        return false;
+    }
+
+    // Stream the 7 data bytes (fewer in the last packet) to the sink
+    j1939_etp_transfer_t* xfer = &session->xfer;
+    uint32_t offset = (packet - 1) * 7;
+    uint32_t left = xfer->total_size - offset;
+    uint8_t len = (left < 7) ? (uint8_t)left : 7;
+
+    const j1939_etp_sink_t* sink = ctx->etp_sink;
+    if (sink->write != NULL && !sink->write(xfer, offset, &msg->data[1], len, sink->user)) {
+        abort_etp_session(ctx, session, TP_ABORT_RESOURCES);
+        return false;
+    }
+    xfer->bytes_received += len;
+    ctx->etp_stats.bytes_streamed += len;
+
+    session->next_packet++;
+    session->deadline_ms = msg->timestamp_ms + J1939_TP_TIMEOUT_MS;
+
+    if (session->next_packet > session->total_packets) {
+        send_etp_eoma(ctx, session);
+        ctx->etp_stats.completed++;
+        close_etp_session(ctx, session, 0);
+        return true;
+    }
+
+    if (session->next_packet > session->dpo_offset + session->dpo_packets) {
+        if (session->next_packet > session->window_end) {
+            send_etp_cts(ctx, session, msg->timestamp_ms);
+        } else {
+            session->dpo_pending = true;  // Sender may split a window over several DPOs
+        }
+    }
+    return false;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_etp_set_sink(j1939_parser_context_t* ctx, const j1939_etp_sink_t* sink) {
+    if (ctx == NULL) return;
+
+    ctx->etp_sink = sink;
+}
+
+bool j1939_etp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* msg) {
+    if (ctx == NULL || msg == NULL) return false;
+
+    // Connection mode only: addressed to us, with a way to answer
+    if (ctx->tp_send == NULL || ctx->tp_local_address == J1939_NULL_ADDRESS ||
+        msg->destination != ctx->tp_local_address) {
+        return false;
+    }
+
+    if (msg->pgn == PGN_ETP_CM) {
+        uint8_t control_byte = msg->data[0];
+
+        if (control_byte == ETP_CM_RTS) {
+            handle_etp_rts(ctx, msg);
+            return false;
+        }
+
+        etp_session_t* session = find_etp_session(ctx, msg->source_address);
+        if (session == NULL) return false;
+
+        if (control_byte == ETP_CM_DPO) {
+            handle_etp_dpo(ctx, session, msg);
+        } else if (control_byte == TP_CM_ABORT && read_pgn(msg->data) == session->xfer.pgn) {
+            ctx->etp_stats.aborts_received++;
+            close_etp_session(ctx, session, msg->data[1]);
+        }
+        return false;
+    }
+
+    if (msg->pgn == PGN_ETP_DT) {
+        etp_session_t* session = find_etp_session(ctx, msg->source_address);
+        return session != NULL && handle_etp_dt(ctx, session, msg);
+    }
+
+    return false;
+}
+
+void j1939_etp_poll(j1939_parser_context_t* ctx, uint32_t now_ms) {
+    if (ctx == NULL) return;
+
+    // A handful of sessions at most: a scan is cheaper than the wheel here
+    for (int i = 0; i < J1939_MAX_ACTIVE_ETP; i++) {
+        etp_session_t* session = &ctx->etp_sessions[i];
+        if (session->active && time_reached(now_ms, session->deadline_ms)) {
+            ctx->etp_stats.timeouts++;
+            abort_etp_session(ctx, session, TP_ABORT_TIMEOUT);
+        }
+    }
+}
+
+void j1939_etp_get_stats(const j1939_parser_context_t* ctx, j1939_etp_stats_t* stats) {
+    if (ctx == NULL || stats == NULL) return;
+
+    *stats = ctx->etp_stats;
+}
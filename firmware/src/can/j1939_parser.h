@@ -23,8 +23,52 @@ extern "C" {
 
 #define J1939_MAX_DATA_LENGTH       8           // Standard CAN frame
 #define J1939_TP_MAX_LENGTH         1785        // Max via Transport Protocol
-#define J1939_TP_TIMEOUT_MS         750         // BAM timeout per J1939-21
-#define J1939_MAX_ACTIVE_TP         4           // Max concurrent TP sessions
+#define J1939_TP_TIMEOUT_MS         750         // BAM / T1 timeout per J1939-21
+#define J1939_TP_T2_MS              1250        // T2: CTS sent, first TP.DT overdue
+#define J1939_TP_MIN_LENGTH         9           // Smallest TP transfer per J1939-21
+#define J1939_ETP_MAX_LENGTH        117440505UL // Max via Extended TP (16777215 * 7)
+
+// TP reassembly memory: sessions take contiguous runs of pool blocks sized by
+// the announced total_size (a 40-byte DM1 takes one block, a full 1785-byte
+// transfer 28). The defaults hold one maximum-size transfer plus several
+// small ones in 3 KB, where four fixed 1785-byte buffers used 7 KB.
+#ifndef J1939_MAX_ACTIVE_TP
+#define J1939_MAX_ACTIVE_TP         16          // Max concurrent TP sessions
+#endif
+#ifndef J1939_TP_BLOCK_SIZE
+#define J1939_TP_BLOCK_SIZE         64          // Bytes per pool block
+#endif
+#ifndef J1939_TP_POOL_BLOCKS
+#define J1939_TP_POOL_BLOCKS        48          // Blocks in the pool (max 255)
+#endif
+#ifndef J1939_TP_CTS_WINDOW
+#define J1939_TP_CTS_WINDOW         16          // Packets we clear per CTS (RTS/CTS)
+#endif
+// TP session deadlines live on a timer wheel of J1939_TP_WHEEL_SLOTS slots,
+// J1939_TP_WHEEL_TICK_MS each; one revolution must outlast the longest timer
+#ifndef J1939_TP_WHEEL_SLOTS
+#define J1939_TP_WHEEL_SLOTS        32
+#endif
+#ifndef J1939_TP_WHEEL_TICK_MS
+#define J1939_TP_WHEEL_TICK_MS      64
+#endif
+#if (J1939_TP_WHEEL_SLOTS & (J1939_TP_WHEEL_SLOTS - 1)) != 0 || J1939_TP_WHEEL_SLOTS > 255
+#error "J1939_TP_WHEEL_SLOTS must be a power of two below 256"
+#endif
+#if (J1939_TP_WHEEL_TICK_MS & (J1939_TP_WHEEL_TICK_MS - 1)) != 0
+#error "J1939_TP_WHEEL_TICK_MS must be a power of two (slots stay aligned across millis() wrap)"
+#endif
+#if J1939_TP_WHEEL_SLOTS * J1939_TP_WHEEL_TICK_MS <= J1939_TP_T2_MS
+#error "TP timer wheel revolution must exceed J1939_TP_T2_MS"
+#endif
+#if J1939_TP_POOL_BLOCKS > 255 || J1939_MAX_ACTIVE_TP > 255
+#error "TP pool blocks and sessions are indexed by uint8_t"
+#endif
+// ETP transfers stream into a sink and hold no payload buffer, so a session
+// costs the same few dozen bytes whatever the transfer size
+#ifndef J1939_MAX_ACTIVE_ETP
+#define J1939_MAX_ACTIVE_ETP        2           // Max concurrent ETP connections
+#endif
 
 // Special values per J1939-71
 #define J1939_NOT_AVAILABLE_8       0xFF
@@ -35,6 +79,8 @@ extern "C" {
 // Transport Protocol PGNs
 #define PGN_TP_CM                   60416       // Connection Management
 #define PGN_TP_DT                   60160       // Data Transfer
+#define PGN_ETP_CM                  51200       // Extended TP Connection Management
+#define PGN_ETP_DT                  50944       // Extended TP Data Transfer
 
 // Transport Protocol control bytes
 #define TP_CM_BAM                   32          // Broadcast Announce Message
@@ -43,6 +89,26 @@ extern "C" {
 #define TP_CM_EOM                   19          // End Of Message
 #define TP_CM_ABORT                 255         // Connection Abort
 
+// Extended Transport Protocol control bytes (ETP.CM); aborts use TP_CM_ABORT
+#define ETP_CM_RTS                  20          // Request To Send
+#define ETP_CM_CTS                  21          // Clear To Send
+#define ETP_CM_DPO                  22          // Data Packet Offset
+#define ETP_CM_EOMA                 23          // End Of Message Acknowledge
+
+// Connection abort reasons (J1939-21 TP.Conn_Abort byte 2)
+#define TP_ABORT_BUSY               1           // Already in a session, cannot support another
+#define TP_ABORT_RESOURCES          2           // Resources needed elsewhere
+#define TP_ABORT_TIMEOUT            3           // T1/T2 timeout
+#define TP_ABORT_UNEXPECTED_DT      6           // Data packet without a clearing CTS/DPO
+#define TP_ABORT_BAD_SEQUENCE       7           // Bad sequence number
+#define TP_ABORT_DUPLICATE_SEQUENCE 8           // Duplicate sequence number
+#define TP_ABORT_TOO_LARGE          9           // Total size > 1785 bytes
+#define TP_ABORT_BAD_DPO_OFFSET     11          // ETP DPO offset is not the next packet
+#define TP_ABORT_DPO_EXCEEDS_CTS    13          // ETP DPO covers more packets than cleared
+
+#define J1939_GLOBAL_ADDRESS        0xFF
+#define J1939_NULL_ADDRESS          0xFE
+
 /*===========================================================================*/
 /*                        DATA STRUCTURES                                   */
 /*===========================================================================*/
@@ -57,7 +123,8 @@ typedef struct {
     uint8_t priority;           // Priority (0-7, lower = higher)
     uint8_t data[J1939_MAX_DATA_LENGTH];
     uint8_t data_length;        // Actual data length (1-8)
-    uint32_t timestamp_ms;      // Reception timestamp
+    uint32_t timestamp_ms;      // Reception timestamp (ms, for protocol timeouts)
+    uint64_t timestamp_us;      // Reception timestamp (us, monotonic since boot)
 } j1939_message_t;
 
 /**
@@ -103,25 +170,194 @@ typedef enum {
     TP_STATE_ERROR              // Timeout or sequence error
 } tp_state_t;
 
+/**
+ * @brief Transport Protocol session kind
+ */
+typedef enum {
+    TP_MODE_BAM,                // Broadcast (destination global), no handshake
+    TP_MODE_CMDT                // RTS/CTS connection addressed to us
+} tp_mode_t;
+
 /**
  * @brief Transport Protocol session
+ *
+ * Identified by (source, destination, PGN). J1939-21 allows one broadcast
+ * and one connection per sender at a time, so sessions are indexed by source
+ * address separately for BAM and for connections to our address.
  */
 typedef struct {
     tp_state_t state;
+    uint8_t mode;               // tp_mode_t
     uint32_t target_pgn;        // PGN being reassembled
     uint8_t source_address;     // Source of multi-packet message
+    uint8_t destination;        // J1939_GLOBAL_ADDRESS (BAM) or our address
     uint16_t total_size;        // Expected total bytes
     uint8_t total_packets;      // Expected packet count
     uint8_t received_packets;   // Packets received so far
-    uint8_t buffer[J1939_TP_MAX_LENGTH];
+    uint8_t window_end;         // Last packet cleared by the current CTS (CMDT)
+    uint8_t max_per_cts;        // Sender's per-CTS limit from the RTS (CMDT)
+    uint8_t first_block;        // First pool block of the reassembly buffer
+    uint8_t block_count;        // Pool blocks held (0 = none)
     uint32_t last_packet_time_ms;
+    uint32_t deadline_ms;       // Expires then unless the next packet arrives (j1939_tp_poll)
+    uint8_t wheel_slot;         // Timer wheel slot holding the session (0xFF = not armed)
+    uint8_t wheel_next;         // Next / previous session in that slot (index + 1, 0 = none)
+    uint8_t wheel_prev;
 } tp_session_t;
 
+/**
+ * @brief Sends a CAN frame for the TP engine (CTS, EOM ack, abort)
+ * @return true if the frame was queued
+ */
+typedef bool (*j1939_tp_send_t)(uint32_t can_id, const uint8_t* data, uint8_t len, void* user);
+
+/**
+ * @brief Read-only view of a completed TP transfer
+ *
+ * data points into the reassembly pool and is only valid for the duration
+ * of the consumer call; the session is released as soon as it returns.
+ */
+typedef struct {
+    uint32_t pgn;               // PGN carried by the transfer
+    uint8_t source_address;     // Sender
+    uint8_t destination;        // J1939_GLOBAL_ADDRESS (BAM) or our address
+    const uint8_t* data;        // Reassembled payload (length bytes)
+    uint16_t length;            // Announced total size (up to J1939_TP_MAX_LENGTH)
+    uint32_t timestamp_ms;      // Receive time of the completing TP.DT
+    uint64_t timestamp_us;
+} j1939_tp_payload_t;
+
+/**
+ * @brief Consumes a completed TP transfer in place
+ *
+ * Must not call back into the TP functions of the same parser context.
+ */
+typedef void (*j1939_tp_consumer_t)(const j1939_tp_payload_t* payload, void* user);
+
+/**
+ * @brief Extended TP transfer being streamed to a sink
+ */
+typedef struct {
+    uint32_t pgn;               // PGN carried by the transfer
+    uint8_t source_address;     // Sender
+    uint32_t total_size;        // Announced size (up to J1939_ETP_MAX_LENGTH)
+    uint32_t bytes_received;    // Bytes handed to the sink so far
+    uint32_t start_time_ms;     // Receive time of the RTS
+} j1939_etp_transfer_t;
+
+/**
+ * @brief Destination for ETP payloads (logger, flash, ...)
+ *
+ * Packets are checked for order before they reach the sink, so write() sees
+ * consecutive offsets from 0 to total_size. The callbacks run from
+ * j1939_tp_handle_frame() / j1939_tp_poll() and must not call back into the
+ * TP functions of the same parser context.
+ */
+typedef struct {
+    // Accept or refuse a new transfer (refused: aborted with TP_ABORT_RESOURCES)
+    bool (*begin)(const j1939_etp_transfer_t* xfer, void* user);
+    // Store len (1-7) bytes at offset; false aborts with TP_ABORT_RESOURCES
+    bool (*write)(const j1939_etp_transfer_t* xfer, uint32_t offset,
+                  const uint8_t* data, uint8_t len, void* user);
+    // Transfer over: result 0 = complete, otherwise the TP_ABORT_* reason
+    void (*end)(const j1939_etp_transfer_t* xfer, uint8_t result, void* user);
+    void* user;
+} j1939_etp_sink_t;
+
+/**
+ * @brief Extended TP connection
+ */
+typedef struct {
+    bool active;
+    bool dpo_pending;           // Next frame must be a DPO for the cleared window
+    uint8_t dpo_packets;        // Packets announced by the current DPO
+    uint32_t dpo_offset;        // Packet offset announced by the current DPO
+    uint32_t next_packet;       // Next packet expected (1-based, absolute)
+    uint32_t window_end;        // Last packet cleared by the current CTS
+    uint32_t total_packets;
+    uint32_t deadline_ms;       // Aborted with TP_ABORT_TIMEOUT once reached
+    j1939_etp_transfer_t xfer;
+} etp_session_t;
+
+/**
+ * @brief Extended TP statistics
+ */
+typedef struct {
+    uint32_t rts_received;      // ETP RTS frames addressed to us
+    uint32_t completed;         // Transfers acknowledged with EOMA
+    uint32_t aborts_sent;       // Transfers we aborted (any reason, incl. timeouts)
+    uint32_t aborts_received;   // Transfers the sender aborted
+    uint32_t timeouts;          // Transfers aborted for T1/T2
+    uint32_t bytes_streamed;    // Payload bytes handed to the sink
+} j1939_etp_stats_t;
+
+/**
+ * @brief RTS/CTS connection statistics
+ */
+typedef struct {
+    uint32_t rts_received;      // RTS frames addressed to us
+    uint32_t cts_sent;          // CTS frames sent (one per window)
+    uint32_t completed;         // Transfers acknowledged with EOM
+    uint32_t aborts_sent;       // Connections we aborted (any reason)
+    uint32_t aborts_received;   // Connections the sender aborted
+    uint32_t timeouts;          // Connections aborted for T1/T2
+    uint32_t send_failures;     // Control frames the send hook refused
+} j1939_tp_conn_stats_t;
+
+/**
+ * @brief TP session expiry statistics (bus health)
+ *
+ * Every session that runs out of time is counted here, whether the timer
+ * wheel or a late TP.DT frame noticed it first.
+ */
+typedef struct {
+    uint32_t sweeps;            // j1939_tp_poll() calls that advanced the wheel
+    uint32_t expired;           // Sessions reclaimed on timeout (all kinds)
+    uint32_t bam_expired;       // Broadcasts whose next TP.DT never arrived
+    uint32_t conn_expired;      // Connections aborted for T1/T2
+    uint32_t unclaimed;         // Completed transfers never fetched with get_data
+    uint32_t last_time_ms;      // When the most recent expiry happened
+    uint32_t last_pgn;          // PGN of the most recent expiry
+    uint8_t last_source;        // Sender of the most recent expiry
+} j1939_tp_expiry_stats_t;
+
+/**
+ * @brief TP reassembly pool statistics
+ */
+typedef struct {
+    uint32_t allocations;       // Buffers handed out
+    uint32_t exhausted;         // BAMs refused: fewer free blocks than needed
+    uint32_t fragmented;        // BAMs refused: enough free blocks, but no contiguous run
+    uint32_t no_session;        // BAMs refused: J1939_MAX_ACTIVE_TP sessions busy
+    uint32_t rejected_size;     // BAMs announcing an invalid total_size
+    uint16_t blocks_in_use;     // Blocks currently held
+    uint16_t blocks_high_water; // Most blocks ever held at once
+    uint16_t largest_free_run;  // Longest contiguous free run (blocks)
+    uint8_t sessions_in_use;    // Sessions currently open
+    uint8_t sessions_high_water;// Most sessions ever open at once
+} j1939_tp_pool_stats_t;
+
 /**
  * @brief Parser context holding all state
  */
 typedef struct {
     tp_session_t tp_sessions[J1939_MAX_ACTIVE_TP];
+    uint8_t tp_session_by_sa[256];  // Source address -> BAM session index + 1 (0 = none)
+    uint8_t tp_conn_by_sa[256];     // Source address -> RTS/CTS session index + 1
+    uint8_t tp_local_address;       // Our address; J1939_NULL_ADDRESS ignores RTS
+    j1939_tp_send_t tp_send;        // Control frame output (NULL ignores RTS)
+    void* tp_send_user;
+    j1939_tp_conn_stats_t tp_conn_stats;
+    uint8_t tp_wheel[J1939_TP_WHEEL_SLOTS];    // Slot -> first session index + 1 (0 = empty)
+    uint32_t tp_wheel_ms;                       // Start of the next wheel tick to sweep
+    uint8_t tp_expired_by_sa[256];              // Expiries per sender (saturates at 255)
+    j1939_tp_expiry_stats_t tp_expiry_stats;
+    uint8_t tp_pool[J1939_TP_POOL_BLOCKS * J1939_TP_BLOCK_SIZE];
+    uint8_t tp_block_used[J1939_TP_POOL_BLOCKS];    // 1 = block held by a session
+    j1939_tp_pool_stats_t tp_pool_stats;
+    etp_session_t etp_sessions[J1939_MAX_ACTIVE_ETP];
+    const j1939_etp_sink_t* etp_sink;           // NULL refuses ETP transfers
+    j1939_etp_stats_t etp_stats;
     uint32_t messages_received;
     uint32_t messages_parsed;
     uint32_t parse_errors;
@@ -191,12 +427,27 @@ uint32_t j1939_build_can_id(uint32_t pgn, uint8_t source_address, uint8_t priori
 bool j1939_parse_frame(uint32_t can_id, const uint8_t* data, uint8_t data_len,
                        uint32_t timestamp_ms, j1939_message_t* msg);
 
+/**
+ * @brief Parse raw CAN frame stamped with a microsecond receive time
+ * @param can_id 29-bit extended CAN identifier
+ * @param data CAN frame data bytes
+ * @param data_len Data length (1-8)
+ * @param timestamp_us Reception timestamp in microseconds (e.g. can_frame_t.timestamp_us)
+ * @param msg Output message structure (timestamp_ms is derived from timestamp_us)
+ * @return true if parsing successful
+ */
+bool j1939_parse_frame_us(uint32_t can_id, const uint8_t* data, uint8_t data_len,
+                          uint64_t timestamp_us, j1939_message_t* msg);
+
 /**
  * @brief Decode SPN value from message data
  * @param msg J1939 message
  * @param spn SPN to decode
  * @param value Output decoded value
  * @return true if SPN found and valid
+ *
+ * Looks the SPN up in the sorted SPN index (j1939_decoder.h); the message
+ * must carry the PGN the SPN belongs to.
  */
 bool j1939_decode_spn(const j1939_message_t* msg, uint16_t spn, float* value);
 
@@ -292,15 +543,139 @@ float j1939_decode_throttle_position(const uint8_t* data);
 float j1939_decode_ambient_temp(const uint8_t* data);
 
 /**
- * @brief Handle Transport Protocol frame (BAM/TP.DT)
+ * @brief Enable RTS/CTS reception for our address
+ *
+ * Until this is called, RTS frames are ignored and only BAM transfers are
+ * reassembled. The send hook is called from j1939_tp_handle_frame() and
+ * j1939_tp_poll() for CTS, EOM acknowledge and abort frames.
+ *
+ * @param ctx Parser context
+ * @param address Our source address
+ * @param send Frame output
+ * @param user Passed to send
+ */
+void j1939_tp_set_local_address(j1939_parser_context_t* ctx, uint8_t address,
+                                j1939_tp_send_t send, void* user);
+
+/**
+ * @brief Handle Transport Protocol frame (TP.CM / TP.DT, ETP.CM / ETP.DT)
+ *
+ * BAM transfers from any source and RTS/CTS transfers addressed to our
+ * address are reassembled; connections are answered with CTS windows of up
+ * to J1939_TP_CTS_WINDOW packets and an EOM acknowledge. ETP frames are
+ * passed on to j1939_etp_handle_frame().
+ *
  * @param ctx Parser context
  * @param msg Received J1939 message
- * @return true if a complete TP message is now available
+ * @return true if a complete TP message is now available (never for ETP,
+ *         whose payload goes to the sink)
  */
 bool j1939_tp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* msg);
 
 /**
- * @brief Get completed TP message data
+ * @brief Run the session timers
+ *
+ * Sweeps the timer wheel up to now_ms and reclaims every session whose
+ * deadline passed: broadcasts missing their next TP.DT (T1), connections
+ * whose next packet is overdue (T2 after a CTS, T1 between packets; aborted
+ * with TP_ABORT_TIMEOUT) and completed transfers nobody fetched. Cost is
+ * proportional to the wheel ticks elapsed and the sessions expired, not to
+ * the sessions open. Expiry resolution is one J1939_TP_WHEEL_TICK_MS.
+ * ETP connections are timed out here too (j1939_etp_poll()).
+ *
+ * Call periodically, e.g. every decode wakeup; timeouts do not depend on
+ * further frames arriving.
+ *
+ * @param ctx Parser context
+ * @param now_ms Current time on the msg->timestamp_ms clock
+ */
+void j1939_tp_poll(j1939_parser_context_t* ctx, uint32_t now_ms);
+
+/**
+ * @brief Get TP session expiry statistics
+ * @param ctx Parser context
+ * @param stats Output statistics
+ */
+void j1939_tp_get_expiry_stats(const j1939_parser_context_t* ctx, j1939_tp_expiry_stats_t* stats);
+
+/**
+ * @brief Sessions from one sender that timed out (saturates at 255)
+ * @param ctx Parser context
+ * @param source_address Sender
+ * @return Expiry count
+ */
+uint8_t j1939_tp_get_expired_count(const j1939_parser_context_t* ctx, uint8_t source_address);
+
+/**
+ * @brief Get RTS/CTS connection statistics
+ * @param ctx Parser context
+ * @param stats Output statistics
+ */
+void j1939_tp_get_conn_stats(const j1939_parser_context_t* ctx, j1939_tp_conn_stats_t* stats);
+
+/**
+ * @brief Hand a completed TP transfer to a consumer without copying it
+ *
+ * Call with the frame for which j1939_tp_handle_frame() returned true. The
+ * consumer sees the whole payload in the session buffer, whatever its size,
+ * and the session is released when it returns.
+ *
+ * @param ctx Parser context
+ * @param msg TP.DT frame that completed the transfer
+ * @param consumer Called once with the payload view
+ * @param user Passed through to the consumer
+ * @return true if a completed transfer was delivered
+ */
+bool j1939_tp_deliver(j1939_parser_context_t* ctx, const j1939_message_t* msg,
+                      j1939_tp_consumer_t consumer, void* user);
+
+/**
+ * @brief Set the sink that receives Extended TP transfers
+ *
+ * Without a sink (the default) ETP RTS frames are refused with
+ * TP_ABORT_RESOURCES. Like RTS/CTS, ETP also needs
+ * j1939_tp_set_local_address().
+ *
+ * @param ctx Parser context
+ * @param sink Sink (kept by reference), or NULL to refuse ETP
+ */
+void j1939_etp_set_sink(j1939_parser_context_t* ctx, const j1939_etp_sink_t* sink);
+
+/**
+ * @brief Handle an Extended TP frame addressed to us (ETP.CM / ETP.DT)
+ *
+ * Packets are streamed to the sink as they arrive, in order, with one CTS
+ * window of up to J1939_TP_CTS_WINDOW packets at a time; no payload is
+ * buffered. Called by j1939_tp_handle_frame().
+ *
+ * @param ctx Parser context
+ * @param msg Received J1939 message
+ * @return true if this frame completed a transfer (the sink saw end(0))
+ */
+bool j1939_etp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* msg);
+
+/**
+ * @brief Run the ETP connection timers (called by j1939_tp_poll())
+ * @param ctx Parser context
+ * @param now_ms Current time on the msg->timestamp_ms clock
+ */
+void j1939_etp_poll(j1939_parser_context_t* ctx, uint32_t now_ms);
+
+/**
+ * @brief Get Extended TP statistics
+ * @param ctx Parser context
+ * @param stats Output statistics
+ */
+void j1939_etp_get_stats(const j1939_parser_context_t* ctx, j1939_etp_stats_t* stats);
+
+/**
+ * @brief Get completed TP message data (copying)
+ *
+ * Call right after j1939_tp_handle_frame() returned true; a completed
+ * broadcast from the source is returned before a completed connection.
+ * Payloads longer than max_len are truncated; j1939_tp_deliver() avoids
+ * both the copy and the limit.
+ *
  * @param ctx Parser context
  * @param source_address Source to get TP data for
  * @param pgn Output: PGN of completed message
@@ -311,6 +686,13 @@ bool j1939_tp_handle_frame(j1939_parser_context_t* ctx, const j1939_message_t* m
 uint16_t j1939_tp_get_data(j1939_parser_context_t* ctx, uint8_t source_address,
                            uint32_t* pgn, uint8_t* data, uint16_t max_len);
 
+/**
+ * @brief Get TP reassembly pool statistics
+ * @param ctx Parser context
+ * @param stats Output statistics (largest_free_run is computed on the call)
+ */
+void j1939_tp_get_pool_stats(const j1939_parser_context_t* ctx, j1939_tp_pool_stats_t* stats);
+
 /**
  * @brief Parse DM1 diagnostic trouble codes
  * @param data DM1 message data (may be from TP)
@@ -339,7 +721,7 @@ static inline bool j1939_is_valid_16(uint16_t value) {
 }
 
 /**
- * @brief Get PGN name string
+ * @brief Get PGN name string (O(1) via the PGN dispatch index)
  * @param pgn Parameter Group Number
  * @return Human-readable PGN name or "Unknown"
  */
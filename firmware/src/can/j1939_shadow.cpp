@@ -0,0 +1,257 @@
+/**
+ * @file j1939_shadow.cpp
+ * @brief Last-frame shadow cache implementation
+ *
+ * Keys are never removed (an ECU that stops transmitting keeps its last
+ * frame), so linear probing stops at the first unused slot.
+ */
+
+#include "j1939_shadow.h"
+#include "j1939_decoder.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        TABLE                                             */
+/*===========================================================================*/
+
+/**
+ * @brief Home slot of a (PGN, SA) key (multiplicative hash)
+ */
+static inline uint16_t shadow_hash(uint32_t pgn, uint8_t source_address) {
+    uint32_t key = (pgn << 8) | source_address;
+    return (uint16_t)((key * 2654435761UL) >> 16) & (J1939_SHADOW_SLOTS - 1);
+}
+
+/**
+ * @brief Find the slot of a key
+ * @return Slot index, or -1 if the key has never been stored
+ */
+static int32_t find_slot(const j1939_shadow_t* shadow, uint32_t pgn, uint8_t source_address) {
+    uint16_t slot = shadow_hash(pgn, source_address);
+
+    for (uint16_t probe = 0; probe < J1939_SHADOW_SLOTS; probe++) {
+        const j1939_shadow_entry_t* e = &shadow->entries[slot];
+        if (!__atomic_load_n(&e->used, __ATOMIC_ACQUIRE)) return -1;
+        if (e->pgn == pgn && e->source_address == source_address) return slot;
+        slot = (slot + 1) & (J1939_SHADOW_SLOTS - 1);
+    }
+    return -1;
+}
+
+/**
+ * @brief Find the slot of a key, claiming an unused one for a new key
+ * @return Slot index, or -1 if the table is full
+ */
+static int32_t find_or_insert_slot(j1939_shadow_t* shadow, uint32_t pgn, uint8_t source_address) {
+    uint16_t slot = shadow_hash(pgn, source_address);
+
+    for (uint16_t probe = 0; probe < J1939_SHADOW_SLOTS; probe++) {
+        j1939_shadow_entry_t* e = &shadow->entries[slot];
+        if (!e->used) {
+            e->pgn = pgn;
+            e->source_address = source_address;
+            __atomic_store_n(&e->used, true, __ATOMIC_RELEASE);
+            shadow->stats.entries++;
+            return slot;
+        }
+        if (e->pgn == pgn && e->source_address == source_address) return slot;
+        slot = (slot + 1) & (J1939_SHADOW_SLOTS - 1);
+    }
+    return -1;
+}
+
+/**
+ * @brief Copy an entry without tearing against a concurrent store
+ */
+static void read_entry(const j1939_shadow_entry_t* e, j1939_shadow_entry_t* out) {
+    uint32_t before, after;
+
+    do {
+        before = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, e, sizeof(j1939_shadow_entry_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+    } while ((before & 1U) != 0 || before != after);
+}
+
+/*===========================================================================*/
+/*                        LAZY DECODE                                       */
+/*===========================================================================*/
+
+/**
+ * @brief Data manager resolver: decode a pending parameter from its newest frame
+ */
+static bool shadow_resolve(param_id_t param_id, uint32_t* raw_value,
+                           const data_scaling_t** scaling, uint64_t* timestamp_us,
+                           void* user) {
+    j1939_shadow_t* shadow = (j1939_shadow_t*)user;
+
+    uint16_t slot = shadow->param_slot[param_id];
+    if (slot == 0) return false;
+
+    j1939_shadow_entry_t entry;
+    read_entry(&shadow->entries[slot - 1], &entry);
+
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(entry.pgn);
+    if (desc == NULL) return false;
+
+    for (uint8_t i = 0; i < desc->signal_count; i++) {
+        const j1939_signal_t* sig = &desc->signals[i];
+        if (sig->param_id == PARAM_NONE) break;  // On-demand signals follow
+        if (sig->param_id != param_id) continue;
+
+        uint32_t raw = j1939_signal_extract_raw(entry.payload, sig);
+        if (raw >= sig->raw_limit) return false;  // Error or not available: keep last value
+
+        __atomic_fetch_add(&shadow->stats.decodes, 1, __ATOMIC_RELAXED);
+        *raw_value = raw;
+        *scaling = &sig->scaling;  // Applied by the data manager
+        *timestamp_us = entry.timestamp_us;
+        return true;
+    }
+    return false;
+}
+
+/*===========================================================================*/
+/*                        PUBLIC API                                        */
+/*===========================================================================*/
+
+void j1939_shadow_init(j1939_shadow_t* shadow, data_manager_t* dm) {
+    if (shadow == NULL) return;
+
+    memset(shadow, 0, sizeof(j1939_shadow_t));
+    shadow->dm = dm;
+
+    data_manager_set_resolver(dm, shadow_resolve, SOURCE_J1939, shadow);
+}
+
+uint8_t j1939_shadow_store(j1939_shadow_t* shadow, const j1939_message_t* msg) {
+    if (shadow == NULL || msg == NULL) return 0;
+
+    // PGNs without signals never take a slot
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(msg->pgn);
+    if (desc == NULL) return 0;
+
+    int32_t slot = find_or_insert_slot(shadow, msg->pgn, msg->source_address);
+    if (slot < 0) {
+        // Table full: nothing to defer to, decode now
+        shadow->stats.overflow++;
+        return j1939_decoder_process(msg, shadow->dm, SOURCE_J1939);
+    }
+
+    // Same bytes as last time? One 64-bit compare decides
+    j1939_shadow_entry_t* e = &shadow->entries[slot];
+    uint64_t payload = j1939_decoder_load_payload(msg->data, msg->data_length);
+    bool repeat = (e->count > 0 && e->payload == payload && e->data_length == msg->data_length);
+
+    // Publish the frame: odd sequence while the entry is inconsistent
+    uint32_t seq = e->seq;
+    __atomic_store_n(&e->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (!repeat) {
+        e->payload = payload;
+        e->data_length = msg->data_length;
+    }
+    e->timestamp_us = msg->timestamp_us;
+    e->count++;
+    if (repeat) e->repeats++;
+    __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+
+    shadow->stats.frames++;
+    if (repeat) shadow->stats.repeats++;
+
+    uint16_t owner = (uint16_t)(slot + 1);
+    uint8_t marked = 0;
+    for (uint8_t i = 0; i < desc->signal_count; i++) {
+        const j1939_signal_t* sig = &desc->signals[i];
+        param_id_t param_id = sig->param_id;
+        if (param_id == PARAM_NONE) break;  // On-demand signals follow
+
+        if (repeat && shadow->param_slot[param_id] == owner) {
+            // Unchanged value: only its age moves (unless it is not available)
+            if (j1939_signal_extract_raw(payload, sig) < sig->raw_limit) {
+                data_manager_touch_us(shadow->dm, param_id, msg->timestamp_us);
+            }
+            continue;
+        }
+
+        shadow->param_slot[param_id] = owner;
+        data_manager_mark_pending(shadow->dm, param_id);
+        marked++;
+    }
+    return marked;
+}
+
+uint8_t j1939_shadow_expire(j1939_shadow_t* shadow, uint32_t pgn, uint8_t source_address) {
+    if (shadow == NULL) return 0;
+
+    int32_t slot = find_slot(shadow, pgn, source_address);
+    if (slot < 0) return 0;
+
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(pgn);
+    if (desc == NULL) return 0;
+
+    uint16_t owner = (uint16_t)(slot + 1);
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < desc->signal_count; i++) {
+        param_id_t param_id = desc->signals[i].param_id;
+        if (param_id == PARAM_NONE) break;  // On-demand signals follow
+        if (shadow->param_slot[param_id] != owner) continue;
+
+        // Unowned: the next frame marks it pending instead of touching it
+        shadow->param_slot[param_id] = 0;
+        data_manager_invalidate(shadow->dm, param_id);
+        expired++;
+    }
+    return expired;
+}
+
+bool j1939_shadow_get(const j1939_shadow_t* shadow, uint32_t pgn,
+                      uint8_t source_address, j1939_shadow_entry_t* entry) {
+    if (shadow == NULL || entry == NULL) return false;
+
+    int32_t slot = find_slot(shadow, pgn, source_address);
+    if (slot < 0) return false;
+
+    read_entry(&shadow->entries[slot], entry);
+    return true;
+}
+
+bool j1939_shadow_get_entry(const j1939_shadow_t* shadow, uint16_t index,
+                            j1939_shadow_entry_t* entry) {
+    if (shadow == NULL || entry == NULL) return false;
+    if (index >= J1939_SHADOW_SLOTS) return false;
+
+    const j1939_shadow_entry_t* e = &shadow->entries[index];
+    if (!__atomic_load_n(&e->used, __ATOMIC_ACQUIRE)) return false;
+
+    read_entry(e, entry);
+    return true;
+}
+
+bool j1939_shadow_decode_spn(const j1939_shadow_t* shadow, uint16_t spn,
+                             uint8_t source_address, float* value) {
+    if (shadow == NULL || value == NULL) return false;
+
+    const j1939_spn_entry_t* spn_entry = j1939_decoder_find_spn(spn);
+    if (spn_entry == NULL) return false;
+
+    j1939_shadow_entry_t entry;
+    if (!j1939_shadow_get(shadow, spn_entry->pgn, source_address, &entry)) return false;
+
+    uint32_t raw = j1939_signal_extract_raw(entry.payload, spn_entry->signal);
+    if (raw >= spn_entry->signal->raw_limit) return false;  // Error or not available
+
+    *value = j1939_signal_to_physical(raw, spn_entry->signal);
+    return true;
+}
+
+void j1939_shadow_get_stats(const j1939_shadow_t* shadow, j1939_shadow_stats_t* stats) {
+    if (shadow == NULL || stats == NULL) return;
+
+    stats->frames = shadow->stats.frames;
+    stats->repeats = shadow->stats.repeats;
+    stats->decodes = __atomic_load_n(&shadow->stats.decodes, __ATOMIC_RELAXED);
+    stats->entries = shadow->stats.entries;
+    stats->overflow = shadow->stats.overflow;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file j1939_shadow.h
+ * @brief Last-frame shadow cache with lazy signal decoding
+ *
+ * Keeps the newest raw payload, receive time and frame count for every
+ * (PGN, source address) of a decoder-table PGN in a compact open-addressed
+ * table; other PGNs take no slot.
+ * Storing a frame only copies 8 bytes and marks the PGN's parameters pending
+ * in the data manager; the signals are decoded when the decode task resolves
+ * them (data_manager_resolve_pending()), once per resolve however many
+ * frames came in. EEC1 at 10 ms resolved every 50 ms is decoded once
+ * instead of five times.
+ *
+ * A frame whose payload equals the cached one (a single 64-bit compare) is
+ * a repeat: ET1, HOURS, DD and VEP1 often broadcast the same bytes for
+ * seconds. Repeats only refresh the timestamps of the parameters they carry.
+ *
+ * One task stores and resolves frames. Other tasks may read entries
+ * directly (j1939_shadow_get(), j1939_shadow_decode_spn()): each entry is
+ * published through a sequence counter, so they never see a torn payload.
+ */
+
+#ifndef J1939_SHADOW_H
+#define J1939_SHADOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "j1939_parser.h"
+#include "../data/data_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_SHADOW_SLOTS
+#define J1939_SHADOW_SLOTS          128     // (PGN, SA) pairs tracked (power of two)
+#endif
+
+#if (J1939_SHADOW_SLOTS & (J1939_SHADOW_SLOTS - 1)) != 0 || J1939_SHADOW_SLOTS > 32768
+#error "J1939_SHADOW_SLOTS must be a power of two no larger than 32768"
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Newest frame of one (PGN, source address)
+ */
+typedef struct {
+    uint32_t pgn;               // Parameter Group Number
+    uint8_t source_address;     // Transmitting ECU
+    uint8_t data_length;        // Valid bytes in payload
+    bool used;                  // Slot holds a key
+    uint32_t seq;               // Odd while the entry is being written
+    uint64_t payload;           // Frame data, byte 0 in bits 0-7
+    uint64_t timestamp_us;      // Receive time of the newest frame
+    uint32_t count;             // Frames received for this key
+    uint32_t repeats;           // Frames identical to their predecessor
+} j1939_shadow_entry_t;
+
+/**
+ * @brief Shadow cache counters
+ */
+typedef struct {
+    uint32_t frames;            // Frames stored
+    uint32_t repeats;           // Frames identical to the cached payload (skip ratio = repeats / frames)
+    uint32_t decodes;           // Signals decoded by resolves
+    uint32_t entries;           // Keys in use
+    uint32_t overflow;          // Frames decoded eagerly because the table was full
+} j1939_shadow_stats_t;
+
+/**
+ * @brief Shadow cache
+ */
+typedef struct {
+    j1939_shadow_entry_t entries[J1939_SHADOW_SLOTS];
+    uint16_t param_slot[PARAM_MAX];     // Entry index + 1 last feeding each parameter
+    data_manager_t* dm;
+    j1939_shadow_stats_t stats;
+} j1939_shadow_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Initialize a shadow cache and install it as the data manager's resolver
+ * @param shadow Cache to initialize
+ * @param dm Initialized data manager to publish decoded values to
+ */
+void j1939_shadow_init(j1939_shadow_t* shadow, data_manager_t* dm);
+
+/**
+ * @brief Store a frame and mark its mapped parameters pending
+ *
+ * PGNs missing from the decoder table are ignored. A repeated payload marks
+ * nothing: the parameters it last set only get the new receive time. If the
+ * table is full the frame is decoded immediately
+ * instead, so no parameter is ever lost; such frames are counted in
+ * stats.overflow.
+ *
+ * @param shadow Cache
+ * @param msg Parsed single-frame J1939 message
+ * @return Number of parameters with a new value pending (or decoded)
+ */
+uint8_t j1939_shadow_store(j1939_shadow_t* shadow, const j1939_message_t* msg);
+
+/**
+ * @brief Invalidate the parameters a silent (PGN, source address) last set
+ *
+ * For lost-message handling: parameters another source has taken over are
+ * left alone. The key's next frame publishes its values again, even if its
+ * payload repeats the cached one.
+ *
+ * @param shadow Cache
+ * @param pgn Parameter Group Number
+ * @param source_address Silent ECU
+ * @return Number of parameters invalidated
+ */
+uint8_t j1939_shadow_expire(j1939_shadow_t* shadow, uint32_t pgn, uint8_t source_address);
+
+/**
+ * @brief Copy the newest frame of a (PGN, source address)
+ * @param shadow Cache
+ * @param pgn Parameter Group Number
+ * @param source_address Transmitting ECU
+ * @param entry Output: consistent snapshot of the entry
+ * @return true if a frame has been stored for this key
+ */
+bool j1939_shadow_get(const j1939_shadow_t* shadow, uint32_t pgn,
+                      uint8_t source_address, j1939_shadow_entry_t* entry);
+
+/**
+ * @brief Copy an entry by table index (for loggers walking the cache)
+ * @param shadow Cache
+ * @param index Table index (0 .. J1939_SHADOW_SLOTS - 1)
+ * @param entry Output: consistent snapshot of the entry
+ * @return true if the slot holds a key
+ */
+bool j1939_shadow_get_entry(const j1939_shadow_t* shadow, uint16_t index,
+                            j1939_shadow_entry_t* entry);
+
+/**
+ * @brief Decode one SPN from the newest frame of a source address
+ * @param shadow Cache
+ * @param spn Suspect Parameter Number (any SPN in the decoder's index)
+ * @param source_address Transmitting ECU
+ * @param value Output: physical value
+ * @return true if the frame is cached and the SPN holds a valid value
+ */
+bool j1939_shadow_decode_spn(const j1939_shadow_t* shadow, uint16_t spn,
+                             uint8_t source_address, float* value);
+
+/**
+ * @brief Get shadow cache counters
+ * @param shadow Cache
+ * @param stats Output: counters
+ */
+void j1939_shadow_get_stats(const j1939_shadow_t* shadow, j1939_shadow_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_SHADOW_H */
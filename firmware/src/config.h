@@ -63,13 +63,34 @@
 /*===========================================================================*/
 
 #define J1939_BAUD_RATE             250000      // Standard J1939 baud rate (250 kbps)
-#define J1939_TX_QUEUE_SIZE         10          // Transmit queue depth
-#define J1939_RX_QUEUE_SIZE         50          // Receive queue depth
+// Driver queue depths: CAN_DRIVER_RX_QUEUE_LEN / CAN_DRIVER_TX_QUEUE_LEN (can_driver.h)
+#define CAN_RX_BATCH_MAX            32          // Frames drained per wakeup before yielding
+#define CAN_RX_WAIT_MS              10          // Blocking wait for the first frame of a burst
+#define CAN_DECODE_BATCH            16          // Frames popped from the ring per decode pass
+#define CAN_DECODE_WAIT_MS          20          // Decode task wakes at least this often (TP and lost-message timers)
+
+// Hardware acceptance filter, planned from the PGNs we consume (can_filter.h)
+#define CAN_FILTER_ENABLED          1           // 0 = receive every frame
+#define CAN_FILTER_LEARN_MS         10000       // Accept-all traffic sample before the first plan
+#define CAN_FILTER_CHECK_MS         1000        // How often the consumed PGN set is re-checked
 
 // Our device address (use diagnostic tool range to avoid conflicts)
 #define J1939_OUR_ADDRESS           0xF9        // Off-board Diagnostic Tool #1
-
-// Source addresses we care about
+// NAME sent in Address Claimed: off-board diagnostic-service tool (function 129),
+// industry group global, not arbitrary address capable, identity number 1
+#define J1939_OUR_NAME              0x0000810000000001ULL
+
+// On-request PGNs, asked for with Request (PGN 59904) at these periods
+// (0 = not requested); an ECU broadcasting the PGN anyway is not asked
+#define J1939_REQUEST_HOURS_MS      60000       // HOURS (65253)
+#define J1939_REQUEST_VD_MS         10000       // VD (65217)
+#define J1939_REQUEST_DM2_MS        60000       // DM2 (65227), previously active DTCs
+#define J1939_REQUEST_AT_BOOT       1           // Address claims once
+
+// Typical source addresses. Decoding does not depend on them: PGNs with a
+// fixed sender are routed by the function in the sender's address claim
+// (j1939_addr.h), whatever address it has on this truck.
+#define J1939_ROUTE_BY_FUNCTION     1           // 0 = accept every PGN from any address
 #define J1939_ADDR_ENGINE           0x00
 #define J1939_ADDR_TRANSMISSION     0x03
 #define J1939_ADDR_BRAKES           0x0B
@@ -90,7 +111,6 @@
 /*                        DATA MANAGER CONFIGURATION                        */
 /*===========================================================================*/
 
-#define DATA_MAX_PARAMETERS         128         // Maximum tracked parameters
 #define DATA_FRESHNESS_TIMEOUT_MS   5000        // Mark data stale after 5 seconds
 #define DATA_UPDATE_CALLBACK_MAX    16          // Maximum parameter change callbacks
 
@@ -137,6 +157,7 @@
 
 // Task stack sizes (words, not bytes - multiply by 4 for bytes)
 #define TASK_STACK_CAN              4096
+#define TASK_STACK_DECODE           4096
 #define TASK_STACK_J1708            4096
 #define TASK_STACK_SENSOR           2048
 #define TASK_STACK_DISPLAY          4096
@@ -145,6 +166,7 @@
 // Task priorities (higher number = higher priority)
 #define TASK_PRIORITY_CAN           5           // Highest - time critical
 #define TASK_PRIORITY_J1708         4
+#define TASK_PRIORITY_DECODE        4
 #define TASK_PRIORITY_DISPLAY       3
 #define TASK_PRIORITY_SENSOR        2
 #define TASK_PRIORITY_STORAGE       1           // Lowest - background
@@ -152,6 +174,7 @@
 // Task core assignments (ESP32 has cores 0 and 1)
 #define TASK_CORE_CAN               0           // Protocol tasks on core 0
 #define TASK_CORE_J1708             0
+#define TASK_CORE_DECODE            1           // Decoding off the receive core
 #define TASK_CORE_SENSOR            1           // Processing tasks on core 1
 #define TASK_CORE_DISPLAY           1
 
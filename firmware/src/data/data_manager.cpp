@@ -17,7 +17,7 @@ void data_manager_init(data_manager_t* dm) {
     memset(dm, 0, sizeof(data_manager_t));
     
     // Initialize all parameters as invalid
-    for (int i = 0; i < DATA_MAX_PARAMETERS; i++) {
+    for (int i = 0; i < PARAM_MAX; i++) {
         dm->parameters[i].is_valid = false;
         dm->parameters[i].source = SOURCE_UNKNOWN;
     }
@@ -29,37 +29,193 @@ void data_manager_init(data_manager_t* dm) {
 /*                        PARAMETER UPDATES                                 */
 /*===========================================================================*/
 
-void data_manager_update(data_manager_t* dm, param_id_t param_id,
-                         float value, data_source_t source, uint32_t timestamp_ms) {
-    if (dm == NULL || !dm->initialized) return;
-    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
+/**
+ * @brief Current value of a parameter in engineering units
+ */
+static inline float param_value(const data_parameter_t* param) {
+#if DATA_FIXED_POINT
+    if (param->scaling != NULL) return data_scaling_apply(param->scaling, param->raw);
+#endif
+    return param->value;
+}
+
+/**
+ * @brief Stamp a freshly stored value
+ */
+static inline void commit_value(data_manager_t* dm, data_parameter_t* param,
+                                data_source_t source, uint64_t timestamp_us) {
+    param->timestamp_us = timestamp_us;
+    param->timestamp_ms = (uint32_t)(timestamp_us / 1000ULL);
+    param->source = source;
+    param->is_valid = true;
+    param->update_count++;
     
+    dm->total_updates++;
+}
+
+static void notify_callbacks(data_manager_t* dm, param_id_t param_id,
+                             float new_value, float old_value) {
+    for (uint8_t i = 0; i < dm->callback_count; i++) {
+        if (dm->callbacks[i] != NULL) {
+            dm->callbacks[i](param_id, new_value, old_value);
+        }
+    }
+}
+
+/**
+ * @brief Store a value and notify callbacks (shared by updates and resolves)
+ */
+static void store_value(data_manager_t* dm, param_id_t param_id,
+                        float value, data_source_t source, uint64_t timestamp_us) {
     data_parameter_t* param = &dm->parameters[param_id];
     
     // Store previous value for callbacks
-    float old_value = param->value;
+    float old_value = param_value(param);
     bool was_valid = param->is_valid;
     
     // Update parameter
-    param->prev_value = param->value;
+    param->prev_value = old_value;
     param->value = value;
-    param->timestamp_ms = timestamp_ms;
-    param->source = source;
-    param->is_valid = true;
-    param->update_count++;
-    
-    dm->total_updates++;
+#if DATA_FIXED_POINT
+    param->prev_scaling = NULL;
+    param->scaling = NULL;
+#endif
+    commit_value(dm, param, source, timestamp_us);
     
     // Notify callbacks if value changed significantly
     if (!was_valid || fabsf(value - old_value) > 0.001f) {
-        for (uint8_t i = 0; i < dm->callback_count; i++) {
-            if (dm->callbacks[i] != NULL) {
-                dm->callbacks[i](param_id, value, old_value);
-            }
-        }
+        notify_callbacks(dm, param_id, value, old_value);
     }
 }
 
+/**
+ * @brief Store a raw value (converted now, or kept raw with DATA_FIXED_POINT)
+ */
+static void store_raw(data_manager_t* dm, param_id_t param_id, uint32_t raw,
+                      const data_scaling_t* scaling, data_source_t source,
+                      uint64_t timestamp_us) {
+#if DATA_FIXED_POINT
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    // Same raw value through the same scaling: exactly the same value
+    bool changed = !param->is_valid || param->scaling != scaling || param->raw != raw;
+    bool notify = changed && dm->callback_count > 0;
+    float old_value = notify ? param_value(param) : 0.0f;
+    
+    // The previous value is kept as it was stored, converted only when read
+    param->prev_value = param->value;
+    param->prev_raw = param->raw;
+    param->prev_scaling = param->scaling;
+    param->raw = raw;
+    param->scaling = scaling;
+    commit_value(dm, param, source, timestamp_us);
+    
+    // Converted only for listeners
+    if (notify) {
+        notify_callbacks(dm, param_id, data_scaling_apply(scaling, raw), old_value);
+    }
+#else
+    store_value(dm, param_id, data_scaling_apply(scaling, raw), source, timestamp_us);
+#endif
+}
+
+/**
+ * @brief Decode a pending parameter through the resolver
+ *
+ * Runs on the storing task only, so nothing else invalidates or rewrites
+ * the parameter between the resolver and the store.
+ */
+static inline bool resolve_pending(data_manager_t* dm, param_id_t param_id) {
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    if (!param->pending) return false;
+    param->pending = false;
+    if (dm->resolver == NULL) return false;
+    
+    uint32_t raw;
+    const data_scaling_t* scaling = NULL;
+    uint64_t timestamp_us;
+    if (!dm->resolver(param_id, &raw, &scaling, &timestamp_us, dm->resolver_user) ||
+        scaling == NULL) {
+        return false;
+    }
+    store_raw(dm, param_id, raw, scaling, dm->resolver_source, timestamp_us);
+    return true;
+}
+
+void data_manager_set_resolver(data_manager_t* dm, data_resolver_t resolver,
+                               data_source_t source, void* user) {
+    if (dm == NULL || !dm->initialized) return;
+    
+    dm->resolver = resolver;
+    dm->resolver_source = source;
+    dm->resolver_user = user;
+}
+
+void data_manager_mark_pending(data_manager_t* dm, param_id_t param_id) {
+    if (dm == NULL || !dm->initialized) return;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
+    
+    dm->parameters[param_id].pending = true;
+}
+
+bool data_manager_resolve(data_manager_t* dm, param_id_t param_id) {
+    if (dm == NULL || !dm->initialized) return false;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return false;
+    
+    return resolve_pending(dm, param_id);
+}
+
+uint16_t data_manager_resolve_pending(data_manager_t* dm) {
+    if (dm == NULL || !dm->initialized) return 0;
+    
+    uint16_t resolved = 0;
+    for (int i = PARAM_NONE + 1; i < PARAM_MAX; i++) {
+        if (resolve_pending(dm, (param_id_t)i)) resolved++;
+    }
+    return resolved;
+}
+
+void data_manager_update(data_manager_t* dm, param_id_t param_id,
+                         float value, data_source_t source, uint32_t timestamp_ms) {
+    data_manager_update_us(dm, param_id, value, source, (uint64_t)timestamp_ms * 1000ULL);
+}
+
+void data_manager_update_us(data_manager_t* dm, param_id_t param_id,
+                            float value, data_source_t source, uint64_t timestamp_us) {
+    if (dm == NULL || !dm->initialized) return;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
+    
+    // A direct update is newer than any raw data still waiting to be decoded
+    dm->parameters[param_id].pending = false;
+    
+    store_value(dm, param_id, value, source, timestamp_us);
+}
+
+void data_manager_update_raw_us(data_manager_t* dm, param_id_t param_id, uint32_t raw,
+                                const data_scaling_t* scaling, data_source_t source,
+                                uint64_t timestamp_us) {
+    if (dm == NULL || !dm->initialized) return;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
+    if (scaling == NULL) return;
+    
+    dm->parameters[param_id].pending = false;
+    
+    store_raw(dm, param_id, raw, scaling, source, timestamp_us);
+}
+
+void data_manager_touch_us(data_manager_t* dm, param_id_t param_id, uint64_t timestamp_us) {
+    if (dm == NULL || !dm->initialized) return;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
+    
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    if (!param->is_valid) return;
+    
+    param->timestamp_us = timestamp_us;
+    param->timestamp_ms = (uint32_t)(timestamp_us / 1000ULL);
+}
+
 /*===========================================================================*/
 /*                        PARAMETER ACCESS                                  */
 /*===========================================================================*/
@@ -73,10 +229,51 @@ bool data_manager_get(data_manager_t* dm, param_id_t param_id, float* value) {
     
     if (!param->is_valid) return false;
     
-    *value = param->value;
+    *value = param_value(param);
+    return true;
+}
+
+bool data_manager_get_prev(data_manager_t* dm, param_id_t param_id, float* value) {
+    if (dm == NULL || !dm->initialized) return false;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return false;
+    if (value == NULL) return false;
+    
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    if (!param->is_valid || param->update_count < 2) return false;
+    
+#if DATA_FIXED_POINT
+    if (param->prev_scaling != NULL) {
+        *value = data_scaling_apply(param->prev_scaling, param->prev_raw);
+        return true;
+    }
+#endif
+    *value = param->prev_value;
     return true;
 }
 
+bool data_manager_get_raw(data_manager_t* dm, param_id_t param_id, uint32_t* raw,
+                          const data_scaling_t** scaling) {
+    if (dm == NULL || !dm->initialized) return false;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return false;
+    if (raw == NULL) return false;
+    
+#if DATA_FIXED_POINT
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    if (!param->is_valid || param->scaling == NULL) return false;
+    
+    *raw = param->raw;
+    if (scaling != NULL) {
+        *scaling = param->scaling;
+    }
+    return true;
+#else
+    (void)scaling;
+    return false;  // Values are converted when stored
+#endif
+}
+
 bool data_manager_get_with_timestamp(data_manager_t* dm, param_id_t param_id,
                                       float* value, uint32_t* timestamp_ms) {
     if (dm == NULL || !dm->initialized) return false;
@@ -87,7 +284,7 @@ bool data_manager_get_with_timestamp(data_manager_t* dm, param_id_t param_id,
     if (!param->is_valid) return false;
     
     if (value != NULL) {
-        *value = param->value;
+        *value = param_value(param);
     }
     if (timestamp_ms != NULL) {
         *timestamp_ms = param->timestamp_ms;
@@ -96,6 +293,25 @@ bool data_manager_get_with_timestamp(data_manager_t* dm, param_id_t param_id,
     return true;
 }
 
+bool data_manager_get_with_timestamp_us(data_manager_t* dm, param_id_t param_id,
+                                         float* value, uint64_t* timestamp_us) {
+    if (dm == NULL || !dm->initialized) return false;
+    if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return false;
+    
+    data_parameter_t* param = &dm->parameters[param_id];
+    
+    if (!param->is_valid) return false;
+    
+    if (value != NULL) {
+        *value = param_value(param);
+    }
+    if (timestamp_us != NULL) {
+        *timestamp_us = param->timestamp_us;
+    }
+    
+    return true;
+}
+
 bool data_manager_is_fresh(data_manager_t* dm, param_id_t param_id,
                            uint32_t current_time_ms, uint32_t max_age_ms) {
     if (dm == NULL || !dm->initialized) return false;
@@ -125,6 +341,7 @@ void data_manager_invalidate(data_manager_t* dm, param_id_t param_id) {
     if (dm == NULL || !dm->initialized) return;
     if (param_id == PARAM_NONE || param_id >= PARAM_MAX) return;
     
+    dm->parameters[param_id].pending = false;
     dm->parameters[param_id].is_valid = false;
 }
 
@@ -211,6 +428,14 @@ static const param_info_t param_info[] = {
     // Diagnostics
     { PARAM_ACTIVE_DTC_COUNT,   "Active DTC Count",     "" },
     { PARAM_MIL_STATUS,         "MIL Status",           "" },
+    { PARAM_BUS_LOAD,           "Bus Load",             "%" },
+    { PARAM_BUS_LOAD_WORST,     "Bus Load (Worst)",     "%" },
+    { PARAM_BUS_FRAME_RATE,     "Bus Frame Rate",       "fps" },
+    { PARAM_BUS_OFF_CYCLE_COUNT, "Off-Cycle PGNs",      "" },
+    { PARAM_BUS_MAX_JITTER,     "Max PGN Jitter",       "ms" },
+    { PARAM_BUS_BUSIEST_SA,     "Busiest ECU",          "" },
+    { PARAM_BUS_BUSIEST_SA_RATE, "Busiest ECU Rate",    "fps" },
+    { PARAM_BUS_LOST_COUNT,     "Lost PGNs",            "" },
     
     // Computed
     { PARAM_MPG_CURRENT,        "Current MPG",          "mpg" },
@@ -251,7 +476,7 @@ void data_manager_get_stats(data_manager_t* dm, uint32_t* valid_count, uint32_t*
     
     if (valid_count != NULL) {
         *valid_count = 0;
-        for (int i = 0; i < DATA_MAX_PARAMETERS; i++) {
+        for (int i = 0; i < PARAM_MAX; i++) {
             if (dm->parameters[i].is_valid) {
                 (*valid_count)++;
             }
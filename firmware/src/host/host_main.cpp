@@ -0,0 +1,353 @@
+/**
+ * @file host_main.cpp
+ * @brief Linux host build of the dashboard pipeline (pio run -e host)
+ *
+ * Runs the firmware's CAN pipeline - driver, parser, TP reassembly, decoder,
+ * data manager, watch list and (RAM-backed) storage - as a normal Linux
+ * process, so it can be fed real or replayed traffic and profiled with perf.
+ *
+ * Usage: dashboard_host [-i seconds] [-q] [-e dir] <source>
+ *   source   SocketCAN interface (e.g. vcan0), or a candump -L log file,
+ *            or "-" to read a log from stdin when no vcan is available
+ *   -i N     Print statistics every N seconds of wall time (0 = only at exit)
+ *   -q       Only print the final summary
+ *   -e dir   Accept Extended TP transfers to our address and stream each
+ *            one to dir/etp_<SA>_<PGN>_<n>.bin
+ *
+ * Examples:
+ *   canplayer -I lib/j1939_data/test_data/truck_sample_generated.log vcan0=vcan0 &
+ *   .pio/build/host/program vcan0
+ *   .pio/build/host/program lib/j1939_data/test_data/truck_sample_generated.log
+ */
+
+#ifdef HOST_BUILD
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "../config.h"
+#include "../can/can_driver.h"
+#include "../can/can_host.h"
+#include "../can/j1939_parser.h"
+#include "../data/data_manager.h"
+#include "../data/watch_list_manager.h"
+#include "../storage/nvs_storage.h"
+#include "../pipeline/j1939_pipeline.h"
+
+// Native millis() stub (can/j1939_parser.cpp), driven from the host clock here
+void test_set_millis(uint32_t ms);
+
+#define HOST_RX_BATCH           64          // Frames per driver call
+#define HOST_RX_WAIT_MS         100         // Idle wait on SocketCAN
+#define HOST_STORAGE_PERIOD_MS  10000       // Matches the firmware storage task
+
+/*===========================================================================*/
+/*                        GLOBAL INSTANCES                                  */
+/*===========================================================================*/
+
+static j1939_parser_context_t g_j1939_ctx;
+static data_manager_t g_data_manager;
+static watch_list_manager_t g_watch_list;
+static nvs_storage_t g_storage;
+static j1939_pipeline_t g_pipeline;
+
+static volatile sig_atomic_t g_stop = 0;
+static bool g_quiet = false;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+/*===========================================================================*/
+/*                        ETP FILE SINK                                     */
+/*===========================================================================*/
+
+static const char* g_etp_dir = NULL;
+static FILE* g_etp_files[256];          // Open output per sender
+static uint32_t g_etp_file_count = 0;
+
+static bool etp_file_begin(const j1939_etp_transfer_t* xfer, void* user) {
+    (void)user;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/etp_%02X_%05lX_%lu.bin", g_etp_dir,
+             xfer->source_address, (unsigned long)xfer->pgn, (unsigned long)g_etp_file_count++);
+
+    g_etp_files[xfer->source_address] = fopen(path, "wb");
+    if (g_etp_files[xfer->source_address] == NULL) {
+        fprintf(stderr, "cannot create %s\n", path);
+        return false;
+    }
+    if (!g_quiet) {
+        printf("ETP from SA %02X: PGN %05lX, %lu bytes -> %s\n", xfer->source_address,
+               (unsigned long)xfer->pgn, (unsigned long)xfer->total_size, path);
+    }
+    return true;
+}
+
+static bool etp_file_write(const j1939_etp_transfer_t* xfer, uint32_t offset,
+                           const uint8_t* data, uint8_t len, void* user) {
+    (void)offset;  // Offsets arrive in order
+    (void)user;
+    FILE* file = g_etp_files[xfer->source_address];
+    return file != NULL && fwrite(data, 1, len, file) == len;
+}
+
+static void etp_file_end(const j1939_etp_transfer_t* xfer, uint8_t result, void* user) {
+    (void)user;
+    FILE* file = g_etp_files[xfer->source_address];
+    if (file != NULL) fclose(file);
+    g_etp_files[xfer->source_address] = NULL;
+
+    if (!g_quiet) {
+        printf("ETP from SA %02X: %s after %lu bytes\n", xfer->source_address,
+               result == 0 ? "complete" : "aborted", (unsigned long)xfer->bytes_received);
+    }
+}
+
+static const j1939_etp_sink_t g_etp_file_sink = {
+    etp_file_begin, etp_file_write, etp_file_end, NULL
+};
+
+/*===========================================================================*/
+/*                        OUTPUT                                            */
+/*===========================================================================*/
+
+static void print_stats(uint64_t wall_us, uint64_t trace_us) {
+    can_stats_t can_stats;
+    can_driver_get_stats(&can_stats);
+
+    double wall_s = wall_us / 1e6;
+    printf("frames %lu  wall %.3f s  trace %.3f s  %.0f frames/s\n",
+           (unsigned long)g_pipeline.frames, wall_s, trace_us / 1e6,
+           wall_s > 0 ? g_pipeline.frames / wall_s : 0.0);
+    printf("  pipeline: parse errors %lu  TP messages %lu  signals %lu\n",
+           (unsigned long)g_pipeline.parse_errors, (unsigned long)g_pipeline.tp_messages,
+           (unsigned long)g_pipeline.decoded_signals);
+    j1939_tp_pool_stats_t tp_stats;
+    j1939_tp_get_pool_stats(&g_j1939_ctx, &tp_stats);
+    printf("  TP pool: %u/%u blocks (HWM %u)  sessions HWM %u  refused %lu exhausted, "
+           "%lu fragmented, %lu no session\n",
+           tp_stats.blocks_in_use, J1939_TP_POOL_BLOCKS, tp_stats.blocks_high_water,
+           tp_stats.sessions_high_water, (unsigned long)tp_stats.exhausted,
+           (unsigned long)tp_stats.fragmented, (unsigned long)tp_stats.no_session);
+    j1939_tp_conn_stats_t conn_stats;
+    j1939_tp_get_conn_stats(&g_j1939_ctx, &conn_stats);
+    printf("  TP connections: RTS %lu  completed %lu  aborts %lu sent/%lu received  "
+           "timeouts %lu\n",
+           (unsigned long)conn_stats.rts_received, (unsigned long)conn_stats.completed,
+           (unsigned long)conn_stats.aborts_sent, (unsigned long)conn_stats.aborts_received,
+           (unsigned long)conn_stats.timeouts);
+    j1939_etp_stats_t etp_stats;
+    j1939_etp_get_stats(&g_j1939_ctx, &etp_stats);
+    printf("  ETP: RTS %lu  completed %lu  aborts %lu sent/%lu received  bytes %lu\n",
+           (unsigned long)etp_stats.rts_received, (unsigned long)etp_stats.completed,
+           (unsigned long)etp_stats.aborts_sent, (unsigned long)etp_stats.aborts_received,
+           (unsigned long)etp_stats.bytes_streamed);
+    j1939_tp_expiry_stats_t expiry;
+    j1939_tp_get_expiry_stats(&g_j1939_ctx, &expiry);
+    printf("  TP expired: %lu (BAM %lu, connection %lu, unclaimed %lu)\n",
+           (unsigned long)expiry.expired, (unsigned long)expiry.bam_expired,
+           (unsigned long)expiry.conn_expired, (unsigned long)expiry.unclaimed);
+    j1939_shadow_stats_t shadow_stats;
+    j1939_shadow_get_stats(&g_pipeline.shadow, &shadow_stats);
+    printf("  shadow: %lu frames (%lu repeats, %.1f%% skipped)  %lu keys  %lu decodes on read  "
+           "%lu overflow\n",
+           (unsigned long)shadow_stats.frames, (unsigned long)shadow_stats.repeats,
+           shadow_stats.frames ? 100.0 * shadow_stats.repeats / shadow_stats.frames : 0.0,
+           (unsigned long)shadow_stats.entries, (unsigned long)shadow_stats.decodes,
+           (unsigned long)shadow_stats.overflow);
+    j1939_busmon_stats_t bus;
+    j1939_busmon_get_stats(&g_pipeline.busmon, &bus);
+    printf("  bus: load %.1f%% (worst %.1f%%, peak %.1f%%)  %.0f frames/s  %u keys (%lu untracked)  "
+           "%u off-cycle  busiest SA 0x%02X %.0f frames/s  max jitter %.2f ms (PGN %lu SA 0x%02X)\n",
+           bus.load_pct, bus.load_worst_pct, bus.peak_load_pct, bus.frame_rate, bus.keys,
+           (unsigned long)bus.untracked, bus.off_cycle, bus.busiest_sa, bus.busiest_sa_rate,
+           bus.max_jitter_us / 1000.0, (unsigned long)bus.max_jitter_pgn, bus.max_jitter_sa);
+    printf("  lost: %lu messages (%u silent now)  late frames %lu  parameters invalidated %lu\n",
+           (unsigned long)g_pipeline.lost_messages, bus.lost_keys, (unsigned long)bus.late,
+           (unsigned long)g_pipeline.lost_params);
+
+    j1939_dm1_stats_t dm1;
+    j1939_dm1_get_stats(&g_pipeline.dm1, &dm1);
+    printf("  dm1: %lu received  %lu repeats skipped  %lu changes (%lu not stored)  active faults %u  MIL %s\n",
+           (unsigned long)dm1.messages, (unsigned long)dm1.repeats, (unsigned long)dm1.changes,
+           (unsigned long)g_pipeline.fault_overflows, g_pipeline.dm1.active_count,
+           g_pipeline.dm1.mil ? "on" : "off");
+
+    j1939_addr_stats_t addr;
+    j1939_addr_get_stats(&g_pipeline.addr, &addr);
+    printf("  claims: %u addresses  engine 0x%02X  transmission 0x%02X  moves %lu  foreign frames dropped %lu\n",
+           addr.claimed,
+           j1939_addr_find(&g_pipeline.addr, J1939_FUNCTION_ENGINE, 0),
+           j1939_addr_find(&g_pipeline.addr, J1939_FUNCTION_TRANSMISSION, 0),
+           (unsigned long)addr.moves, (unsigned long)g_pipeline.foreign_frames);
+
+    j1939_diag_stats_t diag;
+    j1939_diag_get_stats(&g_pipeline.diag, &diag);
+    printf("  captures: %lu started  %lu complete  %lu incomplete  %lu coalesced  %lu dropped  %lu unrequested  %lu DM2 unsolicited\n",
+           (unsigned long)diag.started, (unsigned long)diag.completed,
+           (unsigned long)diag.incomplete, (unsigned long)diag.coalesced,
+           (unsigned long)diag.dropped, (unsigned long)diag.unrequested,
+           (unsigned long)diag.unsolicited);
+
+    // Acceptance filter the firmware would install for this traffic
+    can_filter_set_t consumed;
+    can_filter_set_clear(&consumed);
+    j1939_pipeline_get_consumed(&g_pipeline, &consumed);
+    for (uint8_t i = 0; i < g_watch_list.item_count; i++) {
+        if (g_watch_list.items[i].enabled) {
+            can_filter_set_add_param(&consumed, g_watch_list.items[i].param_id);
+        }
+    }
+    static can_filter_traffic_t traffic[J1939_BUSMON_SLOTS];
+    uint16_t traffic_count = j1939_pipeline_get_traffic(&g_pipeline, traffic, J1939_BUSMON_SLOTS);
+    can_filter_plan_t plan;
+    can_filter_plan(&consumed, traffic, traffic_count, &plan);
+    printf("  filter: %s for %u PGNs  code %08lX/%08lX  mask %08lX/%08lX  drops %lu of %lu "
+           "frames (%.1f%%)\n",
+           can_filter_get_mode_name(plan.mode), consumed.count,
+           (unsigned long)plan.code[0], (unsigned long)plan.code[1],
+           (unsigned long)plan.mask[0], (unsigned long)plan.mask[1],
+           (unsigned long)plan.sample_rejected, (unsigned long)plan.sample_frames,
+           plan.sample_frames ? 100.0 * plan.sample_rejected / plan.sample_frames : 0.0);
+    printf("  driver: rx %lu  tx %lu  lost %lu  tx errors %lu\n",
+           (unsigned long)can_stats.rx_count, (unsigned long)can_stats.tx_count,
+           (unsigned long)can_stats.rx_errors, (unsigned long)can_stats.tx_errors);
+}
+
+static void print_parameters(void) {
+    uint32_t valid_params, total_updates;
+    data_manager_get_stats(&g_data_manager, &valid_params, &total_updates);
+    printf("parameters: %lu valid, %lu updates\n",
+           (unsigned long)valid_params, (unsigned long)total_updates);
+
+    for (int id = PARAM_NONE + 1; id < PARAM_MAX; id++) {
+        float value;
+        if (data_manager_get(&g_data_manager, (param_id_t)id, &value)) {
+            printf("  %-28s %12.3f %s\n", data_manager_get_param_name((param_id_t)id),
+                   value, data_manager_get_param_unit((param_id_t)id));
+        }
+    }
+}
+
+/*===========================================================================*/
+/*                        MAIN                                              */
+/*===========================================================================*/
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [-i seconds] [-q] [-e dir] <vcan0 | candump.log | ->\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t stats_interval_s = 10;
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:qe:")) != -1) {
+        switch (opt) {
+            case 'i': stats_interval_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'q': quiet = true; break;
+            case 'e': g_etp_dir = optarg; break;
+            default:  usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* source = argv[optind];
+
+    // Same initialization order as the firmware setup()
+    j1939_parser_init(&g_j1939_ctx);
+    data_manager_init(&g_data_manager);
+    watch_list_init(&g_watch_list, &g_data_manager);
+    watch_list_setup_defaults(&g_watch_list);
+    nvs_storage_init(&g_storage);
+    j1939_pipeline_init(&g_pipeline, &g_j1939_ctx, &g_data_manager, &g_storage);
+    if (g_etp_dir != NULL) {
+        j1939_etp_set_sink(&g_j1939_ctx, &g_etp_file_sink);
+    }
+    g_quiet = quiet;
+
+    if (!can_driver_native_set_source(source)) {
+        fprintf(stderr, "cannot open CAN source '%s'\n", source);
+        return 1;
+    }
+    if (!can_driver_init(0, 0, J1939_BAUD_RATE) || !can_driver_start()) {
+        fprintf(stderr, "CAN driver failed to start\n");
+        return 1;
+    }
+
+    if (!quiet) {
+        printf("reading %s (%s)\n", source,
+               can_host_get_kind() == CAN_HOST_SOCKETCAN ? "SocketCAN" : "candump log");
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    can_frame_t batch[HOST_RX_BATCH];
+    uint64_t start_us = can_driver_time_us();
+    uint64_t first_frame_us = 0;
+    uint64_t last_frame_us = 0;
+    uint64_t now_us = start_us;
+    uint64_t last_display_us = start_us;
+    uint64_t last_storage_us = start_us;
+    uint64_t last_stats_wall_us = start_us;
+
+    while (!g_stop && can_driver_get_state() == CAN_STATE_RUNNING) {
+        uint32_t count = can_driver_receive_batch(batch, HOST_RX_BATCH, HOST_RX_WAIT_MS);
+
+        for (uint32_t i = 0; i < count; i++) {
+            j1939_pipeline_process(&g_pipeline, &batch[i], NULL);
+        }
+
+        // Logs replay faster than real time, so "now" is the newer of the
+        // host clock and the last frame's receive time
+        uint64_t wall_us = can_driver_time_us();
+        if (count > 0) {
+            if (first_frame_us == 0) first_frame_us = batch[0].timestamp_us;
+            last_frame_us = batch[count - 1].timestamp_us;
+        }
+        now_us = (last_frame_us > wall_us) ? last_frame_us : wall_us;
+        uint32_t now_ms = (uint32_t)(now_us / 1000ULL);
+        test_set_millis(now_ms);
+        j1939_pipeline_poll(&g_pipeline, now_ms);
+
+        if (now_us - last_display_us >= DISPLAY_UPDATE_INTERVAL_MS * 1000ULL) {
+            watch_list_update(&g_watch_list, now_ms);
+            last_display_us = now_us;
+        }
+
+        if (now_us - last_storage_us >= HOST_STORAGE_PERIOD_MS * 1000ULL) {
+            float speed, fuel_rate;
+            float dt_hours = (now_us - last_storage_us) / 3.6e9f;
+            j1939_pipeline_store_faults(&g_pipeline);
+            if (data_manager_get(&g_data_manager, PARAM_VEHICLE_SPEED, &speed) &&
+                data_manager_get(&g_data_manager, PARAM_FUEL_RATE, &fuel_rate)) {
+                nvs_storage_periodic_update(&g_storage, now_ms, speed * dt_hours,
+                                            fuel_rate * dt_hours);
+            }
+            last_storage_us = now_us;
+        }
+
+        if (!quiet && stats_interval_s > 0 &&
+            wall_us - last_stats_wall_us >= stats_interval_s * 1000000ULL) {
+            print_stats(wall_us - start_us, last_frame_us - first_frame_us);
+            last_stats_wall_us = wall_us;
+        }
+    }
+
+    uint64_t end_us = can_driver_time_us();
+    print_stats(end_us - start_us, last_frame_us - first_frame_us);
+    print_parameters();
+
+    can_driver_stop();
+    can_driver_native_set_source(NULL);
+    return 0;
+}
+
+#endif // HOST_BUILD
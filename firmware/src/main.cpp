@@ -15,10 +15,14 @@
 #include <Arduino.h>
 #include "config.h"
 #include "can/j1939_parser.h"
+#include "can/j1939_decoder.h"
+#include "can/can_driver.h"
+#include "can/can_ring.h"
 #include "j1708/j1708_parser.h"
 #include "data/data_manager.h"
 #include "data/watch_list_manager.h"
 #include "storage/nvs_storage.h"
+#include "pipeline/j1939_pipeline.h"
 
 // Simulation mode
 #ifdef SIMULATION_MODE
@@ -27,7 +31,6 @@
 
 // Include ESP32 CAN driver (when hardware available)
 #ifndef NATIVE_BUILD
-#include <driver/twai.h>
 #endif
 
 /*===========================================================================*/
@@ -38,16 +41,46 @@
 static j1939_parser_context_t g_j1939_ctx;
 static j1708_parser_context_t g_j1708_ctx;
 
+// Receive -> decode hand-off (CAN task produces, decode task consumes)
+static can_ring_t g_can_ring;
+
 // Data management
 static data_manager_t g_data_manager;
 static watch_list_manager_t g_watch_list;
 static nvs_storage_t g_storage;
 
+// Parse -> TP -> decode -> storage path shared with the host build
+static j1939_pipeline_t g_pipeline;
+
 // Statistics
 static uint32_t g_can_frames_received = 0;
 static uint32_t g_j1708_messages_received = 0;
 static uint32_t g_last_stats_time = 0;
 
+/**
+ * @brief CAN receive pipeline statistics (written by can_task only)
+ */
+typedef struct {
+    uint32_t bursts;            // Wakeups that received at least one frame
+    uint32_t full_bursts;       // Bursts cut off at CAN_RX_BATCH_MAX
+    uint32_t max_burst;         // Most frames drained in one wakeup
+} can_rx_stats_t;
+
+static can_rx_stats_t g_can_rx_stats;
+
+/**
+ * @brief Installed acceptance filter (planned and applied by can_task only)
+ */
+typedef struct {
+    bool installed;             // A plan has been applied
+    can_filter_set_t consumed;  // PGN set it was planned for
+    can_filter_plan_t plan;
+    uint32_t planned_ms;        // millis() when planned (length of the traffic sample)
+    uint32_t checked_ms;        // Last consumed-set check
+} can_filter_state_t;
+
+static can_filter_state_t g_can_filter;
+
 // Simulation state
 #ifdef SIMULATION_MODE
 static sim_scenario_t g_sim_scenario = SIM_SCENARIO_HIGHWAY;
@@ -60,6 +93,7 @@ static uint32_t g_sim_last_update = 0;
 
 #ifndef NATIVE_BUILD
 static TaskHandle_t g_can_task_handle = NULL;
+static TaskHandle_t g_decode_task_handle = NULL;
 static TaskHandle_t g_j1708_task_handle = NULL;
 static TaskHandle_t g_display_task_handle = NULL;
 static TaskHandle_t g_storage_task_handle = NULL;
@@ -79,114 +113,15 @@ static TaskHandle_t g_storage_task_handle = NULL;
 static void sim_can_callback(uint32_t can_id, const uint8_t* data, uint8_t len) {
     g_can_frames_received++;
     
-    // Parse the frame
-    j1939_message_t msg;
-    if (!j1939_parse_frame(can_id, data, len, millis(), &msg)) {
-        return;
-    }
-    
-    // Decode parameters based on PGN
-    float value;
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = can_id;
+    frame.length = (len > 8) ? 8 : len;
+    frame.is_extended = true;
+    frame.timestamp_us = can_driver_time_us();
+    memcpy(frame.data, data, frame.length);
     
-    switch (msg.pgn) {
-        case 61444:  // EEC1 - Engine Speed
-            value = j1939_decode_engine_speed(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_ENGINE_SPEED,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 61443:  // EEC2 - Throttle
-            value = j1939_decode_throttle_position(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_THROTTLE_POSITION,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65262:  // ET1 - Coolant Temperature
-            value = j1939_decode_coolant_temp(msg.data);
-            if (value > -9000) {
-                data_manager_update(&g_data_manager, PARAM_COOLANT_TEMP,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65263:  // EFLP1 - Oil Pressure
-            value = j1939_decode_oil_pressure(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_OIL_PRESSURE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65265:  // CCVS - Vehicle Speed
-            value = j1939_decode_vehicle_speed(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_VEHICLE_SPEED,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65266:  // LFE - Fuel Rate
-            value = j1939_decode_fuel_rate(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_FUEL_RATE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65270:  // IC1 - Boost Pressure
-            value = j1939_decode_boost_pressure(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_BOOST_PRESSURE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65271:  // VEP1 - Battery Voltage
-            value = j1939_decode_battery_voltage(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_BATTERY_VOLTAGE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65272:  // TRF1 - Trans Oil Temp
-            value = j1939_decode_trans_oil_temp(msg.data);
-            if (value > -9000) {
-                data_manager_update(&g_data_manager, PARAM_TRANS_OIL_TEMP,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65276:  // DD - Fuel Level
-            value = j1939_decode_fuel_level(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_FUEL_LEVEL_1,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65253:  // HOURS - Engine Hours
-            value = j1939_decode_engine_hours(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_ENGINE_HOURS,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 61445:  // ETC2 - Current Gear
-            {
-                int8_t gear = j1939_decode_current_gear(msg.data);
-                if (gear > -126) {
-                    data_manager_update(&g_data_manager, PARAM_CURRENT_GEAR,
-                                       (float)gear, SOURCE_J1939, millis());
-                }
-            }
-            break;
-    }
+    j1939_pipeline_process(&g_pipeline, &frame, NULL);
 }
 
 /**
@@ -244,214 +179,174 @@ static void print_sim_status(void) {
 
 #ifndef NATIVE_BUILD
 /**
- * @brief Initialize ESP32 TWAI (CAN) controller
+ * @brief Initialize the CAN driver and join the bus
  */
 static bool init_can_bus(void) {
-    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(
-        (gpio_num_t)PIN_CAN_TX, 
-        (gpio_num_t)PIN_CAN_RX, 
-        TWAI_MODE_NORMAL
-    );
-    g_config.rx_queue_len = J1939_RX_QUEUE_SIZE;
-    g_config.tx_queue_len = J1939_TX_QUEUE_SIZE;
-    
-    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_250KBITS();
-    
-    // Accept all extended (29-bit) frames
-    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
-    
-    if (twai_driver_install(&g_config, &t_config, &f_config) != ESP_OK) {
-        Serial.println("ERROR: Failed to install TWAI driver");
+    // Filter defaults to accept-all; J1939 only uses extended frames
+    if (!can_driver_init(PIN_CAN_TX, PIN_CAN_RX, J1939_BAUD_RATE)) {
+        Serial.println("ERROR: Failed to install CAN driver");
         return false;
     }
     
-    if (twai_start() != ESP_OK) {
-        Serial.println("ERROR: Failed to start TWAI driver");
+    if (!can_driver_start()) {
+        Serial.println("ERROR: Failed to start CAN driver");
         return false;
     }
     
-    Serial.println("CAN bus initialized at 250 kbps");
+    Serial.printf("CAN bus initialized at %lu kbps\n", (unsigned long)(J1939_BAUD_RATE / 1000));
     return true;
 }
 
 /**
  * @brief Process a received J1939 CAN frame
  */
-static void process_j1939_frame(const twai_message_t* frame) {
+static void process_j1939_frame(const can_frame_t* frame) {
     if (frame == NULL) return;
-    if (!frame->extd) return;  // J1939 requires extended IDs
+    if (!frame->is_extended) return;  // J1939 requires extended IDs
     
     g_can_frames_received++;
     
-    // Parse the frame
+    #if DEBUG_CAN_FRAMES
+    Serial.printf("%llu.%06llu %08lX [%u] %02X %02X %02X %02X %02X %02X %02X %02X\n",
+                  frame->timestamp_us / 1000000ULL, frame->timestamp_us % 1000000ULL,
+                  (unsigned long)frame->id, frame->length,
+                  frame->data[0], frame->data[1], frame->data[2], frame->data[3],
+                  frame->data[4], frame->data[5], frame->data[6], frame->data[7]);
+    #endif
+    
+    // Parse, reassemble TP, decode and persist
     j1939_message_t msg;
-    if (!j1939_parse_frame(frame->identifier, frame->data, frame->data_length_code,
-                           millis(), &msg)) {
+    if (!j1939_pipeline_process(&g_pipeline, frame, &msg)) {
         return;
     }
     
-    // Check for Transport Protocol frames
-    if (msg.pgn == PGN_TP_CM || msg.pgn == PGN_TP_DT) {
-        if (j1939_tp_handle_frame(&g_j1939_ctx, &msg)) {
-            // TP message complete - process it
-            uint32_t tp_pgn;
-            uint8_t tp_buffer[256];
-            uint16_t tp_len = j1939_tp_get_data(&g_j1939_ctx, msg.source_address,
-                                                 &tp_pgn, tp_buffer, sizeof(tp_buffer));
-            
-            if (tp_len > 0 && tp_pgn == 65226) {  // DM1
-                j1939_lamp_status_t lamps;
-                j1939_dtc_t dtcs[8];
-                uint8_t dtc_count = j1939_parse_dm1(tp_buffer, tp_len, &lamps, dtcs, 8);
-                
-                // Store DTC count
-                data_manager_update(&g_data_manager, PARAM_ACTIVE_DTC_COUNT,
-                                   (float)dtc_count, SOURCE_J1939, millis());
-                
-                // Store in NVS
-                for (uint8_t i = 0; i < dtc_count; i++) {
-                    nvs_dtc_store(&g_storage, dtcs[i].spn, dtcs[i].fmi,
-                                  dtcs[i].source_address, millis() / 1000, true);
-                }
-            }
+    // Debug output
+    #if DEBUG_PARSED_VALUES
+    if (g_can_frames_received % 100 == 0) {
+        Serial.printf("CAN: %llu.%06llu PGN %u (%s) from SA 0x%02X\n",
+                      msg.timestamp_us / 1000000ULL, msg.timestamp_us % 1000000ULL, msg.pgn,
+                      j1939_get_pgn_name(msg.pgn), msg.source_address);
+    }
+    #endif
+}
+
+/**
+ * @brief Re-plan the hardware acceptance filter when the consumed PGNs change
+ * 
+ * Consumers are the decoder table and transport/DM1 handling (pipeline), the
+ * watch list, and the raw frame log (DEBUG_CAN_FRAMES wants every frame).
+ * Runs in can_task between bursts so reinstalling the driver never races a
+ * receive; transmits from decode_task fail while it runs (the driver holds
+ * the controller for either). A failed reinstall keeps or restores the
+ * previous filter and is retried at the next check. The first plan waits until CAN_FILTER_LEARN_MS of accept-all
+ * traffic has been seen, so candidates are ranked by real frame counts.
+ */
+static void update_can_filter(uint32_t now_ms) {
+    if (now_ms - g_can_filter.checked_ms < CAN_FILTER_CHECK_MS) return;
+    g_can_filter.checked_ms = now_ms;
+    if (now_ms < CAN_FILTER_LEARN_MS) return;
+    
+    can_filter_set_t consumed;
+    can_filter_set_clear(&consumed);
+    j1939_pipeline_get_consumed(&g_pipeline, &consumed);
+    for (uint8_t i = 0; i < g_watch_list.item_count; i++) {
+        if (g_watch_list.items[i].enabled) {
+            can_filter_set_add_param(&consumed, g_watch_list.items[i].param_id);
         }
+    }
+    #if DEBUG_CAN_FRAMES || !CAN_FILTER_ENABLED
+    consumed.accept_all = true;
+    #endif
+    
+    if (g_can_filter.installed && can_filter_set_equal(&consumed, &g_can_filter.consumed)) {
         return;
     }
     
-    // Decode parameters based on PGN
-    float value;
+    static can_filter_traffic_t traffic[J1939_BUSMON_SLOTS];
+    uint16_t traffic_count = j1939_pipeline_get_traffic(&g_pipeline, traffic, J1939_BUSMON_SLOTS);
+    if (!g_can_filter.installed && traffic_count == 0) return;  // Nothing sampled yet
     
-    switch (msg.pgn) {
-        case 61444:  // EEC1 - Engine Speed
-            value = j1939_decode_engine_speed(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_ENGINE_SPEED,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 61443:  // EEC2 - Throttle
-            value = j1939_decode_throttle_position(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_THROTTLE_POSITION,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65262:  // ET1 - Coolant Temperature
-            value = j1939_decode_coolant_temp(msg.data);
-            if (value > -9000) {
-                data_manager_update(&g_data_manager, PARAM_COOLANT_TEMP,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65263:  // EFLP1 - Oil Pressure
-            value = j1939_decode_oil_pressure(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_OIL_PRESSURE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65265:  // CCVS - Vehicle Speed
-            value = j1939_decode_vehicle_speed(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_VEHICLE_SPEED,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65266:  // LFE - Fuel Rate
-            value = j1939_decode_fuel_rate(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_FUEL_RATE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65269:  // AMB - Ambient Temperature
-            value = j1939_decode_ambient_temp(msg.data);
-            if (value > -9000) {
-                data_manager_update(&g_data_manager, PARAM_AMBIENT_TEMP,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65270:  // IC1 - Boost Pressure
-            value = j1939_decode_boost_pressure(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_BOOST_PRESSURE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65271:  // VEP1 - Battery Voltage
-            value = j1939_decode_battery_voltage(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_BATTERY_VOLTAGE,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65272:  // TRF1 - Trans Oil Temp
-            value = j1939_decode_trans_oil_temp(msg.data);
-            if (value > -9000) {
-                data_manager_update(&g_data_manager, PARAM_TRANS_OIL_TEMP,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65276:  // DD - Fuel Level
-            value = j1939_decode_fuel_level(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_FUEL_LEVEL_1,
-                                   value, SOURCE_J1939, millis());
-            }
-            break;
-            
-        case 65253:  // HOURS - Engine Hours
-            value = j1939_decode_engine_hours(msg.data);
-            if (value >= 0) {
-                data_manager_update(&g_data_manager, PARAM_ENGINE_HOURS,
-                                   value, SOURCE_J1939, millis());
-                nvs_lifetime_set_engine_hours(&g_storage, value);
-            }
-            break;
-            
-        case 61445:  // ETC2 - Current Gear
-            {
-                int8_t gear = j1939_decode_current_gear(msg.data);
-                if (gear > -126) {
-                    data_manager_update(&g_data_manager, PARAM_CURRENT_GEAR,
-                                       (float)gear, SOURCE_J1939, millis());
-                }
-            }
-            break;
-    }
+    can_filter_plan_t plan;
+    can_filter_plan(&consumed, traffic, traffic_count, &plan);
     
-    // Debug output
-    #if DEBUG_PARSED_VALUES
-    if (g_can_frames_received % 100 == 0) {
-        Serial.printf("CAN: PGN %u from SA 0x%02X\n", msg.pgn, msg.source_address);
+    bool applied;
+    if (plan.mode == CAN_FILTER_DUAL) {
+        applied = can_driver_set_dual_filter(plan.code[0], plan.mask[0], plan.code[1], plan.mask[1]);
+    } else {
+        applied = can_driver_set_filter(plan.code[0], plan.mask[0]);  // Mask 0 accepts all
     }
-    #endif
+    if (!applied) {
+        Serial.println("ERROR: CAN filter reinstall failed, retrying");
+        return;
+    }
+    
+    g_can_filter.installed = true;
+    g_can_filter.consumed = consumed;
+    g_can_filter.plan = plan;
+    g_can_filter.planned_ms = now_ms;
+    Serial.printf("CAN filter: %s for %u PGNs, drops %lu of %lu sampled frames\n",
+                  can_filter_get_mode_name(plan.mode), consumed.count,
+                  plan.sample_rejected, plan.sample_frames);
 }
 
 /**
  * @brief CAN bus receive task
+ * 
+ * The driver blocks for the first frame, then drains everything already
+ * queued, up to CAN_RX_BATCH_MAX frames per call; it also services bus-off
+ * recovery while idle. Frames are only copied into the ring here; decoding
+ * happens in decode_task. A full batch means the bus is saturated, so the
+ * task sleeps one tick to let the idle task feed the watchdog.
  */
 static void can_task(void* param) {
-    twai_message_t message;
+    can_frame_t batch[CAN_RX_BATCH_MAX];
     
     while (true) {
-        // Wait for CAN message with 10ms timeout
-        if (twai_receive(&message, pdMS_TO_TICKS(10)) == ESP_OK) {
-            process_j1939_frame(&message);
+        update_can_filter(millis());
+        
+        uint32_t burst = can_driver_receive_batch(batch, CAN_RX_BATCH_MAX, CAN_RX_WAIT_MS);
+        if (burst == 0) {
+            continue;  // Bus idle or recovering
+        }
+        
+        for (uint32_t i = 0; i < burst; i++) {
+            can_ring_push(&g_can_ring, &batch[i]);  // Full ring is counted as overflow
+        }
+        xTaskNotifyGive(g_decode_task_handle);
+        
+        g_can_rx_stats.bursts++;
+        if (burst > g_can_rx_stats.max_burst) {
+            g_can_rx_stats.max_burst = burst;
         }
         
-        // Feed watchdog
-        vTaskDelay(1);
+        if (burst >= CAN_RX_BATCH_MAX) {
+            g_can_rx_stats.full_bursts++;
+            vTaskDelay(1);  // Let lower-priority tasks and the watchdog run
+        }
+    }
+}
+
+/**
+ * @brief J1939 decode task
+ * 
+ * Woken by can_task after each receive burst; drains the ring in batches so
+ * slow data manager callbacks never hold up reception.
+ */
+static void decode_task(void* param) {
+    can_frame_t batch[CAN_DECODE_BATCH];
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_DECODE_WAIT_MS));
+        
+        uint32_t count;
+        while ((count = can_ring_pop_batch(&g_can_ring, batch, CAN_DECODE_BATCH)) > 0) {
+            for (uint32_t i = 0; i < count; i++) {
+                process_j1939_frame(&batch[i]);
+            }
+        }
+        
+        // Wakes at least every CAN_DECODE_WAIT_MS, so TP and lost-message timers run on an idle bus too
+        j1939_pipeline_poll(&g_pipeline, millis());
     }
 }
 #endif // NATIVE_BUILD
@@ -623,6 +518,9 @@ static void storage_task(void* param) {
         uint32_t now = millis();
         float distance, fuel_rate;
         
+        // Fault changes and DM2 / DM4 captures since the last pass (stored here, off the decode path)
+        j1939_pipeline_store_faults(&g_pipeline);
+        
         // Calculate distance and fuel deltas
         if (data_manager_get(&g_data_manager, PARAM_VEHICLE_SPEED, &distance)) {
             // Approximate distance from speed (very rough)
@@ -655,6 +553,104 @@ static void print_stats(void) {
     if (now - g_last_stats_time >= 10000) {  // Every 10 seconds
         Serial.println("\n========== Dashboard Statistics ==========");
         Serial.printf("CAN frames received: %lu\n", g_can_frames_received);
+        Serial.printf("CAN rx bursts: %lu (max %lu, full %lu)\n",
+                      g_can_rx_stats.bursts, g_can_rx_stats.max_burst,
+                      g_can_rx_stats.full_bursts);
+        
+        can_stats_t can_stats;
+        can_driver_get_stats(&can_stats);
+        Serial.printf("CAN driver: rx %lu  tx %lu  queue HWM: %lu/%d  lost: %lu  tx errors: %lu\n",
+                      can_stats.rx_count, can_stats.tx_count, can_stats.rx_queue_high_water,
+                      CAN_DRIVER_RX_QUEUE_LEN, can_stats.rx_errors, can_stats.tx_errors);
+        Serial.printf("CAN bus: errors %lu  arb lost %lu  TEC/REC %u/%u  bus-off %lu (recovered %lu)\n",
+                      can_stats.bus_errors, can_stats.arbitration_lost,
+                      can_stats.tx_error_counter, can_stats.rx_error_counter,
+                      can_stats.bus_off_count, can_stats.recovery_count);
+        
+        can_ring_stats_t ring_stats;
+        can_ring_get_stats(&g_can_ring, &ring_stats);
+        Serial.printf("Decode ring: %lu/%lu queued  HWM: %lu  overflow: %lu\n",
+                      ring_stats.occupancy, ring_stats.capacity,
+                      ring_stats.high_water, ring_stats.overflow_count);
+        j1939_tp_pool_stats_t tp_stats;
+        j1939_tp_get_pool_stats(&g_j1939_ctx, &tp_stats);
+        Serial.printf("TP pool: %u/%u blocks (HWM %u, largest free %u)  sessions %u (HWM %u)\n",
+                      tp_stats.blocks_in_use, J1939_TP_POOL_BLOCKS, tp_stats.blocks_high_water,
+                      tp_stats.largest_free_run, tp_stats.sessions_in_use,
+                      tp_stats.sessions_high_water);
+        Serial.printf("TP refused: exhausted %lu  fragmented %lu  no session %lu  bad size %lu\n",
+                      tp_stats.exhausted, tp_stats.fragmented, tp_stats.no_session,
+                      tp_stats.rejected_size);
+        j1939_tp_conn_stats_t conn_stats;
+        j1939_tp_get_conn_stats(&g_j1939_ctx, &conn_stats);
+        Serial.printf("TP connections: RTS %lu  CTS %lu  done %lu  aborts %lu sent/%lu received  "
+                      "timeouts %lu  tx fail %lu\n",
+                      conn_stats.rts_received, conn_stats.cts_sent, conn_stats.completed,
+                      conn_stats.aborts_sent, conn_stats.aborts_received,
+                      conn_stats.timeouts, conn_stats.send_failures);
+        j1939_etp_stats_t etp_stats;
+        j1939_etp_get_stats(&g_j1939_ctx, &etp_stats);
+        Serial.printf("ETP: RTS %lu  done %lu  aborts %lu sent/%lu received  bytes %lu\n",
+                      etp_stats.rts_received, etp_stats.completed, etp_stats.aborts_sent,
+                      etp_stats.aborts_received, etp_stats.bytes_streamed);
+        j1939_tp_expiry_stats_t expiry;
+        j1939_tp_get_expiry_stats(&g_j1939_ctx, &expiry);
+        Serial.printf("TP expired: %lu (BAM %lu, connection %lu, unclaimed %lu)  last SA %u PGN %lu\n",
+                      expiry.expired, expiry.bam_expired, expiry.conn_expired, expiry.unclaimed,
+                      expiry.last_source, expiry.last_pgn);
+        j1939_shadow_stats_t shadow_stats;
+        j1939_shadow_get_stats(&g_pipeline.shadow, &shadow_stats);
+        Serial.printf("Shadow cache: %lu frames (%lu repeats, %.1f%% skipped)  %lu keys  "
+                      "%lu decodes on read  %lu overflow\n",
+                      shadow_stats.frames, shadow_stats.repeats,
+                      shadow_stats.frames ? 100.0f * shadow_stats.repeats / shadow_stats.frames : 0.0f,
+                      shadow_stats.entries, shadow_stats.decodes, shadow_stats.overflow);
+        
+        j1939_busmon_stats_t bus;
+        j1939_busmon_get_stats(&g_pipeline.busmon, &bus);
+        Serial.printf("Bus load: %.1f%% (worst %.1f%%, peak %.1f%%)  %.0f frames/s  %u keys  "
+                      "%u off-cycle  busiest SA 0x%02X (%.0f frames/s)  max jitter %.2f ms (PGN %lu SA 0x%02X)\n",
+                      bus.load_pct, bus.load_worst_pct, bus.peak_load_pct, bus.frame_rate, bus.keys,
+                      bus.off_cycle, bus.busiest_sa, bus.busiest_sa_rate,
+                      bus.max_jitter_us / 1000.0f, bus.max_jitter_pgn, bus.max_jitter_sa);
+        Serial.printf("Lost messages: %lu (%u silent now)  late frames %lu  parameters invalidated %lu\n",
+                      g_pipeline.lost_messages, bus.lost_keys, bus.late, g_pipeline.lost_params);
+        
+        j1939_dm1_stats_t dm1;
+        j1939_dm1_get_stats(&g_pipeline.dm1, &dm1);
+        Serial.printf("DM1: %lu received  %lu repeats skipped  %lu changes (%lu not stored)  active faults %u  MIL %s\n",
+                      dm1.messages, dm1.repeats, dm1.changes, g_pipeline.fault_overflows,
+                      g_pipeline.dm1.active_count, g_pipeline.dm1.mil ? "on" : "off");
+        
+        j1939_addr_stats_t addr;
+        j1939_addr_get_stats(&g_pipeline.addr, &addr);
+        Serial.printf("Address claims: %u addresses  engine 0x%02X  transmission 0x%02X  moves %lu  foreign frames dropped %lu\n",
+                      addr.claimed,
+                      j1939_addr_find(&g_pipeline.addr, J1939_FUNCTION_ENGINE, 0),
+                      j1939_addr_find(&g_pipeline.addr, J1939_FUNCTION_TRANSMISSION, 0),
+                      addr.moves, g_pipeline.foreign_frames);
+        
+        j1939_request_stats_t req;
+        j1939_request_get_stats(&g_pipeline.requests, &req);
+        Serial.printf("Requests: %lu sent  %lu answered  %lu timeouts  %lu NACKs  %lu coalesced  RTT avg %.1f ms max %.1f ms\n",
+                      req.sent, req.answered, req.timeouts, req.nacks, req.coalesced,
+                      req.rtt_avg_us / 1000.0f, req.rtt_max_us / 1000.0f);
+        
+        j1939_diag_stats_t diag;
+        j1939_diag_get_stats(&g_pipeline.diag, &diag);
+        Serial.printf("Fault captures: %lu started  %lu complete  %lu incomplete  %lu coalesced  %lu dropped  %lu unrequested  %lu DM2 unsolicited\n",
+                      diag.started, diag.completed, diag.incomplete, diag.coalesced, diag.dropped,
+                      diag.unrequested, diag.unsolicited);
+        
+        const can_filter_plan_t* filter = &g_can_filter.plan;
+        if (g_can_filter.installed && filter->sample_frames > 0) {
+            Serial.printf("CAN filter: %s for %u PGNs  est. %.1f%% of frames dropped (~%.0f/s)\n",
+                          can_filter_get_mode_name(filter->mode), g_can_filter.consumed.count,
+                          100.0f * filter->sample_rejected / filter->sample_frames,
+                          1000.0f * filter->sample_rejected / g_can_filter.planned_ms);
+        } else {
+            Serial.printf("CAN filter: %s\n", g_can_filter.installed ? "accept-all" : "learning");
+        }
         Serial.printf("J1708 messages received: %lu\n", g_j1708_messages_received);
         
         uint32_t valid_params, total_updates;
@@ -716,6 +712,24 @@ void setup() {
         Serial.println("  Warning: Storage initialization failed");
     }
     
+    j1939_pipeline_init(&g_pipeline, &g_j1939_ctx, &g_data_manager, &g_storage);
+    
+    // Parameter groups many ECUs only send when asked
+    uint64_t boot_us = (uint64_t)millis() * 1000ULL;
+#if J1939_REQUEST_AT_BOOT
+    j1939_pipeline_request(&g_pipeline, PGN_ADDRESS_CLAIMED, J1939_GLOBAL_ADDRESS, 0, boot_us);
+#endif
+#if J1939_REQUEST_HOURS_MS > 0
+    j1939_pipeline_request(&g_pipeline, 65253, J1939_GLOBAL_ADDRESS, J1939_REQUEST_HOURS_MS, boot_us);
+#endif
+#if J1939_REQUEST_VD_MS > 0
+    j1939_pipeline_request(&g_pipeline, 65217, J1939_GLOBAL_ADDRESS, J1939_REQUEST_VD_MS, boot_us);
+#endif
+#if J1939_REQUEST_DM2_MS > 0
+    // Answers no capture waits for are stored as previously active DTCs
+    j1939_pipeline_request(&g_pipeline, 65227, J1939_GLOBAL_ADDRESS, J1939_REQUEST_DM2_MS, boot_us);
+#endif
+    
 #ifndef NATIVE_BUILD
     // Initialize CAN bus
     Serial.println("Initializing CAN bus...");
@@ -745,6 +759,14 @@ void setup() {
     // Create tasks
     Serial.println("Starting tasks...");
     
+    can_ring_init(&g_can_ring);
+    
+    // Decode task first so the CAN task always has a handle to notify
+    xTaskCreatePinnedToCore(
+        decode_task, "Decode_Task", TASK_STACK_DECODE,
+        NULL, TASK_PRIORITY_DECODE, &g_decode_task_handle, TASK_CORE_DECODE
+    );
+    
     xTaskCreatePinnedToCore(
         can_task, "CAN_Task", TASK_STACK_CAN,
         NULL, TASK_PRIORITY_CAN, &g_can_task_handle, TASK_CORE_CAN
@@ -786,6 +808,12 @@ void loop() {
     // Update simulation - this generates CAN frames
     update_simulation();
     
+    // Timers the decode task would run: pending decodes, TP, requests, captures
+    j1939_pipeline_poll(&g_pipeline, millis());
+    
+    // No storage task in simulation: write fault changes and captures here
+    j1939_pipeline_store_faults(&g_pipeline);
+    
     // Update display values
     update_computed_params();
     
@@ -0,0 +1,398 @@
+/**
+ * @file j1939_pipeline.cpp
+ * @brief J1939 frame pipeline implementation
+ */
+
+#include "j1939_pipeline.h"
+#include "../can/j1939_decoder.h"
+#include "../config.h"
+#include <string.h>
+
+/*===========================================================================*/
+/*                        INITIALIZATION                                    */
+/*===========================================================================*/
+
+/**
+ * @brief Put a frame in the driver's transmit queue
+ */
+static bool send_frame(uint32_t can_id, const uint8_t* data, uint8_t len, void* user) {
+    (void)user;
+
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = can_id;
+    frame.length = (len > 8) ? 8 : len;
+    frame.is_extended = true;
+    memcpy(frame.data, data, frame.length);
+
+    return can_driver_transmit(&frame, 0);  // Never block the decode path
+}
+
+/**
+ * @brief Transmit hook for TP.CM replies (CTS, EOM acknowledge, abort) and requests
+ *
+ * Nothing leaves our address before it is claimed, or after it is lost.
+ */
+static bool transmit_tp_frame(uint32_t can_id, const uint8_t* data, uint8_t len, void* user) {
+    j1939_pipeline_t* pipe = (j1939_pipeline_t*)user;
+
+    if (!j1939_addr_claim_ready(&pipe->claim)) return false;
+    return send_frame(can_id, data, len, NULL);
+}
+
+/**
+ * @brief Publish the fault table totals
+ */
+static void publish_dm1(j1939_pipeline_t* pipe, uint64_t timestamp_us) {
+    data_manager_update_us(pipe->dm, PARAM_ACTIVE_DTC_COUNT,
+                           (float)pipe->dm1.active_count, SOURCE_J1939, timestamp_us);
+    data_manager_update_us(pipe->dm, PARAM_MIL_STATUS,
+                           pipe->dm1.mil ? 1.0f : 0.0f, SOURCE_J1939, timestamp_us);
+}
+
+/**
+ * @brief Bus monitor hook: a cyclic message stopped, so its values are stale
+ */
+static void message_lost(uint32_t pgn, uint8_t source_address, uint64_t last_us, void* user) {
+    j1939_pipeline_t* pipe = (j1939_pipeline_t*)user;
+
+    pipe->lost_messages++;
+    pipe->lost_params += j1939_shadow_expire(&pipe->shadow, pgn, source_address);
+
+    // A silent ECU's faults are unknown, unless its DM1 moved on to TP
+    if (pgn == 65226) {
+        const j1939_dm1_ecu_t* ecu = j1939_dm1_find(&pipe->dm1, source_address);
+        if (ecu != NULL && ecu->last_us <= last_us &&
+            j1939_dm1_forget(&pipe->dm1, source_address, last_us)) {
+            publish_dm1(pipe, last_us);
+        }
+    }
+}
+
+/**
+ * @brief DM1 table hook: queue the change for storage, capture new faults
+ */
+static void fault_changed(const j1939_dtc_t* dtc, bool active, uint64_t timestamp_us, void* user) {
+    j1939_pipeline_t* pipe = (j1939_pipeline_t*)user;
+    if (pipe->storage == NULL) return;
+
+    if (active) {
+        j1939_diag_capture(&pipe->diag, dtc->source_address, timestamp_us);
+    }
+
+    uint32_t head = pipe->fault_head;
+    uint32_t tail = __atomic_load_n(&pipe->fault_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= J1939_PIPELINE_FAULT_EVENTS) {
+        pipe->fault_overflows++;
+        return;
+    }
+
+    j1939_fault_event_t* event = &pipe->fault_events[head & (J1939_PIPELINE_FAULT_EVENTS - 1)];
+    event->spn = dtc->spn;
+    event->fmi = dtc->fmi;
+    event->source_address = dtc->source_address;
+    event->active = active;
+    event->timestamp_s = (uint32_t)(timestamp_us / 1000000ULL);
+    __atomic_store_n(&pipe->fault_head, head + 1, __ATOMIC_RELEASE);
+}
+
+void j1939_pipeline_init(j1939_pipeline_t* pipe, j1939_parser_context_t* parser,
+                         data_manager_t* dm, nvs_storage_t* storage) {
+    if (pipe == NULL) return;
+
+    memset(pipe, 0, sizeof(j1939_pipeline_t));
+    pipe->parser = parser;
+    pipe->dm = dm;
+    pipe->storage = storage;
+
+    j1939_busmon_init(&pipe->busmon, dm, J1939_BAUD_RATE);
+    j1939_dm1_init(&pipe->dm1, fault_changed, pipe);
+    j1939_addr_init(&pipe->addr);
+    j1939_addr_claim_init(&pipe->claim, J1939_OUR_NAME, J1939_OUR_ADDRESS, send_frame, NULL);
+    j1939_request_init(&pipe->requests, J1939_OUR_ADDRESS, transmit_tp_frame, pipe);
+    j1939_diag_init(&pipe->diag, &pipe->requests);
+    if (dm != NULL) {
+        j1939_shadow_init(&pipe->shadow, dm);
+        j1939_busmon_set_lost_handler(&pipe->busmon, message_lost, pipe);
+    }
+
+    if (parser != NULL) {
+        j1939_tp_set_local_address(parser, J1939_OUR_ADDRESS, transmit_tp_frame, pipe);
+    }
+}
+
+void j1939_pipeline_poll(j1939_pipeline_t* pipe, uint32_t now_ms) {
+    if (pipe == NULL) return;
+
+    // Report bus load even while nothing is received
+    j1939_busmon_poll(&pipe->busmon, (uint64_t)now_ms * 1000ULL);
+
+    // Decode what the shadow cache holds; readers never decode
+    if (pipe->dm != NULL && now_ms - pipe->resolved_ms >= J1939_PIPELINE_RESOLVE_MS) {
+        data_manager_resolve_pending(pipe->dm);
+        pipe->resolved_ms = now_ms;
+    }
+
+    if (pipe->parser != NULL) {
+        j1939_tp_poll(pipe->parser, now_ms);
+    }
+
+    j1939_diag_poll(&pipe->diag, (uint64_t)now_ms * 1000ULL);
+    j1939_request_poll(&pipe->requests, (uint64_t)now_ms * 1000ULL);
+}
+
+bool j1939_pipeline_request(j1939_pipeline_t* pipe, uint32_t pgn, uint8_t destination,
+                            uint32_t period_ms, uint64_t now_us) {
+    if (pipe == NULL) return false;
+    if (!j1939_request_add(&pipe->requests, pgn, destination, period_ms, now_us)) return false;
+
+    // Answers come at the request period, not the broadcast cycle
+    j1939_busmon_set_cycle(&pipe->busmon, pgn, period_ms);
+    return true;
+}
+
+/*===========================================================================*/
+/*                        FAULT STORAGE (STORAGE TASK)                      */
+/*===========================================================================*/
+
+/**
+ * @brief Write the fault changes the decode task queued, oldest first
+ */
+static uint16_t store_fault_events(j1939_pipeline_t* pipe) {
+    uint16_t stored = 0;
+    uint32_t tail = pipe->fault_tail;
+    uint32_t head = __atomic_load_n(&pipe->fault_head, __ATOMIC_ACQUIRE);
+
+    while (tail != head) {
+        const j1939_fault_event_t* event = &pipe->fault_events[tail & (J1939_PIPELINE_FAULT_EVENTS - 1)];
+        if (event->active) {
+            nvs_dtc_store(pipe->storage, event->spn, event->fmi, event->source_address,
+                          event->timestamp_s, true);
+        } else {
+            nvs_dtc_set_inactive(pipe->storage, event->spn, event->fmi, event->source_address,
+                                 event->timestamp_s);
+        }
+        tail++;
+        stored++;
+    }
+    __atomic_store_n(&pipe->fault_tail, tail, __ATOMIC_RELEASE);
+    return stored;
+}
+
+uint16_t j1939_pipeline_store_faults(j1939_pipeline_t* pipe) {
+    if (pipe == NULL) return 0;
+
+    // Events are only queued with storage attached
+    uint16_t stored = (pipe->storage != NULL) ? store_fault_events(pipe) : 0;
+    j1939_diag_job_t job;
+    while (j1939_diag_take(&pipe->diag, &job)) {
+        stored++;
+        if (pipe->storage == NULL) continue;
+
+        uint32_t timestamp_s = (uint32_t)(job.started_us / 1000000ULL);
+
+        if (job.dm2_received) {
+            j1939_dtc_t dtcs[J1939_DM1_MAX_DTCS];
+            uint8_t count = j1939_parse_dm1(job.dm2, job.dm2_length, NULL, dtcs, J1939_DM1_MAX_DTCS);
+            for (uint8_t i = 0; i < count; i++) {
+                nvs_dtc_store_previous(pipe->storage, dtcs[i].spn, dtcs[i].fmi,
+                                       job.source_address, dtcs[i].oc, timestamp_s);
+            }
+        }
+
+        if (job.dm4_received) {
+            j1939_freeze_frame_t frames[NVS_MAX_FREEZE_FRAMES];
+            uint8_t count = j1939_parse_dm4(job.dm4, job.dm4_length, frames, NVS_MAX_FREEZE_FRAMES);
+            for (uint8_t i = 0; i < count; i++) {
+                stored_freeze_frame_t ff;
+                memset(&ff, 0, sizeof(ff));
+                ff.spn = frames[i].dtc.spn;
+                ff.fmi = frames[i].dtc.fmi;
+                ff.source_address = job.source_address;
+                ff.occurrence_count = frames[i].dtc.oc;
+                ff.snapshot_length = frames[i].snapshot_length;
+                memcpy(ff.snapshot, frames[i].snapshot, frames[i].snapshot_length);
+                ff.timestamp = timestamp_s;
+                nvs_freeze_frame_store(pipe->storage, &ff);
+            }
+        }
+    }
+    return stored;
+}
+
+/*===========================================================================*/
+/*                        ACCEPTANCE FILTER INPUTS                          */
+/*===========================================================================*/
+
+void j1939_pipeline_get_consumed(const j1939_pipeline_t* pipe, can_filter_set_t* set) {
+    if (pipe == NULL || set == NULL) return;
+
+    can_filter_set_add_decoder(set);
+    can_filter_set_add(set, PGN_TP_CM);
+    can_filter_set_add(set, PGN_TP_DT);
+    can_filter_set_add(set, PGN_ETP_CM);
+    can_filter_set_add(set, PGN_ETP_DT);
+    can_filter_set_add(set, 65226);  // DM1 (single frame; longer ones arrive over TP)
+    can_filter_set_add(set, PGN_DM2);
+    can_filter_set_add(set, PGN_DM4);
+    can_filter_set_add(set, PGN_ADDRESS_CLAIMED);
+    can_filter_set_add(set, PGN_REQUEST);
+    can_filter_set_add(set, PGN_ACKNOWLEDGMENT);
+    for (uint8_t i = 0; i < pipe->requests.count; i++) {
+        can_filter_set_add(set, pipe->requests.entries[i].pgn);
+    }
+}
+
+uint16_t j1939_pipeline_get_traffic(const j1939_pipeline_t* pipe,
+                                    can_filter_traffic_t* traffic, uint16_t max_entries) {
+    if (pipe == NULL || traffic == NULL) return 0;
+
+    // Sum the bus monitor's per-(PGN, SA) counts per PGN: every extended frame
+    uint16_t count = 0;
+    j1939_busmon_key_t key;
+    for (uint16_t i = 0; i < J1939_BUSMON_SLOTS; i++) {
+        if (!j1939_busmon_get_key(&pipe->busmon, i, &key)) continue;
+
+        uint16_t t = 0;
+        while (t < count && traffic[t].pgn != key.pgn) t++;
+        if (t == count) {
+            if (count >= max_entries) continue;
+            traffic[count].pgn = key.pgn;
+            traffic[count].frames = 0;
+            count++;
+        }
+        traffic[t].frames += key.frames;
+    }
+    return count;
+}
+
+/*===========================================================================*/
+/*                        TRANSPORT PROTOCOL                                */
+/*===========================================================================*/
+
+/**
+ * @brief Feed a DM1 to the fault table; publish the totals when they change
+ */
+static void process_dm1(j1939_pipeline_t* pipe, uint8_t source_address,
+                        const uint8_t* data, uint16_t len, uint64_t timestamp_us) {
+    if (!j1939_dm1_process(&pipe->dm1, source_address, data, len, timestamp_us)) {
+        // Unchanged: the totals are still current
+        data_manager_touch_us(pipe->dm, PARAM_ACTIVE_DTC_COUNT, timestamp_us);
+        data_manager_touch_us(pipe->dm, PARAM_MIL_STATUS, timestamp_us);
+        return;
+    }
+    publish_dm1(pipe, timestamp_us);
+}
+
+/**
+ * @brief Act on a completed TP transfer, read in place from the session buffer
+ */
+static void consume_tp_payload(const j1939_tp_payload_t* payload, void* user) {
+    j1939_pipeline_t* pipe = (j1939_pipeline_t*)user;
+
+    pipe->tp_messages++;
+    j1939_request_frame(&pipe->requests, payload->pgn, payload->source_address,
+                        payload->timestamp_us);
+
+    if (payload->pgn == 65226) {  // DM1
+        process_dm1(pipe, payload->source_address, payload->data, payload->length,
+                    payload->timestamp_us);
+    } else {
+        j1939_diag_payload(&pipe->diag, payload->pgn, payload->source_address,
+                           payload->data, payload->length, payload->timestamp_us);
+    }
+}
+
+/**
+ * @brief Handle a TP.CM / TP.DT frame and act on completed transfers
+ */
+static void process_tp_frame(j1939_pipeline_t* pipe, const j1939_message_t* msg) {
+    if (!j1939_tp_handle_frame(pipe->parser, msg)) return;
+
+    // TP message complete - consume it without copying, whatever its size
+    j1939_tp_deliver(pipe->parser, msg, consume_tp_payload, pipe);
+}
+
+/*===========================================================================*/
+/*                        FRAME PROCESSING                                  */
+/*===========================================================================*/
+
+bool j1939_pipeline_process(j1939_pipeline_t* pipe, const can_frame_t* frame,
+                            j1939_message_t* msg) {
+    if (pipe == NULL || frame == NULL) return false;
+
+    // Every frame loads the bus, J1939 or not
+    j1939_busmon_frame(&pipe->busmon, frame);
+
+    if (!frame->is_extended) return false;  // J1939 requires extended IDs
+
+    pipe->frames++;
+
+    // Parse the frame (stamped by the driver at receive time)
+    j1939_message_t local;
+    j1939_message_t* m = (msg != NULL) ? msg : &local;
+    if (!j1939_parse_frame_us(frame->id, frame->data, frame->length,
+                              frame->timestamp_us, m)) {
+        pipe->parse_errors++;
+        return false;
+    }
+
+    j1939_request_frame(&pipe->requests, m->pgn, m->source_address, m->timestamp_us);
+
+    // Check for Transport Protocol frames (ETP goes to the parser's ETP sink)
+    if (m->pgn == PGN_TP_CM || m->pgn == PGN_TP_DT ||
+        m->pgn == PGN_ETP_CM || m->pgn == PGN_ETP_DT) {
+        process_tp_frame(pipe, m);
+        return true;
+    }
+
+    if (m->pgn == PGN_ACKNOWLEDGMENT) {
+        j1939_request_ack(&pipe->requests, m->source_address, m->data, m->data_length,
+                          m->timestamp_us);
+        return true;
+    }
+
+    if (m->pgn == PGN_ADDRESS_CLAIMED) {
+        j1939_addr_claim_frame(&pipe->claim, m);
+        j1939_addr_process_claim(&pipe->addr, m->source_address, m->data, m->data_length);
+        return true;
+    }
+
+    if (m->pgn == PGN_REQUEST) {
+        j1939_addr_claim_frame(&pipe->claim, m);  // Only Address Claimed is answered
+        return true;
+    }
+
+#if J1939_ROUTE_BY_FUNCTION
+    // Drop PGNs from nodes other than their function's ECU before storing them
+    const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(m->pgn);
+    if (desc != NULL && !j1939_addr_accepts(&pipe->addr, desc->source_function, m->source_address)) {
+        pipe->foreign_frames++;
+        return true;
+    }
+#endif
+
+    if (m->pgn == 65226) {  // DM1 with at most one fault
+        process_dm1(pipe, m->source_address, m->data, m->data_length, m->timestamp_us);
+        return true;
+    }
+
+    if (j1939_diag_payload(&pipe->diag, m->pgn, m->source_address, m->data, m->data_length,
+                           m->timestamp_us)) {
+        return true;  // DM2 / DM4 for the fault history: stored in the background
+    }
+
+    // Keep the raw frame; its signals are decoded when someone reads them
+    uint8_t decoded = j1939_shadow_store(&pipe->shadow, m);
+    pipe->decoded_signals += decoded;
+
+    if (decoded > 0 && m->pgn == 65253 && pipe->storage != NULL) {  // HOURS - mirror into lifetime stats
+        float hours;
+        data_manager_resolve(pipe->dm, PARAM_ENGINE_HOURS);
+        if (data_manager_get(pipe->dm, PARAM_ENGINE_HOURS, &hours)) {
+            nvs_lifetime_set_engine_hours(pipe->storage, hours);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file j1939_pipeline.h
+ * @brief J1939 frame pipeline: parse, TP reassembly, decode, storage
+ *
+ * Everything that happens to a received CAN frame after the driver hands it
+ * over, independent of where it came from. The firmware decode task and the
+ * Linux host build (src/host/) both feed frames through this one path.
+ *
+ * The pipeline also answers RTS/CTS transfers addressed to J1939_OUR_ADDRESS,
+ * transmitting TP.CM replies through can_driver_transmit(); its connection
+ * timers advance in j1939_pipeline_poll(). PGNs registered with the request
+ * scheduler (pipe->requests) are asked for from the same poll. Address
+ * Claimed with J1939_OUR_NAME goes out before the first of these frames,
+ * and Request for Address Claimed is answered.
+ *
+ * Single frames are not decoded on arrival: they land in a per-(PGN, SA)
+ * shadow cache, and j1939_pipeline_poll() decodes the parameters they
+ * changed every J1939_PIPELINE_RESOLVE_MS. Decoding stays in the decode
+ * task, which is the only writer of J1939 parameters and where change
+ * callbacks run; readers only read.
+ *
+ * Address claims fill a NAME table. Frames of PGNs the decoder table
+ * assigns to one function (EEC1 to the engine, ETC1 to the transmission)
+ * are dropped before storage when they come from another node.
+ *
+ * DM1 (single frame or TP) goes to a per-ECU fault table. Repeats of the
+ * same DM1 stop there; PARAM_ACTIVE_DTC_COUNT / PARAM_MIL_STATUS are only
+ * touched when an ECU's fault set or lamps change, and each change is queued
+ * for storage.
+ *
+ * A newly active fault starts a capture of the ECU's DM2 and DM4. The decode
+ * task only copies the replies. j1939_pipeline_store_faults(), called from
+ * the storage task, writes the queued fault changes and parses and stores
+ * the captures, so only that task touches the fault history.
+ */
+
+#ifndef J1939_PIPELINE_H
+#define J1939_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../can/can_driver.h"
+#include "../can/j1939_parser.h"
+#include "../can/j1939_shadow.h"
+#include "../can/j1939_busmon.h"
+#include "../can/j1939_dm1.h"
+#include "../can/j1939_addr.h"
+#include "../can/j1939_request.h"
+#include "../can/j1939_diag.h"
+#include "../can/can_filter.h"
+#include "../data/data_manager.h"
+#include "../storage/nvs_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================*/
+/*                        CONFIGURATION                                     */
+/*===========================================================================*/
+
+#ifndef J1939_PIPELINE_FAULT_EVENTS
+#define J1939_PIPELINE_FAULT_EVENTS 32      // Fault changes queued for storage (power of two)
+#endif
+
+#ifndef J1939_PIPELINE_RESOLVE_MS
+#define J1939_PIPELINE_RESOLVE_MS   50      // Pending parameters decoded at least this often
+#endif
+
+#if (J1939_PIPELINE_FAULT_EVENTS & (J1939_PIPELINE_FAULT_EVENTS - 1)) != 0
+#error "J1939_PIPELINE_FAULT_EVENTS must be a power of two"
+#endif
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief A fault that became active or cleared, waiting to be stored
+ */
+typedef struct {
+    uint32_t spn;
+    uint8_t fmi;
+    uint8_t source_address;
+    bool active;                // Became active (false: cleared)
+    uint32_t timestamp_s;
+} j1939_fault_event_t;
+
+/**
+ * @brief Pipeline wiring and counters
+ */
+typedef struct {
+    j1939_parser_context_t* parser;
+    data_manager_t* dm;
+    nvs_storage_t* storage;         // May be NULL (nothing persisted)
+    j1939_shadow_t shadow;          // Newest frame per (PGN, SA), decoded lazily
+    j1939_busmon_t busmon;          // Bus load and per-(PGN, SA) rates
+    j1939_dm1_table_t dm1;          // Active faults per ECU
+    j1939_addr_table_t addr;        // Claimed NAME per address, address per function
+    j1939_addr_claim_t claim;       // Our claim of J1939_OUR_ADDRESS
+    j1939_request_sched_t requests; // Request (PGN 59904) polling of on-request PGNs
+    j1939_diag_t diag;              // DM2 / DM4 captures of ECUs with new faults
+
+    // Fault changes: written by the decode task, read by the storage task
+    j1939_fault_event_t fault_events[J1939_PIPELINE_FAULT_EVENTS];
+    uint32_t fault_head;            // Next event to write (decode task)
+    uint32_t fault_tail;            // Next event to store (storage task)
+    uint32_t fault_overflows;       // Changes dropped because the queue was full
+
+    uint32_t resolved_ms;           // Time of the last decode of pending parameters
+
+    uint32_t frames;                // Extended frames accepted
+    uint32_t parse_errors;          // Frames rejected by the parser
+    uint32_t tp_messages;           // Completed TP transfers
+    uint32_t decoded_signals;       // Parameters refreshed in the data manager
+    uint32_t foreign_frames;        // Frames dropped: sent by a node other than the PGN's function
+    uint32_t lost_messages;         // Cyclic (PGN, SA) pairs that missed their deadline
+    uint32_t lost_params;           // Parameters invalidated because their source went silent
+} j1939_pipeline_t;
+
+/*===========================================================================*/
+/*                        FUNCTION DECLARATIONS                             */
+/*===========================================================================*/
+
+/**
+ * @brief Wire up a pipeline
+ * @param pipe Pipeline to initialize
+ * @param parser Initialized parser context (TP sessions)
+ * @param dm Initialized data manager (its resolver becomes the shadow cache)
+ * @param storage Initialized storage, or NULL
+ */
+void j1939_pipeline_init(j1939_pipeline_t* pipe, j1939_parser_context_t* parser,
+                         data_manager_t* dm, nvs_storage_t* storage);
+
+/**
+ * @brief Run one received frame through the pipeline
+ * @param pipe Pipeline
+ * @param frame Frame as delivered by the CAN driver
+ * @param msg Optional output: the parsed message
+ * @return true if the frame was a valid J1939 frame
+ */
+bool j1939_pipeline_process(j1939_pipeline_t* pipe, const can_frame_t* frame,
+                            j1939_message_t* msg);
+
+/**
+ * @brief Run pipeline timers (TP connection timeouts, bus monitor window, requests, captures)
+ *        and decode pending parameters
+ *
+ * Call at least every few hundred ms, including while the bus is idle, so
+ * stalled transfers are aborted and their buffers reclaimed.
+ *
+ * @param pipe Pipeline
+ * @param now_ms Current time (millis())
+ */
+void j1939_pipeline_poll(j1939_pipeline_t* pipe, uint32_t now_ms);
+
+/**
+ * @brief Poll an on-request PGN
+ *
+ * Registers the PGN with the request scheduler and sets its bus monitor
+ * period to the request period, so an answer stays valid until the next
+ * one is due (J1939_BUSMON_LOST_CYCLES request periods). A one-shot
+ * request leaves the PGN without a deadline.
+ *
+ * @param pipe Pipeline
+ * @param pgn PGN to request
+ * @param destination ECU to ask, or J1939_GLOBAL_ADDRESS
+ * @param period_ms Request period (0 = once)
+ * @param now_us Current time
+ * @return true if registered (false: request table full)
+ */
+bool j1939_pipeline_request(j1939_pipeline_t* pipe, uint32_t pgn, uint8_t destination,
+                            uint32_t period_ms, uint64_t now_us);
+
+/**
+ * @brief Store queued fault changes and completed DM2 / DM4 captures
+ *
+ * The only writer of the storage's fault history and freeze frames. Call
+ * from one low-priority task (the storage task, which also saves them);
+ * never from the decode path.
+ *
+ * @param pipe Pipeline
+ * @return Number of fault changes and captures stored
+ */
+uint16_t j1939_pipeline_store_faults(j1939_pipeline_t* pipe);
+
+/**
+ * @brief Add the PGNs the pipeline consumes to an acceptance filter set
+ *
+ * Every PGN the decoder publishes, TP/ETP connection management and data
+ * transfer, DM1, DM2, DM4, address claims, acknowledgments and every PGN registered
+ * with the request scheduler.
+ *
+ * @param pipe Pipeline
+ * @param set Set to add to
+ */
+void j1939_pipeline_get_consumed(const j1939_pipeline_t* pipe, can_filter_set_t* set);
+
+/**
+ * @brief Frames seen per PGN so far (all sources), for filter planning
+ * @param pipe Pipeline
+ * @param traffic Output array
+ * @param max_entries Capacity of traffic
+ * @return Number of entries written
+ */
+uint16_t j1939_pipeline_get_traffic(const j1939_pipeline_t* pipe,
+                                    can_filter_traffic_t* traffic, uint16_t max_entries);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J1939_PIPELINE_H */
@@ -170,6 +170,14 @@ bool nvs_storage_load_all(nvs_storage_t* storage) {
             prefs_dtc.getBytes("dtcs", storage->dtc_history, 
                                storage->dtc_count * sizeof(stored_dtc_t));
         }
+        storage->freeze_frame_count = prefs_dtc.getUChar("ff_count", 0);
+        if (storage->freeze_frame_count > NVS_MAX_FREEZE_FRAMES) {
+            storage->freeze_frame_count = 0;
+        }
+        if (storage->freeze_frame_count > 0) {
+            prefs_dtc.getBytes("ffs", storage->freeze_frames,
+                               storage->freeze_frame_count * sizeof(stored_freeze_frame_t));
+        }
         prefs_dtc.end();
     }
 #else
@@ -247,6 +255,11 @@ bool nvs_storage_save_all(nvs_storage_t* storage) {
             prefs_dtc.putBytes("dtcs", storage->dtc_history,
                                storage->dtc_count * sizeof(stored_dtc_t));
         }
+        prefs_dtc.putUChar("ff_count", storage->freeze_frame_count);
+        if (storage->freeze_frame_count > 0) {
+            prefs_dtc.putBytes("ffs", storage->freeze_frames,
+                               storage->freeze_frame_count * sizeof(stored_freeze_frame_t));
+        }
         prefs_dtc.end();
         storage->dtc_dirty = false;
     }
@@ -460,6 +473,55 @@ void nvs_dtc_store(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
     }
 }
 
+bool nvs_dtc_set_inactive(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
+                          uint8_t source_address, uint32_t timestamp) {
+    if (storage == NULL) return false;
+    
+    for (uint8_t i = 0; i < storage->dtc_count; i++) {
+        stored_dtc_t* dtc = &storage->dtc_history[i];
+        if (dtc->spn == spn && dtc->fmi == fmi && dtc->source_address == source_address) {
+            if (!dtc->is_active) return false;
+            dtc->last_seen = timestamp;
+            dtc->is_active = false;
+            storage->dtc_dirty = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void nvs_dtc_store_previous(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
+                            uint8_t source_address, uint8_t occurrence_count,
+                            uint32_t timestamp) {
+    if (storage == NULL) return;
+    
+    for (uint8_t i = 0; i < storage->dtc_count; i++) {
+        stored_dtc_t* dtc = &storage->dtc_history[i];
+        if (dtc->spn == spn && dtc->fmi == fmi && dtc->source_address == source_address) {
+            // Already known: the ECU's count may cover occurrences we missed
+            if (occurrence_count > dtc->occurrence_count) {
+                dtc->occurrence_count = occurrence_count;
+                storage->dtc_dirty = true;
+            }
+            return;
+        }
+    }
+    
+    // Never seen active here: keep it as history, without evicting anything
+    if (storage->dtc_count < NVS_MAX_DTC_HISTORY) {
+        stored_dtc_t* dtc = &storage->dtc_history[storage->dtc_count];
+        dtc->spn = spn;
+        dtc->fmi = fmi;
+        dtc->source_address = source_address;
+        dtc->first_seen = timestamp;
+        dtc->last_seen = timestamp;
+        dtc->occurrence_count = (occurrence_count > 0) ? occurrence_count : 1;
+        dtc->is_active = false;
+        storage->dtc_count++;
+        storage->dtc_dirty = true;
+    }
+}
+
 void nvs_dtc_clear_active(nvs_storage_t* storage) {
     if (storage == NULL) return;
     
@@ -474,6 +536,8 @@ void nvs_dtc_clear_all(nvs_storage_t* storage) {
     
     storage->dtc_count = 0;
     memset(storage->dtc_history, 0, sizeof(storage->dtc_history));
+    storage->freeze_frame_count = 0;
+    memset(storage->freeze_frames, 0, sizeof(storage->freeze_frames));
     storage->dtc_dirty = true;
 }
 
@@ -499,6 +563,60 @@ uint8_t nvs_dtc_get_active_count(nvs_storage_t* storage) {
     return count;
 }
 
+void nvs_freeze_frame_store(nvs_storage_t* storage, const stored_freeze_frame_t* frame) {
+    if (storage == NULL || frame == NULL) return;
+    
+    stored_freeze_frame_t* slot = NULL;
+    for (uint8_t i = 0; i < storage->freeze_frame_count; i++) {
+        stored_freeze_frame_t* ff = &storage->freeze_frames[i];
+        if (ff->spn == frame->spn && ff->fmi == frame->fmi &&
+            ff->source_address == frame->source_address) {
+            slot = ff;  // Newest frame of the fault replaces the previous one
+            break;
+        }
+    }
+    
+    if (slot == NULL) {
+        if (storage->freeze_frame_count < NVS_MAX_FREEZE_FRAMES) {
+            slot = &storage->freeze_frames[storage->freeze_frame_count++];
+        } else {
+            // Replace oldest frame
+            slot = &storage->freeze_frames[0];
+            for (uint8_t i = 1; i < NVS_MAX_FREEZE_FRAMES; i++) {
+                if (storage->freeze_frames[i].timestamp < slot->timestamp) {
+                    slot = &storage->freeze_frames[i];
+                }
+            }
+        }
+    }
+    
+    *slot = *frame;
+    storage->dtc_dirty = true;
+}
+
+const stored_freeze_frame_t* nvs_freeze_frame_find(nvs_storage_t* storage, uint32_t spn,
+                                                   uint8_t fmi, uint8_t source_address) {
+    if (storage == NULL) return NULL;
+    
+    for (uint8_t i = 0; i < storage->freeze_frame_count; i++) {
+        const stored_freeze_frame_t* ff = &storage->freeze_frames[i];
+        if (ff->spn == spn && ff->fmi == fmi && ff->source_address == source_address) {
+            return ff;
+        }
+    }
+    return NULL;
+}
+
+const stored_freeze_frame_t* nvs_freeze_frame_get_all(nvs_storage_t* storage, uint8_t* count) {
+    if (storage == NULL) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    
+    if (count) *count = storage->freeze_frame_count;
+    return storage->freeze_frames;
+}
+
 /*===========================================================================*/
 /*                        USER SETTINGS                                     */
 /*===========================================================================*/
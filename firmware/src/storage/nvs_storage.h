@@ -21,6 +21,8 @@ extern "C" {
 /*===========================================================================*/
 
 #define NVS_MAX_DTC_HISTORY         20      // Maximum stored fault codes
+#define NVS_MAX_FREEZE_FRAMES       8       // Maximum stored freeze frames
+#define NVS_FREEZE_FRAME_SNAPSHOT   8       // Raw standard parameter bytes per frame
 #define NVS_KEY_MAX_LENGTH          15      // NVS key name limit
 
 /*===========================================================================*/
@@ -67,6 +69,22 @@ typedef struct {
     bool is_active;                 // Currently active?
 } stored_dtc_t;
 
+/**
+ * @brief Stored freeze frame (DM4) of a fault code
+ *
+ * The snapshot holds the raw standard parameters in DM4 order; decode them
+ * with j1939_freeze_frame_decode().
+ */
+typedef struct {
+    uint32_t spn;                   // Suspect Parameter Number
+    uint8_t fmi;                    // Failure Mode Identifier
+    uint8_t source_address;         // ECU source
+    uint8_t occurrence_count;       // Occurrence count reported with the frame
+    uint8_t snapshot_length;        // Valid snapshot bytes
+    uint8_t snapshot[NVS_FREEZE_FRAME_SNAPSHOT];
+    uint32_t timestamp;             // Timestamp captured
+} stored_freeze_frame_t;
+
 /**
  * @brief User settings structure
  */
@@ -103,6 +121,8 @@ typedef struct {
     lifetime_stats_t lifetime;
     stored_dtc_t dtc_history[NVS_MAX_DTC_HISTORY];
     uint8_t dtc_count;
+    stored_freeze_frame_t freeze_frames[NVS_MAX_FREEZE_FRAMES];
+    uint8_t freeze_frame_count;
     user_settings_t settings;
     system_state_t system;
     
@@ -243,6 +263,35 @@ void nvs_lifetime_set_engine_hours(nvs_storage_t* storage, float hours);
 void nvs_dtc_store(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
                    uint8_t source_address, uint32_t timestamp, bool is_active);
 
+/**
+ * @brief Mark one fault code as no longer active
+ * @param storage Storage context
+ * @param spn Suspect Parameter Number
+ * @param fmi Failure Mode Identifier
+ * @param source_address Source ECU address
+ * @param timestamp Time the fault cleared
+ * @return true if the fault was stored and active
+ */
+bool nvs_dtc_set_inactive(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
+                          uint8_t source_address, uint32_t timestamp);
+
+/**
+ * @brief Record a previously active fault code (DM2)
+ *
+ * Adds the fault as inactive if it is not stored yet; a stored fault only
+ * takes the reported occurrence count if it is higher.
+ *
+ * @param storage Storage context
+ * @param spn Suspect Parameter Number
+ * @param fmi Failure Mode Identifier
+ * @param source_address Source ECU address
+ * @param occurrence_count Occurrence count reported by the ECU
+ * @param timestamp Current timestamp
+ */
+void nvs_dtc_store_previous(nvs_storage_t* storage, uint32_t spn, uint8_t fmi,
+                            uint8_t source_address, uint8_t occurrence_count,
+                            uint32_t timestamp);
+
 /**
  * @brief Clear active fault codes (mark as historical)
  * @param storage Storage context
@@ -270,6 +319,35 @@ const stored_dtc_t* nvs_dtc_get_history(nvs_storage_t* storage, uint8_t* count);
  */
 uint8_t nvs_dtc_get_active_count(nvs_storage_t* storage);
 
+/**
+ * @brief Store a freeze frame (replaces the fault's previous frame)
+ *
+ * Saved with the fault code history. When full, the oldest frame is replaced.
+ *
+ * @param storage Storage context
+ * @param frame Freeze frame to store
+ */
+void nvs_freeze_frame_store(nvs_storage_t* storage, const stored_freeze_frame_t* frame);
+
+/**
+ * @brief Find the freeze frame of a fault code
+ * @param storage Storage context
+ * @param spn Suspect Parameter Number
+ * @param fmi Failure Mode Identifier
+ * @param source_address Source ECU address
+ * @return Freeze frame, or NULL if none was captured
+ */
+const stored_freeze_frame_t* nvs_freeze_frame_find(nvs_storage_t* storage, uint32_t spn,
+                                                   uint8_t fmi, uint8_t source_address);
+
+/**
+ * @brief Get all stored freeze frames
+ * @param storage Storage context
+ * @param count Output: number of stored frames
+ * @return Pointer to freeze frame array
+ */
+const stored_freeze_frame_t* nvs_freeze_frame_get_all(nvs_storage_t* storage, uint8_t* count);
+
 /*===========================================================================*/
 /*                        USER SETTINGS                                     */
 /*===========================================================================*/
@@ -0,0 +1,186 @@
+/**
+ * @file bench_utils.h
+ * @brief Shared helpers for native benchmark suites (test/test_bench_*)
+ *
+ * Benchmarks run under `pio test -e native_bench`, which builds with -O2.
+ * They are excluded from the regular `native` test run.
+ *
+ * Every reported result is also collected for bench_write_json(), which
+ * prints one machine-readable "BENCH_JSON {...}" line per suite (and writes
+ * $BENCH_JSON_DIR/<suite>.json when that variable is set). On glibc the
+ * heap entry points are wrapped so a case can check it allocates nothing;
+ * include this header from exactly one file per suite.
+ */
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+/*===========================================================================*/
+/*                        TIMING                                            */
+/*===========================================================================*/
+
+/**
+ * @brief Monotonic timestamp in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*===========================================================================*/
+/*                        ALLOCATION COUNTING                               */
+/*===========================================================================*/
+
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_COUNT)
+#define BENCH_ALLOC_COUNTING 1
+
+// Heap calls made by the suite process (malloc, calloc, realloc, operator new)
+static uint64_t bench_allocations = 0;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) __THROW {
+    __atomic_add_fetch(&bench_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW {
+    __atomic_add_fetch(&bench_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW {
+    __atomic_add_fetch(&bench_allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+}
+
+/**
+ * @brief Heap allocations so far (take the difference around a measured loop)
+ */
+static inline uint64_t bench_alloc_count(void) {
+    return __atomic_load_n(&bench_allocations, __ATOMIC_RELAXED);
+}
+#else
+#define BENCH_ALLOC_COUNTING 0
+
+static inline uint64_t bench_alloc_count(void) {
+    return 0;   // Not tracked on this platform
+}
+#endif
+
+/*===========================================================================*/
+/*                        RESULTS                                           */
+/*===========================================================================*/
+
+/**
+ * @brief Sink that keeps the optimizer from discarding benchmark results
+ */
+static volatile uint32_t bench_sink;
+
+/**
+ * @brief Benchmark result for one measured case
+ */
+typedef struct {
+    const char* name;           // Case label
+    uint64_t operations;        // Operations performed
+    uint64_t elapsed_ns;        // Wall time for all operations
+    uint64_t allocations;       // Heap allocations during the operations
+} bench_result_t;
+
+#define BENCH_MAX_RESULTS   64
+
+// Results reported so far, for bench_write_json()
+static bench_result_t bench_results[BENCH_MAX_RESULTS];
+static uint32_t bench_result_count = 0;
+
+/**
+ * @brief Nanoseconds per operation
+ */
+static inline double bench_ns_per_op(const bench_result_t* r) {
+    return r->operations ? (double)r->elapsed_ns / (double)r->operations : 0.0;
+}
+
+/**
+ * @brief Print one result line (name, ns/op, ops/s) and keep it for JSON
+ */
+static inline void bench_report(const bench_result_t* r) {
+    double ns = bench_ns_per_op(r);
+    printf("BENCH %-32s %10.2f ns/op %14.0f ops/s\n",
+           r->name, ns, ns > 0.0 ? 1e9 / ns : 0.0);
+
+    if (bench_result_count < BENCH_MAX_RESULTS) {
+        bench_results[bench_result_count++] = *r;
+    }
+}
+
+/*===========================================================================*/
+/*                        JSON OUTPUT                                       */
+/*===========================================================================*/
+
+static inline void bench_json_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', out);
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static inline void bench_json_document(FILE* out, const char* suite) {
+    fputs("{\"suite\":", out);
+    bench_json_string(out, suite);
+    fprintf(out, ",\"alloc_counting\":%s,\"results\":[", BENCH_ALLOC_COUNTING ? "true" : "false");
+
+    for (uint32_t i = 0; i < bench_result_count; i++) {
+        const bench_result_t* r = &bench_results[i];
+        double ns = bench_ns_per_op(r);
+
+        fputs(i ? ",{\"name\":" : "{\"name\":", out);
+        bench_json_string(out, r->name);
+        fprintf(out, ",\"operations\":%llu,\"elapsed_ns\":%llu,\"ns_per_op\":%.3f,"
+                     "\"ops_per_sec\":%.0f,\"allocations\":%llu}",
+                (unsigned long long)r->operations, (unsigned long long)r->elapsed_ns,
+                ns, ns > 0.0 ? 1e9 / ns : 0.0, (unsigned long long)r->allocations);
+    }
+    fputs("]}", out);
+}
+
+/**
+ * @brief Emit every reported result as JSON
+ *
+ * Prints "BENCH_JSON <document>" on stdout; with $BENCH_JSON_DIR set the
+ * document is also written to <dir>/<suite>.json.
+ *
+ * @param suite Suite name (e.g. "test_bench_decode")
+ */
+static inline void bench_write_json(const char* suite) {
+    fputs("BENCH_JSON ", stdout);
+    bench_json_document(stdout, suite);
+    fputc('\n', stdout);
+
+    const char* dir = getenv("BENCH_JSON_DIR");
+    if (dir == NULL || dir[0] == '\0') return;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.json", dir, suite);
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        printf("BENCH_JSON cannot write %s\n", path);
+        return;
+    }
+    bench_json_document(f, suite);
+    fputc('\n', f);
+    fclose(f);
+}
+
+#endif /* BENCH_UTILS_H */
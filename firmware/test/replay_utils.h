@@ -0,0 +1,229 @@
+/**
+ * @file replay_utils.h
+ * @brief Trace replay through the J1939 receive path for native suites
+ *
+ * Streams a loaded trace (see trace_utils.h) through the same stages the
+ * firmware pipeline runs per frame - j1939_parse_frame_us(), TP reassembly
+ * (with DM1 handling of completed transfers) and the table decoder, which
+ * publishes through data_manager_update_us(), or the shadow cache the
+ * pipeline uses, which defers decoding to data_manager_resolve_pending() - and accounts
+ * the time spent in each stage. Frames are replayed either as fast as possible or paced to
+ * their recorded timestamps (optionally scaled).
+ */
+
+#ifndef REPLAY_UTILS_H
+#define REPLAY_UTILS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include "j1939_shadow.h"
+#include "data_manager.h"
+#include "bench_utils.h"
+#include "trace_utils.h"
+
+// Native millis() stub (j1939_parser.cpp) - TP timeouts follow trace time
+void test_set_millis(uint32_t ms);
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief Replay options
+ */
+typedef struct {
+    double speed;               // 0 = as fast as possible, 1 = recorded pace, N = N x faster
+    bool time_stages;           // Time each stage per frame (adds timer overhead)
+    j1939_shadow_t* shadow;     // Store frames here for lazy decode (NULL = decode eagerly)
+} replay_options_t;
+
+/**
+ * @brief Replay stage being timed
+ */
+typedef enum {
+    REPLAY_STAGE_PARSE = 0,     // j1939_parse_frame_us()
+    REPLAY_STAGE_TP,            // TP.CM/TP.DT handling and completed transfers
+    REPLAY_STAGE_DECODE,        // Signal decode + data_manager_update_us(), or shadow store
+    REPLAY_STAGE_COUNT
+} replay_stage_t;
+
+/**
+ * @brief Replay results
+ */
+typedef struct {
+    uint32_t frames;            // Frames offered
+    uint32_t parse_errors;      // Frames rejected by the parser
+    uint32_t tp_messages;       // Completed TP transfers
+    uint32_t decoded_signals;   // Parameters published to the data manager
+
+    uint64_t elapsed_ns;        // Wall time for the whole replay
+    uint64_t trace_us;          // Recorded span (last - first timestamp)
+    uint64_t stage_ns[REPLAY_STAGE_COUNT];      // Time in each stage (if timed)
+    uint32_t stage_calls[REPLAY_STAGE_COUNT];   // Frames that reached each stage
+} replay_stats_t;
+
+static const char* const replay_stage_names[REPLAY_STAGE_COUNT] = {
+    "parse", "tp", "decode",
+};
+
+/*===========================================================================*/
+/*                        REPLAY                                            */
+/*===========================================================================*/
+
+/**
+ * @brief Replay state handed to the TP payload consumer
+ */
+typedef struct {
+    data_manager_t* dm;
+    replay_stats_t* stats;
+} replay_tp_sink_t;
+
+/**
+ * @brief Act on a completed TP transfer in place: count it, publish DM1 results
+ */
+static inline void replay_tp_payload(const j1939_tp_payload_t* payload, void* user) {
+    replay_tp_sink_t* sink = (replay_tp_sink_t*)user;
+
+    sink->stats->tp_messages++;
+
+    if (payload->pgn == 65226) {  // DM1
+        j1939_lamp_status_t lamps;
+        j1939_dtc_t dtcs[8];
+        uint8_t dtc_count = j1939_parse_dm1(payload->data, payload->length, &lamps, dtcs, 8);
+        data_manager_update_us(sink->dm, PARAM_ACTIVE_DTC_COUNT, (float)dtc_count,
+                               SOURCE_J1939, payload->timestamp_us);
+    }
+}
+
+/**
+ * @brief Handle one TP frame; on a completed transfer publish DM1 results
+ */
+static inline void replay_tp_frame(j1939_parser_context_t* parser, data_manager_t* dm,
+                                   const j1939_message_t* msg, replay_stats_t* stats) {
+    if (!j1939_tp_handle_frame(parser, msg)) return;
+
+    replay_tp_sink_t sink = { dm, stats };
+    j1939_tp_deliver(parser, msg, replay_tp_payload, &sink);
+}
+
+/**
+ * @brief Replay a trace through parser, TP and decoder into a data manager
+ * @param frames Loaded trace
+ * @param count Number of frames
+ * @param options Pacing and timing options
+ * @param parser Initialized parser context (TP sessions)
+ * @param dm Initialized data manager
+ * @param stats Output results (cleared first)
+ */
+static inline void replay_run(const trace_frame_t* frames, uint32_t count,
+                              const replay_options_t* options,
+                              j1939_parser_context_t* parser, data_manager_t* dm,
+                              replay_stats_t* stats) {
+    memset(stats, 0, sizeof(replay_stats_t));
+    if (count == 0) return;
+
+    const bool paced = options->speed > 0.0;
+    const bool timed = options->time_stages;
+    const uint64_t first_us = frames[0].timestamp_us;
+    j1939_message_t msg;
+    uint64_t t0 = 0, t1 = 0;
+
+    stats->trace_us = frames[count - 1].timestamp_us - first_us;
+    uint64_t start_ns = bench_now_ns();
+
+    for (uint32_t i = 0; i < count; i++) {
+        const trace_frame_t* f = &frames[i];
+
+        if (paced) {
+            uint64_t due_ns = start_ns + (uint64_t)((double)(f->timestamp_us - first_us) *
+                                                    1000.0 / options->speed);
+            uint64_t now_ns = bench_now_ns();
+            if (due_ns > now_ns) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due_ns - now_ns));
+            }
+        }
+
+        stats->frames++;
+        test_set_millis(f->timestamp_ms);
+
+        if (timed) t0 = bench_now_ns();
+        bool parsed = j1939_parse_frame_us(f->can_id, f->data, f->data_length,
+                                           f->timestamp_us, &msg);
+        if (timed) t1 = bench_now_ns();
+        stats->stage_ns[REPLAY_STAGE_PARSE] += t1 - t0;
+        stats->stage_calls[REPLAY_STAGE_PARSE]++;
+
+        if (!parsed) {
+            stats->parse_errors++;
+            continue;
+        }
+
+        if (msg.pgn == PGN_TP_CM || msg.pgn == PGN_TP_DT ||
+            msg.pgn == PGN_ETP_CM || msg.pgn == PGN_ETP_DT) {
+            replay_tp_frame(parser, dm, &msg, stats);
+            if (timed) t0 = bench_now_ns();
+            stats->stage_ns[REPLAY_STAGE_TP] += t0 - t1;
+            stats->stage_calls[REPLAY_STAGE_TP]++;
+            continue;
+        }
+
+        stats->decoded_signals += (options->shadow != NULL)
+                                ? j1939_shadow_store(options->shadow, &msg)
+                                : j1939_decoder_process(&msg, dm, SOURCE_J1939);
+        if (timed) t0 = bench_now_ns();
+        stats->stage_ns[REPLAY_STAGE_DECODE] += t0 - t1;
+        stats->stage_calls[REPLAY_STAGE_DECODE]++;
+    }
+
+    stats->elapsed_ns = bench_now_ns() - start_ns;
+}
+
+/*===========================================================================*/
+/*                        REPORTING                                         */
+/*===========================================================================*/
+
+/**
+ * @brief Replay throughput in frames per second of wall time
+ */
+static inline double replay_frames_per_sec(const replay_stats_t* stats) {
+    return stats->elapsed_ns ? (double)stats->frames * 1e9 / (double)stats->elapsed_ns : 0.0;
+}
+
+/**
+ * @brief Print throughput, per-stage timing and pipeline counters
+ */
+static inline void replay_report(const char* name, const replay_stats_t* stats) {
+    printf("REPLAY %-32s %8u frames %12.0f frames/s  wall %.6f s  trace %.3f s\n",
+           name, (unsigned)stats->frames, replay_frames_per_sec(stats),
+           stats->elapsed_ns / 1e9, stats->trace_us / 1e6);
+
+    for (uint8_t s = 0; s < REPLAY_STAGE_COUNT; s++) {
+        if (stats->stage_ns[s] == 0) continue;  // Not timed, or never reached
+        printf("      %-8s %8u frames %10.1f ns/frame\n", replay_stage_names[s],
+               (unsigned)stats->stage_calls[s],
+               (double)stats->stage_ns[s] / (double)stats->stage_calls[s]);
+    }
+    printf("      parse errors %u  TP messages %u  signals %u\n",
+           (unsigned)stats->parse_errors, (unsigned)stats->tp_messages,
+           (unsigned)stats->decoded_signals);
+}
+
+/**
+ * @brief Print every valid parameter held by a data manager
+ */
+static inline void replay_print_parameters(data_manager_t* dm) {
+    for (int id = PARAM_NONE + 1; id < PARAM_MAX; id++) {
+        float value;
+        if (data_manager_get(dm, (param_id_t)id, &value)) {
+            printf("      %-28s %12.3f %s\n", data_manager_get_param_name((param_id_t)id),
+                   value, data_manager_get_param_unit((param_id_t)id));
+        }
+    }
+}
+
+#endif /* REPLAY_UTILS_H */
@@ -0,0 +1,295 @@
+/**
+ * @file test_bench_decode.cpp
+ * @brief Benchmark: table-driven signal decoder vs. the legacy PGN switch
+ *
+ * The legacy path is a copy of the per-PGN switch that used to live in
+ * main.cpp (one hand-written decoder call per PGN). Both paths publish to a
+ * data manager so the measured cost includes the store, as on the target.
+ * The shadow cache bench stores every frame and decodes pending parameters
+ * at 10 Hz, as the pipeline's periodic resolve does.
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include "j1939_shadow.h"
+#include "data_manager.h"
+#include "bench_utils.h"
+#include <string.h>
+
+#define BENCH_ITERATIONS    200000
+#define BENCH_READ_EVERY    10          // Mix passes per display read (10 ms frames, 10 Hz reads)
+
+static data_manager_t g_dm_legacy;
+static data_manager_t g_dm_table;
+static data_manager_t g_dm_shadow;
+static j1939_shadow_t g_shadow;
+
+/*===========================================================================*/
+/*                        FRAME MIX                                         */
+/*===========================================================================*/
+
+typedef struct {
+    uint32_t pgn;
+    uint8_t data[8];
+} bench_frame_t;
+
+// Typical highway cruise values, one frame per decoded PGN
+static const bench_frame_t frame_mix[] = {
+    { 61444, { 0xF0, 0x7D, 0xA0, 0x80, 0x3E, 0x00, 0xFF, 0xFF } },  // EEC1
+    { 61443, { 0xFF, 0x64, 0x46, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },  // EEC2
+    { 65262, { 0x82, 0x46, 0x20, 0x2B, 0xFF, 0xFF, 0xFF, 0xFF } },  // ET1
+    { 65263, { 0xFF, 0xFF, 0xFF, 0x4B, 0xFF, 0xFF, 0xFF, 0xFF } },  // EFLP1
+    { 65265, { 0x00, 0x00, 0x69, 0x05, 0xFF, 0x69, 0xFF, 0xFF } },  // CCVS
+    { 65266, { 0x20, 0x03, 0x00, 0x0E, 0x00, 0x0D, 0xFF, 0xFF } },  // LFE
+    { 65269, { 0xC6, 0x80, 0x25, 0x60, 0x23, 0xFF, 0xFF, 0xFF } },  // AMB
+    { 65270, { 0xFF, 0x64, 0x55, 0xFF, 0xFF, 0x00, 0x38, 0xFF } },  // IC1
+    { 65271, { 0xFF, 0xFF, 0xFF, 0xFF, 0x1C, 0x02, 0x18, 0x02 } },  // VEP1
+    { 65272, { 0xFF, 0xFF, 0xFF, 0x96, 0x40, 0x29, 0xFF, 0xFF } },  // TRF1
+    { 65276, { 0xFF, 0xAF, 0xFF, 0xFF, 0xFF, 0xFF, 0xA0, 0xFF } },  // DD
+    { 65253, { 0x40, 0x42, 0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF } },  // HOURS
+    { 61445, { 0x8F, 0xE8, 0x03, 0x8F, 0xFF, 0xFF, 0xFF, 0xFF } },  // ETC2
+    { 65226, { 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF } },  // DM1 (not decoded)
+};
+
+#define FRAME_MIX_COUNT (sizeof(frame_mix) / sizeof(frame_mix[0]))
+
+static j1939_message_t g_messages[FRAME_MIX_COUNT];
+
+/*===========================================================================*/
+/*                        LEGACY SWITCH (REFERENCE)                         */
+/*===========================================================================*/
+
+static void legacy_update(param_id_t id, float value, uint32_t ts) {
+    data_manager_update(&g_dm_legacy, id, value, SOURCE_J1939, ts);
+}
+
+static void legacy_decode(const j1939_message_t* msg, uint32_t ts) {
+    float value;
+
+    switch (msg->pgn) {
+        case 61444:  // EEC1 - Engine Speed
+            value = j1939_decode_engine_speed(msg->data);
+            if (value >= 0) legacy_update(PARAM_ENGINE_SPEED, value, ts);
+            break;
+        case 61443:  // EEC2 - Throttle
+            value = j1939_decode_throttle_position(msg->data);
+            if (value >= 0) legacy_update(PARAM_THROTTLE_POSITION, value, ts);
+            break;
+        case 65262:  // ET1 - Coolant Temperature
+            value = j1939_decode_coolant_temp(msg->data);
+            if (value > -9000) legacy_update(PARAM_COOLANT_TEMP, value, ts);
+            break;
+        case 65263:  // EFLP1 - Oil Pressure
+            value = j1939_decode_oil_pressure(msg->data);
+            if (value >= 0) legacy_update(PARAM_OIL_PRESSURE, value, ts);
+            break;
+        case 65265:  // CCVS - Vehicle Speed
+            value = j1939_decode_vehicle_speed(msg->data);
+            if (value >= 0) legacy_update(PARAM_VEHICLE_SPEED, value, ts);
+            break;
+        case 65266:  // LFE - Fuel Rate
+            value = j1939_decode_fuel_rate(msg->data);
+            if (value >= 0) legacy_update(PARAM_FUEL_RATE, value, ts);
+            break;
+        case 65269:  // AMB - Ambient Temperature
+            value = j1939_decode_ambient_temp(msg->data);
+            if (value > -9000) legacy_update(PARAM_AMBIENT_TEMP, value, ts);
+            break;
+        case 65270:  // IC1 - Boost Pressure
+            value = j1939_decode_boost_pressure(msg->data);
+            if (value >= 0) legacy_update(PARAM_BOOST_PRESSURE, value, ts);
+            break;
+        case 65271:  // VEP1 - Battery Voltage
+            value = j1939_decode_battery_voltage(msg->data);
+            if (value >= 0) legacy_update(PARAM_BATTERY_VOLTAGE, value, ts);
+            break;
+        case 65272:  // TRF1 - Trans Oil Temp
+            value = j1939_decode_trans_oil_temp(msg->data);
+            if (value > -9000) legacy_update(PARAM_TRANS_OIL_TEMP, value, ts);
+            break;
+        case 65276:  // DD - Fuel Level
+            value = j1939_decode_fuel_level(msg->data);
+            if (value >= 0) legacy_update(PARAM_FUEL_LEVEL_1, value, ts);
+            break;
+        case 65253:  // HOURS - Engine Hours
+            value = j1939_decode_engine_hours(msg->data);
+            if (value >= 0) legacy_update(PARAM_ENGINE_HOURS, value, ts);
+            break;
+        case 61445:  // ETC2 - Current Gear
+            {
+                int8_t gear = j1939_decode_current_gear(msg->data);
+                if (gear > -126) legacy_update(PARAM_CURRENT_GEAR, (float)gear, ts);
+            }
+            break;
+    }
+}
+
+/*===========================================================================*/
+/*                        BENCHMARKS                                        */
+/*===========================================================================*/
+
+void test_table_matches_legacy(void) {
+    for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+        legacy_decode(&g_messages[i], 1);
+        j1939_decoder_process(&g_messages[i], &g_dm_table, SOURCE_J1939);
+    }
+
+    // Every parameter the switch produced must match the table decoder
+    uint8_t compared = 0;
+    for (uint16_t id = 0; id < PARAM_MAX; id++) {
+        float legacy_value, table_value;
+        if (!data_manager_get(&g_dm_legacy, (param_id_t)id, &legacy_value)) continue;
+
+        TEST_ASSERT_TRUE(data_manager_get(&g_dm_table, (param_id_t)id, &table_value));
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, legacy_value, table_value);
+        compared++;
+    }
+    TEST_ASSERT_EQUAL_UINT8(13, compared);
+}
+
+void test_bench_legacy_switch(void) {
+    bench_result_t r = { "decode/legacy_switch", 0, 0, 0 };
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+            legacy_decode(&g_messages[i], n);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * FRAME_MIX_COUNT;
+
+    uint32_t valid, updates;
+    data_manager_get_stats(&g_dm_legacy, &valid, &updates);
+    bench_sink = updates;
+    bench_report(&r);
+}
+
+void test_bench_table_decoder(void) {
+    bench_result_t r = { "decode/table", 0, 0, 0 };
+    uint32_t signals = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+            signals += j1939_decoder_process(&g_messages[i], &g_dm_table, SOURCE_J1939);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * FRAME_MIX_COUNT;
+
+    bench_sink = signals;
+    bench_report(&r);
+    printf("      %.2f signals/frame (legacy switch: <= 1)\n",
+           (double)signals / (double)r.operations);
+}
+
+void test_bench_table_decode_only(void) {
+    bench_result_t r = { "decode/table_no_store", 0, 0, 0 };
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    uint32_t signals = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+            signals += j1939_decode_signals(&g_messages[i], values,
+                                            J1939_DECODER_MAX_SIGNALS_PER_PGN);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * FRAME_MIX_COUNT;
+
+    bench_sink = signals;
+    bench_report(&r);
+}
+
+void test_bench_shadow_lazy(void) {
+    bench_result_t r = { "decode/shadow_store_10hz_read", 0, 0, 0 };
+    j1939_message_t messages[FRAME_MIX_COUNT];
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    uint32_t eager_per_pass = 0;
+    float value;
+
+    // The parameters the mix carries, as a display page would read them
+    param_id_t shown[PARAM_MAX];
+    uint16_t shown_count = 0;
+    for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+        messages[i] = g_messages[i];
+        eager_per_pass += j1939_decode_signals(&messages[i], values,
+                                               J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+        const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(frame_mix[i].pgn);
+        for (uint8_t s = 0; desc != NULL && s < desc->signal_count; s++) {
+            if (desc->signals[s].param_id == PARAM_NONE) break;
+            shown[shown_count++] = desc->signals[s].param_id;
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        // Engine speed and accelerator move every pass; the rest repeat
+        messages[0].data[3] = (uint8_t)n;
+        messages[1].data[1] = (uint8_t)(n % 250);
+        for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+            j1939_shadow_store(&g_shadow, &messages[i]);
+        }
+        if (n % BENCH_READ_EVERY == 0) {
+            // Decode task resolve, then a display refresh
+            data_manager_resolve_pending(&g_dm_shadow);
+            for (uint16_t p = 0; p < shown_count; p++) {
+                data_manager_get(&g_dm_shadow, shown[p], &value);
+            }
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * FRAME_MIX_COUNT;
+
+    j1939_shadow_stats_t stats;
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    uint64_t eager = (uint64_t)eager_per_pass * BENCH_ITERATIONS;
+    bench_sink = stats.decodes;
+    bench_report(&r);
+    printf("      %.3f signals decoded/frame (eager: %.2f), %.1f%% repeated payloads skipped\n",
+           (double)stats.decodes / (double)r.operations, (double)eager / (double)r.operations,
+           100.0 * stats.repeats / stats.frames);
+
+    // Reads at a tenth of the frame rate must cut decode work by about as much
+    TEST_ASSERT_TRUE((uint64_t)stats.decodes * (BENCH_READ_EVERY / 2) < eager);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overflow);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    data_manager_init(&g_dm_legacy);
+    data_manager_init(&g_dm_table);
+    data_manager_init(&g_dm_shadow);
+    j1939_shadow_init(&g_shadow, &g_dm_shadow);
+
+    for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+        memset(&g_messages[i], 0, sizeof(j1939_message_t));
+        g_messages[i].pgn = frame_mix[i].pgn;
+        g_messages[i].data_length = 8;
+        memcpy(g_messages[i].data, frame_mix[i].data, 8);
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_table_matches_legacy);
+    RUN_TEST(test_bench_legacy_switch);
+    RUN_TEST(test_bench_table_decoder);
+    RUN_TEST(test_bench_table_decode_only);
+    RUN_TEST(test_bench_shadow_lazy);
+
+    bench_write_json("test_bench_decode");
+    return UNITY_END();
+}
@@ -0,0 +1,441 @@
+/**
+ * @file test_bench_hotpaths.cpp
+ * @brief Benchmark: per-call cost of every parser and manager hot path
+ *
+ * One case per function the receive and display paths call per frame, byte
+ * or refresh: PGN extraction, each j1939_decode_*, BAM reassembly, the TP
+ * timer sweep, the bus monitor, the J1708 byte state machine and message
+ * parser, data manager update/get and the watch list refresh. Each case also asserts that it made no heap
+ * allocation, and the suite ends with a BENCH_JSON line for CI to compare.
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "j1939_busmon.h"
+#include "j1708_parser.h"
+#include "data_manager.h"
+#include "watch_list_manager.h"
+#include "bench_utils.h"
+#include <string.h>
+
+#define BENCH_ITERATIONS    200000
+
+// Native millis() stub (j1939_parser.cpp) - TP session timeouts
+void test_set_millis(uint32_t ms);
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+static uint64_t g_start_ns;
+static uint64_t g_start_allocs;
+
+static void bench_begin(void) {
+    g_start_allocs = bench_alloc_count();
+    g_start_ns = bench_now_ns();
+}
+
+/**
+ * @brief Close a measured loop, report it and require it to be allocation-free
+ */
+static void bench_end(const char* name, uint64_t operations) {
+    bench_result_t r = { name, operations, 0, 0 };
+    r.elapsed_ns = bench_now_ns() - g_start_ns;
+    r.allocations = bench_alloc_count() - g_start_allocs;
+
+    bench_report(&r);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.allocations, "Hot path allocated from the heap");
+}
+
+void test_alloc_counter_sees_heap(void) {
+    if (!BENCH_ALLOC_COUNTING) {
+        TEST_IGNORE_MESSAGE("Allocation counting needs glibc");
+    }
+
+    // Through a volatile pointer so the pair cannot be optimized away
+    void* (*volatile alloc)(size_t) = malloc;
+    uint64_t before = bench_alloc_count();
+    void* p = alloc(64);
+    TEST_ASSERT_NOT_NULL(p);
+    free(p);
+    TEST_ASSERT_EQUAL_UINT64(before + 1, bench_alloc_count());
+}
+
+/*===========================================================================*/
+/*                        J1939                                             */
+/*===========================================================================*/
+
+// Identifiers seen on a typical bus: PDU2 broadcasts, PDU1 requests/TP
+static const uint32_t can_ids[] = {
+    0x0CF00400, 0x0CF00300, 0x18FEEE00, 0x18FEEF00, 0x18FEF100, 0x18FEF200,
+    0x18FEF500, 0x18FEF600, 0x18FEF700, 0x18FEF800, 0x18FEFC17, 0x18FEE500,
+    0x18FECA00, 0x18ECFF00, 0x18EBFF00, 0x18EA00F9,
+};
+
+#define CAN_ID_COUNT (sizeof(can_ids) / sizeof(can_ids[0]))
+
+void test_bench_extract_pgn(void) {
+    uint32_t acc = 0;
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < CAN_ID_COUNT; i++) {
+            acc += j1939_extract_pgn(can_ids[i] + (n & 1));
+        }
+    }
+    bench_end("j1939/extract_pgn", (uint64_t)BENCH_ITERATIONS * CAN_ID_COUNT);
+    bench_sink = acc;
+}
+
+void test_bench_parse_frame(void) {
+    static const uint8_t data[8] = { 0xF0, 0x7D, 0xA0, 0x80, 0x3E, 0x00, 0xFF, 0xFF };
+    j1939_message_t msg;
+    uint32_t acc = 0;
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < CAN_ID_COUNT; i++) {
+            j1939_parse_frame_us(can_ids[i], data, 8, n, &msg);
+            acc += msg.pgn;
+        }
+    }
+    bench_end("j1939/parse_frame_us", (uint64_t)BENCH_ITERATIONS * CAN_ID_COUNT);
+    bench_sink = acc;
+}
+
+typedef float (*decode_fn_t)(const uint8_t* data);
+
+typedef struct {
+    const char* name;
+    decode_fn_t decode;
+    uint8_t data[8];
+} decode_case_t;
+
+// Typical highway cruise payloads (same values as test_bench_decode)
+static const decode_case_t decode_cases[] = {
+    { "j1939/decode_engine_speed",      j1939_decode_engine_speed,      { 0xF0, 0x7D, 0xA0, 0x80, 0x3E, 0x00, 0xFF, 0xFF } },
+    { "j1939/decode_throttle_position", j1939_decode_throttle_position, { 0xFF, 0x64, 0x46, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },
+    { "j1939/decode_coolant_temp",      j1939_decode_coolant_temp,      { 0x82, 0x46, 0x20, 0x2B, 0xFF, 0xFF, 0xFF, 0xFF } },
+    { "j1939/decode_oil_pressure",      j1939_decode_oil_pressure,      { 0xFF, 0xFF, 0xFF, 0x4B, 0xFF, 0xFF, 0xFF, 0xFF } },
+    { "j1939/decode_vehicle_speed",     j1939_decode_vehicle_speed,     { 0x00, 0x00, 0x69, 0x05, 0xFF, 0x69, 0xFF, 0xFF } },
+    { "j1939/decode_fuel_rate",         j1939_decode_fuel_rate,         { 0x20, 0x03, 0x00, 0x0E, 0x00, 0x0D, 0xFF, 0xFF } },
+    { "j1939/decode_ambient_temp",      j1939_decode_ambient_temp,      { 0xC6, 0x80, 0x25, 0x60, 0x23, 0xFF, 0xFF, 0xFF } },
+    { "j1939/decode_boost_pressure",    j1939_decode_boost_pressure,    { 0xFF, 0x64, 0x55, 0xFF, 0xFF, 0x00, 0x38, 0xFF } },
+    { "j1939/decode_battery_voltage",   j1939_decode_battery_voltage,   { 0xFF, 0xFF, 0xFF, 0xFF, 0x1C, 0x02, 0x18, 0x02 } },
+    { "j1939/decode_trans_oil_temp",    j1939_decode_trans_oil_temp,    { 0xFF, 0xFF, 0xFF, 0x96, 0x40, 0x29, 0xFF, 0xFF } },
+    { "j1939/decode_fuel_level",        j1939_decode_fuel_level,        { 0xFF, 0xAF, 0xFF, 0xFF, 0xFF, 0xFF, 0xA0, 0xFF } },
+    { "j1939/decode_engine_hours",      j1939_decode_engine_hours,      { 0x40, 0x42, 0x0F, 0x00, 0xFF, 0xFF, 0xFF, 0xFF } },
+};
+
+#define DECODE_CASE_COUNT (sizeof(decode_cases) / sizeof(decode_cases[0]))
+
+void test_bench_decode_functions(void) {
+    for (uint8_t c = 0; c < DECODE_CASE_COUNT; c++) {
+        // Alternate with a second payload so the call cannot be hoisted
+        uint8_t data[2][8];
+        memcpy(data[0], decode_cases[c].data, 8);
+        memcpy(data[1], decode_cases[c].data, 8);
+        for (uint8_t b = 0; b < 8; b++) {
+            if (data[1][b] != 0xFF) data[1][b]++;
+        }
+
+        float acc = 0.0f;
+        bench_begin();
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+            acc += decode_cases[c].decode(data[n & 1]);
+        }
+        bench_end(decode_cases[c].name, BENCH_ITERATIONS);
+        bench_sink = (uint32_t)acc;
+    }
+}
+
+void test_bench_decode_current_gear(void) {
+    static const uint8_t data[2][8] = {
+        { 0x8F, 0xE8, 0x03, 0x8F, 0xFF, 0xFF, 0xFF, 0xFF },
+        { 0x8E, 0xE8, 0x03, 0x8E, 0xFF, 0xFF, 0xFF, 0xFF },
+    };
+    int32_t acc = 0;
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        acc += j1939_decode_current_gear(data[n & 1]);
+    }
+    bench_end("j1939/decode_current_gear", BENCH_ITERATIONS);
+    bench_sink = (uint32_t)acc;
+}
+
+void test_bench_tp_bam(void) {
+    // BAM announcing 23 bytes of component ID (PGN 65259) in 4 packets
+    static const uint8_t frames[5][8] = {
+        { 0x20, 0x17, 0x00, 0x04, 0xFF, 0xEB, 0xFE, 0x00 },
+        { 0x01, 0x44, 0x45, 0x4D, 0x4F, 0x2A, 0x4D, 0x46 },
+        { 0x02, 0x52, 0x2A, 0x44, 0x45, 0x4D, 0x4F, 0x20 },
+        { 0x03, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x2A },
+        { 0x04, 0x53, 0x4E, 0x31, 0x32, 0xFF, 0xFF, 0xFF },
+    };
+    j1939_parser_context_t ctx;
+    j1939_message_t msgs[5];
+    uint32_t completed = 0;
+
+    j1939_parser_init(&ctx);
+    test_set_millis(1000);
+    for (uint8_t i = 0; i < 5; i++) {
+        j1939_parse_frame(i == 0 ? 0x18ECFF00 : 0x18EBFF00, frames[i], 8, 1000, &msgs[i]);
+    }
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS / 5; n++) {
+        for (uint8_t i = 0; i < 5; i++) {
+            completed += j1939_tp_handle_frame(&ctx, &msgs[i]) ? 1 : 0;
+        }
+    }
+    bench_end("j1939/tp_handle_frame", (uint64_t)(BENCH_ITERATIONS / 5) * 5);
+
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS / 5, completed);
+    bench_sink = completed;
+}
+
+void test_bench_tp_poll(void) {
+    // Every session slot holds a transfer in progress; each poll advances the
+    // wheel one tick and nothing is due, so the cost must not scale with them
+    static const uint8_t bam[8] = { 0x20, 0x17, 0x00, 0x04, 0xFF, 0xEB, 0xFE, 0x00 };
+    static j1939_parser_context_t ctx;
+    j1939_message_t msg;
+    uint64_t elapsed_ns = 0, allocs = 0;
+    uint32_t now = 0;
+
+    j1939_parser_init(&ctx);
+    for (uint32_t n = 0; n < BENCH_ITERATIONS / 8; n++) {
+        // Re-announce outside the timed window so no deadline is reached
+        for (uint8_t sa = 0; sa < J1939_MAX_ACTIVE_TP; sa++) {
+            j1939_parse_frame(0x18ECFF00 | sa, bam, 8, now, &msg);
+            j1939_tp_handle_frame(&ctx, &msg);
+        }
+
+        bench_begin();
+        for (uint8_t i = 0; i < 8; i++) {
+            now += J1939_TP_WHEEL_TICK_MS;
+            j1939_tp_poll(&ctx, now);
+        }
+        elapsed_ns += bench_now_ns() - g_start_ns;
+        allocs += bench_alloc_count() - g_start_allocs;
+    }
+
+    bench_result_t r = { "j1939/tp_poll (16 open, none due)", BENCH_ITERATIONS, elapsed_ns, allocs };
+    bench_report(&r);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.allocations, "Hot path allocated from the heap");
+
+    j1939_tp_expiry_stats_t stats;
+    j1939_tp_get_expiry_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.expired);
+    bench_sink = stats.sweeps;
+}
+
+/*===========================================================================*/
+/*                        J1708                                             */
+/*===========================================================================*/
+
+// MID 128 engine: road speed, coolant temp, engine speed, battery voltage;
+// the checksum byte is filled in by main()
+static uint8_t j1708_msg[] = { 128, 84, 110, 110, 150, 190, 0x40, 0x1F, 168, 0x10, 0x00 };
+
+void test_bench_j1708_receive_byte(void) {
+    j1708_parser_context_t ctx;
+    j1708_message_t msg;
+    uint32_t messages = 0;
+    uint32_t t = 0;
+
+    j1708_parser_init(&ctx);
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS / sizeof(j1708_msg); n++) {
+        t += 40;  // Inter-message gap ends the previous message
+        for (uint8_t i = 0; i < sizeof(j1708_msg); i++) {
+            if (j1708_receive_byte(&ctx, j1708_msg[i], t + i)) {
+                messages += j1708_get_message(&ctx, &msg) ? 1 : 0;
+                j1708_receive_byte(&ctx, j1708_msg[i], t + i);
+            }
+        }
+    }
+    bench_end("j1708/receive_byte", (uint64_t)(BENCH_ITERATIONS / sizeof(j1708_msg)) *
+                                    sizeof(j1708_msg));
+
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS / sizeof(j1708_msg) - 1, messages);
+    bench_sink = messages;
+}
+
+void test_bench_j1708_parse_message(void) {
+    j1708_message_t msg;
+    uint32_t params = 0;
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        if (j1708_parse_message(j1708_msg, sizeof(j1708_msg), &msg)) {
+            params += msg.param_count;
+        }
+    }
+    bench_end("j1708/parse_message", BENCH_ITERATIONS);
+
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS * 4, params);
+    bench_sink = params;
+}
+
+/*===========================================================================*/
+/*                        DATA MANAGER / WATCH LIST                         */
+/*===========================================================================*/
+
+static data_manager_t g_dm;
+static watch_list_manager_t g_watch_list;
+
+/*===========================================================================*/
+/*                        BUS MONITOR                                       */
+/*===========================================================================*/
+
+void test_bench_busmon_frame(void) {
+    static j1939_busmon_t mon;
+    can_frame_t frame;
+    uint64_t now_us = 1;
+
+    j1939_busmon_init(&mon, &g_dm, 250000);
+    memset(&frame, 0, sizeof(frame));
+    frame.length = 8;
+    frame.is_extended = true;
+
+    // One frame every 500 us: the per-window close is amortized in
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < CAN_ID_COUNT; i++) {
+            frame.id = can_ids[i];
+            frame.timestamp_us = now_us;
+            j1939_busmon_frame(&mon, &frame);
+            now_us += 500;
+        }
+    }
+    bench_end("j1939/busmon_frame", (uint64_t)BENCH_ITERATIONS * CAN_ID_COUNT);
+
+    j1939_busmon_stats_t stats;
+    j1939_busmon_get_stats(&mon, &stats);
+    bench_sink = stats.windows;
+    TEST_ASSERT_EQUAL_UINT16(CAN_ID_COUNT, stats.keys);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.untracked);
+}
+
+// Parameters the J1939 decoder publishes most often
+static const param_id_t hot_params[] = {
+    PARAM_ENGINE_SPEED, PARAM_THROTTLE_POSITION, PARAM_COOLANT_TEMP, PARAM_OIL_PRESSURE,
+    PARAM_VEHICLE_SPEED, PARAM_FUEL_RATE, PARAM_AMBIENT_TEMP, PARAM_BOOST_PRESSURE,
+    PARAM_BATTERY_VOLTAGE, PARAM_TRANS_OIL_TEMP, PARAM_FUEL_LEVEL_1, PARAM_ENGINE_HOURS,
+    PARAM_CURRENT_GEAR,
+};
+
+#define HOT_PARAM_COUNT (sizeof(hot_params) / sizeof(hot_params[0]))
+
+void test_bench_data_manager_update(void) {
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < HOT_PARAM_COUNT; i++) {
+            data_manager_update(&g_dm, hot_params[i], (float)(n & 0xFF), SOURCE_J1939, n);
+        }
+    }
+    bench_end("data_manager/update", (uint64_t)BENCH_ITERATIONS * HOT_PARAM_COUNT);
+}
+
+void test_bench_data_manager_get(void) {
+    float value, acc = 0.0f;
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < HOT_PARAM_COUNT; i++) {
+            if (data_manager_get(&g_dm, hot_params[i], &value)) acc += value;
+        }
+    }
+    bench_end("data_manager/get", (uint64_t)BENCH_ITERATIONS * HOT_PARAM_COUNT);
+    bench_sink = (uint32_t)acc;
+}
+
+void test_bench_watch_list_update(void) {
+    watch_list_setup_defaults(&g_watch_list);
+
+    bench_begin();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS / 10; n++) {
+        watch_list_update(&g_watch_list, n * 100);
+    }
+    bench_end("watch_list/update", BENCH_ITERATIONS / 10);
+}
+
+void test_bench_busmon_poll(void) {
+    // Every key has a lost deadline armed; each poll advances the wheel one
+    // tick and nothing is due, so the cost must not scale with the keys
+    static j1939_busmon_t mon;
+    can_frame_t frame;
+    uint64_t elapsed_ns = 0, allocs = 0;
+    uint64_t now_us = 1000;
+
+    j1939_busmon_init(&mon, &g_dm, 250000);
+    memset(&frame, 0, sizeof(frame));
+    frame.length = 8;
+    frame.is_extended = true;
+
+    for (uint32_t n = 0; n < BENCH_ITERATIONS / 32; n++) {
+        // Re-send ET1 (3 s deadline) outside the timed window
+        for (uint16_t sa = 0; sa < J1939_BUSMON_SLOTS; sa++) {
+            frame.id = 0x18FEEE00 | sa;
+            frame.timestamp_us = now_us;
+            j1939_busmon_frame(&mon, &frame);
+        }
+
+        bench_begin();
+        for (uint8_t i = 0; i < 32; i++) {
+            now_us += J1939_BUSMON_WHEEL_TICK_MS * 1000;
+            j1939_busmon_poll(&mon, now_us);
+        }
+        elapsed_ns += bench_now_ns() - g_start_ns;
+        allocs += bench_alloc_count() - g_start_allocs;
+    }
+
+    bench_result_t r = { "j1939/busmon_poll (64 armed, none due)", BENCH_ITERATIONS, elapsed_ns, allocs };
+    bench_report(&r);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.allocations, "Hot path allocated from the heap");
+
+    j1939_busmon_stats_t stats;
+    j1939_busmon_get_stats(&mon, &stats);
+    TEST_ASSERT_EQUAL_UINT16(J1939_BUSMON_SLOTS, stats.keys);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.lost_events);
+    bench_sink = stats.windows;
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    data_manager_init(&g_dm);
+    watch_list_init(&g_watch_list, &g_dm);
+    j1708_msg[sizeof(j1708_msg) - 1] = j1708_calculate_checksum(j1708_msg, sizeof(j1708_msg) - 1);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_alloc_counter_sees_heap);
+    RUN_TEST(test_bench_extract_pgn);
+    RUN_TEST(test_bench_parse_frame);
+    RUN_TEST(test_bench_decode_functions);
+    RUN_TEST(test_bench_decode_current_gear);
+    RUN_TEST(test_bench_tp_bam);
+    RUN_TEST(test_bench_tp_poll);
+    RUN_TEST(test_bench_busmon_frame);
+    RUN_TEST(test_bench_busmon_poll);
+    RUN_TEST(test_bench_j1708_receive_byte);
+    RUN_TEST(test_bench_j1708_parse_message);
+    RUN_TEST(test_bench_data_manager_update);
+    RUN_TEST(test_bench_data_manager_get);
+    RUN_TEST(test_bench_watch_list_update);
+
+    bench_write_json("test_bench_hotpaths");
+    return UNITY_END();
+}
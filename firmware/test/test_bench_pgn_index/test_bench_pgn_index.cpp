@@ -0,0 +1,176 @@
+/**
+ * @file test_bench_pgn_index.cpp
+ * @brief Benchmark: PGN dispatch index vs. linear and binary search
+ *
+ * The linear case is a copy of the pgn_names[] scan that j1939_get_pgn_name()
+ * used before the index; the binary case searches the sorted descriptor table.
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include "bench_utils.h"
+#include <string.h>
+
+#define BENCH_ITERATIONS    500000
+
+/*===========================================================================*/
+/*                        REFERENCE LOOKUPS                                 */
+/*===========================================================================*/
+
+typedef struct {
+    uint32_t pgn;
+    const char* name;
+} legacy_pgn_name_t;
+
+// Former j1939_parser.cpp table (original order)
+static const legacy_pgn_name_t legacy_names[] = {
+    { 61444, "EEC1" }, { 61443, "EEC2" }, { 61442, "ETC1" }, { 61445, "ETC2" },
+    { 65262, "ET1" },  { 65263, "EFLP1" }, { 65265, "CCVS" }, { 65266, "LFE" },
+    { 65269, "AMB" },  { 65270, "IC1" },  { 65271, "VEP1" }, { 65272, "TRF1" },
+    { 65276, "DD" },   { 65253, "HOURS" }, { 65226, "DM1" }, { 65227, "DM2" },
+    { 60416, "TP.CM" }, { 60160, "TP.DT" },
+    { 0, NULL }
+};
+
+static const char* legacy_linear_name(uint32_t pgn) {
+    for (int i = 0; legacy_names[i].name != NULL; i++) {
+        if (legacy_names[i].pgn == pgn) {
+            return legacy_names[i].name;
+        }
+    }
+    return "Unknown PGN";
+}
+
+static const j1939_pgn_desc_t* binary_find(uint32_t pgn) {
+    uint16_t count;
+    const j1939_pgn_desc_t* table = j1939_decoder_get_pgns(&count);
+    uint16_t low = 0;
+    uint16_t high = count;
+
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (table[mid].pgn < pgn) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < count && table[low].pgn == pgn) ? &table[low] : NULL;
+}
+
+/*===========================================================================*/
+/*                        PGN MIX                                           */
+/*===========================================================================*/
+
+// Weighted roughly by bus share: 10 ms PGNs dominate, plus unknown PGNs
+static const uint32_t pgn_mix[] = {
+    61444, 61442, 61444, 61442, 61444, 61442, 61444, 61442, 61443, 61443,
+    65265, 65266, 61445, 65262, 65263, 65270, 65271, 65226, 60416, 60160,
+    65280, 65248, 64965, 65132,
+};
+
+#define PGN_MIX_COUNT (sizeof(pgn_mix) / sizeof(pgn_mix[0]))
+
+/*===========================================================================*/
+/*                        BENCHMARKS                                        */
+/*===========================================================================*/
+
+void test_index_matches_binary_search(void) {
+    for (uint8_t i = 0; i < PGN_MIX_COUNT; i++) {
+        TEST_ASSERT_EQUAL_PTR(binary_find(pgn_mix[i]), j1939_decoder_find_pgn(pgn_mix[i]));
+    }
+}
+
+void test_bench_linear_name_scan(void) {
+    bench_result_t r = { "pgn/linear_name_scan", 0, 0, 0 };
+    uint32_t acc = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < PGN_MIX_COUNT; i++) {
+            acc += (uint32_t)(uintptr_t)legacy_linear_name(pgn_mix[i]);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * PGN_MIX_COUNT;
+
+    bench_sink = acc;
+    bench_report(&r);
+}
+
+void test_bench_binary_search(void) {
+    bench_result_t r = { "pgn/binary_search", 0, 0, 0 };
+    uint32_t acc = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < PGN_MIX_COUNT; i++) {
+            acc += (uint32_t)(uintptr_t)binary_find(pgn_mix[i]);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * PGN_MIX_COUNT;
+
+    bench_sink = acc;
+    bench_report(&r);
+}
+
+void test_bench_dispatch_index(void) {
+    bench_result_t r = { "pgn/dispatch_index", 0, 0, 0 };
+    uint32_t acc = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < PGN_MIX_COUNT; i++) {
+            acc += (uint32_t)(uintptr_t)j1939_decoder_find_pgn(pgn_mix[i]);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * PGN_MIX_COUNT;
+
+    bench_sink = acc;
+    bench_report(&r);
+}
+
+void test_bench_get_pgn_name(void) {
+    bench_result_t r = { "pgn/get_pgn_name", 0, 0, 0 };
+    uint32_t acc = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++) {
+        for (uint8_t i = 0; i < PGN_MIX_COUNT; i++) {
+            acc += (uint32_t)(uintptr_t)j1939_get_pgn_name(pgn_mix[i]);
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = (uint64_t)BENCH_ITERATIONS * PGN_MIX_COUNT;
+
+    bench_sink = acc;
+    bench_report(&r);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    j1939_pgn_index_init();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_index_matches_binary_search);
+    RUN_TEST(test_bench_linear_name_scan);
+    RUN_TEST(test_bench_binary_search);
+    RUN_TEST(test_bench_dispatch_index);
+    RUN_TEST(test_bench_get_pgn_name);
+
+    bench_write_json("test_bench_pgn_index");
+    return UNITY_END();
+}
@@ -0,0 +1,231 @@
+/**
+ * @file test_bench_replay.cpp
+ * @brief Replay harness: recorded traces through parse, TP and decode
+ *
+ * Every shipped trace (.asc, candump .log, CSV) is replayed as fast as
+ * possible through the receive path (see replay_utils.h), reporting
+ * frames/s, per-stage ns/frame and the final parameter values. The
+ * throughput floor makes this suite the regression gate for the decode
+ * path: `pio test -e native_bench -f test_bench_replay`.
+ *
+ * Any other trace can be replayed, optionally at recorded pace:
+ *   REPLAY_TRACE=capture.log REPLAY_SPEED=1 pio test -e native_bench -f test_bench_replay
+ * (REPLAY_SPEED 0 = as fast as possible, 1 = recorded pace, 10 = 10x).
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "data_manager.h"
+#include "j1939_shadow.h"
+#include "bench_utils.h"
+#include "trace_utils.h"
+#include "replay_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_FRAMES       20000
+#define REPLAY_PASSES           20          // Throughput passes per trace
+
+// Lowest acceptable throughput on the host; the bus itself tops out near
+// 2000 frames/s at 250 kbit/s, so this leaves a wide margin for the ESP32
+#ifndef REPLAY_MIN_FRAMES_PER_SEC
+#define REPLAY_MIN_FRAMES_PER_SEC   1000000.0
+#endif
+
+static trace_frame_t g_frames[REPLAY_MAX_FRAMES];
+static j1939_parser_context_t g_parser;
+static data_manager_t g_dm;
+static data_manager_t g_dm_lazy;
+static j1939_shadow_t g_shadow;
+
+/*===========================================================================*/
+/*                        HELPERS                                           */
+/*===========================================================================*/
+
+/**
+ * @brief Load a trace and replay it once into fresh parser/data manager state
+ * @return Frames loaded
+ */
+static uint32_t replay_file(const char* path, const replay_options_t* options,
+                            replay_stats_t* stats) {
+    uint32_t count = trace_load(path, g_frames, REPLAY_MAX_FRAMES);
+
+    j1939_parser_init(&g_parser);
+    data_manager_init(&g_dm);
+    replay_run(g_frames, count, options, &g_parser, &g_dm, stats);
+    return count;
+}
+
+/**
+ * @brief Replay one shipped trace: stage timing, values, then throughput gate
+ */
+static void replay_and_gate(const char* path) {
+    replay_options_t timed = { 0.0, true, NULL };
+    replay_stats_t stats;
+
+    if (replay_file(path, &timed, &stats) == 0) {
+        TEST_IGNORE_MESSAGE("Trace not found (run from firmware/)");
+    }
+    replay_report(path, &stats);
+    replay_print_parameters(&g_dm);
+
+    TEST_ASSERT_EQUAL_UINT32(0, stats.parse_errors);
+    TEST_ASSERT_GREATER_THAN(0, stats.decoded_signals);
+
+    // Untimed passes for the throughput figure
+    replay_options_t fast = { 0.0, false, NULL };
+    uint64_t frames = 0, elapsed_ns = 0;
+    for (uint32_t pass = 0; pass < REPLAY_PASSES; pass++) {
+        j1939_parser_init(&g_parser);
+        data_manager_init(&g_dm);
+        replay_run(g_frames, stats.frames, &fast, &g_parser, &g_dm, &stats);
+        frames += stats.frames;
+        elapsed_ns += stats.elapsed_ns;
+    }
+
+    bench_result_t r = { path, frames, elapsed_ns, 0 };
+    bench_report(&r);
+    TEST_ASSERT_TRUE_MESSAGE(1e9 / bench_ns_per_op(&r) >= REPLAY_MIN_FRAMES_PER_SEC,
+                             "Replay throughput below REPLAY_MIN_FRAMES_PER_SEC");
+}
+
+/*===========================================================================*/
+/*                        TESTS                                             */
+/*===========================================================================*/
+
+void test_replay_idle_asc(void) {
+    replay_and_gate(trace_asc_paths[0]);
+}
+
+void test_replay_acceleration_asc(void) {
+    replay_and_gate(trace_asc_paths[1]);
+}
+
+void test_replay_highway_asc(void) {
+    replay_and_gate(trace_asc_paths[2]);
+
+    float speed;
+    TEST_ASSERT_TRUE(data_manager_get(&g_dm, PARAM_VEHICLE_SPEED, &speed));
+    TEST_ASSERT_TRUE(speed > 50.0f);
+}
+
+void test_replay_cold_start_asc(void) {
+    replay_and_gate(trace_asc_paths[3]);
+}
+
+void test_replay_truck_sample_asc(void) {
+    replay_and_gate(trace_asc_paths[4]);
+}
+
+void test_replay_candump_log(void) {
+    replay_and_gate(trace_log_path);
+
+    // The log carries one BAM transfer (component ID)
+    replay_options_t fast = { 0.0, false, NULL };
+    replay_stats_t stats;
+    replay_file(trace_log_path, &fast, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.tp_messages);
+}
+
+void test_replay_csv(void) {
+    replay_and_gate(trace_csv_path);
+
+    float speed;
+    TEST_ASSERT_TRUE(data_manager_get(&g_dm, PARAM_VEHICLE_SPEED, &speed));
+    TEST_ASSERT_TRUE(speed > 50.0f);
+}
+
+void test_replay_lazy_matches_eager(void) {
+    // The pipeline's shadow cache must end on the values eager decoding produces
+    replay_options_t eager = { 0.0, false, NULL };
+    replay_stats_t eager_stats, lazy_stats;
+
+    if (replay_file(trace_asc_paths[2], &eager, &eager_stats) == 0) {
+        TEST_IGNORE_MESSAGE("Trace not found (run from firmware/)");
+    }
+
+    j1939_parser_init(&g_parser);
+    data_manager_init(&g_dm_lazy);
+    j1939_shadow_init(&g_shadow, &g_dm_lazy);
+    replay_options_t lazy = { 0.0, false, &g_shadow };
+    replay_run(g_frames, eager_stats.frames, &lazy, &g_parser, &g_dm_lazy, &lazy_stats);
+    data_manager_resolve_pending(&g_dm_lazy);  // The decode task's next poll
+
+    uint16_t compared = 0;
+    for (uint16_t id = PARAM_NONE + 1; id < PARAM_MAX; id++) {
+        float eager_value, lazy_value;
+        bool valid = data_manager_get(&g_dm, (param_id_t)id, &eager_value);
+        TEST_ASSERT_EQUAL(valid, data_manager_get(&g_dm_lazy, (param_id_t)id, &lazy_value));
+        if (!valid) continue;
+        TEST_ASSERT_EQUAL_FLOAT(eager_value, lazy_value);
+        compared++;
+    }
+    TEST_ASSERT_GREATER_THAN(0, compared);
+
+    j1939_shadow_stats_t shadow_stats;
+    j1939_shadow_get_stats(&g_shadow, &shadow_stats);
+    printf("      %u frames stored (%u repeats), %u keys, %u signals decoded lazily (eager: %u)\n",
+           (unsigned)shadow_stats.frames, (unsigned)shadow_stats.repeats,
+           (unsigned)shadow_stats.entries, (unsigned)shadow_stats.decodes,
+           (unsigned)eager_stats.decoded_signals);
+    TEST_ASSERT_EQUAL_UINT32(0, shadow_stats.overflow);
+    TEST_ASSERT_TRUE(shadow_stats.decodes <= compared);
+}
+
+void test_replay_recorded_pace(void) {
+    // 100x recorded pace: the 30 s trace must take at least ~0.3 s of wall time
+    replay_options_t paced = { 100.0, false, NULL };
+    replay_stats_t stats;
+
+    if (replay_file(trace_asc_paths[1], &paced, &stats) == 0) {
+        TEST_IGNORE_MESSAGE("Trace not found (run from firmware/)");
+    }
+    replay_report("paced x100", &stats);
+
+    uint64_t expected_ns = stats.trace_us * 1000ULL / 100ULL;
+    TEST_ASSERT_TRUE(stats.elapsed_ns >= expected_ns);
+    TEST_ASSERT_TRUE(stats.elapsed_ns < expected_ns + 250000000ULL);
+}
+
+void test_replay_user_trace(void) {
+    const char* path = getenv("REPLAY_TRACE");
+    if (path == NULL) {
+        TEST_IGNORE_MESSAGE("Set REPLAY_TRACE (and optionally REPLAY_SPEED) to replay a file");
+    }
+
+    const char* speed = getenv("REPLAY_SPEED");
+    replay_options_t options = { speed ? atof(speed) : 0.0, true, NULL };
+    replay_stats_t stats;
+
+    TEST_ASSERT_TRUE_MESSAGE(replay_file(path, &options, &stats) > 0, "No frames loaded");
+    replay_report(path, &stats);
+    replay_print_parameters(&g_dm);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_replay_idle_asc);
+    RUN_TEST(test_replay_acceleration_asc);
+    RUN_TEST(test_replay_highway_asc);
+    RUN_TEST(test_replay_cold_start_asc);
+    RUN_TEST(test_replay_truck_sample_asc);
+    RUN_TEST(test_replay_candump_log);
+    RUN_TEST(test_replay_csv);
+    RUN_TEST(test_replay_lazy_matches_eager);
+    RUN_TEST(test_replay_recorded_pace);
+    RUN_TEST(test_replay_user_trace);
+
+    bench_write_json("test_bench_replay");
+    return UNITY_END();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_bench_spn.cpp
+ * @brief Benchmark: j1939_decode_spn() lookups over the synthetic .asc traces
+ *
+ * Every frame of the traces is parsed once; the timed loops then pull each
+ * indexed SPN of the frame's PGN through j1939_decode_spn(), the way the
+ * watch list and tools request values on demand.
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include "bench_utils.h"
+#include "trace_utils.h"
+#include <string.h>
+
+#define BENCH_MAX_FRAMES    20000
+#define BENCH_PASSES        20
+
+static trace_frame_t g_frames[BENCH_MAX_FRAMES];
+static j1939_message_t g_messages[BENCH_MAX_FRAMES];
+static uint32_t g_message_count = 0;
+
+/*===========================================================================*/
+/*                        BENCHMARKS                                        */
+/*===========================================================================*/
+
+void test_traces_loaded(void) {
+    if (g_message_count == 0) {
+        TEST_IGNORE_MESSAGE("No .asc traces found (run from firmware/)");
+    }
+    printf("      %u frames from .asc traces\n", (unsigned)g_message_count);
+}
+
+void test_bench_find_spn(void) {
+    uint16_t spn_count;
+    const j1939_spn_entry_t* spns = j1939_decoder_get_spns(&spn_count);
+    bench_result_t r = { "spn/find_spn", 0, 0, 0 };
+    uint32_t acc = 0;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t n = 0; n < 100000; n++) {
+        for (uint16_t i = 0; i < spn_count; i++) {
+            acc += j1939_decoder_find_spn(spns[i].spn)->pgn;
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = 100000ULL * spn_count;
+
+    bench_sink = acc;
+    bench_report(&r);
+}
+
+void test_bench_decode_spn_traces(void) {
+    if (g_message_count == 0) {
+        TEST_IGNORE_MESSAGE("No .asc traces found");
+    }
+
+    bench_result_t r = { "spn/decode_spn_traces", 0, 0, 0 };
+    uint64_t lookups = 0;
+    uint32_t valid = 0;
+    float value;
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t pass = 0; pass < BENCH_PASSES; pass++) {
+        for (uint32_t m = 0; m < g_message_count; m++) {
+            const j1939_message_t* msg = &g_messages[m];
+            const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(msg->pgn);
+            if (desc == NULL) continue;
+
+            for (uint8_t s = 0; s < desc->signal_count; s++) {
+                valid += j1939_decode_spn(msg, desc->signals[s].spn, &value) ? 1 : 0;
+                lookups++;
+            }
+        }
+    }
+    r.elapsed_ns = bench_now_ns() - start;
+    r.operations = lookups;
+
+    bench_sink = valid;
+    bench_report(&r);
+    printf("      %.1f%% of lookups returned a valid value\n",
+           lookups ? 100.0 * (double)valid / (double)lookups : 0.0);
+    TEST_ASSERT_GREATER_THAN(0, valid);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    uint32_t frame_count = trace_load_all_asc(g_frames, BENCH_MAX_FRAMES);
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        if (j1939_parse_frame_us(g_frames[i].can_id, g_frames[i].data, g_frames[i].data_length,
+                                 g_frames[i].timestamp_us, &g_messages[g_message_count])) {
+            g_message_count++;
+        }
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_traces_loaded);
+    RUN_TEST(test_bench_find_spn);
+    RUN_TEST(test_bench_decode_spn_traces);
+
+    bench_write_json("test_bench_spn");
+    return UNITY_END();
+}
@@ -0,0 +1,459 @@
+/**
+ * @file test_can_driver.cpp
+ * @brief CAN driver API tests against the native loopback backend
+ */
+
+#include <unity.h>
+#include "can_driver.h"
+#include "can_host.h"
+#include "can_filter.h"
+#include <stdio.h>
+#include <string.h>
+
+// Native millis() stub control (j1939_parser.cpp)
+void test_set_millis(uint32_t ms);
+
+static can_frame_t make_frame(uint32_t id, uint8_t seq) {
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = id;
+    frame.length = 8;
+    frame.is_extended = true;
+    frame.data[0] = seq;
+    return frame;
+}
+
+/*===========================================================================*/
+/*                        LIFECYCLE TESTS                                   */
+/*===========================================================================*/
+
+void test_init_rejects_unknown_baud(void) {
+    TEST_ASSERT_FALSE(can_driver_init(5, 4, 125000));
+    TEST_ASSERT_FALSE(can_driver_start());
+}
+
+void test_start_stop(void) {
+    can_frame_t frame = make_frame(0x18FEEE00, 0);
+
+    TEST_ASSERT_TRUE(can_driver_init(5, 4, CAN_BAUD_250K));
+    TEST_ASSERT_EQUAL(CAN_STATE_STOPPED, can_driver_get_state());
+    TEST_ASSERT_FALSE(can_driver_transmit(&frame, 0));
+
+    TEST_ASSERT_TRUE(can_driver_start());
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+    TEST_ASSERT_FALSE(can_driver_start());  // Already running
+
+    TEST_ASSERT_TRUE(can_driver_stop());
+    TEST_ASSERT_EQUAL(CAN_STATE_STOPPED, can_driver_get_state());
+}
+
+/*===========================================================================*/
+/*                        RECEIVE TESTS                                     */
+/*===========================================================================*/
+
+void test_receive_batch_order_and_limit(void) {
+    can_frame_t out[8];
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    test_set_millis(1234);
+
+    for (uint8_t i = 0; i < 12; i++) {
+        can_frame_t frame = make_frame(0x18FEEE00, i);
+        TEST_ASSERT_TRUE(can_driver_transmit(&frame, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(8, can_driver_receive_batch(out, 8, 10));
+    TEST_ASSERT_EQUAL_UINT8(0, out[0].data[0]);
+    TEST_ASSERT_EQUAL_UINT8(7, out[7].data[0]);
+    TEST_ASSERT_EQUAL_UINT64(1234000ULL, out[7].timestamp_us);
+    TEST_ASSERT_TRUE(out[0].is_extended);
+
+    TEST_ASSERT_EQUAL_UINT32(4, can_driver_receive_batch(out, 8, 0));
+    TEST_ASSERT_EQUAL_UINT8(8, out[0].data[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, can_driver_receive_batch(out, 8, 0));
+
+    can_stats_t stats;
+    can_driver_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.rx_count);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.tx_count);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.rx_queue_high_water);
+}
+
+void test_receive_single(void) {
+    can_frame_t frame = make_frame(0x0CF00400, 42);
+    can_frame_t out;
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+
+    TEST_ASSERT_FALSE(can_driver_receive(&out, 0));
+    can_driver_transmit(&frame, 0);
+    TEST_ASSERT_TRUE(can_driver_receive(&out, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x0CF00400, out.id);
+    TEST_ASSERT_EQUAL_UINT8(42, out.data[0]);
+}
+
+void test_rx_queue_full_counted(void) {
+    can_frame_t out[CAN_DRIVER_RX_QUEUE_LEN];
+    can_stats_t stats;
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+
+    for (uint32_t i = 0; i < CAN_DRIVER_RX_QUEUE_LEN + 5; i++) {
+        can_frame_t frame = make_frame(0x18FEEE00, (uint8_t)i);
+        can_driver_transmit(&frame, 0);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(CAN_DRIVER_RX_QUEUE_LEN,
+                             can_driver_receive_batch(out, CAN_DRIVER_RX_QUEUE_LEN, 0));
+    can_driver_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.rx_errors);
+}
+
+void test_filter(void) {
+    can_frame_t out[4];
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+
+    // Only PGN 65262 (ET1) from any source address
+    TEST_ASSERT_TRUE(can_driver_set_filter(0x00FEEE00, 0x03FFFF00));
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+
+    can_frame_t et1 = make_frame(0x18FEEE17, 1);
+    can_frame_t eec1 = make_frame(0x0CF00400, 2);
+    can_driver_transmit(&eec1, 0);
+    can_driver_transmit(&et1, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(1, can_driver_receive_batch(out, 4, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x18FEEE17, out[0].id);
+}
+
+void test_dual_filter(void) {
+    can_frame_t out[4];
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+
+    // EEC1 and ET1; dual filters only see ID28..ID13, so PS is matched on its top bits
+    TEST_ASSERT_TRUE(can_driver_set_dual_filter(0x00F00400, 0x03FFE000, 0x00FEEE00, 0x03FFE000));
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+
+    can_frame_t eec1 = make_frame(0x0CF00400, 1);
+    can_frame_t hours = make_frame(0x18FEE500, 2);   // PS 0xE5: top bits 111
+    can_frame_t vd = make_frame(0x18FEE000, 3);      // PS 0xE0: top bits 111
+    can_frame_t ccss = make_frame(0x18FEDF00, 4);    // PS 0xDF: top bits 110
+    can_driver_transmit(&eec1, 0);
+    can_driver_transmit(&hours, 0);
+    can_driver_transmit(&vd, 0);
+    can_driver_transmit(&ccss, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(3, can_driver_receive_batch(out, 4, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x0CF00400, out[0].id);
+    TEST_ASSERT_EQUAL_HEX32(0x18FEE500, out[1].id);
+    TEST_ASSERT_EQUAL_HEX32(0x18FEE000, out[2].id);
+}
+
+void test_filter_reinstall_failure_recovers(void) {
+    can_frame_t out[4];
+    can_frame_t et1 = make_frame(0x18FEEE17, 1);
+    can_frame_t eec1 = make_frame(0x0CF00400, 2);
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    TEST_ASSERT_TRUE(can_driver_set_filter(0x00FEEE00, 0x03FFFF00));
+
+    // The new filter does not install: the previous one comes back, running
+    can_driver_native_fail_installs(1);
+    TEST_ASSERT_FALSE(can_driver_set_filter(0x00F00400, 0x03FFFF00));
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+    can_driver_transmit(&eec1, 0);
+    can_driver_transmit(&et1, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, can_driver_receive_batch(out, 4, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x18FEEE17, out[0].id);
+
+    // Neither installs: the driver is off until the retry succeeds
+    can_driver_native_fail_installs(2);
+    TEST_ASSERT_FALSE(can_driver_set_filter(0x00F00400, 0x03FFFF00));
+    TEST_ASSERT_EQUAL(CAN_STATE_STOPPED, can_driver_get_state());
+    TEST_ASSERT_FALSE(can_driver_transmit(&eec1, 0));
+
+    TEST_ASSERT_TRUE(can_driver_set_filter(0x00F00400, 0x03FFFF00));
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+    can_driver_transmit(&et1, 0);
+    can_driver_transmit(&eec1, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, can_driver_receive_batch(out, 4, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x0CF00400, out[0].id);
+}
+
+/*===========================================================================*/
+/*                        FILTER PLANNER TESTS                              */
+/*===========================================================================*/
+
+static uint32_t pgn_id(uint8_t priority, uint32_t pgn, uint8_t sa) {
+    return ((uint32_t)priority << 26) | (pgn << 8) | sa;
+}
+
+void test_filter_set_sorted(void) {
+    can_filter_set_t a, b;
+    can_filter_set_clear(&a);
+    can_filter_set_clear(&b);
+
+    can_filter_set_add(&a, 65262);
+    can_filter_set_add(&a, 61444);
+    can_filter_set_add(&a, 65262);     // Duplicate
+    can_filter_set_add(&b, 61444);
+    can_filter_set_add(&b, 65262);
+
+    TEST_ASSERT_EQUAL_UINT8(2, a.count);
+    TEST_ASSERT_EQUAL_UINT32(61444, a.pgns[0]);
+    TEST_ASSERT_TRUE(can_filter_set_equal(&a, &b));
+
+    can_filter_set_add(&b, 65265);
+    TEST_ASSERT_FALSE(can_filter_set_equal(&a, &b));
+}
+
+void test_filter_plan_accepts_consumed(void) {
+    const uint32_t pgns[] = { 61443, 61444, 65262, 65263, 65265, 65266 };
+    can_filter_set_t set;
+    can_filter_plan_t plan;
+
+    can_filter_set_clear(&set);
+    for (uint8_t i = 0; i < 6; i++) can_filter_set_add(&set, pgns[i]);
+    can_filter_plan(&set, NULL, 0, &plan);
+    TEST_ASSERT_NOT_EQUAL(CAN_FILTER_ACCEPT_ALL, plan.mode);
+
+    // Any priority, any source
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST_ASSERT_TRUE(can_filter_accepts(&plan, pgn_id(3, pgns[i], 0x00)));
+        TEST_ASSERT_TRUE(can_filter_accepts(&plan, pgn_id(6, pgns[i], 0x17)));
+        TEST_ASSERT_TRUE(can_filter_accepts(&plan, pgn_id(7, pgns[i], 0xFE)));
+    }
+    TEST_ASSERT_FALSE(can_filter_accepts(&plan, pgn_id(6, 59904, 0x00)));  // Request
+}
+
+void test_filter_plan_pdu1_any_destination(void) {
+    can_filter_set_t set;
+    can_filter_plan_t plan;
+
+    can_filter_set_clear(&set);
+    can_filter_set_add(&set, 0xEA17);  // Request to 0x17
+    TEST_ASSERT_EQUAL_HEX32(0xEA00, set.pgns[0]);
+
+    can_filter_plan(&set, NULL, 0, &plan);
+    TEST_ASSERT_TRUE(can_filter_accepts(&plan, 0x18EAFF00));
+    TEST_ASSERT_TRUE(can_filter_accepts(&plan, 0x18EA0017));
+    TEST_ASSERT_FALSE(can_filter_accepts(&plan, 0x18EB0017));
+}
+
+void test_filter_plan_dual_from_traffic(void) {
+    can_frame_t out[8];
+    can_filter_set_t set;
+    can_filter_plan_t plan;
+
+    can_filter_set_clear(&set);
+    can_filter_set_add(&set, 0xF004);
+    can_filter_set_add(&set, 0xFEEE);
+
+    // 0xF0EE fits the one mask covering both, but neither dual half
+    const can_filter_traffic_t traffic[] = {
+        { 0xF004, 100 }, { 0xFEEE, 10 }, { 0xF0EE, 300 }
+    };
+    can_filter_plan(&set, traffic, 3, &plan);
+
+    TEST_ASSERT_EQUAL(CAN_FILTER_DUAL, plan.mode);
+    TEST_ASSERT_EQUAL_UINT32(410, plan.sample_frames);
+    TEST_ASSERT_EQUAL_UINT32(300, plan.sample_rejected);
+
+    // Installed plan behaves as predicted
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    TEST_ASSERT_TRUE(can_driver_set_dual_filter(plan.code[0], plan.mask[0], plan.code[1], plan.mask[1]));
+
+    const uint32_t ids[] = { 0x0CF00400, 0x18F0EE00, 0x18FEEE00, 0x08F00431 };
+    for (uint8_t i = 0; i < 4; i++) {
+        can_frame_t frame = make_frame(ids[i], i);
+        can_driver_transmit(&frame, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, can_driver_receive_batch(out, 8, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x0CF00400, out[0].id);
+    TEST_ASSERT_EQUAL_HEX32(0x18FEEE00, out[1].id);
+    TEST_ASSERT_EQUAL_HEX32(0x08F00431, out[2].id);
+}
+
+void test_filter_set_overflow_accepts_all(void) {
+    can_filter_set_t set;
+    can_filter_plan_t plan;
+    const can_filter_traffic_t traffic[] = { { 0xFF00, 5 } };
+
+    can_filter_set_clear(&set);
+    for (uint32_t i = 0; i < CAN_FILTER_MAX_PGNS; i++) {
+        TEST_ASSERT_TRUE(can_filter_set_add(&set, 0xFE00 + i));
+    }
+    TEST_ASSERT_FALSE(can_filter_set_add(&set, 0xFF00));
+    TEST_ASSERT_TRUE(set.accept_all);
+
+    can_filter_plan(&set, traffic, 1, &plan);
+    TEST_ASSERT_EQUAL(CAN_FILTER_ACCEPT_ALL, plan.mode);
+    TEST_ASSERT_EQUAL_UINT32(0, plan.sample_rejected);
+    TEST_ASSERT_TRUE(can_filter_accepts(&plan, 0x18FF0000));
+}
+
+/*===========================================================================*/
+/*                        BUS-OFF RECOVERY TESTS                            */
+/*===========================================================================*/
+
+void test_bus_off_auto_recovery(void) {
+    can_frame_t out[4];
+    can_stats_t stats;
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    can_driver_native_force_bus_off();
+
+    // First poll notices bus-off and starts recovery
+    TEST_ASSERT_EQUAL_UINT32(0, can_driver_receive_batch(out, 4, 10));
+    TEST_ASSERT_EQUAL(CAN_STATE_RECOVERING, can_driver_get_state());
+    can_driver_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.bus_off_count);
+    TEST_ASSERT_EQUAL_UINT8(255, stats.tx_error_counter);
+    TEST_ASSERT_GREATER_THAN(0, stats.bus_errors);
+
+    can_frame_t frame = make_frame(0x18FEEE00, 1);
+    TEST_ASSERT_FALSE(can_driver_transmit(&frame, 0));
+
+    // Next poll sees recovery complete and restarts the controller
+    can_driver_receive_batch(out, 4, 10);
+    TEST_ASSERT_EQUAL(CAN_STATE_RUNNING, can_driver_get_state());
+    can_driver_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.recovery_count);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.tx_error_counter);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.tx_errors);
+
+    TEST_ASSERT_TRUE(can_driver_transmit(&frame, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, can_driver_receive_batch(out, 4, 0));
+}
+
+void test_manual_recover_requires_bus_off(void) {
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    TEST_ASSERT_FALSE(can_driver_recover());
+}
+
+void test_clear_stats(void) {
+    can_frame_t frame = make_frame(0x18FEEE00, 1);
+    can_frame_t out;
+    can_stats_t stats;
+
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+    can_driver_transmit(&frame, 0);
+    can_driver_receive(&out, 0);
+
+    can_driver_clear_stats();
+    can_driver_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.rx_count);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.tx_count);
+}
+
+/*===========================================================================*/
+/*                        HOST SOURCE TESTS                                 */
+/*===========================================================================*/
+
+void test_parse_candump_line(void) {
+    can_frame_t frame;
+    uint64_t log_time_us;
+
+    TEST_ASSERT_TRUE(can_host_parse_log_line("(1706007000.010000) vcan0 0CF00400#007D7D843E000000\n",
+                                             &frame, &log_time_us));
+    TEST_ASSERT_EQUAL_UINT64(1706007000010000ULL, log_time_us);
+    TEST_ASSERT_EQUAL_HEX32(0x0CF00400, frame.id);
+    TEST_ASSERT_TRUE(frame.is_extended);
+    TEST_ASSERT_EQUAL_UINT8(8, frame.length);
+    TEST_ASSERT_EQUAL_HEX8(0x84, frame.data[3]);
+
+    TEST_ASSERT_TRUE(can_host_parse_log_line("(1.000001) can0 123#DEAD", &frame, &log_time_us));
+    TEST_ASSERT_FALSE(frame.is_extended);
+    TEST_ASSERT_EQUAL_UINT8(2, frame.length);
+
+    TEST_ASSERT_FALSE(can_host_parse_log_line("# comment", &frame, &log_time_us));
+    TEST_ASSERT_FALSE(can_host_parse_log_line("(1.0) can0 123##0DEAD", &frame, &log_time_us));
+}
+
+void test_log_source_replay(void) {
+    const char* path = "test_can_driver_source.log";
+    FILE* f = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("# candump -L\n", f);
+    fputs("(100.000000) vcan0 0CF00400#007D7D803E000000\n", f);
+    fputs("(100.010000) vcan0 18FEEE00#3C3C0024FFFFFF00\n", f);
+    fputs("(100.250000) vcan0 18FEF100#FF00000000000000\n", f);
+    fclose(f);
+
+    can_frame_t out[8];
+    TEST_ASSERT_TRUE(can_driver_native_set_source(path));
+    TEST_ASSERT_EQUAL(CAN_HOST_LOG, can_host_get_kind());
+    can_driver_init(5, 4, CAN_BAUD_250K);
+    can_driver_start();
+
+    TEST_ASSERT_EQUAL_UINT32(3, can_driver_receive_batch(out, 8, 10));
+    TEST_ASSERT_EQUAL_HEX32(0x18FEEE00, out[1].id);
+    TEST_ASSERT_EQUAL_UINT64(10000ULL, out[1].timestamp_us - out[0].timestamp_us);
+    TEST_ASSERT_EQUAL_UINT64(250000ULL, out[2].timestamp_us - out[0].timestamp_us);
+
+    // End of log stops the driver
+    TEST_ASSERT_EQUAL_UINT32(0, can_driver_receive_batch(out, 8, 10));
+    can_driver_receive_batch(out, 8, 0);
+    TEST_ASSERT_EQUAL(CAN_STATE_STOPPED, can_driver_get_state());
+
+    TEST_ASSERT_TRUE(can_driver_native_set_source(NULL));
+    TEST_ASSERT_EQUAL(CAN_HOST_NONE, can_host_get_kind());
+    remove(path);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+    test_set_millis(0);
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Lifecycle tests
+    RUN_TEST(test_init_rejects_unknown_baud);
+    RUN_TEST(test_start_stop);
+
+    // Receive tests
+    RUN_TEST(test_receive_batch_order_and_limit);
+    RUN_TEST(test_receive_single);
+    RUN_TEST(test_rx_queue_full_counted);
+    RUN_TEST(test_filter);
+    RUN_TEST(test_dual_filter);
+    RUN_TEST(test_filter_reinstall_failure_recovers);
+
+    // Filter planner tests
+    RUN_TEST(test_filter_set_sorted);
+    RUN_TEST(test_filter_plan_accepts_consumed);
+    RUN_TEST(test_filter_plan_pdu1_any_destination);
+    RUN_TEST(test_filter_plan_dual_from_traffic);
+    RUN_TEST(test_filter_set_overflow_accepts_all);
+
+    // Bus-off recovery tests
+    RUN_TEST(test_bus_off_auto_recovery);
+    RUN_TEST(test_manual_recover_requires_bus_off);
+    RUN_TEST(test_clear_stats);
+
+    // Host source tests
+    RUN_TEST(test_parse_candump_line);
+    RUN_TEST(test_log_source_replay);
+
+    return UNITY_END();
+}
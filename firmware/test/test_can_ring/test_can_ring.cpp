@@ -0,0 +1,209 @@
+/**
+ * @file test_can_ring.cpp
+ * @brief Unit and two-thread stress tests for the SPSC CAN frame ring
+ */
+
+#include <unity.h>
+#include "can_ring.h"
+#include <string.h>
+#include <thread>
+
+static can_ring_t g_ring;
+
+static can_frame_t make_frame(uint32_t seq) {
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = 0x18FEEE00 | (seq & 0xFF);
+    frame.length = 8;
+    frame.is_extended = true;
+    frame.timestamp_us = (uint64_t)seq * 1000ULL;
+    memcpy(frame.data, &seq, sizeof(seq));
+    return frame;
+}
+
+static uint32_t frame_seq(const can_frame_t* frame) {
+    uint32_t seq;
+    memcpy(&seq, frame->data, sizeof(seq));
+    return seq;
+}
+
+/*===========================================================================*/
+/*                        BASIC TESTS                                       */
+/*===========================================================================*/
+
+void test_ring_init_empty(void) {
+    can_ring_stats_t stats;
+    can_frame_t out[4];
+
+    can_ring_init(&g_ring);
+    can_ring_get_stats(&g_ring, &stats);
+
+    TEST_ASSERT_EQUAL_UINT32(0, can_ring_count(&g_ring));
+    TEST_ASSERT_EQUAL_UINT32(0, can_ring_pop_batch(&g_ring, out, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overflow_count);
+    TEST_ASSERT_EQUAL_UINT32(CAN_RING_SIZE, stats.capacity);
+}
+
+void test_ring_fifo_order(void) {
+    can_frame_t out[8];
+    can_ring_init(&g_ring);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        can_frame_t frame = make_frame(i);
+        TEST_ASSERT_TRUE(can_ring_push(&g_ring, &frame));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3, can_ring_pop_batch(&g_ring, out, 3));
+    TEST_ASSERT_EQUAL_UINT32(0, frame_seq(&out[0]));
+    TEST_ASSERT_EQUAL_UINT32(2, frame_seq(&out[2]));
+    TEST_ASSERT_EQUAL_UINT64(2000, out[2].timestamp_us);
+
+    TEST_ASSERT_EQUAL_UINT32(2, can_ring_pop_batch(&g_ring, out, 8));
+    TEST_ASSERT_EQUAL_UINT32(3, frame_seq(&out[0]));
+    TEST_ASSERT_EQUAL_UINT32(4, frame_seq(&out[1]));
+    TEST_ASSERT_EQUAL_UINT32(0, can_ring_count(&g_ring));
+}
+
+void test_ring_overflow_counted(void) {
+    can_ring_stats_t stats;
+    can_ring_init(&g_ring);
+
+    for (uint32_t i = 0; i < CAN_RING_SIZE + 10; i++) {
+        can_frame_t frame = make_frame(i);
+        can_ring_push(&g_ring, &frame);
+    }
+
+    can_ring_get_stats(&g_ring, &stats);
+    TEST_ASSERT_EQUAL_UINT32(CAN_RING_SIZE, stats.occupancy);
+    TEST_ASSERT_EQUAL_UINT32(CAN_RING_SIZE, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.overflow_count);
+
+    // Oldest frames are kept; the newest were dropped
+    can_frame_t out[1];
+    can_ring_pop_batch(&g_ring, out, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, frame_seq(&out[0]));
+}
+
+void test_ring_wraparound(void) {
+    can_frame_t out[CAN_RING_SIZE];
+    can_ring_init(&g_ring);
+
+    uint32_t next = 0;
+    for (uint32_t round = 0; round < 5; round++) {
+        for (uint32_t i = 0; i < CAN_RING_SIZE - 3; i++) {
+            can_frame_t frame = make_frame(next + i);
+            TEST_ASSERT_TRUE(can_ring_push(&g_ring, &frame));
+        }
+        uint32_t count = can_ring_pop_batch(&g_ring, out, CAN_RING_SIZE);
+        TEST_ASSERT_EQUAL_UINT32(CAN_RING_SIZE - 3, count);
+        for (uint32_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_UINT32(next + i, frame_seq(&out[i]));
+        }
+        next += count;
+    }
+}
+
+/*===========================================================================*/
+/*                        TWO-THREAD STRESS TESTS                           */
+/*===========================================================================*/
+
+#define STRESS_FRAMES   2000000
+
+void test_ring_stress_lossless(void) {
+    can_ring_init(&g_ring);
+
+    // Producer retries when full, so every frame must arrive exactly once, in order
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < STRESS_FRAMES; i++) {
+            can_frame_t frame = make_frame(i);
+            while (!can_ring_push(&g_ring, &frame)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    can_frame_t batch[32];
+    uint32_t expected = 0;
+    bool in_order = true;
+
+    while (expected < STRESS_FRAMES) {
+        uint32_t count = can_ring_pop_batch(&g_ring, batch, 32);
+        for (uint32_t i = 0; i < count; i++) {
+            if (frame_seq(&batch[i]) != expected || batch[i].timestamp_us != (uint64_t)expected * 1000ULL) {
+                in_order = false;
+            }
+            expected++;
+        }
+        if (count == 0) std::this_thread::yield();
+    }
+    producer.join();
+
+    can_ring_stats_t stats;
+    can_ring_get_stats(&g_ring, &stats);
+    TEST_ASSERT_TRUE(in_order);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.occupancy);  // Rejected pushes still count as overflow
+}
+
+void test_ring_stress_lossy(void) {
+    can_ring_init(&g_ring);
+    volatile bool done = false;
+
+    // Producer never waits: drops are counted, survivors stay ordered
+    std::thread producer([&done]() {
+        for (uint32_t i = 0; i < STRESS_FRAMES; i++) {
+            can_frame_t frame = make_frame(i);
+            can_ring_push(&g_ring, &frame);
+        }
+        __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+    });
+
+    can_frame_t batch[8];
+    uint32_t received = 0;
+    uint32_t last = 0;
+    bool increasing = true;
+
+    while (true) {
+        bool finished = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+        uint32_t count = can_ring_pop_batch(&g_ring, batch, 8);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t seq = frame_seq(&batch[i]);
+            if (received > 0 && seq <= last) increasing = false;
+            last = seq;
+            received++;
+        }
+        if (finished && count == 0) break;
+    }
+    producer.join();
+
+    can_ring_stats_t stats;
+    can_ring_get_stats(&g_ring, &stats);
+    TEST_ASSERT_TRUE(increasing);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, received + stats.overflow_count);
+    TEST_ASSERT_TRUE(stats.high_water <= CAN_RING_SIZE);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Basic tests
+    RUN_TEST(test_ring_init_empty);
+    RUN_TEST(test_ring_fifo_order);
+    RUN_TEST(test_ring_overflow_counted);
+    RUN_TEST(test_ring_wraparound);
+
+    // Two-thread stress tests
+    RUN_TEST(test_ring_stress_lossless);
+    RUN_TEST(test_ring_stress_lossy);
+
+    return UNITY_END();
+}
@@ -7,6 +7,10 @@
 
 #include <unity.h>
 #include "j1939_parser.h"
+#include "j1939_dm1.h"
+#include "j1939_addr.h"
+#include "j1939_request.h"
+#include "j1939_diag.h"
 #include <string.h>
 #include <math.h>
 
@@ -363,6 +367,709 @@ void test_parse_dm1_no_faults(void) {
     TEST_ASSERT_FALSE(lamps.malfunction_lamp);
 }
 
+/*===========================================================================*/
+/*                        DM1 FAULT TABLE TESTS                             */
+/*===========================================================================*/
+
+typedef struct {
+    uint8_t appeared;
+    uint8_t cleared;
+    j1939_dtc_t last;
+} dm1_changes_t;
+
+static void record_fault_change(const j1939_dtc_t* dtc, bool active, uint64_t timestamp_us, void* user) {
+    (void)timestamp_us;
+    dm1_changes_t* changes = (dm1_changes_t*)user;
+    if (active) changes->appeared++; else changes->cleared++;
+    changes->last = *dtc;
+}
+
+static void make_dm1(uint8_t* data, bool mil, uint32_t spn, uint8_t fmi, uint8_t oc) {
+    data[0] = 0x00;
+    data[1] = mil ? 0x10 : 0x00;
+    data[2] = (uint8_t)spn;
+    data[3] = (uint8_t)(spn >> 8);
+    data[4] = (uint8_t)(((spn >> 11) & 0xE0) | fmi);
+    data[5] = oc;
+    data[6] = 0xFF;
+    data[7] = 0xFF;
+}
+
+void test_dm1_table_skips_repeats(void) {
+    dm1_changes_t changes = {};
+    j1939_dm1_table_t table;
+    j1939_dm1_init(&table, record_fault_change, &changes);
+
+    uint8_t data[8];
+    make_dm1(data, true, 110, 0, 1);
+
+    TEST_ASSERT_TRUE(j1939_dm1_process(&table, 0x00, data, 8, 1000000));
+    TEST_ASSERT_EQUAL_UINT8(1, changes.appeared);
+    TEST_ASSERT_EQUAL_UINT32(110, changes.last.spn);
+    TEST_ASSERT_EQUAL_UINT8(0x00, changes.last.source_address);
+
+    // The same DM1 a second later changes nothing
+    TEST_ASSERT_FALSE(j1939_dm1_process(&table, 0x00, data, 8, 2000000));
+    TEST_ASSERT_EQUAL_UINT8(1, changes.appeared);
+
+    // Only the occurrence count moved: parsed, but no fault appeared or cleared
+    make_dm1(data, true, 110, 0, 2);
+    TEST_ASSERT_FALSE(j1939_dm1_process(&table, 0x00, data, 8, 3000000));
+    TEST_ASSERT_EQUAL_UINT8(1, changes.appeared);
+    TEST_ASSERT_EQUAL_UINT8(0, changes.cleared);
+
+    j1939_dm1_stats_t stats;
+    j1939_dm1_get_stats(&table, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.messages);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.repeats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.changes);
+    TEST_ASSERT_EQUAL_UINT16(1, table.active_count);
+    TEST_ASSERT_TRUE(table.mil);
+}
+
+void test_dm1_table_reports_cleared_faults(void) {
+    dm1_changes_t changes = {};
+    j1939_dm1_table_t table;
+    j1939_dm1_init(&table, record_fault_change, &changes);
+
+    uint8_t data[8];
+    make_dm1(data, true, 100, 1, 1);
+    j1939_dm1_process(&table, 0x00, data, 8, 1000000);
+
+    // A different fault replaces it
+    make_dm1(data, true, 524287, 31, 1);
+    TEST_ASSERT_TRUE(j1939_dm1_process(&table, 0x00, data, 8, 2000000));
+    TEST_ASSERT_EQUAL_UINT8(2, changes.appeared);
+    TEST_ASSERT_EQUAL_UINT8(1, changes.cleared);
+    TEST_ASSERT_EQUAL_UINT32(524287, changes.last.spn);
+    TEST_ASSERT_EQUAL_UINT8(31, changes.last.fmi);
+
+    // No faults, lamp off
+    make_dm1(data, false, 0, 0, 0);
+    TEST_ASSERT_TRUE(j1939_dm1_process(&table, 0x00, data, 8, 3000000));
+    TEST_ASSERT_EQUAL_UINT8(2, changes.cleared);
+    TEST_ASSERT_EQUAL_UINT16(0, table.active_count);
+    TEST_ASSERT_FALSE(table.mil);
+}
+
+void test_dm1_table_tracks_ecus_separately(void) {
+    dm1_changes_t changes = {};
+    j1939_dm1_table_t table;
+    j1939_dm1_init(&table, record_fault_change, &changes);
+
+    uint8_t engine[8];
+    uint8_t trans[8];
+    make_dm1(engine, true, 110, 0, 1);
+    make_dm1(trans, false, 177, 3, 1);
+
+    j1939_dm1_process(&table, 0x00, engine, 8, 1000000);
+    j1939_dm1_process(&table, 0x03, trans, 8, 1000000);
+    TEST_ASSERT_EQUAL_UINT16(2, table.active_count);
+    TEST_ASSERT_TRUE(table.mil);
+
+    // Alternating sources are still repeats of their own previous DM1
+    TEST_ASSERT_FALSE(j1939_dm1_process(&table, 0x00, engine, 8, 2000000));
+    TEST_ASSERT_FALSE(j1939_dm1_process(&table, 0x03, trans, 8, 2000000));
+
+    const j1939_dm1_ecu_t* ecu = j1939_dm1_find(&table, 0x03);
+    TEST_ASSERT_NOT_NULL(ecu);
+    TEST_ASSERT_EQUAL_UINT8(1, ecu->dtc_count);
+    TEST_ASSERT_EQUAL_UINT32(177, ecu->dtcs[0].spn);
+    TEST_ASSERT_EQUAL_UINT32(2, ecu->messages);
+    TEST_ASSERT_NULL(j1939_dm1_find(&table, 0x0B));
+
+    // The engine going quiet clears its faults and its MIL only
+    TEST_ASSERT_TRUE(j1939_dm1_forget(&table, 0x00, 3000000));
+    TEST_ASSERT_EQUAL_UINT8(1, changes.cleared);
+    TEST_ASSERT_EQUAL_UINT16(1, table.active_count);
+    TEST_ASSERT_FALSE(table.mil);
+    TEST_ASSERT_FALSE(j1939_dm1_forget(&table, 0x00, 3000000));
+}
+
+void test_dm1_table_multipacket(void) {
+    j1939_dm1_table_t table;
+    j1939_dm1_init(&table, NULL, NULL);
+
+    // Three faults over TP (14 bytes)
+    uint8_t data[14] = {
+        0x04, 0x00,
+        0x6E, 0x00, 0x00, 0x01,     // SPN 110 FMI 0
+        0x64, 0x00, 0x01, 0x01,     // SPN 100 FMI 1
+        0xBE, 0x00, 0x02, 0x01      // SPN 190 FMI 2
+    };
+    TEST_ASSERT_TRUE(j1939_dm1_process(&table, 0x00, data, sizeof(data), 1000000));
+    TEST_ASSERT_EQUAL_UINT16(3, table.active_count);
+    TEST_ASSERT_FALSE(table.mil);
+    TEST_ASSERT_TRUE(j1939_dm1_find(&table, 0x00)->lamps.protect_lamp);
+    TEST_ASSERT_FALSE(j1939_dm1_process(&table, 0x00, data, sizeof(data), 2000000));
+}
+
+/*===========================================================================*/
+/*                        ADDRESS CLAIM TESTS                               */
+/*===========================================================================*/
+
+static void make_name(uint8_t* data, uint8_t function, uint8_t function_instance, uint32_t identity) {
+    uint64_t name = (uint64_t)identity |
+                    ((uint64_t)function_instance << 35) |
+                    ((uint64_t)function << 40) |
+                    (1ULL << 63);
+    for (uint8_t i = 0; i < 8; i++) {
+        data[i] = (uint8_t)(name >> (8 * i));
+    }
+}
+
+void test_addr_claim_resolves_function(void) {
+    j1939_addr_table_t table;
+    j1939_addr_init(&table);
+    TEST_ASSERT_EQUAL_HEX8(J1939_NULL_ADDRESS, j1939_addr_find(&table, J1939_FUNCTION_ENGINE, 0));
+
+    uint8_t engine[8];
+    uint8_t trans[8];
+    make_name(engine, J1939_FUNCTION_ENGINE, 0, 1234);
+    make_name(trans, J1939_FUNCTION_TRANSMISSION, 0, 5678);
+
+    TEST_ASSERT_TRUE(j1939_addr_process_claim(&table, 0x01, engine, 8));
+    TEST_ASSERT_TRUE(j1939_addr_process_claim(&table, 0x05, trans, 8));
+    TEST_ASSERT_FALSE(j1939_addr_process_claim(&table, 0x01, engine, 8));  // Re-claim
+
+    TEST_ASSERT_EQUAL_HEX8(0x01, j1939_addr_find(&table, J1939_FUNCTION_ENGINE, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x05, j1939_addr_find(&table, J1939_FUNCTION_TRANSMISSION, 0));
+
+    uint64_t name = 0;
+    TEST_ASSERT_TRUE(j1939_addr_get_name(&table, 0x01, &name));
+    TEST_ASSERT_EQUAL_UINT8(J1939_FUNCTION_ENGINE, j1939_name_get_function(name));
+    TEST_ASSERT_EQUAL_UINT32(1234, j1939_name_get_identity(name));
+    TEST_ASSERT_FALSE(j1939_addr_get_name(&table, 0x00, &name));
+
+    // A second engine beyond the O(1) instances is still found
+    uint8_t engine8[8];
+    make_name(engine8, J1939_FUNCTION_ENGINE, 7, 999);
+    j1939_addr_process_claim(&table, 0x02, engine8, 8);
+    TEST_ASSERT_EQUAL_HEX8(0x02, j1939_addr_find(&table, J1939_FUNCTION_ENGINE, 7));
+
+    j1939_addr_stats_t stats;
+    j1939_addr_get_stats(&table, &stats);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.claims);
+    TEST_ASSERT_EQUAL_UINT16(3, stats.claimed);
+}
+
+void test_addr_claim_moves_and_takeovers(void) {
+    j1939_addr_table_t table;
+    j1939_addr_init(&table);
+
+    uint8_t engine[8];
+    uint8_t brakes[8];
+    make_name(engine, J1939_FUNCTION_ENGINE, 0, 1234);
+    make_name(brakes, J1939_FUNCTION_BRAKES, 0, 42);
+
+    // The engine moves from 0x00 to 0x01
+    j1939_addr_process_claim(&table, 0x00, engine, 8);
+    j1939_addr_process_claim(&table, 0x01, engine, 8);
+    TEST_ASSERT_EQUAL_HEX8(0x01, j1939_addr_find(&table, J1939_FUNCTION_ENGINE, 0));
+    TEST_ASSERT_FALSE(j1939_addr_get_name(&table, 0x00, NULL));
+
+    // The brake controller wins 0x01; the engine gives up (Cannot Claim)
+    j1939_addr_process_claim(&table, 0x01, brakes, 8);
+    TEST_ASSERT_EQUAL_HEX8(J1939_NULL_ADDRESS, j1939_addr_find(&table, J1939_FUNCTION_ENGINE, 0));
+    TEST_ASSERT_EQUAL_HEX8(0x01, j1939_addr_find(&table, J1939_FUNCTION_BRAKES, 0));
+    TEST_ASSERT_FALSE(j1939_addr_process_claim(&table, J1939_NULL_ADDRESS, engine, 8));
+
+    // The brake controller cannot keep any address
+    TEST_ASSERT_TRUE(j1939_addr_process_claim(&table, J1939_NULL_ADDRESS, brakes, 8));
+    TEST_ASSERT_EQUAL_HEX8(J1939_NULL_ADDRESS, j1939_addr_find(&table, J1939_FUNCTION_BRAKES, 0));
+
+    j1939_addr_stats_t stats;
+    j1939_addr_get_stats(&table, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.moves);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.takeovers);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.cannot_claim);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.claimed);
+}
+
+void test_addr_accepts_by_function(void) {
+    j1939_addr_table_t table;
+    j1939_addr_init(&table);
+
+    // No claims yet: every address is accepted
+    TEST_ASSERT_TRUE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x00));
+    TEST_ASSERT_TRUE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x0F));
+
+    // A claimed retarder is not the engine, even before the engine claims
+    uint8_t name[8];
+    make_name(name, 13, 0, 7);
+    j1939_addr_process_claim(&table, 0x0F, name, 8);
+    TEST_ASSERT_FALSE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x0F));
+    TEST_ASSERT_TRUE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x00));
+
+    // Once the engine has claimed, only its address is
+    make_name(name, J1939_FUNCTION_ENGINE, 0, 1234);
+    j1939_addr_process_claim(&table, 0x01, name, 8);
+    TEST_ASSERT_TRUE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x01));
+    TEST_ASSERT_FALSE(j1939_addr_accepts(&table, J1939_FUNCTION_ENGINE, 0x00));
+    TEST_ASSERT_TRUE(j1939_addr_accepts(&table, J1939_FUNCTION_ANY, 0x00));
+}
+
+typedef struct {
+    uint8_t count;
+    uint32_t can_id;
+    uint8_t data[8];
+    bool refuse;
+} sent_claim_t;
+
+static bool capture_claim(uint32_t can_id, const uint8_t* data, uint8_t len, void* user) {
+    sent_claim_t* sent = (sent_claim_t*)user;
+    if (sent->refuse) return false;
+    sent->count++;
+    sent->can_id = can_id;
+    memcpy(sent->data, data, len);
+    return true;
+}
+
+void test_addr_claim_before_first_transmit(void) {
+    sent_claim_t sent = {};
+    j1939_addr_claim_t claim;
+    uint64_t our_name = 0x0000810000000001ULL;
+    j1939_addr_claim_init(&claim, our_name, 0xF9, capture_claim, &sent);
+    TEST_ASSERT_EQUAL_UINT8(0, sent.count);
+
+    // A failed send is retried on the next frame
+    sent.refuse = true;
+    TEST_ASSERT_FALSE(j1939_addr_claim_ready(&claim));
+    sent.refuse = false;
+    TEST_ASSERT_TRUE(j1939_addr_claim_ready(&claim));
+    TEST_ASSERT_TRUE(j1939_addr_claim_ready(&claim));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    TEST_ASSERT_EQUAL_HEX32(0x18EEFFF9, sent.can_id);
+    TEST_ASSERT_EQUAL_HEX8(0x01, sent.data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x81, sent.data[5]);
+
+    // Request for Address Claimed: global and to us answered, to others and other PGNs not
+    j1939_message_t msg;
+    uint8_t request_claim[3] = { 0x00, 0xEE, 0x00 };
+    uint8_t request_hours[3] = { 0xE5, 0xFE, 0x00 };
+    j1939_parse_frame(0x18EAFF00, request_claim, 3, 0, &msg);
+    TEST_ASSERT_TRUE(j1939_addr_claim_frame(&claim, &msg));
+    j1939_parse_frame(0x18EAF900, request_claim, 3, 0, &msg);
+    TEST_ASSERT_TRUE(j1939_addr_claim_frame(&claim, &msg));
+    j1939_parse_frame(0x18EA1700, request_claim, 3, 0, &msg);
+    TEST_ASSERT_FALSE(j1939_addr_claim_frame(&claim, &msg));
+    j1939_parse_frame(0x18EAFF00, request_hours, 3, 0, &msg);
+    TEST_ASSERT_FALSE(j1939_addr_claim_frame(&claim, &msg));
+    TEST_ASSERT_EQUAL_UINT8(3, sent.count);
+}
+
+void test_addr_claim_contention(void) {
+    sent_claim_t sent = {};
+    j1939_addr_claim_t claim;
+    j1939_addr_claim_init(&claim, 0x0000810000000010ULL, 0xF9, capture_claim, &sent);
+    TEST_ASSERT_TRUE(j1939_addr_claim_ready(&claim));
+
+    // A lower-priority NAME claims our address: we defend it
+    j1939_message_t msg;
+    uint8_t weaker[8] = { 0x20, 0, 0, 0, 0, 0x81, 0, 0 };
+    j1939_parse_frame(0x18EEFFF9, weaker, 8, 0, &msg);
+    TEST_ASSERT_TRUE(j1939_addr_claim_frame(&claim, &msg));
+    TEST_ASSERT_EQUAL_UINT8(2, sent.count);
+    TEST_ASSERT_EQUAL_HEX32(0x18EEFFF9, sent.can_id);
+    TEST_ASSERT_TRUE(j1939_addr_claim_ready(&claim));
+
+    // A higher-priority NAME takes it: Cannot Claim, then silence
+    uint8_t stronger[8] = { 0x01, 0, 0, 0, 0, 0x81, 0, 0 };
+    j1939_parse_frame(0x18EEFFF9, stronger, 8, 0, &msg);
+    TEST_ASSERT_TRUE(j1939_addr_claim_frame(&claim, &msg));
+    TEST_ASSERT_EQUAL_UINT8(3, sent.count);
+    TEST_ASSERT_EQUAL_HEX32(0x18EEFFFE, sent.can_id);
+    TEST_ASSERT_FALSE(j1939_addr_claim_ready(&claim));
+    TEST_ASSERT_EQUAL_UINT8(3, sent.count);
+
+    // Requests for Address Claimed still get Cannot Claim
+    uint8_t request_claim[3] = { 0x00, 0xEE, 0x00 };
+    j1939_parse_frame(0x18EAFF00, request_claim, 3, 0, &msg);
+    TEST_ASSERT_TRUE(j1939_addr_claim_frame(&claim, &msg));
+    TEST_ASSERT_EQUAL_HEX32(0x18EEFFFE, sent.can_id);
+    TEST_ASSERT_EQUAL_UINT32(2, claim.contentions);
+}
+
+/*===========================================================================*/
+/*                        REQUEST SCHEDULER TESTS                           */
+/*===========================================================================*/
+
+typedef struct {
+    uint8_t count;
+    uint32_t can_id;
+    uint32_t pgn;
+    bool refuse;
+} sent_requests_t;
+
+static bool capture_request(uint32_t can_id, const uint8_t* data, uint8_t len, void* user) {
+    sent_requests_t* sent = (sent_requests_t*)user;
+    if (sent->refuse) return false;
+    sent->count++;
+    sent->can_id = can_id;
+    sent->pgn = (len >= 3) ? (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) : 0;
+    return true;
+}
+
+#define MS(x) ((uint64_t)(x) * 1000ULL)
+
+void test_request_spreads_and_answers(void) {
+    sent_requests_t sent = {};
+    j1939_request_sched_t sched;
+    j1939_request_init(&sched, 0xF9, capture_request, &sent);
+
+    TEST_ASSERT_TRUE(j1939_request_add(&sched, 65253, J1939_GLOBAL_ADDRESS, 10000, 0));
+    TEST_ASSERT_TRUE(j1939_request_add(&sched, 65217, 0x00, 10000, 0));
+
+    // Both due: one goes now, the other after the gap
+    j1939_request_poll(&sched, MS(0));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    TEST_ASSERT_EQUAL_HEX32(0x18EAFFF9, sent.can_id);
+    TEST_ASSERT_EQUAL_UINT32(65253, sent.pgn);
+    j1939_request_poll(&sched, MS(J1939_REQUEST_GAP_MS - 1));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    j1939_request_poll(&sched, MS(J1939_REQUEST_GAP_MS));
+    TEST_ASSERT_EQUAL_UINT8(2, sent.count);
+    TEST_ASSERT_EQUAL_HEX32(0x18EA00F9, sent.can_id);  // Destination specific
+    TEST_ASSERT_EQUAL_UINT32(65217, sent.pgn);
+
+    // Answers: the global one from any ECU, the specific one only from its ECU
+    j1939_request_frame(&sched, 65253, 0x17, MS(30));
+    j1939_request_frame(&sched, 65217, 0x17, MS(J1939_REQUEST_GAP_MS + 10));
+    j1939_request_frame(&sched, 65217, 0x00, MS(J1939_REQUEST_GAP_MS + 20));
+
+    j1939_request_entry_t entry;
+    TEST_ASSERT_TRUE(j1939_request_get_entry(&sched, 0, &entry));
+    TEST_ASSERT_FALSE(entry.pending);
+    TEST_ASSERT_EQUAL_UINT32(30000, entry.rtt_last_us);
+    TEST_ASSERT_EQUAL_UINT64(MS(10000), entry.due_us);
+    TEST_ASSERT_TRUE(j1939_request_get_entry(&sched, 1, &entry));
+    TEST_ASSERT_EQUAL_UINT32(20000, entry.rtt_last_us);
+    TEST_ASSERT_EQUAL_UINT32(0, entry.unsolicited);  // VD from 0x17 is not the engine's
+
+    j1939_request_stats_t stats;
+    j1939_request_get_stats(&sched, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.answered);
+    TEST_ASSERT_EQUAL_UINT32(30000, stats.rtt_max_us);
+
+    // Nothing more until the period has passed
+    j1939_request_poll(&sched, MS(5000));
+    TEST_ASSERT_EQUAL_UINT8(2, sent.count);
+    j1939_request_poll(&sched, MS(10000));
+    TEST_ASSERT_EQUAL_UINT8(3, sent.count);
+}
+
+void test_request_backs_off_when_unanswered(void) {
+    sent_requests_t sent = {};
+    j1939_request_sched_t sched;
+    j1939_request_init(&sched, 0xF9, capture_request, &sent);
+    j1939_request_add(&sched, 65227, 0x00, 2000, 0);
+
+    j1939_request_poll(&sched, MS(0));
+    j1939_request_poll(&sched, MS(J1939_REQUEST_TIMEOUT_MS));
+
+    j1939_request_entry_t entry;
+    j1939_request_get_entry(&sched, 0, &entry);
+    TEST_ASSERT_FALSE(entry.pending);
+    TEST_ASSERT_EQUAL_UINT32(1, entry.timeouts);
+    TEST_ASSERT_EQUAL_UINT8(1, entry.backoff);
+    TEST_ASSERT_EQUAL_UINT64(MS(4000), entry.due_us);  // Period doubled
+
+    j1939_request_poll(&sched, MS(3999));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    j1939_request_poll(&sched, MS(4000));
+    TEST_ASSERT_EQUAL_UINT8(2, sent.count);
+
+    // A NACK (not supported) goes to the longest period
+    uint8_t nack[8] = { J1939_ACK_NEGATIVE, 0xFF, 0xFF, 0xFF, 0xF9, 0xCB, 0xFE, 0x00 };
+    j1939_request_ack(&sched, 0x00, nack, 8, MS(4010));
+    j1939_request_get_entry(&sched, 0, &entry);
+    TEST_ASSERT_EQUAL_UINT32(1, entry.nacks);
+    TEST_ASSERT_EQUAL_UINT8(J1939_REQUEST_MAX_BACKOFF, entry.backoff);
+    TEST_ASSERT_EQUAL_UINT64(MS(4000) + (MS(2000) << J1939_REQUEST_MAX_BACKOFF), entry.due_us);
+
+    // An answer restores the configured period
+    j1939_request_poll(&sched, entry.due_us);
+    j1939_request_frame(&sched, 65227, 0x00, entry.due_us + MS(5));
+    j1939_request_get_entry(&sched, 0, &entry);
+    TEST_ASSERT_EQUAL_UINT8(0, entry.backoff);
+    TEST_ASSERT_EQUAL_UINT32(3, entry.sent);
+    TEST_ASSERT_EQUAL_UINT64(entry.sent_us + MS(2000), entry.due_us);
+}
+
+void test_request_coalesces_consumers(void) {
+    sent_requests_t sent = {};
+    j1939_request_sched_t sched;
+    j1939_request_init(&sched, 0xF9, capture_request, &sent);
+
+    // Two consumers of HOURS share an entry at the shorter period
+    j1939_request_add(&sched, 65253, J1939_GLOBAL_ADDRESS, 60000, 0);
+    j1939_request_add(&sched, 65253, J1939_GLOBAL_ADDRESS, 10000, 0);
+    j1939_request_add(&sched, 65253, 0x00, 10000, 0);
+    TEST_ASSERT_EQUAL_UINT8(2, sched.count);
+
+    j1939_request_entry_t entry;
+    j1939_request_get_entry(&sched, 0, &entry);
+    TEST_ASSERT_EQUAL_UINT8(2, entry.consumers);
+    TEST_ASSERT_EQUAL_UINT32(10000, entry.period_ms);
+
+    // The pending global request covers the engine's entry
+    j1939_request_poll(&sched, MS(0));
+    j1939_request_poll(&sched, MS(J1939_REQUEST_GAP_MS));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    j1939_request_stats_t stats;
+    j1939_request_get_stats(&sched, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+
+    // Consumers leave one by one
+    TEST_ASSERT_TRUE(j1939_request_remove(&sched, 65253, J1939_GLOBAL_ADDRESS));
+    TEST_ASSERT_EQUAL_UINT8(2, sched.count);
+    TEST_ASSERT_TRUE(j1939_request_remove(&sched, 65253, J1939_GLOBAL_ADDRESS));
+    TEST_ASSERT_TRUE(j1939_request_remove(&sched, 65253, 0x00));
+    TEST_ASSERT_EQUAL_UINT8(0, sched.count);
+    TEST_ASSERT_FALSE(j1939_request_remove(&sched, 65253, 0x00));
+}
+
+void test_request_skips_broadcast_pgns(void) {
+    sent_requests_t sent = {};
+    j1939_request_sched_t sched;
+    j1939_request_init(&sched, 0xF9, capture_request, &sent);
+    j1939_request_add(&sched, 65217, J1939_GLOBAL_ADDRESS, 10000, 0);
+    j1939_request_add(&sched, 65259, J1939_GLOBAL_ADDRESS, 0, 0);
+
+    // VD and component ID show up on their own before the first poll
+    j1939_request_frame(&sched, 65217, 0x00, MS(1));
+    j1939_request_frame(&sched, 65259, 0x00, MS(1));
+    TEST_ASSERT_EQUAL_UINT8(1, sched.count);  // The one-shot is satisfied and freed
+    for (uint32_t t = 0; t < 10000; t += 100) {
+        j1939_request_poll(&sched, MS(t));
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, sent.count);
+    j1939_request_poll(&sched, MS(10001));
+    TEST_ASSERT_EQUAL_UINT8(1, sent.count);
+    TEST_ASSERT_EQUAL_UINT32(65217, sent.pgn);
+
+    // Unanswered: next request at twice the period; a refused transmit
+    // is retried after the gap
+    sent.refuse = true;
+    j1939_request_poll(&sched, MS(30001));
+    sent.refuse = false;
+    j1939_request_stats_t stats;
+    j1939_request_get_stats(&sched, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.tx_failed);
+    j1939_request_poll(&sched, MS(30001 + J1939_REQUEST_GAP_MS));
+    TEST_ASSERT_EQUAL_UINT8(2, sent.count);
+}
+
+/*===========================================================================*/
+/*                        DIAGNOSTIC CAPTURE TESTS                          */
+/*===========================================================================*/
+
+void test_diag_parse_dm4_freeze_frames(void) {
+    uint8_t dm4[] = {
+        // SPN 110 FMI 0, OC 3: standard parameters
+        0x0C, 0x6E, 0x00, 0x00, 0x03,
+        0xF1, 100, 0x80, 0x3E, 50, 130, 0x00, 0x5A,
+        // SPN 100 FMI 1, OC 1: parameters not available, 2 manufacturer bytes
+        0x0E, 0x64, 0x00, 0x01, 0x01,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xAA, 0xBB
+    };
+    j1939_freeze_frame_t frames[4];
+
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_parse_dm4(dm4, sizeof(dm4), frames, 4));
+    TEST_ASSERT_EQUAL_UINT32(110, frames[0].dtc.spn);
+    TEST_ASSERT_EQUAL_UINT8(0, frames[0].dtc.fmi);
+    TEST_ASSERT_EQUAL_UINT8(3, frames[0].dtc.oc);
+    TEST_ASSERT_EQUAL_UINT8(8, frames[0].snapshot_length);
+    TEST_ASSERT_EQUAL_UINT32(100, frames[1].dtc.spn);
+    TEST_ASSERT_EQUAL_UINT8(1, frames[1].dtc.fmi);
+    TEST_ASSERT_EQUAL_UINT8(8, frames[1].snapshot_length);  // Manufacturer bytes dropped
+
+    // A record running past the payload ends the parse
+    TEST_ASSERT_EQUAL_UINT8(1, j1939_parse_dm4(dm4, 20, frames, 4));
+    TEST_ASSERT_EQUAL_UINT8(1, j1939_parse_dm4(dm4, sizeof(dm4), frames, 1));
+}
+
+void test_diag_freeze_frame_decodes_through_signal_table(void) {
+    const uint8_t snapshot[] = { 0xF1, 100, 0x80, 0x3E, 50, 130, 0x00, 0x5A };
+    const uint8_t blank[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    float value;
+
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 899, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 102, &value));
+    ASSERT_FLOAT_NEAR(200.0f, value);
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 190, &value));
+    ASSERT_FLOAT_NEAR(2000.0f, value);
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 92, &value));
+    ASSERT_FLOAT_NEAR(50.0f, value);
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 110, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 8, 84, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+
+    // Not available, not captured, not a freeze frame parameter
+    TEST_ASSERT_FALSE(j1939_freeze_frame_decode(blank, 8, 110, &value));
+    TEST_ASSERT_FALSE(j1939_freeze_frame_decode(snapshot, 4, 110, &value));
+    TEST_ASSERT_TRUE(j1939_freeze_frame_decode(snapshot, 4, 190, &value));
+    TEST_ASSERT_FALSE(j1939_freeze_frame_decode(snapshot, 8, 91, &value));
+
+    uint8_t count;
+    const uint16_t* spns = j1939_freeze_frame_get_spns(&count);
+    TEST_ASSERT_EQUAL_UINT8(6, count);
+    TEST_ASSERT_EQUAL_UINT16(899, spns[0]);
+}
+
+void test_diag_capture_requests_and_hands_over(void) {
+    sent_requests_t sent = {};
+    j1939_request_sched_t sched;
+    j1939_diag_t diag;
+    j1939_request_init(&sched, 0xF9, capture_request, &sent);
+    j1939_diag_init(&diag, &sched);
+
+    // Two new faults of one ECU: one capture
+    TEST_ASSERT_TRUE(j1939_diag_capture(&diag, 0x00, MS(0)));
+    TEST_ASSERT_TRUE(j1939_diag_capture(&diag, 0x00, MS(5)));
+    TEST_ASSERT_EQUAL_UINT8(2, sched.count);
+
+    j1939_request_poll(&sched, MS(10));
+    TEST_ASSERT_EQUAL_HEX32(0x18EA00F9, sent.can_id);
+    TEST_ASSERT_EQUAL_UINT32(PGN_DM4, sent.pgn);
+    j1939_request_poll(&sched, MS(10 + J1939_REQUEST_GAP_MS));
+    TEST_ASSERT_EQUAL_UINT32(PGN_DM2, sent.pgn);
+
+    uint8_t dm4[] = { 0x07, 0x6E, 0x00, 0x00, 0x03, 0xF1, 100, 0x80 };
+    uint8_t dm2[] = { 0x00, 0xFF, 0x64, 0x00, 0x01, 0x02, 0xFF, 0xFF };
+    uint8_t dm2_none[] = { 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+    TEST_ASSERT_TRUE(j1939_diag_payload(&diag, PGN_DM4, 0x00, dm4, sizeof(dm4), MS(30)));
+
+    j1939_diag_job_t job;
+    TEST_ASSERT_FALSE(j1939_diag_take(&diag, &job));  // DM2 still outstanding
+    TEST_ASSERT_FALSE(j1939_diag_payload(&diag, PGN_DM2, 0x17, dm2_none, sizeof(dm2_none), MS(80)));
+    TEST_ASSERT_FALSE(j1939_diag_payload(&diag, 65226, 0x00, dm2, sizeof(dm2), MS(80)));
+    TEST_ASSERT_TRUE(j1939_diag_payload(&diag, PGN_DM2, 0x00, dm2, sizeof(dm2), MS(90)));
+    TEST_ASSERT_EQUAL_UINT8(0, sched.count);  // Requests released
+
+    TEST_ASSERT_TRUE(j1939_diag_take(&diag, &job));
+    TEST_ASSERT_EQUAL_UINT8(0x00, job.source_address);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(dm4), job.dm4_length);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(dm2), job.dm2_length);
+    TEST_ASSERT_EQUAL_MEMORY(dm2, job.dm2, sizeof(dm2));
+    TEST_ASSERT_EQUAL_UINT64(MS(90), job.completed_us);
+    TEST_ASSERT_FALSE(j1939_diag_take(&diag, &job));
+
+    j1939_diag_stats_t stats;
+    j1939_diag_get_stats(&diag, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.started);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.completed);
+}
+
+void test_diag_capture_times_out_with_partial_data(void) {
+    j1939_request_sched_t sched;
+    j1939_diag_t diag;
+    j1939_request_init(&sched, 0xF9, NULL, NULL);
+    j1939_diag_init(&diag, &sched);
+
+    for (uint8_t sa = 0; sa < J1939_DIAG_MAX_JOBS; sa++) {
+        TEST_ASSERT_TRUE(j1939_diag_capture(&diag, sa, MS(0)));
+    }
+    TEST_ASSERT_FALSE(j1939_diag_capture(&diag, 0x30, MS(0)));  // No free job
+
+    // An oversized reply keeps its first J1939_DIAG_BUFFER bytes
+    uint8_t dm4[J1939_DIAG_BUFFER + 16];
+    memset(dm4, 0xFF, sizeof(dm4));
+    TEST_ASSERT_TRUE(j1939_diag_payload(&diag, PGN_DM4, 0x00, dm4, sizeof(dm4), MS(100)));
+
+    j1939_diag_job_t job;
+    j1939_diag_poll(&diag, MS(J1939_DIAG_TIMEOUT_MS - 1));
+    TEST_ASSERT_FALSE(j1939_diag_take(&diag, &job));
+    j1939_diag_poll(&diag, MS(J1939_DIAG_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT8(0, sched.count);
+
+    uint8_t taken = 0;
+    while (j1939_diag_take(&diag, &job)) {
+        if (job.source_address == 0x00) {
+            TEST_ASSERT_TRUE(job.dm4_received);
+            TEST_ASSERT_EQUAL_UINT16(J1939_DIAG_BUFFER, job.dm4_length);
+        } else {
+            TEST_ASSERT_FALSE(job.dm4_received);
+        }
+        TEST_ASSERT_FALSE(job.dm2_received);
+        taken++;
+    }
+    TEST_ASSERT_EQUAL_UINT8(J1939_DIAG_MAX_JOBS, taken);
+
+    // Slots are free again
+    TEST_ASSERT_TRUE(j1939_diag_capture(&diag, 0x30, MS(J1939_DIAG_TIMEOUT_MS)));
+
+    j1939_diag_stats_t stats;
+    j1939_diag_get_stats(&diag, &stats);
+    TEST_ASSERT_EQUAL_UINT32(J1939_DIAG_MAX_JOBS, stats.incomplete);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.truncated);
+}
+
+void test_diag_capture_refused_when_requests_do_not_fit(void) {
+    j1939_request_sched_t sched;
+    j1939_diag_t diag;
+    j1939_request_init(&sched, 0xF9, NULL, NULL);
+    j1939_diag_init(&diag, &sched);
+
+    // One free entry: DM4 fits, DM2 does not
+    for (uint8_t i = 0; i < J1939_REQUEST_MAX_ENTRIES - 1; i++) {
+        TEST_ASSERT_TRUE(j1939_request_add(&sched, 65000 + i, J1939_GLOBAL_ADDRESS, 1000, 0));
+    }
+    TEST_ASSERT_FALSE(j1939_diag_capture(&diag, 0x00, MS(0)));
+    TEST_ASSERT_EQUAL_UINT8(J1939_REQUEST_MAX_ENTRIES - 1, sched.count);  // DM4 released
+
+    j1939_diag_stats_t stats;
+    j1939_diag_get_stats(&diag, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.started);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.unrequested);
+
+    // Room again: the capture starts, and its answered requests free their entries
+    j1939_request_remove(&sched, 65000, J1939_GLOBAL_ADDRESS);
+    TEST_ASSERT_TRUE(j1939_diag_capture(&diag, 0x00, MS(10)));
+    TEST_ASSERT_EQUAL_UINT8(J1939_REQUEST_MAX_ENTRIES, sched.count);
+    j1939_request_frame(&sched, PGN_DM4, 0x00, MS(20));
+    TEST_ASSERT_EQUAL_UINT8(J1939_REQUEST_MAX_ENTRIES - 1, sched.count);
+}
+
+void test_diag_unsolicited_dm2_is_handed_over(void) {
+    j1939_diag_t diag;
+    j1939_diag_init(&diag, NULL);
+
+    // Answers to the global DM2 request: only one with faults is kept
+    uint8_t dm2[] = { 0x00, 0xFF, 0x64, 0x00, 0x01, 0x02, 0xFF, 0xFF };
+    uint8_t dm2_none[] = { 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+    TEST_ASSERT_FALSE(j1939_diag_payload(&diag, PGN_DM2, 0x03, dm2_none, sizeof(dm2_none), MS(10)));
+    TEST_ASSERT_TRUE(j1939_diag_payload(&diag, PGN_DM2, 0x00, dm2, sizeof(dm2), MS(20)));
+    TEST_ASSERT_FALSE(j1939_diag_payload(&diag, PGN_DM4, 0x00, dm2, sizeof(dm2), MS(20)));
+
+    j1939_diag_job_t job;
+    TEST_ASSERT_TRUE(j1939_diag_take(&diag, &job));
+    TEST_ASSERT_EQUAL_UINT8(0x00, job.source_address);
+    TEST_ASSERT_TRUE(job.dm2_received);
+    TEST_ASSERT_FALSE(job.dm4_received);
+    TEST_ASSERT_EQUAL_MEMORY(dm2, job.dm2, sizeof(dm2));
+    TEST_ASSERT_EQUAL_UINT64(MS(20), job.started_us);
+    TEST_ASSERT_FALSE(j1939_diag_take(&diag, &job));
+
+    // Every slot taken: the next one is dropped
+    for (uint8_t sa = 0; sa < J1939_DIAG_MAX_JOBS; sa++) {
+        TEST_ASSERT_TRUE(j1939_diag_payload(&diag, PGN_DM2, sa, dm2, sizeof(dm2), MS(30)));
+    }
+    TEST_ASSERT_FALSE(j1939_diag_payload(&diag, PGN_DM2, 0x30, dm2, sizeof(dm2), MS(30)));
+
+    j1939_diag_stats_t stats;
+    j1939_diag_get_stats(&diag, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1 + J1939_DIAG_MAX_JOBS, stats.unsolicited);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.started);
+}
+
 /*===========================================================================*/
 /*                        FRAME PARSING TESTS                               */
 /*===========================================================================*/
@@ -382,6 +1089,21 @@ void test_parse_frame_basic(void) {
     TEST_ASSERT_EQUAL_UINT8(8, msg.data_length);
 }
 
+void test_parse_frame_us_timestamp(void) {
+    uint8_t data[8] = {0x8C, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg;
+    
+    // Past the 32-bit microsecond wrap (~71.6 minutes)
+    uint64_t timestamp_us = 5000000000ULL + 123;
+    
+    TEST_ASSERT_TRUE(j1939_parse_frame_us(0x18FEEE00, data, 8, timestamp_us, &msg));
+    TEST_ASSERT_EQUAL_UINT64(timestamp_us, msg.timestamp_us);
+    TEST_ASSERT_EQUAL_UINT32(5000000, msg.timestamp_ms);
+    
+    TEST_ASSERT_TRUE(j1939_parse_frame(0x18FEEE00, data, 8, 1000, &msg));
+    TEST_ASSERT_EQUAL_UINT64(1000000ULL, msg.timestamp_us);
+}
+
 void test_parse_frame_null_data(void) {
     j1939_message_t msg;
     bool result = j1939_parse_frame(0x18FEEE00, NULL, 8, 1000, &msg);
@@ -415,6 +1137,747 @@ void test_parser_init(void) {
     }
 }
 
+/*===========================================================================*/
+/*                        TRANSPORT PROTOCOL TESTS                          */
+/*===========================================================================*/
+
+static j1939_message_t make_tp_msg(uint32_t pgn, uint8_t sa, uint32_t ts,
+                                   const uint8_t* data) {
+    j1939_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.pgn = pgn;
+    msg.source_address = sa;
+    msg.destination = 0xFF;
+    msg.data_length = 8;
+    msg.timestamp_ms = ts;
+    memcpy(msg.data, data, 8);
+    return msg;
+}
+
+void test_tp_bam_interleaved_sources(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+
+    // Two BAM announcements of DM1 (10 bytes, 2 packets) from SA 0x00 and 0x03
+    uint8_t bam[8] = {TP_CM_BAM, 10, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x00, 0, bam);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_tp_msg(PGN_TP_CM, 0x03, 0, bam);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+
+    uint8_t dt_a1[8] = {1, 0x00, 0x00, 0x64, 0x00, 0x03, 0x01, 0xAA};
+    uint8_t dt_b1[8] = {1, 0x04, 0x00, 0x6E, 0x00, 0x00, 0x02, 0xBB};
+    uint8_t dt_a2[8] = {2, 0x11, 0x22, 0x33, 0xFF, 0xFF, 0xFF, 0xFF};
+    uint8_t dt_b2[8] = {2, 0x44, 0x55, 0x66, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 50, dt_a1);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_tp_msg(PGN_TP_DT, 0x03, 55, dt_b1);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_tp_msg(PGN_TP_DT, 0x03, 100, dt_b2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 105, dt_a2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+
+    uint8_t buffer[16];
+    uint32_t pgn = 0;
+
+    TEST_ASSERT_EQUAL_UINT16(10, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(65226, pgn);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, buffer[6]);
+    TEST_ASSERT_EQUAL_HEX8(0x33, buffer[9]);
+
+    TEST_ASSERT_EQUAL_UINT16(10, j1939_tp_get_data(&ctx, 0x03, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_HEX8(0xBB, buffer[6]);
+    TEST_ASSERT_EQUAL_HEX8(0x66, buffer[9]);
+
+    // Sessions released: nothing left for either source
+    TEST_ASSERT_EQUAL_UINT16(0, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(2, ctx.tp_complete_count);
+}
+
+void test_tp_dt_without_bam_ignored(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+
+    uint8_t dt[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+    j1939_message_t msg = make_tp_msg(PGN_TP_DT, 0x17, 0, dt);
+
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.tp_complete_count);
+}
+
+void test_tp_session_limit(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+
+    uint8_t bam[8] = {TP_CM_BAM, 10, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    for (uint8_t sa = 0; sa < J1939_MAX_ACTIVE_TP; sa++) {
+        j1939_message_t msg = make_tp_msg(PGN_TP_CM, sa, 0, bam);
+        j1939_tp_handle_frame(&ctx, &msg);
+    }
+
+    // All sessions busy: a further source gets no session
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x80, 0, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    uint8_t dt[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+    msg = make_tp_msg(PGN_TP_DT, 0x80, 10, dt);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.tp_session_by_sa[0x80]);
+}
+
+static void send_bam(j1939_parser_context_t* ctx, uint8_t sa, uint16_t size) {
+    uint8_t packets = (uint8_t)((size + 6) / 7);
+    uint8_t bam[8] = {TP_CM_BAM, (uint8_t)(size & 0xFF), (uint8_t)(size >> 8), packets,
+                      0xFF, 0xCA, 0xFE, 0x00};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, sa, 0, bam);
+    j1939_tp_handle_frame(ctx, &msg);
+}
+
+void test_tp_pool_sized_by_bam(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    j1939_tp_pool_stats_t stats;
+
+    send_bam(&ctx, 0x00, 40);                          // 1 block
+    send_bam(&ctx, 0x03, J1939_TP_BLOCK_SIZE + 1);     // 2 blocks
+    send_bam(&ctx, 0x17, J1939_TP_MAX_LENGTH);         // Largest transfer
+    j1939_tp_get_pool_stats(&ctx, &stats);
+
+    uint16_t max_blocks = (J1939_TP_MAX_LENGTH + J1939_TP_BLOCK_SIZE - 1) / J1939_TP_BLOCK_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(3, stats.allocations);
+    TEST_ASSERT_EQUAL_UINT16(3 + max_blocks, stats.blocks_in_use);
+    TEST_ASSERT_EQUAL_UINT8(3, stats.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT16(J1939_TP_POOL_BLOCKS - 3 - max_blocks, stats.largest_free_run);
+
+    // Completing the 40-byte transfer hands its block back
+    for (uint8_t seq = 1; seq <= 6; seq++) {
+        uint8_t dt[8] = {seq, seq, seq, seq, seq, seq, seq, seq};
+        j1939_message_t msg = make_tp_msg(PGN_TP_DT, 0x00, 10 * seq, dt);
+        TEST_ASSERT_EQUAL(seq == 6, j1939_tp_handle_frame(&ctx, &msg));
+    }
+    uint8_t buffer[64];
+    uint32_t pgn;
+    TEST_ASSERT_EQUAL_UINT16(40, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT8(6, buffer[39]);
+
+    j1939_tp_get_pool_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT16(2 + max_blocks, stats.blocks_in_use);
+    TEST_ASSERT_EQUAL_UINT8(2, stats.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT8(3, stats.sessions_high_water);
+}
+
+void test_tp_pool_exhaustion_and_fragmentation(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    j1939_tp_pool_stats_t stats;
+
+    // Three single-block transfers, then large ones until the pool is full
+    send_bam(&ctx, 1, 20);
+    send_bam(&ctx, 2, 20);
+    send_bam(&ctx, 3, 20);
+    uint16_t remaining = J1939_TP_POOL_BLOCKS - 3;
+    uint8_t sa = 0x10;
+    while (remaining > 0) {
+        uint16_t chunk = J1939_TP_MAX_LENGTH / J1939_TP_BLOCK_SIZE;
+        if (chunk > remaining) chunk = remaining;
+        send_bam(&ctx, sa++, chunk * J1939_TP_BLOCK_SIZE);
+        remaining -= chunk;
+    }
+    j1939_tp_get_pool_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT16(J1939_TP_POOL_BLOCKS, stats.blocks_in_use);
+
+    // Nothing left: a new transfer is refused as exhaustion
+    send_bam(&ctx, 0xB0, 20);
+    j1939_tp_get_pool_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.exhausted);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.tp_session_by_sa[0xB0]);
+
+    // Free two non-adjacent single blocks: 2 free, but no run of 2
+    uint8_t bad_dt[8] = {9, 0, 0, 0, 0, 0, 0, 0};
+    j1939_message_t msg = make_tp_msg(PGN_TP_DT, 1, 10, bad_dt);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 3, 10, bad_dt);
+    j1939_tp_handle_frame(&ctx, &msg);
+
+    send_bam(&ctx, 0xB1, J1939_TP_BLOCK_SIZE + 1);
+    j1939_tp_get_pool_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fragmented);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.largest_free_run);
+
+    // A single-block transfer still fits
+    send_bam(&ctx, 0xB2, 20);
+    TEST_ASSERT_NOT_EQUAL(0, ctx.tp_session_by_sa[0xB2]);
+}
+
+void test_tp_bam_invalid_size_rejected(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    j1939_tp_pool_stats_t stats;
+
+    send_bam(&ctx, 0x00, 8);                            // Fits one frame: not TP
+    send_bam(&ctx, 0x01, J1939_TP_MAX_LENGTH + 1);
+    j1939_tp_get_pool_stats(&ctx, &stats);
+
+    TEST_ASSERT_EQUAL_UINT32(2, stats.rejected_size);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.blocks_in_use);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.sessions_in_use);
+}
+
+// Last payload seen by capture_tp_payload
+static j1939_tp_payload_t g_tp_payload;
+static uint8_t g_tp_payload_last;
+static uint8_t g_tp_payload_calls;
+
+static void capture_tp_payload(const j1939_tp_payload_t* payload, void* user) {
+    (void)user;
+    g_tp_payload = *payload;
+    g_tp_payload_last = payload->data[payload->length - 1];
+    g_tp_payload_calls++;
+}
+
+void test_tp_deliver_full_size_in_place(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    g_tp_payload_calls = 0;
+
+    // Largest transfer J1939-21 allows: 255 packets, 1785 bytes
+    send_bam(&ctx, 0x00, J1939_TP_MAX_LENGTH);
+    j1939_message_t msg;
+    for (uint16_t seq = 1; seq <= 255; seq++) {
+        uint8_t dt[8] = {(uint8_t)seq, 0, 0, 0, 0, 0, 0, (uint8_t)(seq ^ 0x5A)};
+        msg = make_tp_msg(PGN_TP_DT, 0x00, (uint32_t)seq, dt);
+        TEST_ASSERT_EQUAL(seq == 255, j1939_tp_handle_frame(&ctx, &msg));
+    }
+    msg.timestamp_us = 255123;
+
+    TEST_ASSERT_TRUE(j1939_tp_deliver(&ctx, &msg, capture_tp_payload, NULL));
+    TEST_ASSERT_EQUAL_UINT8(1, g_tp_payload_calls);
+    TEST_ASSERT_EQUAL_UINT16(J1939_TP_MAX_LENGTH, g_tp_payload.length);
+    TEST_ASSERT_EQUAL_UINT32(65226, g_tp_payload.pgn);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, g_tp_payload.destination);
+    TEST_ASSERT_EQUAL_UINT8(255 ^ 0x5A, g_tp_payload_last);
+    TEST_ASSERT_EQUAL_UINT64(255123, g_tp_payload.timestamp_us);
+
+    // The view pointed into the pool: nothing was copied out
+    TEST_ASSERT_TRUE(g_tp_payload.data >= ctx.tp_pool &&
+                     g_tp_payload.data < ctx.tp_pool + sizeof(ctx.tp_pool));
+
+    // Released once the consumer returned
+    j1939_tp_pool_stats_t stats;
+    j1939_tp_get_pool_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.blocks_in_use);
+    TEST_ASSERT_FALSE(j1939_tp_deliver(&ctx, &msg, capture_tp_payload, NULL));
+    TEST_ASSERT_EQUAL_UINT8(1, g_tp_payload_calls);
+}
+
+// Control frames sent by the TP engine (the last 16 are kept)
+static uint32_t g_tp_sent_ids[16];
+static uint8_t g_tp_sent[16][8];
+static uint32_t g_tp_sent_count;
+
+static bool capture_tp_send(uint32_t can_id, const uint8_t* data, uint8_t len, void* user) {
+    (void)user;
+    if (len == 8) {
+        g_tp_sent_ids[g_tp_sent_count % 16] = can_id;
+        memcpy(g_tp_sent[g_tp_sent_count % 16], data, 8);
+        g_tp_sent_count++;
+    }
+    return true;
+}
+
+static void init_cmdt(j1939_parser_context_t* ctx) {
+    j1939_parser_init(ctx);
+    j1939_tp_set_local_address(ctx, 0xF9, capture_tp_send, NULL);
+    g_tp_sent_count = 0;
+}
+
+static j1939_message_t make_cmdt_msg(uint32_t pgn, uint8_t sa, uint8_t da, uint32_t ts,
+                                     const uint8_t* data) {
+    j1939_message_t msg = make_tp_msg(pgn, sa, ts, data);
+    msg.destination = da;
+    return msg;
+}
+
+void test_tp_rts_cts_windows_and_eom(void) {
+    static j1939_parser_context_t ctx;
+    init_cmdt(&ctx);
+
+    // 30 bytes of DM2 (PGN 65227) in 5 packets, at most 2 per CTS
+    uint8_t rts[8] = {TP_CM_RTS, 30, 0, 5, 2, 0xCB, 0xFE, 0x00};
+    j1939_message_t msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 0, rts);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+
+    TEST_ASSERT_EQUAL_UINT8(1, g_tp_sent_count);
+    TEST_ASSERT_EQUAL_HEX32(0x1CEC00F9, g_tp_sent_ids[0]);  // TP.CM to SA 0x00 from us
+    uint8_t cts1[8] = {TP_CM_CTS, 2, 1, 0xFF, 0xFF, 0xCB, 0xFE, 0x00};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(cts1, g_tp_sent[0], 8);
+
+    for (uint8_t seq = 1; seq <= 5; seq++) {
+        uint8_t dt[8] = {seq, seq, seq, seq, seq, seq, seq, seq};
+        msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 10 * seq, dt);
+        TEST_ASSERT_EQUAL(seq == 5, j1939_tp_handle_frame(&ctx, &msg));
+    }
+
+    // CTS for packets 3-4, CTS for 5, then the EOM acknowledge
+    TEST_ASSERT_EQUAL_UINT8(4, g_tp_sent_count);
+    uint8_t cts2[8] = {TP_CM_CTS, 2, 3, 0xFF, 0xFF, 0xCB, 0xFE, 0x00};
+    uint8_t cts3[8] = {TP_CM_CTS, 1, 5, 0xFF, 0xFF, 0xCB, 0xFE, 0x00};
+    uint8_t eom[8] = {TP_CM_EOM, 30, 0, 5, 0xFF, 0xCB, 0xFE, 0x00};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(cts2, g_tp_sent[1], 8);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(cts3, g_tp_sent[2], 8);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(eom, g_tp_sent[3], 8);
+
+    uint8_t buffer[64];
+    uint32_t pgn;
+    TEST_ASSERT_EQUAL_UINT16(30, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(65227, pgn);
+    TEST_ASSERT_EQUAL_UINT8(5, buffer[29]);
+
+    j1939_tp_conn_stats_t stats;
+    j1939_tp_get_conn_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.cts_sent);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.completed);
+}
+
+void test_tp_bam_and_connection_from_same_source(void) {
+    static j1939_parser_context_t ctx;
+    init_cmdt(&ctx);
+
+    uint8_t bam[8] = {TP_CM_BAM, 10, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    uint8_t rts[8] = {TP_CM_RTS, 10, 0, 2, 0xFF, 0xEB, 0xFE, 0x00};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x00, 0, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 0, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+
+    // Interleaved packets of both transfers complete independently
+    uint8_t dt1[8] = {1, 0xA1, 0xA1, 0xA1, 0xA1, 0xA1, 0xA1, 0xA1};
+    uint8_t dt2[8] = {2, 0xA2, 0xA2, 0xA2, 0xFF, 0xFF, 0xFF, 0xFF};
+    msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 5, dt1);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 6, dt1);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 7, dt2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+
+    uint8_t buffer[16];
+    uint32_t pgn;
+    TEST_ASSERT_EQUAL_UINT16(10, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(65259, pgn);
+
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 8, dt2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+    TEST_ASSERT_EQUAL_UINT16(10, j1939_tp_get_data(&ctx, 0x00, &pgn, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT32(65226, pgn);
+}
+
+void test_tp_short_packet_count_padded(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    g_tp_payload_calls = 0;
+
+    // 23 bytes announced in 3 packets (21 bytes), as some ECUs send it;
+    // leave stale data in the pool to prove the tail is filled
+    memset(ctx.tp_pool, 0x00, sizeof(ctx.tp_pool));
+    uint8_t bam[8] = {TP_CM_BAM, 23, 0, 3, 0xFF, 0xEB, 0xFE, 0x00};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x00, 0, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    for (uint8_t seq = 1; seq <= 3; seq++) {
+        uint8_t dt[8] = {seq, seq, seq, seq, seq, seq, seq, seq};
+        msg = make_tp_msg(PGN_TP_DT, 0x00, 10 * seq, dt);
+        TEST_ASSERT_EQUAL(seq == 3, j1939_tp_handle_frame(&ctx, &msg));
+    }
+
+    TEST_ASSERT_TRUE(j1939_tp_deliver(&ctx, &msg, capture_tp_payload, NULL));
+    TEST_ASSERT_EQUAL_UINT16(23, g_tp_payload.length);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, g_tp_payload_last);
+}
+
+void test_tp_deliver_picks_session_by_destination(void) {
+    static j1939_parser_context_t ctx;
+    init_cmdt(&ctx);
+    g_tp_payload_calls = 0;
+
+    // A broadcast completes and is left pending, then a connection completes
+    uint8_t bam[8] = {TP_CM_BAM, 10, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    uint8_t rts[8] = {TP_CM_RTS, 10, 0, 2, 0xFF, 0xEB, 0xFE, 0x00};
+    uint8_t dt1[8] = {1, 1, 2, 3, 4, 5, 6, 7};
+    uint8_t dt2[8] = {2, 8, 9, 10, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x00, 0, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 5, dt1);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x00, 6, dt2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+
+    msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 10, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 15, dt1);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 16, dt2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+
+    // The completing frame selects the connection, not the older broadcast
+    TEST_ASSERT_TRUE(j1939_tp_deliver(&ctx, &msg, capture_tp_payload, NULL));
+    TEST_ASSERT_EQUAL_UINT32(65259, g_tp_payload.pgn);
+    TEST_ASSERT_EQUAL_UINT8(0xF9, g_tp_payload.destination);
+    TEST_ASSERT_EQUAL_UINT16(10, g_tp_payload.length);
+    TEST_ASSERT_EQUAL_UINT8(10, g_tp_payload_last);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.tp_conn_by_sa[0x00]);
+    TEST_ASSERT_NOT_EQUAL(0, ctx.tp_session_by_sa[0x00]);
+}
+
+void test_tp_connection_abort_and_timeout(void) {
+    static j1939_parser_context_t ctx;
+    init_cmdt(&ctx);
+    j1939_tp_pool_stats_t pool;
+
+    // Sender aborts: session and blocks released, nothing sent back
+    uint8_t rts[8] = {TP_CM_RTS, 20, 0, 3, 0xFF, 0xCB, 0xFE, 0x00};
+    j1939_message_t msg = make_cmdt_msg(PGN_TP_CM, 0x03, 0xF9, 0, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    uint8_t abort_msg[8] = {TP_CM_ABORT, 2, 0xFF, 0xFF, 0xFF, 0xCB, 0xFE, 0x00};
+    msg = make_cmdt_msg(PGN_TP_CM, 0x03, 0xF9, 10, abort_msg);
+    j1939_tp_handle_frame(&ctx, &msg);
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT8(0, pool.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT8(1, g_tp_sent_count);  // Only the CTS
+
+    // No first packet within T2: the timer aborts without any further frame
+    msg = make_cmdt_msg(PGN_TP_CM, 0x03, 0xF9, 1000, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    j1939_tp_poll(&ctx, 1000 + J1939_TP_T2_MS - 1);
+    TEST_ASSERT_EQUAL_UINT8(2, g_tp_sent_count);
+    j1939_tp_poll(&ctx, 1000 + J1939_TP_T2_MS + J1939_TP_WHEEL_TICK_MS);  // One tick resolution
+    TEST_ASSERT_EQUAL_UINT8(3, g_tp_sent_count);
+    TEST_ASSERT_EQUAL_UINT8(TP_CM_ABORT, g_tp_sent[2][0]);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_TIMEOUT, g_tp_sent[2][1]);
+
+    j1939_tp_conn_stats_t stats;
+    j1939_tp_get_conn_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.aborts_received);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT16(0, pool.blocks_in_use);
+}
+
+void test_tp_connection_refusals(void) {
+    static j1939_parser_context_t ctx;
+    init_cmdt(&ctx);
+
+    // Addressed to another node: not ours, no reply
+    uint8_t rts[8] = {TP_CM_RTS, 20, 0, 3, 0xFF, 0xCB, 0xFE, 0x00};
+    j1939_message_t msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0x17, 0, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    TEST_ASSERT_EQUAL_UINT8(0, g_tp_sent_count);
+
+    // Second PGN from a sender with an open connection: busy
+    msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 0, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    uint8_t rts2[8] = {TP_CM_RTS, 20, 0, 3, 0xFF, 0xDA, 0xFE, 0x00};
+    msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 5, rts2);
+    j1939_tp_handle_frame(&ctx, &msg);
+    TEST_ASSERT_EQUAL_UINT8(2, g_tp_sent_count);
+    TEST_ASSERT_EQUAL_UINT8(TP_CM_ABORT, g_tp_sent[1][0]);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_BUSY, g_tp_sent[1][1]);
+    TEST_ASSERT_EQUAL_UINT8(0xDA, g_tp_sent[1][5]);
+
+    // Out-of-window packet aborts with a sequence error
+    uint8_t dt[8] = {2, 0, 0, 0, 0, 0, 0, 0};
+    msg = make_cmdt_msg(PGN_TP_DT, 0x00, 0xF9, 10, dt);
+    TEST_ASSERT_FALSE(j1939_tp_handle_frame(&ctx, &msg));
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_BAD_SEQUENCE, g_tp_sent[2][1]);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.tp_conn_by_sa[0x00]);
+
+    // Without a local address RTS frames are ignored
+    j1939_parser_init(&ctx);
+    g_tp_sent_count = 0;
+    msg = make_cmdt_msg(PGN_TP_CM, 0x00, 0xF9, 0, rts);
+    j1939_tp_handle_frame(&ctx, &msg);
+    TEST_ASSERT_EQUAL_UINT8(0, g_tp_sent_count);
+    TEST_ASSERT_EQUAL_UINT8(0, ctx.tp_conn_by_sa[0x00]);
+}
+
+void test_tp_bam_lost_packet_expires(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+
+    // Three packets announced, the last one never arrives
+    uint8_t bam[8] = {TP_CM_BAM, 20, 0, 3, 0xFF, 0xCA, 0xFE, 0x00};
+    uint8_t dt1[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+    uint8_t dt2[8] = {2, 0, 0, 0, 0, 0, 0, 0};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x10, 0, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x10, 50, dt1);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x10, 100, dt2);
+    j1939_tp_handle_frame(&ctx, &msg);
+
+    j1939_tp_poll(&ctx, 100 + J1939_TP_TIMEOUT_MS - 1);
+    j1939_tp_pool_stats_t pool;
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT8(1, pool.sessions_in_use);
+
+    // No further frame from 0x10 is needed to reclaim the session
+    j1939_tp_poll(&ctx, 100 + J1939_TP_TIMEOUT_MS + J1939_TP_WHEEL_TICK_MS);
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT8(0, pool.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT16(0, pool.blocks_in_use);
+
+    j1939_tp_expiry_stats_t stats;
+    j1939_tp_get_expiry_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.expired);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.bam_expired);
+    TEST_ASSERT_EQUAL_UINT32(65226, stats.last_pgn);
+    TEST_ASSERT_EQUAL_UINT8(0x10, stats.last_source);
+    TEST_ASSERT_EQUAL_UINT8(1, j1939_tp_get_expired_count(&ctx, 0x10));
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_tp_get_expired_count(&ctx, 0x11));
+}
+
+void test_tp_wheel_expires_only_due_sessions(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+
+    // Every session slot busy, announcements 100 ms apart
+    uint8_t bam[8] = {TP_CM_BAM, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    for (uint8_t sa = 0; sa < J1939_MAX_ACTIVE_TP; sa++) {
+        j1939_message_t msg = make_tp_msg(PGN_TP_CM, sa, 1000 + sa * 100, bam);
+        j1939_tp_handle_frame(&ctx, &msg);
+    }
+
+    j1939_tp_pool_stats_t pool;
+    j1939_tp_expiry_stats_t stats;
+    j1939_tp_poll(&ctx, 1000 + J1939_TP_TIMEOUT_MS + 250);
+    j1939_tp_get_expiry_stats(&ctx, &stats);
+    TEST_ASSERT_TRUE(stats.expired >= 2 && stats.expired <= 3);
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT8(J1939_MAX_ACTIVE_TP - stats.expired, pool.sessions_in_use);
+
+    // A freed slot takes a new transfer right away
+    uint8_t dt1[8] = {1, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA};
+    uint8_t dt2[8] = {2, 0xBB, 0xBB, 0xBB, 0xBB, 0xBB, 0xBB, 0xBB};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x80, 2000, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x80, 2050, dt1);
+    j1939_tp_handle_frame(&ctx, &msg);
+    msg = make_tp_msg(PGN_TP_DT, 0x80, 2100, dt2);
+    TEST_ASSERT_TRUE(j1939_tp_handle_frame(&ctx, &msg));
+    // ... which nobody fetches: reclaimed as unclaimed
+
+    // After a long gap everything left is overdue
+    j1939_tp_poll(&ctx, 100000);
+    j1939_tp_get_expiry_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(J1939_MAX_ACTIVE_TP + 1, stats.expired);
+    TEST_ASSERT_EQUAL_UINT32(J1939_MAX_ACTIVE_TP, stats.bam_expired);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.unclaimed);
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT8(0, pool.sessions_in_use);
+    TEST_ASSERT_EQUAL_UINT16(0, pool.blocks_in_use);
+}
+
+void test_tp_wheel_across_millis_wrap(void) {
+    static j1939_parser_context_t ctx;
+    j1939_parser_init(&ctx);
+    j1939_tp_poll(&ctx, 0xFFFFFF00UL);  // Wheel running just before the wrap
+
+    uint8_t bam[8] = {TP_CM_BAM, 14, 0, 2, 0xFF, 0xCA, 0xFE, 0x00};
+    j1939_message_t msg = make_tp_msg(PGN_TP_CM, 0x20, 0xFFFFFF80UL, bam);
+    j1939_tp_handle_frame(&ctx, &msg);
+
+    j1939_tp_poll(&ctx, (uint32_t)(0xFFFFFF80UL + J1939_TP_TIMEOUT_MS - 1));
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_tp_get_expired_count(&ctx, 0x20));
+    j1939_tp_poll(&ctx, (uint32_t)(0xFFFFFF80UL + J1939_TP_TIMEOUT_MS + J1939_TP_WHEEL_TICK_MS));
+    TEST_ASSERT_EQUAL_UINT8(1, j1939_tp_get_expired_count(&ctx, 0x20));
+}
+
+/*===========================================================================*/
+/*                        EXTENDED TRANSPORT PROTOCOL TESTS                 */
+/*===========================================================================*/
+
+// Sink that checks every streamed byte against etp_pattern() instead of storing it
+static uint32_t g_etp_begins, g_etp_ends, g_etp_result;
+static uint32_t g_etp_next_offset, g_etp_mismatches;
+static bool g_etp_accept;
+
+static uint8_t etp_pattern(uint32_t offset) {
+    return (uint8_t)(offset * 31 + (offset >> 8) + 7);
+}
+
+static bool etp_begin(const j1939_etp_transfer_t* xfer, void* user) {
+    (void)xfer; (void)user;
+    g_etp_begins++;
+    g_etp_next_offset = 0;
+    return g_etp_accept;
+}
+
+static bool etp_write(const j1939_etp_transfer_t* xfer, uint32_t offset,
+                      const uint8_t* data, uint8_t len, void* user) {
+    (void)xfer; (void)user;
+    if (offset != g_etp_next_offset) g_etp_mismatches++;
+    for (uint8_t i = 0; i < len; i++) {
+        if (data[i] != etp_pattern(offset + i)) g_etp_mismatches++;
+    }
+    g_etp_next_offset = offset + len;
+    return true;
+}
+
+static void etp_end(const j1939_etp_transfer_t* xfer, uint8_t result, void* user) {
+    (void)xfer; (void)user;
+    g_etp_ends++;
+    g_etp_result = result;
+}
+
+static const j1939_etp_sink_t g_etp_sink = { etp_begin, etp_write, etp_end, NULL };
+
+static void init_etp(j1939_parser_context_t* ctx) {
+    init_cmdt(ctx);
+    j1939_etp_set_sink(ctx, &g_etp_sink);
+    g_etp_begins = g_etp_ends = g_etp_mismatches = 0;
+    g_etp_result = 0xFF;
+    g_etp_accept = true;
+}
+
+static const uint8_t* last_tp_sent(void) {
+    return g_tp_sent[(g_tp_sent_count - 1) % 16];
+}
+
+static void send_etp_rts(j1939_parser_context_t* ctx, uint8_t sa, uint32_t size, uint32_t ts) {
+    uint8_t rts[8] = {ETP_CM_RTS, (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16),
+                      (uint8_t)(size >> 24), 0x00, 0xD0, 0x00};  // PGN 0xD000
+    j1939_message_t msg = make_cmdt_msg(PGN_ETP_CM, sa, 0xF9, ts, rts);
+    j1939_tp_handle_frame(ctx, &msg);
+}
+
+/**
+ * @brief Play the sender: answer every CTS with a DPO and its packets
+ * @return Number of CTS frames answered
+ */
+static uint32_t run_etp_sender(j1939_parser_context_t* ctx, uint8_t sa, uint32_t size) {
+    uint32_t ts = 10, windows = 0;
+
+    while (last_tp_sent()[0] == ETP_CM_CTS) {
+        const uint8_t* cts = last_tp_sent();
+        uint8_t count = cts[1];
+        uint32_t next = (uint32_t)cts[2] | ((uint32_t)cts[3] << 8) | ((uint32_t)cts[4] << 16);
+        uint32_t offset = next - 1;
+        windows++;
+
+        uint8_t dpo[8] = {ETP_CM_DPO, count, (uint8_t)offset, (uint8_t)(offset >> 8),
+                          (uint8_t)(offset >> 16), 0x00, 0xD0, 0x00};
+        j1939_message_t msg = make_cmdt_msg(PGN_ETP_CM, sa, 0xF9, ts++, dpo);
+        j1939_tp_handle_frame(ctx, &msg);
+
+        for (uint8_t seq = 1; seq <= count; seq++) {
+            uint32_t byte = (offset + seq - 1) * 7;
+            uint8_t dt[8] = {seq, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+            for (uint8_t i = 0; i < 7 && byte + i < size; i++) {
+                dt[1 + i] = etp_pattern(byte + i);
+            }
+            msg = make_cmdt_msg(PGN_ETP_DT, sa, 0xF9, ts++, dt);
+            j1939_tp_handle_frame(ctx, &msg);
+        }
+    }
+    return windows;
+}
+
+void test_etp_streams_large_transfer(void) {
+    static j1939_parser_context_t ctx;
+    init_etp(&ctx);
+
+    // 100 kB: 14286 packets, far beyond TP and the reassembly pool
+    const uint32_t size = 100000;
+    send_etp_rts(&ctx, 0x00, size, 0);
+    uint32_t windows = run_etp_sender(&ctx, 0x00, size);
+
+    TEST_ASSERT_EQUAL_UINT32((14286 + J1939_TP_CTS_WINDOW - 1) / J1939_TP_CTS_WINDOW, windows);
+    TEST_ASSERT_EQUAL_UINT32(1, g_etp_begins);
+    TEST_ASSERT_EQUAL_UINT32(1, g_etp_ends);
+    TEST_ASSERT_EQUAL_UINT8(0, g_etp_result);
+    TEST_ASSERT_EQUAL_UINT32(0, g_etp_mismatches);
+    TEST_ASSERT_EQUAL_UINT32(size, g_etp_next_offset);
+
+    // End of message acknowledged with the byte count, on ETP.CM to the sender
+    uint8_t eoma[8] = {ETP_CM_EOMA, 0xA0, 0x86, 0x01, 0x00, 0x00, 0xD0, 0x00};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(eoma, last_tp_sent(), 8);
+    TEST_ASSERT_EQUAL_HEX32(0x1CC800F9, g_tp_sent_ids[(g_tp_sent_count - 1) % 16]);
+
+    j1939_etp_stats_t stats;
+    j1939_etp_get_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.completed);
+    TEST_ASSERT_EQUAL_UINT32(size, stats.bytes_streamed);
+
+    // Nothing was buffered: the TP pool was never touched
+    j1939_tp_pool_stats_t pool;
+    j1939_tp_get_pool_stats(&ctx, &pool);
+    TEST_ASSERT_EQUAL_UINT16(0, pool.blocks_high_water);
+    TEST_ASSERT_FALSE(ctx.etp_sessions[0].active);
+}
+
+void test_etp_refused_without_sink(void) {
+    static j1939_parser_context_t ctx;
+    init_etp(&ctx);
+
+    // Sink declines the transfer: aborted, and end() is not called
+    g_etp_accept = false;
+    send_etp_rts(&ctx, 0x00, 5000, 0);
+    TEST_ASSERT_EQUAL_UINT8(TP_CM_ABORT, last_tp_sent()[0]);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_RESOURCES, last_tp_sent()[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, g_etp_ends);
+
+    // No sink at all
+    j1939_etp_set_sink(&ctx, NULL);
+    send_etp_rts(&ctx, 0x00, 5000, 0);
+    TEST_ASSERT_EQUAL_UINT32(2, g_tp_sent_count);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_RESOURCES, last_tp_sent()[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_etp_begins);
+
+    j1939_etp_stats_t stats;
+    j1939_etp_get_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.rts_received);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.aborts_sent);
+}
+
+void test_etp_bad_offset_and_timeout(void) {
+    static j1939_parser_context_t ctx;
+    init_etp(&ctx);
+
+    // DPO must continue at the next packet (offset 0 here)
+    send_etp_rts(&ctx, 0x00, 5000, 0);
+    uint8_t dpo[8] = {ETP_CM_DPO, 16, 5, 0, 0, 0x00, 0xD0, 0x00};
+    j1939_message_t msg = make_cmdt_msg(PGN_ETP_CM, 0x00, 0xF9, 10, dpo);
+    j1939_tp_handle_frame(&ctx, &msg);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_BAD_DPO_OFFSET, last_tp_sent()[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, g_etp_ends);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_BAD_DPO_OFFSET, g_etp_result);
+
+    // Sender goes quiet after the CTS: the poll aborts it after T2
+    send_etp_rts(&ctx, 0x00, 5000, 1000);
+    j1939_tp_poll(&ctx, 1000 + J1939_TP_T2_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, g_etp_ends);
+    j1939_tp_poll(&ctx, 1000 + J1939_TP_T2_MS);
+    TEST_ASSERT_EQUAL_UINT32(2, g_etp_ends);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_TIMEOUT, g_etp_result);
+    TEST_ASSERT_EQUAL_UINT8(TP_ABORT_TIMEOUT, last_tp_sent()[1]);
+
+    j1939_etp_stats_t stats;
+    j1939_etp_get_stats(&ctx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+    TEST_ASSERT_FALSE(ctx.etp_sessions[0].active);
+}
+
+/*===========================================================================*/
+/*                        STRING LOOKUP TESTS                               */
+/*===========================================================================*/
+
+void test_get_pgn_name(void) {
+    TEST_ASSERT_EQUAL_STRING("EEC1 - Electronic Engine Controller 1", j1939_get_pgn_name(61444));
+    TEST_ASSERT_EQUAL_STRING("DM1 - Active Diagnostic Trouble Codes", j1939_get_pgn_name(65226));
+    TEST_ASSERT_EQUAL_STRING("Unknown PGN", j1939_get_pgn_name(65000));
+    TEST_ASSERT_EQUAL_STRING("Unknown PGN", j1939_get_pgn_name(0x3FFFF));
+}
+
 /*===========================================================================*/
 /*                        VALIDITY CHECK TESTS                              */
 /*===========================================================================*/
@@ -504,14 +1967,66 @@ int main(int argc, char **argv) {
     RUN_TEST(test_parse_dm1_single_fault);
     RUN_TEST(test_parse_dm1_no_faults);
     
+    // DM1 fault table tests
+    RUN_TEST(test_dm1_table_skips_repeats);
+    RUN_TEST(test_dm1_table_reports_cleared_faults);
+    RUN_TEST(test_dm1_table_tracks_ecus_separately);
+    RUN_TEST(test_dm1_table_multipacket);
+    
+    // Address claim tests
+    RUN_TEST(test_addr_claim_resolves_function);
+    RUN_TEST(test_addr_claim_moves_and_takeovers);
+    RUN_TEST(test_addr_accepts_by_function);
+    RUN_TEST(test_addr_claim_before_first_transmit);
+    RUN_TEST(test_addr_claim_contention);
+    
+    // Request scheduler tests
+    RUN_TEST(test_request_spreads_and_answers);
+    RUN_TEST(test_request_backs_off_when_unanswered);
+    RUN_TEST(test_request_coalesces_consumers);
+    RUN_TEST(test_request_skips_broadcast_pgns);
+    
+    // Diagnostic capture tests
+    RUN_TEST(test_diag_parse_dm4_freeze_frames);
+    RUN_TEST(test_diag_freeze_frame_decodes_through_signal_table);
+    RUN_TEST(test_diag_capture_requests_and_hands_over);
+    RUN_TEST(test_diag_capture_times_out_with_partial_data);
+    RUN_TEST(test_diag_capture_refused_when_requests_do_not_fit);
+    RUN_TEST(test_diag_unsolicited_dm2_is_handed_over);
+    
     // Frame parsing tests
     RUN_TEST(test_parse_frame_basic);
+    RUN_TEST(test_parse_frame_us_timestamp);
     RUN_TEST(test_parse_frame_null_data);
     RUN_TEST(test_parse_frame_invalid_length);
     
     // Parser context tests
     RUN_TEST(test_parser_init);
     
+    // Transport protocol tests
+    RUN_TEST(test_tp_bam_interleaved_sources);
+    RUN_TEST(test_tp_dt_without_bam_ignored);
+    RUN_TEST(test_tp_session_limit);
+    RUN_TEST(test_tp_pool_sized_by_bam);
+    RUN_TEST(test_tp_pool_exhaustion_and_fragmentation);
+    RUN_TEST(test_tp_bam_invalid_size_rejected);
+    RUN_TEST(test_tp_deliver_full_size_in_place);
+    RUN_TEST(test_tp_rts_cts_windows_and_eom);
+    RUN_TEST(test_tp_bam_and_connection_from_same_source);
+    RUN_TEST(test_tp_short_packet_count_padded);
+    RUN_TEST(test_tp_deliver_picks_session_by_destination);
+    RUN_TEST(test_tp_connection_abort_and_timeout);
+    RUN_TEST(test_tp_connection_refusals);
+    RUN_TEST(test_tp_bam_lost_packet_expires);
+    RUN_TEST(test_tp_wheel_expires_only_due_sessions);
+    RUN_TEST(test_tp_wheel_across_millis_wrap);
+    RUN_TEST(test_etp_streams_large_transfer);
+    RUN_TEST(test_etp_refused_without_sink);
+    RUN_TEST(test_etp_bad_offset_and_timeout);
+    
+    // String lookup tests
+    RUN_TEST(test_get_pgn_name);
+    
     // Validity check tests
     RUN_TEST(test_is_valid_8);
     RUN_TEST(test_is_valid_16);
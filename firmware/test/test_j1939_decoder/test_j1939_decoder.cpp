@@ -0,0 +1,943 @@
+/**
+ * @file test_j1939_decoder.cpp
+ * @brief Unit tests for the table-driven J1939 signal decoder
+ *
+ * Tests descriptor table integrity, multi-signal extraction, NA/error
+ * handling, agreement with the hand-written j1939_decode_* functions,
+ * lazy decoding and repeat suppression in the per-(PGN, SA) shadow cache,
+ * and the bus load / rate monitor that uses the table's cycle times.
+ */
+
+#include <unity.h>
+#include "j1939_parser.h"
+#include "j1939_decoder.h"
+#include "j1939_shadow.h"
+#include "j1939_busmon.h"
+#include "j1939_addr.h"
+#include "data_manager.h"
+#include <string.h>
+
+#define FLOAT_EPSILON 0.01f
+#define ASSERT_FLOAT_NEAR(expected, actual) \
+    TEST_ASSERT_FLOAT_WITHIN(FLOAT_EPSILON, expected, actual)
+
+static j1939_message_t make_msg(uint32_t pgn, const uint8_t* data, uint8_t len) {
+    j1939_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.pgn = pgn;
+    msg.data_length = len;
+    memcpy(msg.data, data, len);
+    return msg;
+}
+
+static bool find_value(const j1939_signal_value_t* values, uint8_t count,
+                       param_id_t param_id, float* value) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (values[i].param_id == param_id) {
+            *value = values[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*===========================================================================*/
+/*                        TABLE INTEGRITY TESTS                             */
+/*===========================================================================*/
+
+void test_pgn_table_sorted_and_bounded(void) {
+    uint16_t count = 0;
+    const j1939_pgn_desc_t* pgns = j1939_decoder_get_pgns(&count);
+
+    TEST_ASSERT_NOT_NULL(pgns);
+    TEST_ASSERT_GREATER_THAN(0, count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (i > 0) {
+            TEST_ASSERT_TRUE(pgns[i - 1].pgn < pgns[i].pgn);
+        }
+        TEST_ASSERT_NOT_NULL(pgns[i].name);
+        TEST_ASSERT_TRUE(pgns[i].signal_count <= J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+        for (uint8_t s = 0; s < pgns[i].signal_count; s++) {
+            const j1939_signal_t* sig = &pgns[i].signals[s];
+            TEST_ASSERT_TRUE(sig->bit_length >= 1 && sig->bit_length <= 32);
+            TEST_ASSERT_TRUE(sig->start_bit + sig->bit_length <= 64);
+        }
+    }
+}
+
+void test_find_pgn_unknown(void) {
+    TEST_ASSERT_NULL(j1939_decoder_find_pgn(0));
+    TEST_ASSERT_NULL(j1939_decoder_find_pgn(65000));
+    TEST_ASSERT_NULL(j1939_decoder_find_pgn(0x3FEEE));  // EDP set
+    TEST_ASSERT_NULL(j1939_decoder_find_pgn(59905));    // PDU1 PGNs have PS = 0
+    TEST_ASSERT_NOT_NULL(j1939_decoder_find_pgn(61444));
+}
+
+void test_pgn_index_resolves_every_descriptor(void) {
+    uint16_t count = 0;
+    const j1939_pgn_desc_t* pgns = j1939_decoder_get_pgns(&count);
+
+    TEST_ASSERT_TRUE(j1939_pgn_index_init());
+    for (uint16_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_PTR(&pgns[i], j1939_decoder_find_pgn(pgns[i].pgn));
+    }
+}
+
+void test_pgn_descriptor_fields(void) {
+    const j1939_pgn_desc_t* eec1 = j1939_decoder_find_pgn(61444);
+    TEST_ASSERT_NOT_NULL(eec1);
+    TEST_ASSERT_EQUAL_UINT16(10, eec1->cycle_ms);
+    TEST_ASSERT_EQUAL_UINT8(6, eec1->signal_count);  // 2 published + 4 on demand
+    TEST_ASSERT_EQUAL_UINT8(J1939_FUNCTION_ENGINE, eec1->source_function);
+
+    // DM1 is known but carries no scalar signals
+    const j1939_pgn_desc_t* dm1 = j1939_decoder_find_pgn(65226);
+    TEST_ASSERT_NOT_NULL(dm1);
+    TEST_ASSERT_EQUAL_UINT8(0, dm1->signal_count);
+    TEST_ASSERT_EQUAL_UINT8(J1939_FUNCTION_ANY, dm1->source_function);
+}
+
+void test_signal_raw_limit(void) {
+    TEST_ASSERT_EQUAL_UINT32(0xFE, J1939_SIGNAL_RAW_LIMIT(8));
+    TEST_ASSERT_EQUAL_UINT32(0xFE00, J1939_SIGNAL_RAW_LIMIT(16));
+    TEST_ASSERT_EQUAL_UINT32(0xFE000000, J1939_SIGNAL_RAW_LIMIT(32));
+    TEST_ASSERT_EQUAL_UINT32(2, J1939_SIGNAL_RAW_LIMIT(2));
+}
+
+/*===========================================================================*/
+/*                        DECODING TESTS                                    */
+/*===========================================================================*/
+
+void test_decode_eec1_all_signals(void) {
+    // Torque 75% (raw 200), engine speed 1500 RPM (raw 12000 = 0x2EE0)
+    uint8_t data[8] = {0xF0, 0xFF, 200, 0xE0, 0x2E, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(61444, data, 8);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+
+    uint8_t count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+    TEST_ASSERT_EQUAL_UINT8(2, count);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(1500.0f, value);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_ENGINE_TORQUE, &value));
+    ASSERT_FLOAT_NEAR(75.0f, value);
+}
+
+void test_decode_skips_not_available(void) {
+    // ET1 with only coolant temperature present
+    uint8_t data[8] = {130, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65262, data, 8);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+
+    uint8_t count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+    TEST_ASSERT_EQUAL_UINT8(1, count);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+}
+
+void test_decode_short_frame(void) {
+    // Missing bytes read as "not available"
+    uint8_t data[2] = {0x00, 0x80};
+    j1939_message_t msg = make_msg(65265, data, 2);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+
+    uint8_t count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+    TEST_ASSERT_EQUAL_UINT8(1, count);  // Parking brake only; speed spans byte 2
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_PARKING_BRAKE, &value));
+    ASSERT_FLOAT_NEAR(0.0f, value);
+}
+
+void test_decode_status_bits(void) {
+    // CCVS: parking brake set, cruise active, brake pressed
+    uint8_t data[8] = {0x04, 0x00, 0x69, 0x11, 0xFF, 100, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65265, data, 8);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+
+    uint8_t count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+
+    TEST_ASSERT_EQUAL_UINT8(5, count);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_PARKING_BRAKE, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_CRUISE_ACTIVE, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_BRAKE_SWITCH, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_VEHICLE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(105.0f, value);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_CRUISE_CONTROL_SPEED, &value));
+    ASSERT_FLOAT_NEAR(100.0f, value);
+}
+
+void test_decode_unknown_pgn(void) {
+    uint8_t data[8] = {0};
+    j1939_message_t msg = make_msg(12345, data, 8);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN));
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_decode_signals(NULL, values, J1939_DECODER_MAX_SIGNALS_PER_PGN));
+}
+
+void test_decode_matches_legacy_functions(void) {
+    uint8_t data[8] = {0x80, 0x7D, 0x96, 0x87, 0x9D, 0x2C, 0x1C, 0x02};
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+    uint8_t count;
+
+    j1939_message_t msg = make_msg(61444, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(j1939_decode_engine_speed(data), value);
+
+    msg = make_msg(65262, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(j1939_decode_coolant_temp(data), value);
+
+    msg = make_msg(65263, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_OIL_PRESSURE, &value));
+    ASSERT_FLOAT_NEAR(j1939_decode_oil_pressure(data), value);
+
+    msg = make_msg(65271, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_BATTERY_VOLTAGE, &value));
+    ASSERT_FLOAT_NEAR(j1939_decode_battery_voltage(data), value);
+
+    msg = make_msg(65272, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_TRANS_OIL_TEMP, &value));
+    ASSERT_FLOAT_NEAR(j1939_decode_trans_oil_temp(data), value);
+
+    msg = make_msg(61445, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_CURRENT_GEAR, &value));
+    ASSERT_FLOAT_NEAR((float)j1939_decode_current_gear(data), value);
+
+    msg = make_msg(65253, data, 8);
+    count = j1939_decode_signals(&msg, values, J1939_DECODER_MAX_SIGNALS_PER_PGN);
+    TEST_ASSERT_TRUE(find_value(values, count, PARAM_ENGINE_HOURS, &value));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, j1939_decode_engine_hours(data), value);
+}
+
+void test_decoder_process_updates_data_manager(void) {
+    static data_manager_t dm;
+    data_manager_init(&dm);
+
+    uint8_t data[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1C, 0x02};  // 27.0 V
+    j1939_message_t msg = make_msg(65271, data, 8);
+    msg.timestamp_us = 1234567;
+    float value;
+    uint64_t timestamp_us;
+    uint32_t timestamp_ms;
+
+    TEST_ASSERT_EQUAL_UINT8(1, j1939_decoder_process(&msg, &dm, SOURCE_J1939));
+    TEST_ASSERT_TRUE(data_manager_get(&dm, PARAM_BATTERY_VOLTAGE, &value));
+    ASSERT_FLOAT_NEAR(27.0f, value);
+
+    // Stamped with the frame's receive time, not the processing time
+    TEST_ASSERT_TRUE(data_manager_get_with_timestamp_us(&dm, PARAM_BATTERY_VOLTAGE,
+                                                        NULL, &timestamp_us));
+    TEST_ASSERT_EQUAL_UINT64(1234567ULL, timestamp_us);
+    data_manager_get_with_timestamp(&dm, PARAM_BATTERY_VOLTAGE, NULL, &timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(1234, timestamp_ms);
+    TEST_ASSERT_FALSE(data_manager_get(&dm, PARAM_CHARGING_VOLTAGE, &value));
+}
+
+static uint8_t g_raw_changes;
+
+static void count_raw_change(param_id_t param_id, float new_value, float old_value) {
+    (void)param_id; (void)new_value; (void)old_value;
+    g_raw_changes++;
+}
+
+void test_raw_update_converts_on_read(void) {
+    static data_manager_t dm;
+    data_manager_init(&dm);
+    data_manager_register_callback(&dm, count_raw_change);
+    g_raw_changes = 0;
+
+    static const data_scaling_t coolant = { 1.0f, -40.0f };
+    float value;
+    uint32_t raw;
+    const data_scaling_t* scaling;
+
+    data_manager_update_raw_us(&dm, PARAM_COOLANT_TEMP, 130, &coolant, SOURCE_J1939, 1000);
+    TEST_ASSERT_TRUE(data_manager_get(&dm, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+    TEST_ASSERT_FALSE(data_manager_get_prev(&dm, PARAM_COOLANT_TEMP, &value));  // First value
+
+    // Same raw value: no change reported; a new one is
+    data_manager_update_raw_us(&dm, PARAM_COOLANT_TEMP, 130, &coolant, SOURCE_J1939, 2000);
+    TEST_ASSERT_EQUAL_UINT8(1, g_raw_changes);
+    data_manager_update_raw_us(&dm, PARAM_COOLANT_TEMP, 131, &coolant, SOURCE_J1939, 3000);
+    TEST_ASSERT_EQUAL_UINT8(2, g_raw_changes);
+    TEST_ASSERT_TRUE(data_manager_get_prev(&dm, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+
+#if DATA_FIXED_POINT
+    TEST_ASSERT_TRUE(data_manager_get_raw(&dm, PARAM_COOLANT_TEMP, &raw, &scaling));
+    TEST_ASSERT_EQUAL_UINT32(131, raw);
+    TEST_ASSERT_EQUAL_PTR(&coolant, scaling);
+#else
+    TEST_ASSERT_FALSE(data_manager_get_raw(&dm, PARAM_COOLANT_TEMP, &raw, &scaling));
+#endif
+
+    // An engineering-unit update replaces the raw value
+    data_manager_update_us(&dm, PARAM_COOLANT_TEMP, 85.5f, SOURCE_J1708, 4000);
+    TEST_ASSERT_TRUE(data_manager_get(&dm, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(85.5f, value);
+    TEST_ASSERT_FALSE(data_manager_get_raw(&dm, PARAM_COOLANT_TEMP, &raw, &scaling));
+    TEST_ASSERT_TRUE(data_manager_get_prev(&dm, PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(91.0f, value);
+    TEST_ASSERT_EQUAL_UINT8(3, g_raw_changes);
+}
+
+/*===========================================================================*/
+/*                        SPN INDEX TESTS                                   */
+/*===========================================================================*/
+
+void test_spn_index_sorted_and_consistent(void) {
+    uint16_t spn_count = 0;
+    const j1939_spn_entry_t* spns = j1939_decoder_get_spns(&spn_count);
+
+    for (uint16_t i = 0; i < spn_count; i++) {
+        if (i > 0) {
+            TEST_ASSERT_TRUE(spns[i - 1].spn < spns[i].spn);
+        }
+        TEST_ASSERT_EQUAL_UINT16(spns[i].spn, spns[i].signal->spn);
+
+        // Carrying PGN owns the referenced signal
+        const j1939_pgn_desc_t* desc = j1939_decoder_find_pgn(spns[i].pgn);
+        TEST_ASSERT_NOT_NULL(desc);
+        TEST_ASSERT_TRUE(spns[i].signal >= desc->signals &&
+                         spns[i].signal < desc->signals + desc->signal_count);
+    }
+
+    // Every signal in the PGN table is reachable through the index
+    uint16_t pgn_count = 0;
+    uint16_t signal_total = 0;
+    const j1939_pgn_desc_t* pgns = j1939_decoder_get_pgns(&pgn_count);
+    for (uint16_t i = 0; i < pgn_count; i++) {
+        bool on_demand = false;
+        for (uint8_t s = 0; s < pgns[i].signal_count; s++) {
+            const j1939_spn_entry_t* entry = j1939_decoder_find_spn(pgns[i].signals[s].spn);
+            TEST_ASSERT_NOT_NULL(entry);
+            TEST_ASSERT_EQUAL_PTR(&pgns[i].signals[s], entry->signal);
+
+            // Mapped signals must precede on-demand ones
+            if (pgns[i].signals[s].param_id == PARAM_NONE) {
+                on_demand = true;
+            } else {
+                TEST_ASSERT_FALSE(on_demand);
+            }
+            signal_total++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(signal_total, spn_count);
+}
+
+void test_decode_spn_mapped(void) {
+    uint8_t data[8] = {0xF0, 0xFF, 200, 0xE0, 0x2E, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(61444, data, 8);
+    float value;
+
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 190, &value));
+    ASSERT_FLOAT_NEAR(1500.0f, value);
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 513, &value));
+    ASSERT_FLOAT_NEAR(75.0f, value);
+}
+
+void test_decode_spn_on_demand(void) {
+    // EEC1 driver's demand torque (SPN 512) is not published but decodable
+    uint8_t data[8] = {0xF3, 150, 200, 0xE0, 0x2E, 0x00, 0xF1, 0xFF};
+    j1939_message_t msg = make_msg(61444, data, 8);
+    j1939_signal_value_t values[J1939_DECODER_MAX_SIGNALS_PER_PGN];
+    float value;
+
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 512, &value));
+    ASSERT_FLOAT_NEAR(25.0f, value);
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 899, &value));
+    ASSERT_FLOAT_NEAR(3.0f, value);
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 1675, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_decode_signals(&msg, values,
+                                                    J1939_DECODER_MAX_SIGNALS_PER_PGN));
+}
+
+void test_decode_spn_rejects(void) {
+    uint8_t data[8] = {0x82, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65262, data, 8);
+    float value = 123.0f;
+
+    TEST_ASSERT_FALSE(j1939_decode_spn(&msg, 190, &value));   // SPN of another PGN
+    TEST_ASSERT_FALSE(j1939_decode_spn(&msg, 174, &value));   // Not available
+    TEST_ASSERT_FALSE(j1939_decode_spn(&msg, 60000, &value)); // Unknown SPN
+    TEST_ASSERT_FALSE(j1939_decode_spn(NULL, 110, &value));
+    TEST_ASSERT_FALSE(j1939_decode_spn(&msg, 110, NULL));
+    ASSERT_FLOAT_NEAR(123.0f, value);
+
+    TEST_ASSERT_TRUE(j1939_decode_spn(&msg, 110, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+}
+
+/*===========================================================================*/
+/*                        SHADOW CACHE TESTS                                */
+/*===========================================================================*/
+
+static data_manager_t g_shadow_dm;
+static j1939_shadow_t g_shadow;
+
+/**
+ * @brief Read a parameter as a display does: after the decode task's next resolve
+ */
+static bool shadow_get(param_id_t param_id, float* value) {
+    data_manager_resolve_pending(&g_shadow_dm);
+    return data_manager_get(&g_shadow_dm, param_id, value);
+}
+
+static j1939_message_t make_eec1(uint16_t rpm, uint8_t source_address, uint64_t timestamp_us) {
+    uint16_t raw = (uint16_t)(rpm * 8);
+    uint8_t data[8] = {0xF0, 0xFF, 200, (uint8_t)raw, (uint8_t)(raw >> 8), 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(61444, data, 8);
+    msg.source_address = source_address;
+    msg.timestamp_us = timestamp_us;
+    return msg;
+}
+
+void test_shadow_decodes_on_read(void) {
+    j1939_shadow_stats_t stats;
+    float value;
+    uint64_t timestamp_us;
+
+    // Ten EEC1 frames (100 ms at 10 ms) between two display reads
+    for (uint16_t i = 1; i <= 10; i++) {
+        j1939_message_t msg = make_eec1(1000 + i * 10, 0x00, i * 10000ULL);
+        TEST_ASSERT_EQUAL_UINT8(2, j1939_shadow_store(&g_shadow, &msg));
+    }
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.decodes);
+
+    // Reads never decode
+    TEST_ASSERT_FALSE(data_manager_get(&g_shadow_dm, PARAM_ENGINE_SPEED, &value));
+
+    // A resolve decodes the newest frame, stamped with its receive time
+    TEST_ASSERT_EQUAL_UINT16(2, data_manager_resolve_pending(&g_shadow_dm));
+    TEST_ASSERT_TRUE(data_manager_get_with_timestamp_us(&g_shadow_dm, PARAM_ENGINE_SPEED,
+                                                        &value, &timestamp_us));
+    ASSERT_FLOAT_NEAR(1100.0f, value);
+    TEST_ASSERT_EQUAL_UINT64(100000ULL, timestamp_us);
+
+    // Each parameter is decoded once per resolve, however many frames came in
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_TORQUE, &value));
+    ASSERT_FLOAT_NEAR(75.0f, value);
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.decodes);
+}
+
+void test_shadow_keeps_each_source(void) {
+    j1939_shadow_entry_t entry;
+    float value;
+
+    j1939_message_t engine = make_eec1(1500, 0x00, 1000);
+    for (uint8_t i = 0; i < 3; i++) {
+        j1939_shadow_store(&g_shadow, &engine);
+    }
+    j1939_message_t retarder = make_eec1(800, 0x0F, 2000);
+    j1939_shadow_store(&g_shadow, &retarder);
+
+    // Raw frames and counts per (PGN, SA)
+    TEST_ASSERT_TRUE(j1939_shadow_get(&g_shadow, 61444, 0x00, &entry));
+    TEST_ASSERT_EQUAL_UINT32(3, entry.count);
+    TEST_ASSERT_EQUAL_UINT8(8, entry.data_length);
+    TEST_ASSERT_EQUAL_UINT64(j1939_decoder_load_payload(engine.data, 8), entry.payload);
+    TEST_ASSERT_TRUE(j1939_shadow_get(&g_shadow, 61444, 0x0F, &entry));
+    TEST_ASSERT_EQUAL_UINT32(1, entry.count);
+    TEST_ASSERT_FALSE(j1939_shadow_get(&g_shadow, 61444, 0x03, &entry));
+    TEST_ASSERT_FALSE(j1939_shadow_get(&g_shadow, 65262, 0x00, &entry));
+
+    // Any SPN of any source decodes straight from the cache
+    TEST_ASSERT_TRUE(j1939_shadow_decode_spn(&g_shadow, 190, 0x00, &value));
+    ASSERT_FLOAT_NEAR(1500.0f, value);
+    TEST_ASSERT_TRUE(j1939_shadow_decode_spn(&g_shadow, 190, 0x0F, &value));
+    ASSERT_FLOAT_NEAR(800.0f, value);
+    TEST_ASSERT_FALSE(j1939_shadow_decode_spn(&g_shadow, 110, 0x00, &value));
+
+    // The parameter follows the newest frame, whichever source sent it
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(800.0f, value);
+}
+
+void test_shadow_not_available_keeps_last_value(void) {
+    float value;
+
+    uint8_t valid[8] = {130, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};   // Coolant 90 C
+    uint8_t missing[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65262, valid, 8);
+    j1939_shadow_store(&g_shadow, &msg);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_COOLANT_TEMP, &value));
+
+    msg = make_msg(65262, missing, 8);
+    j1939_shadow_store(&g_shadow, &msg);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+
+    // Never valid: nothing to report
+    TEST_ASSERT_FALSE(shadow_get(PARAM_FUEL_TEMP, &value));
+}
+
+void test_shadow_direct_update_supersedes(void) {
+    float value;
+
+    j1939_message_t msg = make_eec1(1500, 0x00, 1000);
+    j1939_shadow_store(&g_shadow, &msg);
+    data_manager_update_us(&g_shadow_dm, PARAM_ENGINE_SPEED, 650.0f, SOURCE_J1708, 2000);
+
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(650.0f, value);
+    TEST_ASSERT_EQUAL(SOURCE_J1708, g_shadow_dm.parameters[PARAM_ENGINE_SPEED].source);
+}
+
+void test_shadow_repeat_refreshes_timestamp_only(void) {
+    j1939_shadow_stats_t stats;
+    j1939_shadow_entry_t entry;
+    float value;
+    uint32_t timestamp_ms;
+
+    // ET1: coolant 90 C, fuel temperature not available
+    uint8_t data[8] = {130, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65262, data, 8);
+    msg.timestamp_us = 1000000;
+    TEST_ASSERT_GREATER_THAN(0, j1939_shadow_store(&g_shadow, &msg));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_COOLANT_TEMP, &value));
+    uint32_t updates = g_shadow_dm.parameters[PARAM_COOLANT_TEMP].update_count;
+
+    // Five seconds of the same bytes
+    for (uint8_t i = 1; i <= 5; i++) {
+        msg.timestamp_us = 1000000ULL + i * 1000000ULL;
+        TEST_ASSERT_EQUAL_UINT8(0, j1939_shadow_store(&g_shadow, &msg));
+    }
+
+    // Still fresh, never decoded or published again
+    data_manager_resolve_pending(&g_shadow_dm);
+    TEST_ASSERT_TRUE(data_manager_get_with_timestamp(&g_shadow_dm, PARAM_COOLANT_TEMP,
+                                                     &value, &timestamp_ms));
+    ASSERT_FLOAT_NEAR(90.0f, value);
+    TEST_ASSERT_EQUAL_UINT32(6000, timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(updates, g_shadow_dm.parameters[PARAM_COOLANT_TEMP].update_count);
+    TEST_ASSERT_FALSE(shadow_get(PARAM_FUEL_TEMP, &value));
+
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.repeats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.decodes);
+    TEST_ASSERT_TRUE(j1939_shadow_get(&g_shadow, 65262, 0x00, &entry));
+    TEST_ASSERT_EQUAL_UINT32(5, entry.repeats);
+    TEST_ASSERT_EQUAL_UINT64(6000000ULL, entry.timestamp_us);
+
+    // A changed byte is a new value again
+    msg.data[0] = 131;
+    TEST_ASSERT_GREATER_THAN(0, j1939_shadow_store(&g_shadow, &msg));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_COOLANT_TEMP, &value));
+    ASSERT_FLOAT_NEAR(91.0f, value);
+}
+
+void test_shadow_repeat_from_other_source_takes_over(void) {
+    float value;
+
+    j1939_message_t engine = make_eec1(1500, 0x00, 1000);
+    j1939_message_t retarder = make_eec1(800, 0x0F, 2000);
+    j1939_shadow_store(&g_shadow, &engine);
+    j1939_shadow_store(&g_shadow, &retarder);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(800.0f, value);
+
+    // The engine repeats itself, but the parameter last came from the retarder
+    engine.timestamp_us = 3000;
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_shadow_store(&g_shadow, &engine));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(1500.0f, value);
+}
+
+void test_shadow_full_table_decodes_eagerly(void) {
+    j1939_shadow_stats_t stats;
+    float value;
+
+    // PGNs the decoder does not know take no slot
+    uint8_t data[8] = {0};
+    j1939_message_t msg = make_msg(65280, data, 8);
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_shadow_store(&g_shadow, &msg));
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+
+    // Fill every slot with ET1 from distinct sources
+    for (uint16_t sa = 0; sa < J1939_SHADOW_SLOTS; sa++) {
+        msg = make_msg(65262, data, 8);
+        msg.source_address = (uint8_t)sa;
+        j1939_shadow_store(&g_shadow, &msg);
+    }
+
+    msg = make_eec1(1200, 0x00, 1000);
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_shadow_store(&g_shadow, &msg));
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(J1939_SHADOW_SLOTS, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overflow);
+
+    // Already decoded, and existing keys still update in place
+    TEST_ASSERT_FALSE(g_shadow_dm.parameters[PARAM_ENGINE_SPEED].pending);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(1200.0f, value);
+    msg = make_msg(65262, data, 8);
+    msg.source_address = 5;
+    j1939_shadow_store(&g_shadow, &msg);
+    j1939_shadow_get_stats(&g_shadow, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overflow);
+}
+
+/*===========================================================================*/
+/*                        BUS MONITOR TESTS                                 */
+/*===========================================================================*/
+
+static j1939_busmon_t g_busmon;
+
+static can_frame_t make_can_frame(uint32_t id, bool extended, uint64_t timestamp_us) {
+    can_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = id;
+    frame.length = 8;
+    frame.is_extended = extended;
+    frame.timestamp_us = timestamp_us;
+    return frame;
+}
+
+void test_busmon_frame_bits(void) {
+    TEST_ASSERT_EQUAL_UINT16(131, j1939_busmon_frame_bits(true, false, 8, false));
+    TEST_ASSERT_EQUAL_UINT16(160, j1939_busmon_frame_bits(true, false, 8, true));
+    TEST_ASSERT_EQUAL_UINT16(111, j1939_busmon_frame_bits(false, false, 8, false));
+    TEST_ASSERT_EQUAL_UINT16(135, j1939_busmon_frame_bits(false, false, 8, true));
+    TEST_ASSERT_EQUAL_UINT16(67, j1939_busmon_frame_bits(true, true, 8, false));   // No data field
+    TEST_ASSERT_EQUAL_UINT16(160, j1939_busmon_frame_bits(true, false, 15, true)); // Clamped
+}
+
+void test_busmon_load_and_rate(void) {
+    j1939_busmon_stats_t stats;
+    float value;
+
+    // EEC1 at its nominal 10 ms for two windows
+    for (uint32_t i = 0; i < 200; i++) {
+        can_frame_t frame = make_can_frame(0x0CF00400, true, 1000 + i * 10000ULL);
+        j1939_busmon_frame(&g_busmon, &frame);
+    }
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.windows);
+    ASSERT_FLOAT_NEAR(100.0f, stats.frame_rate);
+    ASSERT_FLOAT_NEAR(5.24f, stats.load_pct);           // 100 x 131 bits at 250 kbit/s
+    ASSERT_FLOAT_NEAR(6.40f, stats.load_worst_pct);     // 100 x 160 bits
+    TEST_ASSERT_EQUAL_UINT8(0x00, stats.busiest_sa);
+    ASSERT_FLOAT_NEAR(100.0f, stats.busiest_sa_rate);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.keys);
+
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_LOAD, &value));
+    ASSERT_FLOAT_NEAR(5.24f, value);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_FRAME_RATE, &value));
+    ASSERT_FLOAT_NEAR(100.0f, value);
+
+    // An idle bus still closes the window
+    j1939_busmon_poll(&g_busmon, 1000 + 2000000ULL);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.windows);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.off_cycle);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.max_jitter_us);
+    j1939_busmon_poll(&g_busmon, 1000 + 3000000ULL);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    ASSERT_FLOAT_NEAR(0.0f, stats.load_pct);
+    ASSERT_FLOAT_NEAR(6.40f, stats.peak_load_pct);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.off_cycle);       // Gone silent
+}
+
+void test_busmon_off_cycle_and_jitter(void) {
+    j1939_busmon_stats_t stats;
+    j1939_busmon_key_t key;
+    float value;
+
+    // EEC1 from SA 0x00 at 10 ms, from SA 0x03 at 50 ms instead of 10
+    for (uint64_t t = 10000; t <= 3000000; t += 10000) {
+        can_frame_t frame = make_can_frame(0x0CF00400, true, t);
+        j1939_busmon_frame(&g_busmon, &frame);
+        if (t % 50000 == 0) {
+            frame.id = 0x0CF00403;
+            j1939_busmon_frame(&g_busmon, &frame);
+        }
+    }
+    j1939_busmon_poll(&g_busmon, 3010000);
+
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.windows);
+    TEST_ASSERT_EQUAL_UINT16(1, stats.off_cycle);
+    TEST_ASSERT_EQUAL_UINT32(61444, stats.max_jitter_pgn);
+    TEST_ASSERT_EQUAL_UINT8(0x03, stats.max_jitter_sa);
+    TEST_ASSERT_UINT32_WITHIN(200, 40000, stats.max_jitter_us);
+
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_OFF_CYCLE_COUNT, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_MAX_JITTER, &value));
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 40.0f, value);
+
+    uint8_t found = 0;
+    for (uint16_t i = 0; i < J1939_BUSMON_SLOTS; i++) {
+        if (!j1939_busmon_get_key(&g_busmon, i, &key)) continue;
+        found++;
+        TEST_ASSERT_EQUAL_UINT32(61444, key.pgn);
+        TEST_ASSERT_EQUAL_UINT16(10, key.cycle_ms);
+        if (key.source_address == 0x03) {
+            ASSERT_FLOAT_NEAR(20.0f, key.rate_hz);
+            TEST_ASSERT_EQUAL_UINT32(50000, key.interval_us);
+            TEST_ASSERT_TRUE(key.off_cycle);
+        } else {
+            ASSERT_FLOAT_NEAR(100.0f, key.rate_hz);
+            TEST_ASSERT_EQUAL_UINT32(0, key.jitter_us);
+            TEST_ASSERT_FALSE(key.off_cycle);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT8(2, found);
+}
+
+void test_busmon_standard_frames_and_full_table(void) {
+    j1939_busmon_stats_t stats;
+
+    // 11-bit frames load the bus but have no (PGN, SA)
+    can_frame_t frame = make_can_frame(0x123, false, 1000);
+    j1939_busmon_frame(&g_busmon, &frame);
+
+    // More keys than slots; SA 0x42 talks the most
+    for (uint16_t sa = 0; sa <= J1939_BUSMON_SLOTS; sa++) {
+        frame = make_can_frame(0x18FF0000 | sa, true, 2000 + sa);
+        j1939_busmon_frame(&g_busmon, &frame);
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        frame = make_can_frame(0x18FE0042, true, 5000 + i);
+        j1939_busmon_frame(&g_busmon, &frame);
+    }
+    j1939_busmon_poll(&g_busmon, 1001000);
+
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(J1939_BUSMON_SLOTS + 5, stats.frames);
+    TEST_ASSERT_EQUAL_UINT16(J1939_BUSMON_SLOTS, stats.keys);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.untracked);
+    TEST_ASSERT_EQUAL_UINT8(0x42, stats.busiest_sa);
+    ASSERT_FLOAT_NEAR(3.0f, stats.busiest_sa_rate);
+    ASSERT_FLOAT_NEAR((111.0f + (J1939_BUSMON_SLOTS + 4) * 131.0f) * 100.0f / 250000.0f,
+                      stats.load_pct);
+}
+
+typedef struct {
+    uint8_t count;
+    uint32_t pgn;
+    uint8_t source_address;
+    uint64_t last_us;
+} lost_log_t;
+
+static void record_lost(uint32_t pgn, uint8_t source_address, uint64_t last_us, void* user) {
+    lost_log_t* log = (lost_log_t*)user;
+    log->count++;
+    log->pgn = pgn;
+    log->source_address = source_address;
+    log->last_us = last_us;
+}
+
+static void send_frame(uint32_t id, uint64_t timestamp_us) {
+    can_frame_t frame = make_can_frame(id, true, timestamp_us);
+    j1939_busmon_frame(&g_busmon, &frame);
+}
+
+void test_busmon_lost_after_missed_cycles(void) {
+    lost_log_t log = { 0, 0, 0, 0 };
+    j1939_busmon_stats_t stats;
+    float value;
+    j1939_busmon_set_lost_handler(&g_busmon, record_lost, &log);
+
+    // EEC1 at 10 ms until 200 ms, then silence
+    for (uint64_t t = 100000; t <= 200000; t += 10000) send_frame(0x0CF00400, t);
+
+    j1939_busmon_poll(&g_busmon, 229000);
+    TEST_ASSERT_EQUAL_UINT8(0, log.count);
+
+    // Three cycles (30 ms) plus at most one wheel tick
+    j1939_busmon_poll(&g_busmon, 230000 + J1939_BUSMON_WHEEL_TICK_MS * 1000);
+    TEST_ASSERT_EQUAL_UINT8(1, log.count);
+    TEST_ASSERT_EQUAL_UINT32(61444, log.pgn);
+    TEST_ASSERT_EQUAL_UINT8(0x00, log.source_address);
+    TEST_ASSERT_EQUAL_UINT64(200000, log.last_us);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_LOST_COUNT, &value));
+    ASSERT_FLOAT_NEAR(1.0f, value);
+
+    // Reported once, cleared by the next frame, reported again
+    j1939_busmon_poll(&g_busmon, 400000);
+    TEST_ASSERT_EQUAL_UINT8(1, log.count);
+    send_frame(0x0CF00400, 400000);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT16(0, stats.lost_keys);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.late);  // The 200 ms gap
+    TEST_ASSERT_TRUE(shadow_get(PARAM_BUS_LOST_COUNT, &value));
+    ASSERT_FLOAT_NEAR(0.0f, value);
+
+    j1939_busmon_poll(&g_busmon, 450000);
+    TEST_ASSERT_EQUAL_UINT8(2, log.count);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.lost_events);
+}
+
+void test_busmon_long_deadline_and_event_pgns(void) {
+    lost_log_t log = { 0, 0, 0, 0 };
+    j1939_busmon_set_lost_handler(&g_busmon, record_lost, &log);
+
+    // ET1 (1 s cycle): its 3 s deadline outlasts a wheel revolution
+    send_frame(0x18FEEE00, 1000000);
+    send_frame(0x18EAFF00, 1000000);   // Request: no cycle, never lost
+    for (uint64_t t = 1000000; t < 3996000; t += J1939_BUSMON_WHEEL_TICK_MS * 1000) {
+        j1939_busmon_poll(&g_busmon, t);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, log.count);
+
+    j1939_busmon_poll(&g_busmon, 4000000 + J1939_BUSMON_WHEEL_TICK_MS * 1000);
+    TEST_ASSERT_EQUAL_UINT8(1, log.count);
+    TEST_ASSERT_EQUAL_UINT32(65262, log.pgn);
+
+    j1939_busmon_poll(&g_busmon, 60000000);
+    TEST_ASSERT_EQUAL_UINT8(1, log.count);
+}
+
+static void expire_lost(uint32_t pgn, uint8_t source_address, uint64_t last_us, void* user) {
+    (void)last_us;
+    (void)user;
+    j1939_shadow_expire(&g_shadow, pgn, source_address);
+}
+
+void test_busmon_requested_pgn_uses_request_period(void) {
+    float value;
+    j1939_busmon_stats_t stats;
+    j1939_busmon_set_lost_handler(&g_busmon, expire_lost, NULL);
+
+    // HOURS answer (1000 h); its 1 s table cycle would expire it at 4 s
+    uint8_t data[8] = {0x20, 0x4E, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF};
+    j1939_message_t msg = make_msg(65253, data, 8);
+    msg.timestamp_us = 1000000;
+    send_frame(0x18FEE500, 1000000);
+    j1939_shadow_store(&g_shadow, &msg);
+
+    // Requested every 60 s: the armed deadline moves out
+    TEST_ASSERT_TRUE(j1939_busmon_set_cycle(&g_busmon, 65253, 60000));
+    for (uint64_t t = 1000000; t <= 10000000; t += 100000) j1939_busmon_poll(&g_busmon, t);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.lost_events);
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_HOURS, &value));
+    ASSERT_FLOAT_NEAR(1000.0f, value);
+
+    // Three request periods without an answer
+    j1939_busmon_poll(&g_busmon, 181000000 + J1939_BUSMON_WHEEL_TICK_MS * 1000);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.lost_events);
+    TEST_ASSERT_FALSE(shadow_get(PARAM_ENGINE_HOURS, &value));
+
+    // Keys created later take the set period; 0 means no deadline
+    TEST_ASSERT_TRUE(j1939_busmon_set_cycle(&g_busmon, 65262, 0));
+    send_frame(0x18FEEE00, 200000000);
+    j1939_busmon_poll(&g_busmon, 260000000);
+    j1939_busmon_get_stats(&g_busmon, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.lost_events);
+}
+
+void test_shadow_expire_invalidates_owned_params(void) {
+    float value;
+    j1939_message_t a = make_eec1(1000, 0x00, 1000);
+    j1939_message_t b = make_eec1(1000, 0x01, 2000);
+
+    // SA 0x01 owns engine speed; SA 0x00 going silent changes nothing
+    j1939_shadow_store(&g_shadow, &a);
+    j1939_shadow_store(&g_shadow, &b);
+    TEST_ASSERT_EQUAL_UINT8(0, j1939_shadow_expire(&g_shadow, 61444, 0x00));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_shadow_expire(&g_shadow, 61444, 0x01));
+    TEST_ASSERT_FALSE(shadow_get(PARAM_ENGINE_SPEED, &value));
+
+    // The same payload again is not a mere repeat: the value comes back
+    b.timestamp_us = 3000;
+    TEST_ASSERT_EQUAL_UINT8(2, j1939_shadow_store(&g_shadow, &b));
+    TEST_ASSERT_TRUE(shadow_get(PARAM_ENGINE_SPEED, &value));
+    ASSERT_FLOAT_NEAR(1000.0f, value);
+}
+
+/*===========================================================================*/
+/*                        TEST RUNNER                                       */
+/*===========================================================================*/
+
+void setUp(void) {
+    // Called before each test
+    data_manager_init(&g_shadow_dm);
+    j1939_shadow_init(&g_shadow, &g_shadow_dm);
+    j1939_busmon_init(&g_busmon, &g_shadow_dm, 250000);
+}
+
+void tearDown(void) {
+    // Called after each test
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Table integrity tests
+    RUN_TEST(test_pgn_table_sorted_and_bounded);
+    RUN_TEST(test_find_pgn_unknown);
+    RUN_TEST(test_pgn_index_resolves_every_descriptor);
+    RUN_TEST(test_pgn_descriptor_fields);
+    RUN_TEST(test_signal_raw_limit);
+
+    // Decoding tests
+    RUN_TEST(test_decode_eec1_all_signals);
+    RUN_TEST(test_decode_skips_not_available);
+    RUN_TEST(test_decode_short_frame);
+    RUN_TEST(test_decode_status_bits);
+    RUN_TEST(test_decode_unknown_pgn);
+    RUN_TEST(test_decode_matches_legacy_functions);
+    RUN_TEST(test_decoder_process_updates_data_manager);
+    RUN_TEST(test_raw_update_converts_on_read);
+
+    // SPN index tests
+    RUN_TEST(test_spn_index_sorted_and_consistent);
+    RUN_TEST(test_decode_spn_mapped);
+    RUN_TEST(test_decode_spn_on_demand);
+    RUN_TEST(test_decode_spn_rejects);
+
+    // Shadow cache tests
+    RUN_TEST(test_shadow_decodes_on_read);
+    RUN_TEST(test_shadow_keeps_each_source);
+    RUN_TEST(test_shadow_not_available_keeps_last_value);
+    RUN_TEST(test_shadow_direct_update_supersedes);
+    RUN_TEST(test_shadow_repeat_refreshes_timestamp_only);
+    RUN_TEST(test_shadow_repeat_from_other_source_takes_over);
+    RUN_TEST(test_shadow_full_table_decodes_eagerly);
+
+    // Bus monitor tests
+    RUN_TEST(test_busmon_frame_bits);
+    RUN_TEST(test_busmon_load_and_rate);
+    RUN_TEST(test_busmon_off_cycle_and_jitter);
+    RUN_TEST(test_busmon_standard_frames_and_full_table);
+    RUN_TEST(test_busmon_lost_after_missed_cycles);
+    RUN_TEST(test_busmon_long_deadline_and_event_pgns);
+    RUN_TEST(test_busmon_requested_pgn_uses_request_period);
+    RUN_TEST(test_shadow_expire_invalidates_owned_params);
+
+    return UNITY_END();
+}
@@ -0,0 +1,206 @@
+/**
+ * @file trace_utils.h
+ * @brief CAN trace loading for native benchmark suites
+ *
+ * Reads Vector ASCII (.asc) logs such as the test_data/synthetic traces,
+ * candump -L logs (.log) and the synthetic CSV exports (.csv) into an in-memory frame
+ * array so benchmarks measure decoding, not file I/O.
+ */
+
+#ifndef TRACE_UTILS_H
+#define TRACE_UTILS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can_host.h"
+
+/*===========================================================================*/
+/*                        DATA STRUCTURES                                   */
+/*===========================================================================*/
+
+/**
+ * @brief One CAN frame from a trace
+ */
+typedef struct {
+    uint32_t timestamp_ms;      // Trace timestamp
+    uint64_t timestamp_us;      // Trace timestamp at full .asc resolution
+    uint32_t can_id;            // 29-bit identifier
+    uint8_t data_length;        // Data length (clipped to 8)
+    uint8_t data[8];
+} trace_frame_t;
+
+// Trace locations relative to the PlatformIO project (firmware/) directory
+static const char* const trace_asc_paths[] = {
+    "../test_data/synthetic/idle_60s.asc",
+    "../test_data/synthetic/acceleration_30s.asc",
+    "../test_data/synthetic/highway_60s.asc",
+    "../test_data/synthetic/cold_start_120s.asc",
+    "lib/j1939_data/test_data/truck_sample.asc",
+};
+
+#define TRACE_ASC_PATH_COUNT (sizeof(trace_asc_paths) / sizeof(trace_asc_paths[0]))
+
+// Traces in the other supported formats
+static const char* const trace_log_path = "lib/j1939_data/test_data/truck_sample_generated.log";
+static const char* const trace_csv_path = "../test_data/synthetic/highway_sample.csv";
+
+/*===========================================================================*/
+/*                        LOADING                                           */
+/*===========================================================================*/
+
+/**
+ * @brief Parse one .asc line ("<time> <ch> <id>x Rx d <dlc> <bytes...>")
+ * @return true if the line held an extended data frame
+ */
+static inline bool trace_parse_asc_line(const char* line, trace_frame_t* frame) {
+    double seconds;
+    unsigned channel, dlc;
+    char id_text[16], dir[4], kind[4];
+    int consumed = 0;
+
+    if (sscanf(line, " %lf %u %15s %3s %3s %u%n", &seconds, &channel, id_text,
+               dir, kind, &dlc, &consumed) != 6) {
+        return false;
+    }
+    size_t id_len = strlen(id_text);
+    if (kind[0] != 'd' || id_len < 2 || id_text[id_len - 1] != 'x') return false;
+
+    frame->timestamp_us = (uint64_t)(seconds * 1000000.0 + 0.5);
+    frame->timestamp_ms = (uint32_t)(frame->timestamp_us / 1000ULL);
+    frame->can_id = (uint32_t)strtoul(id_text, NULL, 16) & 0x1FFFFFFF;
+    frame->data_length = (dlc > 8) ? 8 : (uint8_t)dlc;  // Some logs carry 9-byte rows
+
+    const char* p = line + consumed;
+    for (uint8_t i = 0; i < frame->data_length; i++) {
+        unsigned byte;
+        int n = 0;
+        if (sscanf(p, " %x%n", &byte, &n) != 1) return false;
+        frame->data[i] = (uint8_t)byte;
+        p += n;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse one candump -L line ("(sec.usec) iface ID#DATA")
+ *
+ * Uses the same parser as the host build's log source (can_host.cpp).
+ *
+ * @return true if the line held an extended data frame
+ */
+static inline bool trace_parse_candump_line(const char* line, trace_frame_t* frame) {
+    can_frame_t can;
+    uint64_t log_time_us;
+
+    if (!can_host_parse_log_line(line, &can, &log_time_us)) return false;
+    if (!can.is_extended || can.is_rtr) return false;
+
+    frame->timestamp_us = log_time_us;
+    frame->timestamp_ms = (uint32_t)(log_time_us / 1000ULL);
+    frame->can_id = can.id;
+    frame->data_length = can.length;
+    memcpy(frame->data, can.data, 8);
+    return true;
+}
+
+/**
+ * @brief Parse one CSV row ("timestamp,can_id,pgn,source_addr,data_hex")
+ *
+ * The pgn and source_addr columns are redundant with can_id and ignored;
+ * data_hex holds space-separated bytes. The header row does not parse.
+ *
+ * @return true if the row held a frame
+ */
+static inline bool trace_parse_csv_line(const char* line, trace_frame_t* frame) {
+    double seconds;
+    char id_text[16];
+    int consumed = 0;
+
+    if (sscanf(line, " %lf , %15[^,] , %*u , %*u , %n", &seconds, id_text, &consumed) != 2 ||
+        consumed == 0) {
+        return false;
+    }
+
+    frame->timestamp_us = (uint64_t)(seconds * 1000000.0 + 0.5);
+    frame->timestamp_ms = (uint32_t)(frame->timestamp_us / 1000ULL);
+    frame->can_id = (uint32_t)strtoul(id_text, NULL, 16) & 0x1FFFFFFF;
+    frame->data_length = 0;
+
+    const char* p = line + consumed;
+    while (frame->data_length < 8) {
+        unsigned byte;
+        int n = 0;
+        if (sscanf(p, " %2x%n", &byte, &n) != 1) break;
+        frame->data[frame->data_length++] = (uint8_t)byte;
+        p += n;
+    }
+    return frame->data_length > 0;
+}
+
+/**
+ * @brief Append all frames of an .asc file to an array
+ * @return Number of frames appended (0 if the file is missing)
+ */
+static inline uint32_t trace_load_asc(const char* path, trace_frame_t* frames,
+                                      uint32_t max_frames) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return 0;
+
+    char line[256];
+    uint32_t count = 0;
+    while (count < max_frames && fgets(line, sizeof(line), f) != NULL) {
+        if (trace_parse_asc_line(line, &frames[count])) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+/**
+ * @brief Append all frames of a trace, picking the parser from the extension
+ *
+ * ".log" is read as candump -L, ".csv" as the synthetic CSV export, and
+ * anything else as Vector ASCII.
+ *
+ * @return Number of frames appended (0 if the file is missing)
+ */
+static inline uint32_t trace_load(const char* path, trace_frame_t* frames, uint32_t max_frames) {
+    const char* ext = strrchr(path, '.');
+    bool (*parse_line)(const char*, trace_frame_t*) = trace_parse_asc_line;
+
+    if (ext != NULL && strcmp(ext, ".log") == 0) {
+        parse_line = trace_parse_candump_line;
+    } else if (ext != NULL && strcmp(ext, ".csv") == 0) {
+        parse_line = trace_parse_csv_line;
+    }
+
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return 0;
+
+    char line[256];
+    uint32_t count = 0;
+    while (count < max_frames && fgets(line, sizeof(line), f) != NULL) {
+        if (parse_line(line, &frames[count])) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+/**
+ * @brief Load every known .asc trace that is present
+ * @return Total frames loaded
+ */
+static inline uint32_t trace_load_all_asc(trace_frame_t* frames, uint32_t max_frames) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < TRACE_ASC_PATH_COUNT; i++) {
+        total += trace_load_asc(trace_asc_paths[i], frames + total, max_frames - total);
+    }
+    return total;
+}
+
+#endif /* TRACE_UTILS_H */
@@ -277,9 +277,12 @@ class CHeaderGenerator:
         lines.append("/*" + "=" * 75 + "*/")
         lines.append("")
         
+        # Guarded: the firmware headers define some of these PGNs too
         for msg in sorted(self.db.messages.values(), key=lambda m: m.pgn):
             pgn = msg.pgn
+            lines.append(f"#ifndef PGN_{msg.c_name}")
             lines.append(f"#define PGN_{msg.c_name:<20} 0x{pgn:04X}  // {pgn} - {msg.comment or msg.name}")
+            lines.append("#endif")
         
         lines.append("")
         